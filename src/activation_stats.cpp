@@ -0,0 +1,294 @@
+#include "activation_stats.h"
+#include "file_utils.h"
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <thread>
+
+namespace {
+
+constexpr size_t kChunkValues = size_t(1) << 20;  // unit of work; big tensors are split across threads
+constexpr int kLanes = 8;
+constexpr int kBinBlock = 256;
+constexpr int kQuantizedBins = 128;                // INT8 magnitude levels
+
+struct Chunk {
+    size_t tensor;
+    const unsigned char* values;    // float32, not necessarily aligned
+    size_t count;
+};
+
+int resolveThreads(int threads) {
+    if (threads > 0) return threads;
+    return static_cast<int>(std::min(8u, std::max(1u, std::thread::hardware_concurrency())));
+}
+
+// Calls work(item, worker) for every item in [0, items) on a pool of threads
+template <typename Work>
+void parallelFor(size_t items, int threads, const Work& work) {
+    std::atomic<size_t> next{0};
+    std::vector<std::thread> pool;
+    int count = static_cast<int>(std::min<size_t>(static_cast<size_t>(resolveThreads(threads)), std::max<size_t>(1, items)));
+    for (int worker = 0; worker < count; ++worker) {
+        pool.emplace_back([&, worker]() {
+            for (size_t item = next++; item < items; item = next++) work(item, worker);
+        });
+    }
+    for (auto& thread : pool) thread.join();
+}
+
+// Dumps are written on little-endian hosts; memcpy keeps unaligned reads defined
+inline float loadFloat(const unsigned char* p) {
+    float value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+// Largest finite |x|. Lane-wise maxima keep the loop free of a serial
+// dependency so it compiles to packed compares.
+float maxAbs(const unsigned char* values, size_t count) {
+    float lanes[kLanes] = {};
+    size_t i = 0;
+    for (; i + kLanes <= count; i += kLanes) {
+        for (int j = 0; j < kLanes; ++j) {
+            float a = std::fabs(loadFloat(values + (i + j) * sizeof(float)));
+            lanes[j] = (a > lanes[j] && a <= FLT_MAX) ? a : lanes[j];
+        }
+    }
+    float result = 0.0f;
+    for (float lane : lanes) result = std::max(result, lane);
+    for (; i < count; ++i) {
+        float a = std::fabs(loadFloat(values + i * sizeof(float)));
+        if (a > result && a <= FLT_MAX) result = a;
+    }
+    return result;
+}
+
+// Bin indices are computed a block at a time (vectorizable), then counted.
+// Non-finite values land in the top bin.
+void accumulate(const unsigned char* values, size_t count, float scale, uint64_t* histogram) {
+    const float topBin = static_cast<float>(ActivationStats::kBins - 1);
+    int32_t bins[kBinBlock];
+    for (size_t begin = 0; begin < count; begin += kBinBlock) {
+        int n = static_cast<int>(std::min<size_t>(kBinBlock, count - begin));
+        const unsigned char* block = values + begin * sizeof(float);
+        for (int k = 0; k < n; ++k) {
+            float b = std::fabs(loadFloat(block + k * sizeof(float))) * scale;
+            bins[k] = static_cast<int32_t>(b < topBin ? b : topBin);
+        }
+        for (int k = 0; k < n; ++k) ++histogram[bins[k]];
+    }
+}
+
+// TensorRT's entropy calibration: for each candidate threshold (at least 128
+// bins), fold the clipped tail into the last bin to get the reference
+// distribution P, requantize the unclipped bins to 128 levels to get Q, and
+// keep the threshold with the smallest KL(P || Q).
+float entropyAmax(const ActivationStats::Tensor& tensor) {
+    const std::vector<uint64_t>& hist = tensor.histogram;
+    const int bins = static_cast<int>(hist.size());
+    const float binWidth = tensor.maxAbs / bins;
+
+    uint64_t outliers = 0;
+    for (int k = kQuantizedBins; k < bins; ++k) outliers += hist[k];
+
+    std::vector<double> p(bins), q(bins);
+    double bestDivergence = std::numeric_limits<double>::infinity();
+    int bestBins = bins;
+    for (int i = kQuantizedBins; i <= bins; ++i) {
+        for (int k = 0; k < i; ++k) p[k] = static_cast<double>(hist[k]);
+        p[i - 1] += static_cast<double>(outliers);
+        if (i < bins) outliers -= hist[i];
+
+        int merged = i / kQuantizedBins;
+        for (int j = 0; j < kQuantizedBins; ++j) {
+            int begin = j * merged;
+            int end = j == kQuantizedBins - 1 ? i : begin + merged;
+            double sum = 0.0;
+            int nonzero = 0;
+            for (int k = begin; k < end; ++k) {
+                sum += static_cast<double>(hist[k]);
+                nonzero += p[k] != 0.0;
+            }
+            for (int k = begin; k < end; ++k) q[k] = p[k] != 0.0 ? sum / nonzero : 0.0;
+        }
+
+        double pTotal = 0.0, qTotal = 0.0;
+        for (int k = 0; k < i; ++k) {
+            pTotal += p[k];
+            qTotal += q[k];
+        }
+        if (pTotal <= 0.0 || qTotal <= 0.0) continue;
+
+        double divergence = 0.0;
+        for (int k = 0; k < i; ++k) {
+            if (p[k] == 0.0) continue;
+            if (q[k] == 0.0) {
+                divergence = std::numeric_limits<double>::infinity();
+                break;
+            }
+            double pk = p[k] / pTotal;
+            divergence += pk * std::log(pk / (q[k] / qTotal));
+        }
+        if (divergence < bestDivergence) {
+            bestDivergence = divergence;
+            bestBins = i;
+        }
+    }
+    return bestBins * binWidth;
+}
+
+float percentileAmax(const ActivationStats::Tensor& tensor, double percentile) {
+    const std::vector<uint64_t>& hist = tensor.histogram;
+    uint64_t total = 0;
+    for (uint64_t count : hist) total += count;
+    double target = static_cast<double>(total) * std::min(100.0, percentile) / 100.0;
+    uint64_t cumulative = 0;
+    for (size_t k = 0; k < hist.size(); ++k) {
+        cumulative += hist[k];
+        if (static_cast<double>(cumulative) >= target) {
+            return (k + 1) * (tensor.maxAbs / hist.size());
+        }
+    }
+    return tensor.maxAbs;
+}
+
+} // namespace
+
+bool ActivationStats::parseAlgorithm(const std::string& text, Algorithm& algorithm) {
+    if (text == "entropy") algorithm = Algorithm::Entropy;
+    else if (text == "percentile") algorithm = Algorithm::Percentile;
+    else if (text == "minmax") algorithm = Algorithm::MinMax;
+    else return false;
+    return true;
+}
+
+bool ActivationStats::collect(const std::vector<std::string>& files, int threads) {
+    m_tensors.clear();
+
+    // Index every record; the mappings stay open for both passes
+    std::vector<std::unique_ptr<MappedFile>> mappings;
+    std::vector<std::string> names;
+    std::map<std::string, size_t> indices;
+    std::vector<Chunk> chunks;
+    std::vector<uint64_t> counts;
+    for (const auto& path : files) {
+        mappings.push_back(std::make_unique<MappedFile>());
+        MappedFile& file = *mappings.back();
+        if (!file.open(path)) return false;
+
+        const unsigned char* data = file.data();
+        size_t size = file.size(), offset = 0;
+        while (offset < size) {
+            uint32_t nameLength = 0;
+            uint64_t valueCount = 0;
+            if (size - offset < sizeof(nameLength)) break;
+            std::memcpy(&nameLength, data + offset, sizeof(nameLength));
+            offset += sizeof(nameLength);
+            if (nameLength == 0 || size - offset < nameLength + sizeof(valueCount)) break;
+            std::string name(reinterpret_cast<const char*>(data + offset), nameLength);
+            offset += nameLength;
+            std::memcpy(&valueCount, data + offset, sizeof(valueCount));
+            offset += sizeof(valueCount);
+            if (valueCount > (size - offset) / sizeof(float)) {
+                offset = size + 1;
+                break;
+            }
+
+            auto inserted = indices.emplace(name, names.size());
+            if (inserted.second) {
+                names.push_back(name);
+                counts.push_back(0);
+            }
+            size_t tensor = inserted.first->second;
+            counts[tensor] += valueCount;
+            for (uint64_t begin = 0; begin < valueCount; begin += kChunkValues) {
+                chunks.push_back({tensor, data + offset + begin * sizeof(float),
+                                  static_cast<size_t>(std::min<uint64_t>(kChunkValues, valueCount - begin))});
+            }
+            offset += valueCount * sizeof(float);
+        }
+        if (offset != size) {
+            std::cerr << "Error: Truncated or malformed activation dump: " << path << "\n";
+            return false;
+        }
+    }
+    if (names.empty()) {
+        std::cerr << "Error: No activation records found\n";
+        return false;
+    }
+
+    const int workers = resolveThreads(threads);
+    const size_t tensorCount = names.size();
+
+    // Pass 1: range of each tensor
+    std::vector<std::vector<float>> localMax(workers, std::vector<float>(tensorCount, 0.0f));
+    parallelFor(chunks.size(), workers, [&](size_t item, int worker) {
+        const Chunk& chunk = chunks[item];
+        float& m = localMax[worker][chunk.tensor];
+        m = std::max(m, maxAbs(chunk.values, chunk.count));
+    });
+    std::vector<float> ranges(tensorCount, 0.0f);
+    for (const auto& local : localMax) {
+        for (size_t t = 0; t < tensorCount; ++t) ranges[t] = std::max(ranges[t], local[t]);
+    }
+
+    // Pass 2: per-thread histograms over [0, range], merged afterwards
+    std::vector<std::vector<std::vector<uint64_t>>> localHist(workers, std::vector<std::vector<uint64_t>>(tensorCount));
+    parallelFor(chunks.size(), workers, [&](size_t item, int worker) {
+        const Chunk& chunk = chunks[item];
+        if (ranges[chunk.tensor] <= 0.0f) return;
+        std::vector<uint64_t>& hist = localHist[worker][chunk.tensor];
+        if (hist.empty()) hist.assign(kBins, 0);
+        accumulate(chunk.values, chunk.count, kBins / ranges[chunk.tensor], hist.data());
+    });
+
+    for (size_t t = 0; t < tensorCount; ++t) {
+        Tensor& tensor = m_tensors[names[t]];
+        tensor.maxAbs = ranges[t];
+        tensor.count = counts[t];
+        if (ranges[t] <= 0.0f) continue;
+        tensor.histogram.assign(kBins, 0);
+        for (const auto& local : localHist) {
+            if (local[t].empty()) continue;
+            for (int k = 0; k < kBins; ++k) tensor.histogram[k] += local[t][k];
+        }
+    }
+    return true;
+}
+
+std::map<std::string, float> ActivationStats::computeAmax(Algorithm algorithm, double percentile, int threads) const {
+    std::vector<const std::pair<const std::string, Tensor>*> entries;
+    for (const auto& entry : m_tensors) entries.push_back(&entry);
+    std::vector<float> amax(entries.size(), 0.0f);
+
+    // The entropy search is O(kBins^2) per tensor, so tensors are spread over threads
+    parallelFor(entries.size(), threads, [&](size_t item, int) {
+        const Tensor& tensor = entries[item]->second;
+        if (tensor.histogram.empty()) return;
+        switch (algorithm) {
+        case Algorithm::Entropy: amax[item] = entropyAmax(tensor); break;
+        case Algorithm::Percentile: amax[item] = percentileAmax(tensor, percentile); break;
+        case Algorithm::MinMax: amax[item] = tensor.maxAbs; break;
+        }
+    });
+
+    std::map<std::string, float> result;
+    for (size_t i = 0; i < entries.size(); ++i) result[entries[i]->first] = amax[i];
+    return result;
+}
+
+CalibrationCache ActivationStats::makeCache(Algorithm algorithm, double percentile, int threads) const {
+    CalibrationCache cache;
+    cache.header = CalibrationCache::defaultHeader();
+    for (const auto& entry : computeAmax(algorithm, percentile, threads)) {
+        // All-zero tensors get no scale; TensorRT keeps them out of INT8
+        if (entry.second > 0.0f) cache.scales[entry.first] = entry.second / 127.0f;
+    }
+    return cache;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include "calibration_cache.h"
+
+// INT8 activation ranges computed on the CPU from a reference run, written as
+// a TensorRT calibration cache, so calibration needs no GPU or TensorRT build.
+//
+// Input is one or more activation dump files produced by any CPU runtime
+// (e.g. ONNX Runtime with every tensor to be quantized added as an output,
+// including the network input). A dump is a sequence of records, little-endian:
+//
+//   uint32 nameLength, char name[nameLength],      // tensor name as in the ONNX graph
+//   uint64 valueCount, float32 values[valueCount]  // any batch/shape, flattened
+//
+// A tensor may appear in any number of records and files; all are pooled.
+// Collection is two passes over memory-mapped dumps on a thread pool: the
+// per-tensor |x| maximum, then a kBins histogram of |x| over [0, max].
+class ActivationStats {
+public:
+    enum class Algorithm {
+        Entropy,        // TensorRT EntropyCalibration2: threshold minimizing KL divergence
+        Percentile,     // smallest threshold covering the given share of values
+        MinMax,         // largest |x| seen
+    };
+
+    static constexpr int kBins = 2048;
+
+    struct Tensor {
+        float maxAbs = 0.0f;
+        uint64_t count = 0;
+        std::vector<uint64_t> histogram;    // kBins bins of width maxAbs / kBins; empty if maxAbs is 0
+    };
+
+    // "entropy", "percentile" or "minmax"
+    static bool parseAlgorithm(const std::string& text, Algorithm& algorithm);
+
+    // Pools every record of the files; prints an error and returns false on a malformed dump
+    bool collect(const std::vector<std::string>& files, int threads = 0);
+
+    const std::map<std::string, Tensor>& tensors() const { return m_tensors; }
+
+    // amax per tensor; percentile is in (0, 100] and only used by Algorithm::Percentile
+    std::map<std::string, float> computeAmax(Algorithm algorithm, double percentile = 99.99, int threads = 0) const;
+
+    // Scales (amax / 127) under CalibrationCache::defaultHeader()
+    CalibrationCache makeCache(Algorithm algorithm, double percentile = 99.99, int threads = 0) const;
+
+private:
+    std::map<std::string, Tensor> m_tensors;
+};
@@ -0,0 +1,369 @@
+#include "build_daemon.h"
+#include "engine_exporter.h"
+#include "engine_file.h"
+#include "engine_store.h"
+#include "file_utils.h"
+#include "json.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <streambuf>
+#include <thread>
+
+namespace {
+
+// Per-thread destination for log lines; set by a worker for the duration of a build
+thread_local const std::function<void(const std::string&)>* tl_logSink = nullptr;
+
+// Replaces the std::cout/std::cerr buffer: complete lines still reach the console,
+// and lines written by a worker thread are also handed to that worker's sink.
+class LogRoutingBuffer : public std::streambuf {
+public:
+    LogRoutingBuffer(std::streambuf* console, std::mutex& consoleMutex, int slot)
+        : m_console(console), m_consoleMutex(consoleMutex), m_slot(slot) {}
+
+protected:
+    int overflow(int ch) override {
+        if (ch == traits_type::eof()) return 0;
+        char c = static_cast<char>(ch);
+        append(&c, 1);
+        return ch;
+    }
+
+    std::streamsize xsputn(const char* data, std::streamsize size) override {
+        append(data, static_cast<size_t>(size));
+        return size;
+    }
+
+private:
+    void append(const char* data, size_t size) {
+        static thread_local std::string pending[2];
+        std::string& line = pending[m_slot];
+        for (size_t i = 0; i < size; ++i) {
+            if (data[i] != '\n') {
+                line += data[i];
+                continue;
+            }
+            {
+                std::lock_guard<std::mutex> lock(m_consoleMutex);
+                m_console->sputn(line.data(), static_cast<std::streamsize>(line.size()));
+                m_console->sputc('\n');
+                m_console->pubsync();
+            }
+            if (tl_logSink) (*tl_logSink)(line);
+            line.clear();
+        }
+    }
+
+    std::streambuf* m_console;
+    std::mutex& m_consoleMutex;
+    int m_slot;
+};
+
+std::string eventLine(const char* event, JsonValue fields = JsonValue::makeObject()) {
+    JsonValue message = JsonValue::makeObject();
+    message.set("event", event);
+    for (const auto& member : fields.members()) message.set(member.first, member.second);
+    return message.dump();
+}
+
+// Copies the built engine to a waiter's output through a temporary file and a
+// rename: readers never see a partial engine, and an output that is a hard
+// link into the engine store is replaced, not written through
+bool deliverEngine(const std::string& builtPath, const std::string& outputPath) {
+    std::ifstream source(builtPath, std::ios::binary);
+    if (!source) {
+        std::cerr << "Error: Cannot read built engine: " << builtPath << "\n";
+        return false;
+    }
+    std::error_code ec;
+    std::filesystem::path dir = std::filesystem::path(outputPath).parent_path();
+    if (!dir.empty()) std::filesystem::create_directories(dir, ec);
+
+    AtomicFileWriter output(outputPath);
+    std::vector<char> chunk(4 << 20);
+    while (output.isOpen() && source) {
+        source.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+        if (source.gcount() > 0 && !output.write(chunk.data(), static_cast<size_t>(source.gcount()))) break;
+    }
+    if (source.bad() || !source.eof()) {
+        std::cerr << "Error: Cannot copy built engine to " << outputPath << "\n";
+        output.abort();
+        return false;
+    }
+    if (!output.commit()) {
+        return false;
+    }
+
+    // The checksum describes the new file only once it is in place
+    std::string digest = EngineChecksum::read(builtPath);
+    if (digest.empty() || !EngineChecksum::write(outputPath, digest)) {
+        std::filesystem::remove(EngineChecksum::pathFor(outputPath), ec);
+    }
+    return true;
+}
+
+std::string errorLine(const std::string& text) {
+    JsonValue fields = JsonValue::makeObject();
+    fields.set("message", text);
+    return eventLine("error", fields);
+}
+
+} // namespace
+
+void BuildDaemon::Client::send(const std::string& line) {
+    std::lock_guard<std::mutex> lock(mutex);
+    socket.writeLine(line);    // a client that hung up just stops receiving
+}
+
+BuildDaemon::BuildDaemon(const std::string& socketPath, int workers)
+    : m_socketPath(socketPath), m_workers(std::max(1, workers)) {
+}
+
+bool BuildDaemon::parsePriority(const std::string& text, int& priority) {
+    if (text == "interactive") priority = 0;
+    else if (text == "normal") priority = 10;
+    else if (text == "nightly") priority = 20;
+    else if (!text.empty() && text.find_first_not_of("0123456789") == std::string::npos && text.size() < 6) {
+        priority = std::stoi(text);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+int BuildDaemon::run() {
+    LocalSocket server;
+    if (!LocalSocket::listen(m_socketPath, server)) {
+        return 2;
+    }
+
+    m_deviceTag = EngineStore::currentDeviceTag();
+    std::cout << "Build daemon listening on " << m_socketPath << " (" << m_workers << " worker(s)";
+    if (!m_deviceTag.empty()) std::cout << ", " << m_deviceTag;
+    std::cout << ")\n";
+
+    std::mutex consoleMutex;
+    LogRoutingBuffer coutRouter(std::cout.rdbuf(), consoleMutex, 0);
+    LogRoutingBuffer cerrRouter(std::cerr.rdbuf(), consoleMutex, 1);
+    std::streambuf* coutOriginal = std::cout.rdbuf(&coutRouter);
+    std::streambuf* cerrOriginal = std::cerr.rdbuf(&cerrRouter);
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < m_workers; ++i) {
+        workers.emplace_back(&BuildDaemon::workerLoop, this);
+    }
+
+    while (true) {
+        auto client = std::make_shared<Client>();
+        if (!server.accept(client->socket)) {
+            std::cerr << "Error: Accept failed on " << m_socketPath << "\n";
+            break;
+        }
+        std::thread(&BuildDaemon::handleClient, this, client).detach();
+    }
+
+    // Only reached if the listening socket breaks; in-flight builds still finish
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_queueChanged.notify_all();
+    for (auto& worker : workers) worker.join();
+
+    std::cout.rdbuf(coutOriginal);
+    std::cerr.rdbuf(cerrOriginal);
+    return 1;
+}
+
+void BuildDaemon::handleClient(std::shared_ptr<Client> client) {
+    std::string line;
+    if (!client->socket.readLine(line)) return;
+
+    JsonValue request;
+    std::string error;
+    if (!JsonValue::parse(line, request, error) || !request.isObject()) {
+        client->send(errorLine("Malformed request: " + error));
+        return;
+    }
+    const JsonValue* type = request.find("type");
+    std::string typeName = type && type->isString() ? type->asString() : "build";
+    if (typeName == "build") {
+        handleBuildRequest(client, request);
+    } else if (typeName == "status") {
+        handleStatusRequest(client);
+    } else {
+        client->send(errorLine("Unknown request type: " + typeName));
+    }
+}
+
+void BuildDaemon::handleBuildRequest(const std::shared_ptr<Client>& client, const JsonValue& request) {
+    int priority = 10;
+    if (const JsonValue* value = request.find("priority")) {
+        std::string text = value->isNumber() ? std::to_string(static_cast<int>(value->asNumber()))
+                                             : (value->isString() ? value->asString() : "");
+        if (!parsePriority(text, priority)) {
+            client->send(errorLine("Invalid priority (interactive, normal, nightly or a number)"));
+            return;
+        }
+    }
+
+    ExportConfig config;
+    std::string error;
+    const JsonValue* settings = request.find("config");
+    if (!settings || !ConfigParser::applyJson(*settings, config, error)) {
+        client->send(errorLine("Invalid config: " + (settings ? error : std::string("missing"))));
+        return;
+    }
+    if (!config.is_valid() || !std::filesystem::exists(config.input_onnx_path)) {
+        client->send(errorLine("Input ONNX file does not exist: " + config.input_onnx_path));
+        return;
+    }
+
+    std::string material;
+    std::string key = EngineStore::makeKey(config, m_deviceTag, material);
+    if (key.empty()) {
+        client->send(errorLine("Cannot read input ONNX file: " + config.input_onnx_path));
+        return;
+    }
+
+    bool joined = false;
+    size_t position = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto& build = m_builds[key];
+        if (build) {
+            joined = true;
+            build->priority = std::min(build->priority, priority);
+        } else {
+            build = std::make_shared<Build>();
+            build->key = key;
+            build->config = config;
+            build->priority = priority;
+            build->sequence = m_nextSequence++;
+        }
+        build->waiters.push_back({client, config.get_output_path()});
+
+        for (const auto& entry : m_builds) {
+            const Build& other = *entry.second;
+            if (!other.started && other.key != key &&
+                (other.priority < build->priority ||
+                 (other.priority == build->priority && other.sequence < build->sequence))) {
+                ++position;
+            }
+        }
+
+        JsonValue fields = JsonValue::makeObject();
+        fields.set("key", key);
+        fields.set("joined", joined);
+        fields.set("started", build->started);
+        fields.set("position", static_cast<uint64_t>(position));
+        // Under the lock, so "queued" always precedes this build's "started"/"log"/"done"
+        client->send(eventLine("queued", fields));
+    }
+    m_queueChanged.notify_one();
+
+    std::cout << "Request " << key.substr(0, 16) << " (" << config.input_onnx_path << ", priority " << priority
+              << (joined ? ", joined in-flight build" : "") << ")\n";
+}
+
+void BuildDaemon::handleStatusRequest(const std::shared_ptr<Client>& client) {
+    JsonValue builds = JsonValue::makeArray();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (const auto& entry : m_builds) {
+            const Build& build = *entry.second;
+            JsonValue item = JsonValue::makeObject();
+            item.set("key", build.key);
+            item.set("input", build.config.input_onnx_path);
+            item.set("priority", build.priority);
+            item.set("started", build.started);
+            item.set("waiters", static_cast<uint64_t>(build.waiters.size()));
+            builds.push(item);
+        }
+    }
+    JsonValue fields = JsonValue::makeObject();
+    fields.set("workers", m_workers);
+    fields.set("builds", builds);
+    client->send(eventLine("status", fields));
+}
+
+void BuildDaemon::broadcast(const Build& build, const std::string& line) {
+    std::vector<std::shared_ptr<Client>> clients;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (const auto& waiter : build.waiters) clients.push_back(waiter.client);
+    }
+    for (const auto& client : clients) client->send(line);
+}
+
+void BuildDaemon::workerLoop() {
+    while (true) {
+        std::shared_ptr<Build> build;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            auto next = [this]() -> std::shared_ptr<Build> {
+                std::shared_ptr<Build> best;
+                for (const auto& entry : m_builds) {
+                    const auto& candidate = entry.second;
+                    if (candidate->started) continue;
+                    if (!best || candidate->priority < best->priority ||
+                        (candidate->priority == best->priority && candidate->sequence < best->sequence)) {
+                        best = candidate;
+                    }
+                }
+                return best;
+            };
+            m_queueChanged.wait(lock, [&]() { return m_stopping || next() != nullptr; });
+            if (m_stopping) return;
+            build = next();
+            build->started = true;
+        }
+
+        broadcast(*build, eventLine("started"));
+        std::function<void(const std::string&)> sink = [this, &build](const std::string& text) {
+            JsonValue fields = JsonValue::makeObject();
+            fields.set("text", text);
+            broadcast(*build, eventLine("log", fields));
+        };
+
+        auto start_time = std::chrono::high_resolution_clock::now();
+        bool success = false;
+        tl_logSink = &sink;
+        try {
+            EngineExporter exporter(build->config);
+            success = exporter.exportEngine();
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << "\n";
+        }
+        tl_logSink = nullptr;
+        auto end_time = std::chrono::high_resolution_clock::now();
+        double seconds = std::chrono::duration<double>(end_time - start_time).count();
+
+        // No new waiters can join once the build leaves the table
+        std::vector<Waiter> waiters;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_builds.erase(build->key);
+            waiters = build->waiters;
+        }
+
+        std::string builtPath = build->config.get_output_path();
+        for (const auto& waiter : waiters) {
+            bool delivered = success;
+            if (success && waiter.outputPath != builtPath) {
+                delivered = deliverEngine(builtPath, waiter.outputPath);
+            }
+            JsonValue fields = JsonValue::makeObject();
+            fields.set("success", delivered);
+            fields.set("output", waiter.outputPath);
+            fields.set("seconds", seconds);
+            waiter.client->send(eventLine("done", fields));
+        }
+        std::cout << "Build " << build->key.substr(0, 16) << (success ? " succeeded" : " failed") << " ("
+                  << waiters.size() << " waiter(s))\n";
+    }
+}
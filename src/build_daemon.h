@@ -0,0 +1,71 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "config.h"
+#include "local_socket.h"
+
+// Long-running export service on a UNIX-domain socket.
+//
+// Protocol: one JSON object per line. A client sends a single request,
+//   {"type": "build", "priority": "interactive" | "normal" | "nightly" | <int>, "config": {...}}
+//   {"type": "status"}
+// and receives a stream of events until the daemon closes the connection:
+//   {"event": "queued", "key": ..., "joined": bool, "position": n}
+//   {"event": "started"} / {"event": "log", "text": ...}
+//   {"event": "done", "success": bool, "output": ..., "seconds": s}
+//   {"event": "error", "message": ...}
+// Requests whose engine store key matches a queued or running build join it
+// instead of building again; every waiter gets the engine at its own output path.
+class BuildDaemon {
+public:
+    BuildDaemon(const std::string& socketPath, int workers);
+
+    // Serves until the listening socket fails; returns a process exit code
+    int run();
+
+    // Lower runs first; names map to 0 / 10 / 20
+    static bool parsePriority(const std::string& text, int& priority);
+
+private:
+    struct Client {
+        LocalSocket socket;
+        std::mutex mutex;
+        void send(const std::string& line);
+    };
+
+    struct Waiter {
+        std::shared_ptr<Client> client;
+        std::string outputPath;
+    };
+
+    struct Build {
+        std::string key;
+        ExportConfig config;
+        int priority = 10;
+        uint64_t sequence = 0;
+        bool started = false;
+        std::vector<Waiter> waiters;
+    };
+
+    void handleClient(std::shared_ptr<Client> client);
+    void handleBuildRequest(const std::shared_ptr<Client>& client, const JsonValue& request);
+    void handleStatusRequest(const std::shared_ptr<Client>& client);
+    void workerLoop();
+    void broadcast(const Build& build, const std::string& line);
+
+    std::string m_socketPath;
+    int m_workers;
+    std::string m_deviceTag;
+
+    std::mutex m_mutex;
+    std::condition_variable m_queueChanged;
+    std::map<std::string, std::shared_ptr<Build>> m_builds;   // queued and running, by key
+    uint64_t m_nextSequence = 0;
+    bool m_stopping = false;
+};
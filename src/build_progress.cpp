@@ -0,0 +1,72 @@
+#include "build_progress.h"
+#include <algorithm>
+
+BuildProgress::Snapshot BuildProgress::snapshot() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Snapshot result;
+    if (m_phases.empty()) return result;
+
+    Clock::time_point now = Clock::now();
+    result.active = true;
+    result.phase = m_phases.back().name;
+    result.elapsedSeconds = std::chrono::duration<double>(now - m_started).count();
+
+    // Nested phases subdivide the current step of their parent
+    float fraction = 0.0f;
+    for (auto it = m_phases.rbegin(); it != m_phases.rend(); ++it) {
+        fraction = std::min(1.0f, (it->done + fraction) / it->steps);
+    }
+    result.fraction = fraction;
+
+    // Layer timing dominates a build and has by far the most steps
+    const Phase* counted = &m_phases.front();
+    for (const auto& phase : m_phases) {
+        if (phase.steps > counted->steps) counted = &phase;
+    }
+    result.countedPhase = counted->name;
+    result.step = counted->done;
+    result.steps = counted->steps;
+    if (counted->done > 0) {
+        double inPhase = std::chrono::duration<double>(now - counted->started).count();
+        result.etaSeconds = inPhase / counted->done * (counted->steps - counted->done);
+    }
+    return result;
+}
+
+void BuildProgress::phaseStart(const char* phaseName, const char* parentPhase, int32_t nbSteps) noexcept {
+    try {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_hasStarted) {
+            m_started = Clock::now();
+            m_hasStarted = true;
+        }
+        // A top-level phase after an earlier one finished starts a new tree
+        if (!parentPhase) m_phases.clear();
+        m_phases.push_back({phaseName ? phaseName : "", std::max(1, nbSteps), 0, Clock::now()});
+    } catch (...) {
+    }
+}
+
+bool BuildProgress::stepComplete(const char* phaseName, int32_t step) noexcept {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto it = m_phases.rbegin(); it != m_phases.rend(); ++it) {
+            if (phaseName && it->name == phaseName) {
+                it->done = std::min(it->steps, step + 1);
+                break;
+            }
+        }
+    }
+    return !m_cancelled;
+}
+
+void BuildProgress::phaseFinish(const char* phaseName) noexcept {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto it = m_phases.rbegin(); it != m_phases.rend(); ++it) {
+        if (phaseName && it->name == phaseName) {
+            // Drops any nested phase left open by an early exit as well
+            m_phases.erase(std::next(it).base(), m_phases.end());
+            break;
+        }
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <NvInfer.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// IProgressMonitor that keeps the builder's phase tree for a UI to poll, and
+// stops the build at the next step once cancel() is called. TensorRT then
+// returns no engine and the exporter releases the builder as usual.
+class BuildProgress : public nvinfer1::IProgressMonitor {
+public:
+    struct Snapshot {
+        bool active = false;            // a builder phase is running
+        std::string phase;              // innermost phase, e.g. "Computing costs"
+        int step = 0;                   // of the phase with the most steps (layer timing)
+        int steps = 0;
+        std::string countedPhase;
+        float fraction = 0.0f;          // of the outermost phase, including nested progress
+        double elapsedSeconds = 0.0;
+        double etaSeconds = -1.0;       // from the pace of the counted phase; < 0 while unknown
+    };
+
+    void cancel() { m_cancelled = true; }
+    bool cancelled() const { return m_cancelled; }
+
+    Snapshot snapshot() const;
+
+    void phaseStart(const char* phaseName, const char* parentPhase, int32_t nbSteps) noexcept override;
+    bool stepComplete(const char* phaseName, int32_t step) noexcept override;
+    void phaseFinish(const char* phaseName) noexcept override;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Phase {
+        std::string name;
+        int steps = 1;
+        int done = 0;
+        Clock::time_point started;
+    };
+
+    mutable std::mutex m_mutex;
+    std::vector<Phase> m_phases;        // outermost first
+    Clock::time_point m_started;
+    bool m_hasStarted = false;
+    std::atomic<bool> m_cancelled{false};
+};
@@ -0,0 +1,148 @@
+#include "build_report.h"
+#include "file_utils.h"
+#include <NvInferVersion.h>
+#include <algorithm>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+double toMegabytes(uint64_t bytes) {
+    return static_cast<double>(bytes) / (1024.0 * 1024.0);
+}
+
+std::string utcTimestamp() {
+    std::time_t now = std::time(nullptr);
+    std::tm utc{};
+#ifdef _WIN32
+    gmtime_s(&utc, &now);
+#else
+    gmtime_r(&now, &utc);
+#endif
+    char text[32];
+    std::strftime(text, sizeof(text), "%Y-%m-%dT%H:%M:%SZ", &utc);
+    return text;
+}
+
+} // namespace
+
+BuildReport::BuildReport() {
+    reset();
+    m_sampler = std::thread(&BuildReport::sampleLoop, this);
+}
+
+BuildReport::~BuildReport() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    m_sampler.join();
+}
+
+void BuildReport::reset() {
+    m_phases.clear();
+    m_runningPhase.clear();
+    m_facts = JsonValue::makeObject();
+    m_started = Clock::now();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_buildPeak = currentRss();
+}
+
+void BuildReport::beginPhase(const std::string& name) {
+    endPhase();
+    m_runningPhase = name;
+    m_phaseStarted = Clock::now();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_phasePeak = currentRss();
+}
+
+void BuildReport::endPhase() {
+    if (m_runningPhase.empty()) return;
+    Phase phase;
+    phase.name = m_runningPhase;
+    phase.seconds = std::chrono::duration<double>(Clock::now() - m_phaseStarted).count();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        phase.peakRss = std::max(m_phasePeak, currentRss());
+        m_buildPeak = std::max(m_buildPeak, phase.peakRss);
+    }
+    m_phases.push_back(phase);
+    m_runningPhase.clear();
+}
+
+void BuildReport::set(const std::string& key, JsonValue value) {
+    m_facts.set(key, std::move(value));
+}
+
+bool BuildReport::write(const std::string& path, bool success) {
+    endPhase();
+
+    JsonValue report = JsonValue::makeObject();
+    report.set("success", success);
+    report.set("finished_utc", utcTimestamp());
+    report.set("tensorrt", std::to_string(NV_TENSORRT_MAJOR) + "." + std::to_string(NV_TENSORRT_MINOR) + "." +
+                           std::to_string(NV_TENSORRT_PATCH));
+    report.set("total_seconds", std::chrono::duration<double>(Clock::now() - m_started).count());
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        report.set("peak_rss_mb", toMegabytes(m_buildPeak));
+    }
+
+    JsonValue phases = JsonValue::makeArray();
+    for (const auto& phase : m_phases) {
+        JsonValue item = JsonValue::makeObject();
+        item.set("name", phase.name);
+        item.set("seconds", phase.seconds);
+        item.set("peak_rss_mb", toMegabytes(phase.peakRss));
+        phases.push(item);
+    }
+    report.set("phases", phases);
+    for (const auto& fact : m_facts.members()) report.set(fact.first, fact.second);
+
+    std::string text = report.dump(2) + "\n";
+    if (!writeFileAtomic(path, text.data(), text.size())) {
+        std::cerr << "Warning: Cannot write build report: " << path << "\n";
+        return false;
+    }
+    std::cout << "Build report: " << path << "\n";
+    return true;
+}
+
+std::string BuildReport::pathFor(const std::string& enginePath) {
+    return std::filesystem::path(enginePath).replace_extension(".build.json").string();
+}
+
+uint64_t BuildReport::currentRss() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters{};
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return counters.WorkingSetSize;
+    }
+    return 0;
+#else
+    std::ifstream statm("/proc/self/statm");
+    uint64_t totalPages = 0, residentPages = 0;
+    if (!(statm >> totalPages >> residentPages)) return 0;
+    return residentPages * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+void BuildReport::sampleLoop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stopping) {
+        m_wake.wait_for(lock, std::chrono::milliseconds(20));
+        uint64_t rss = currentRss();
+        m_phasePeak = std::max(m_phasePeak, rss);
+        m_buildPeak = std::max(m_buildPeak, rss);
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "json.h"
+
+// Machine-readable record of one engine build, written next to the engine as
+// <engine stem>.build.json: wall time and peak host RSS per phase, plus
+// whatever facts the exporter adds (layer counts, engine size, timing cache
+// use, the builder flags actually applied). Meant for comparing builds across
+// TensorRT upgrades and for sizing build machines.
+//
+// A sampler thread polls the process RSS every 20 ms, so a phase's peak
+// includes short-lived allocations inside TensorRT, not just its end state.
+class BuildReport {
+public:
+    BuildReport();
+    ~BuildReport();
+
+    BuildReport(const BuildReport&) = delete;
+    BuildReport& operator=(const BuildReport&) = delete;
+
+    // Clears phases and facts for the next build
+    void reset();
+
+    // Ends the running phase, if any, and starts timing the next
+    void beginPhase(const std::string& name);
+    void endPhase();
+
+    // Top-level fact; a later set() of the same key replaces it
+    void set(const std::string& key, JsonValue value);
+
+    // Ends the running phase and writes the report atomically
+    bool write(const std::string& path, bool success);
+
+    static std::string pathFor(const std::string& enginePath);
+
+    // Resident set size of this process in bytes, 0 where unsupported
+    static uint64_t currentRss();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Phase {
+        std::string name;
+        double seconds = 0.0;
+        uint64_t peakRss = 0;
+    };
+
+    void sampleLoop();
+
+    std::vector<Phase> m_phases;
+    std::string m_runningPhase;
+    Clock::time_point m_phaseStarted;
+    Clock::time_point m_started;
+    JsonValue m_facts = JsonValue::makeObject();
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    uint64_t m_phasePeak = 0;       // guarded by m_mutex, raised by the sampler
+    uint64_t m_buildPeak = 0;
+    bool m_stopping = false;
+    std::thread m_sampler;
+};
@@ -0,0 +1,383 @@
+// calib_tool: prepares INT8 calibration data and caches on the CPU (no TensorRT or CUDA required)
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "activation_stats.h"
+#include "calibration_shard.h"
+#include "calibration_subset.h"
+#include "onnx_model.h"
+
+namespace {
+
+void printUsage(const std::string& program_name) {
+    std::cout << "Usage: " << program_name << " <command> [arguments]\n\n";
+    std::cout << "Commands:\n";
+    std::cout << "  shard <image_dir> --size <n> [options]\n";
+    std::cout << "                                Decode and preprocess the images once into a memory-mappable\n";
+    std::cout << "                                shard; EngineExport picks it up from the image folder\n";
+    std::cout << "      --size <n>                Square input size (or --height/--width)\n";
+    std::cout << "      --channels <n>            Input channels (default: 3)\n";
+    std::cout << "      --batch <n>               Calibration batch size (default: 8)\n";
+    std::cout << "      --max-batches <n>         Batch limit (default: 200)\n";
+    std::cout << "      --layout <f32|u8>         f32 is read in place, u8 is 4x smaller (default: f32)\n";
+    std::cout << "      --diverse                 Shard a diverse subset of the folder (matches calib_diverse_subset)\n";
+    std::cout << "      --output <file>           Default: <image_dir>/calib_<c>x<h>x<w>_b<batch>.shard\n";
+    std::cout << "  info <file.shard>             Print a shard header\n";
+    std::cout << "  stats <dump|dir>... --output <calib.cache> [options]\n";
+    std::cout << "                                INT8 scales from activation dumps of a CPU reference run,\n";
+    std::cout << "                                written as a TensorRT calibration cache (see activation_stats.h;\n";
+    std::cout << "                                directories contribute their *.act files)\n";
+    std::cout << "      --algorithm <name>        entropy, percentile or minmax (default: entropy)\n";
+    std::cout << "      --percentile <p>          Share of values kept for percentile (default: 99.99)\n";
+    std::cout << "      --threads <n>             Worker threads (default: up to 8)\n";
+    std::cout << "      --header <text>           Cache header (default: " << CalibrationCache::defaultHeader() << ")\n";
+    std::cout << "  cache-check <calib.cache> [--onnx <model.onnx>]\n";
+    std::cout << "                                Parse a calibration cache and check its scales; with --onnx,\n";
+    std::cout << "                                fail if its tensor names belong to another model\n";
+    std::cout << "  cache-diff <a.cache> <b.cache> [--tolerance <percent>]\n";
+    std::cout << "                                Tensors only in one cache and ranges that differ (default: 1%)\n";
+    std::cout << "  cache-merge <a.cache> <b.cache>... --output <calib.cache> [--reduce max|mean]\n";
+    std::cout << "                                Combine caches from different data shards per tensor range\n";
+    std::cout << "                                (default: max); to pool histograms instead, pass all dumps to stats\n\n";
+    std::cout << "Examples:\n";
+    std::cout << "  " << program_name << " shard calibration/ --size 640 --batch 8\n";
+    std::cout << "  " << program_name << " shard frames/ --size 640 --batch 8 --max-batches 40 --diverse\n";
+    std::cout << "  " << program_name << " info calibration/calib_3x640x640_b8.shard\n";
+    std::cout << "  " << program_name << " stats activations/ --algorithm percentile --output calib.cache\n";
+    std::cout << "  " << program_name << " cache-check calib.cache --onnx yolo.onnx\n";
+}
+
+bool takeOption(std::vector<std::string>& args, const std::string& name, std::string& value) {
+    for (size_t i = 0; i < args.size(); ++i) {
+        if (args[i] != name) continue;
+        if (i + 1 >= args.size()) {
+            std::cerr << "Error: Missing value for " << name << "\n";
+            return false;
+        }
+        value = args[i + 1];
+        args.erase(args.begin() + static_cast<std::ptrdiff_t>(i), args.begin() + static_cast<std::ptrdiff_t>(i) + 2);
+        return true;
+    }
+    return true;
+}
+
+bool takeFlag(std::vector<std::string>& args, const std::string& name) {
+    auto it = std::find(args.begin(), args.end(), name);
+    if (it == args.end()) return false;
+    args.erase(it);
+    return true;
+}
+
+// Positive integer option; keeps value when the option is absent
+bool takeCount(std::vector<std::string>& args, const std::string& name, int& value) {
+    std::string text;
+    if (!takeOption(args, name, text)) return false;
+    if (text.empty()) return true;
+    if (text.size() > 7 || text.find_first_not_of("0123456789") != std::string::npos || std::stoi(text) <= 0) {
+        std::cerr << "Error: " << name << " takes a positive number\n";
+        return false;
+    }
+    value = std::stoi(text);
+    return true;
+}
+
+int runShard(std::vector<std::string> args) {
+    int size = 0, height = 0, width = 0, channels = 3, batch = 8, maxBatches = 200;
+    std::string layoutName = "f32", output;
+    bool diverse = takeFlag(args, "--diverse");
+    if (!takeCount(args, "--size", size) || !takeCount(args, "--height", height) || !takeCount(args, "--width", width) ||
+        !takeCount(args, "--channels", channels) || !takeCount(args, "--batch", batch) ||
+        !takeCount(args, "--max-batches", maxBatches) || !takeOption(args, "--layout", layoutName) ||
+        !takeOption(args, "--output", output)) {
+        return 1;
+    }
+    if (args.size() != 1 || !std::filesystem::is_directory(args[0])) {
+        std::cerr << "Error: shard expects <image_dir>\n";
+        return 1;
+    }
+    if (!height) height = size;
+    if (!width) width = size;
+    if (!height || !width) {
+        std::cerr << "Error: shard needs --size or --height and --width\n";
+        return 1;
+    }
+    if (layoutName != "f32" && layoutName != "u8") {
+        std::cerr << "Error: --layout is f32 or u8\n";
+        return 1;
+    }
+    auto layout = layoutName == "u8" ? CalibrationShard::NCHW_UINT8 : CalibrationShard::NCHW_FLOAT32;
+    if (output.empty()) {
+        output = (std::filesystem::path(args[0]) / CalibrationShard::defaultFileName(channels, height, width, batch)).string();
+    }
+
+    std::vector<std::string> images = CalibrationBatchStream::listImages(args[0]);
+    size_t imageCount = static_cast<size_t>(batch) * maxBatches;
+    if (diverse && images.size() > imageCount) {
+        float coverage = 0.0f;
+        size_t available = images.size();
+        images = CalibrationSubset::select(images, imageCount, &coverage);
+        std::cout << "Selected " << images.size() << " of " << available << " images (coverage radius " << coverage << ")\n";
+    }
+    std::cout << "Writing " << output << " (" << images.size() << " images, " << channels << "x" << height
+              << "x" << width << ", batch " << batch << ", " << layoutName << ")\n";
+    if (!CalibrationShard::write(output, images, batch, maxBatches, channels, height, width, layout)) {
+        return 1;
+    }
+    std::cout << "Shard size: " << std::fixed << std::setprecision(1)
+              << std::filesystem::file_size(output) / 1024.0 / 1024.0 << " MB\n";
+    return 0;
+}
+
+int runInfo(const std::vector<std::string>& args) {
+    if (args.size() != 1) {
+        std::cerr << "Error: info expects <file.shard>\n";
+        return 1;
+    }
+    CalibrationShard shard;
+    if (!shard.open(args[0])) return 1;
+    const CalibrationShardHeader& header = shard.header();
+    std::cout << "  Shape: " << header.batchSize << "x" << header.channels << "x" << header.height << "x" << header.width << "\n";
+    std::cout << "  Batches: " << header.batchCount << "\n";
+    std::cout << "  Layout: " << (header.layout == CalibrationShard::NCHW_UINT8 ? "NCHW uint8" : "NCHW float32") << "\n";
+    std::cout << "  Batch stride: " << header.batchStride << " bytes\n";
+    std::cout << "  Preprocessing: " << header.method << "\n";
+    std::cout << "  Source hash: " << header.sourceHash << "\n";
+    return 0;
+}
+
+int runStats(std::vector<std::string> args) {
+    std::string output, algorithmName = "entropy", percentileText, header;
+    int threads = 0;
+    if (!takeOption(args, "--output", output) || !takeOption(args, "--algorithm", algorithmName) ||
+        !takeOption(args, "--percentile", percentileText) || !takeCount(args, "--threads", threads) ||
+        !takeOption(args, "--header", header)) {
+        return 1;
+    }
+    ActivationStats::Algorithm algorithm;
+    if (!ActivationStats::parseAlgorithm(algorithmName, algorithm)) {
+        std::cerr << "Error: --algorithm is entropy, percentile or minmax\n";
+        return 1;
+    }
+    double percentile = percentileText.empty() ? 99.99 : std::stod(percentileText);
+    if (!(percentile > 0.0 && percentile <= 100.0)) {
+        std::cerr << "Error: --percentile must be in (0, 100]\n";
+        return 1;
+    }
+    if (args.empty() || output.empty()) {
+        std::cerr << "Error: stats expects <dump|dir>... --output <calib.cache>\n";
+        return 1;
+    }
+
+    std::vector<std::string> files;
+    for (const auto& arg : args) {
+        if (!std::filesystem::is_directory(arg)) {
+            files.push_back(arg);
+            continue;
+        }
+        std::vector<std::string> found;
+        for (const auto& entry : std::filesystem::directory_iterator(arg)) {
+            if (entry.is_regular_file() && entry.path().extension() == ".act") found.push_back(entry.path().string());
+        }
+        std::sort(found.begin(), found.end());
+        files.insert(files.end(), found.begin(), found.end());
+    }
+
+    ActivationStats stats;
+    if (!stats.collect(files, threads)) return 1;
+    uint64_t values = 0;
+    for (const auto& entry : stats.tensors()) values += entry.second.count;
+    std::cout << "  Dumps: " << files.size() << "\n";
+    std::cout << "  Tensors: " << stats.tensors().size() << " (" << values << " values)\n";
+
+    CalibrationCache cache = stats.makeCache(algorithm, percentile, threads);
+    if (!header.empty()) cache.header = header;
+    for (const auto& entry : stats.tensors()) {
+        if (!cache.scales.count(entry.first)) {
+            std::cout << "  Warning: " << entry.first << " is all zero, no scale written\n";
+        }
+    }
+    std::cout << "  Algorithm: " << algorithmName;
+    if (algorithm == ActivationStats::Algorithm::Percentile) std::cout << " " << percentile << "%";
+    std::cout << "\n";
+    if (!cache.saveToFile(output)) return 1;
+    std::cout << "Saved: " << output << " (" << cache.scales.size() << " scales, " << cache.header << ")\n";
+    return 0;
+}
+
+// Every tensor TensorRT can hold a scale for: runtime inputs and node outputs
+std::set<std::string> onnxTensorNames(const OnnxModel& model) {
+    std::set<std::string> names;
+    for (const OnnxValueInfo* input : model.graph.runtimeInputs()) names.insert(input->name);
+    for (const auto& node : model.graph.nodes) {
+        for (const auto& output : node.outputs) {
+            if (!output.empty()) names.insert(output);
+        }
+    }
+    return names;
+}
+
+void printNames(const std::string& label, const std::vector<std::string>& names, size_t limit = 10) {
+    std::cout << "  " << label << ": " << names.size() << "\n";
+    for (size_t i = 0; i < names.size() && i < limit; ++i) std::cout << "    " << names[i] << "\n";
+    if (names.size() > limit) std::cout << "    ... and " << (names.size() - limit) << " more\n";
+}
+
+int runCacheCheck(std::vector<std::string> args) {
+    std::string onnxPath;
+    if (!takeOption(args, "--onnx", onnxPath)) return 1;
+    if (args.size() != 1) {
+        std::cerr << "Error: cache-check expects <calib.cache>\n";
+        return 1;
+    }
+    CalibrationCache cache;
+    if (!cache.loadFromFile(args[0])) return 1;
+
+    std::set<std::string> tensorNames;
+    OnnxModel model;
+    if (!onnxPath.empty()) {
+        if (!model.loadFromFile(onnxPath)) return 1;
+        tensorNames = onnxTensorNames(model);
+    }
+    CalibrationCacheCheck check = cache.check(tensorNames);
+
+    std::cout << "  Header: " << cache.header;
+    if (!check.headerMatches) std::cout << " (this build writes " << CalibrationCache::defaultHeader() << ")";
+    std::cout << "\n";
+    float low = 0.0f, high = 0.0f;
+    for (const auto& entry : cache.scales) {
+        float amax = entry.second * 127.0f;
+        if (low == 0.0f || amax < low) low = amax;
+        high = std::max(high, amax);
+    }
+    std::cout << "  Scales: " << cache.scales.size() << " (amax " << low << " .. " << high << ")\n";
+    bool ok = check.invalid.empty();
+    if (!ok) printNames("Invalid scales", check.invalid);
+    if (!onnxPath.empty()) {
+        std::cout << "  Matched: " << check.matched << " of " << tensorNames.size() << " ONNX tensors\n";
+        if (!check.unknown.empty()) printNames("Not in the ONNX graph", check.unknown);
+        if (check.isStale()) {
+            std::cerr << "Error: " << args[0] << " does not belong to " << onnxPath << "\n";
+            ok = false;
+        }
+    }
+    if (ok) std::cout << "Cache OK\n";
+    return ok ? 0 : 1;
+}
+
+int runCacheDiff(std::vector<std::string> args) {
+    std::string toleranceText;
+    if (!takeOption(args, "--tolerance", toleranceText)) return 1;
+    double tolerance = toleranceText.empty() ? 1.0 : std::stod(toleranceText);
+    if (args.size() != 2 || !(tolerance >= 0.0)) {
+        std::cerr << "Error: cache-diff expects <a.cache> <b.cache> [--tolerance <percent>]\n";
+        return 1;
+    }
+    CalibrationCache a, b;
+    if (!a.loadFromFile(args[0]) || !b.loadFromFile(args[1])) return 1;
+
+    if (a.header != b.header) std::cout << "  Header: " << a.header << " -> " << b.header << "\n";
+    std::vector<std::string> onlyA, onlyB;
+    std::vector<std::pair<double, std::string>> changed;    // |relative change|, report line
+    for (const auto& entry : a.scales) {
+        auto other = b.scales.find(entry.first);
+        if (other == b.scales.end()) {
+            onlyA.push_back(entry.first);
+            continue;
+        }
+        double ratio = entry.second > 0.0f ? other->second / entry.second : 0.0;
+        double change = std::fabs(ratio - 1.0) * 100.0;
+        if (change > tolerance) {
+            std::ostringstream line;
+            line << entry.first << ": " << entry.second * 127.0f << " -> " << other->second * 127.0f << " ("
+                 << std::showpos << std::fixed << std::setprecision(1) << (ratio - 1.0) * 100.0 << "%)";
+            changed.emplace_back(change, line.str());
+        }
+    }
+    for (const auto& entry : b.scales) {
+        if (!a.scales.count(entry.first)) onlyB.push_back(entry.first);
+    }
+    std::sort(changed.begin(), changed.end(), [](const auto& x, const auto& y) { return x.first > y.first; });
+
+    size_t shared = a.scales.size() - onlyA.size();
+    std::cout << "  Shared tensors: " << shared << "\n";
+    if (!onlyA.empty()) printNames("Only in " + args[0], onlyA);
+    if (!onlyB.empty()) printNames("Only in " + args[1], onlyB);
+    std::vector<std::string> lines;
+    for (const auto& item : changed) lines.push_back(item.second);
+    std::ostringstream label;
+    label << "Ranges differing by more than " << tolerance << "%";
+    printNames(label.str(), lines, 20);
+    return 0;
+}
+
+int runCacheMerge(std::vector<std::string> args) {
+    std::string output, reduce = "max";
+    if (!takeOption(args, "--output", output) || !takeOption(args, "--reduce", reduce)) return 1;
+    if (args.size() < 2 || output.empty() || (reduce != "max" && reduce != "mean")) {
+        std::cerr << "Error: cache-merge expects <a.cache> <b.cache>... --output <calib.cache> [--reduce max|mean]\n";
+        return 1;
+    }
+
+    CalibrationCache merged;
+    std::map<std::string, int> contributions;
+    for (const auto& path : args) {
+        CalibrationCache cache;
+        if (!cache.loadFromFile(path)) return 1;
+        if (merged.header.empty()) {
+            merged.header = cache.header;
+        } else if (cache.header != merged.header) {
+            std::cout << "  Warning: " << path << " has header " << cache.header << ", keeping " << merged.header << "\n";
+        }
+        for (const auto& entry : cache.scales) {
+            float& scale = merged.scales[entry.first];
+            int& count = contributions[entry.first];
+            scale = reduce == "max" ? std::max(scale, entry.second) : scale + entry.second;
+            ++count;
+        }
+    }
+    size_t partial = 0;
+    for (auto& entry : merged.scales) {
+        int count = contributions[entry.first];
+        if (reduce == "mean") entry.second /= static_cast<float>(count);
+        if (count < static_cast<int>(args.size())) ++partial;
+    }
+    if (partial) std::cout << "  Warning: " << partial << " tensors are missing from some caches\n";
+    if (!merged.saveToFile(output)) return 1;
+    std::cout << "Saved: " << output << " (" << merged.scales.size() << " scales from " << args.size()
+              << " caches, " << reduce << ")\n";
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> args(argv, argv + argc);
+    if (argc < 2 || args[1] == "--help" || args[1] == "-h") {
+        printUsage(args[0]);
+        return argc < 2 ? 1 : 0;
+    }
+    std::string command = args[1];
+    std::vector<std::string> rest(args.begin() + 2, args.end());
+
+    try {
+        if (command == "shard") return runShard(rest);
+        if (command == "info") return runInfo(rest);
+        if (command == "stats") return runStats(rest);
+        if (command == "cache-check") return runCacheCheck(rest);
+        if (command == "cache-diff") return runCacheDiff(rest);
+        if (command == "cache-merge") return runCacheMerge(rest);
+        std::cerr << "Error: Unknown command: " << command << "\n";
+        printUsage(args[0]);
+        return 1;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
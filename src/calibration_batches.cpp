@@ -0,0 +1,105 @@
+#include "calibration_batches.h"
+#include "image_preprocess.h"
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <iostream>
+
+CalibrationBatchStream::CalibrationBatchStream(std::vector<std::string> images, int batchSize, int maxBatches,
+                                               int channels, int height, int width, int threads, int ringSize)
+    : m_images(std::move(images)), m_batchSize(std::max(1, batchSize)), m_channels(channels),
+      m_height(height), m_width(width) {
+    m_batchCount = static_cast<int>(std::min<size_t>(std::max(0, maxBatches), m_images.size() / m_batchSize));
+    m_images.resize(static_cast<size_t>(m_batchCount) * m_batchSize);
+    m_imageFloats = static_cast<size_t>(channels) * height * width;
+    if (m_batchCount == 0) return;
+
+    int slots = std::max(1, std::min(ringSize, m_batchCount));
+    m_ring.assign(slots, std::vector<float>(batchFloats()));
+    m_slotFilled.assign(slots, 0);
+
+    if (threads <= 0) {
+        threads = static_cast<int>(std::min(8u, std::max(1u, std::thread::hardware_concurrency())));
+    }
+    threads = std::min<int>(threads, static_cast<int>(m_images.size()));
+    for (int i = 0; i < threads; ++i) {
+        m_threads.emplace_back(&CalibrationBatchStream::decodeLoop, this);
+    }
+}
+
+CalibrationBatchStream::~CalibrationBatchStream() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_slotFreed.notify_all();
+    for (auto& thread : m_threads) thread.join();
+}
+
+std::vector<std::string> CalibrationBatchStream::listImages(const std::string& dir) {
+    std::vector<std::string> images;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+        if (!entry.is_regular_file(ec)) continue;
+        std::string ext = entry.path().extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        if (ext == ".jpg" || ext == ".jpeg" || ext == ".png" || ext == ".bmp") {
+            images.push_back(entry.path().string());
+        }
+    }
+    std::sort(images.begin(), images.end());
+    return images;
+}
+
+void CalibrationBatchStream::decodeLoop() {
+    ImagePreprocessor preprocessor;
+    preprocessor.setOutputSize(m_channels, m_height, m_width);
+    std::vector<unsigned char> pixels;
+    const int slots = static_cast<int>(m_ring.size());
+
+    while (true) {
+        size_t index;
+        int slot;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (m_stopping || m_nextImage >= m_images.size()) return;
+            index = m_nextImage++;
+            int batch = static_cast<int>(index / m_batchSize);
+            // The slot is reused once next() has moved past the batch that held it
+            m_slotFreed.wait(lock, [&]() { return m_stopping || batch < m_releasedBatches + slots; });
+            if (m_stopping) return;
+            slot = batch % slots;
+        }
+
+        float* output = m_ring[slot].data() + (index % m_batchSize) * m_imageFloats;
+        int width = 0, height = 0, channels = 0;
+        if (ImagePreprocessor::loadImage(m_images[index], pixels, width, height, channels)) {
+            preprocessor.run(pixels.data(), width, height, channels, output);
+        } else {
+            std::cerr << "Warning: Cannot decode calibration image, using zeros: " << m_images[index] << "\n";
+            std::fill(output, output + m_imageFloats, 0.0f);
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (++m_slotFilled[slot] == m_batchSize) {
+            m_batchReady.notify_all();
+        }
+    }
+}
+
+const float* CalibrationBatchStream::next() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    const int slots = static_cast<int>(m_ring.size());
+    if (m_nextBatch > 0) {
+        // The batch handed out last time is done with
+        m_slotFilled[(m_nextBatch - 1) % slots] = 0;
+        m_releasedBatches = m_nextBatch;
+        m_slotFreed.notify_all();
+    }
+    if (m_nextBatch >= m_batchCount) return nullptr;
+
+    int slot = m_nextBatch % slots;
+    m_batchReady.wait(lock, [&]() { return m_slotFilled[slot] == m_batchSize; });
+    ++m_nextBatch;
+    return m_ring[slot].data();
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Calibration input, one preprocessed NCHW float batch at a time
+class CalibrationBatchSource {
+public:
+    virtual ~CalibrationBatchSource() = default;
+
+    virtual int batchCount() const = 0;
+    virtual size_t batchFloats() const = 0;
+    // Next batch (batchFloats() values), valid until the following call;
+    // nullptr once every batch has been handed out
+    virtual const float* next() = 0;
+};
+
+// Preprocessed calibration batches, produced ahead of the consumer.
+//
+// A decoder pool walks the image list in order and writes each image straight
+// into its batch slot of a small ring. next() hands out complete batches in
+// order and only waits when decoding has fallen behind the calibrator.
+class CalibrationBatchStream : public CalibrationBatchSource {
+public:
+    // Images are used in list order; a trailing partial batch is dropped
+    CalibrationBatchStream(std::vector<std::string> images, int batchSize, int maxBatches,
+                           int channels, int height, int width, int threads = 0, int ringSize = 4);
+    ~CalibrationBatchStream() override;
+
+    CalibrationBatchStream(const CalibrationBatchStream&) = delete;
+    CalibrationBatchStream& operator=(const CalibrationBatchStream&) = delete;
+
+    // Sorted .jpg/.jpeg/.png/.bmp files directly in dir
+    static std::vector<std::string> listImages(const std::string& dir);
+
+    int batchCount() const override { return m_batchCount; }
+    size_t batchFloats() const override { return m_imageFloats * static_cast<size_t>(m_batchSize); }
+    const float* next() override;
+
+private:
+    void decodeLoop();
+
+    std::vector<std::string> m_images;
+    int m_batchSize;
+    int m_batchCount;
+    int m_channels;
+    int m_height;
+    int m_width;
+    size_t m_imageFloats;
+
+    std::vector<std::vector<float>> m_ring;
+    std::vector<int> m_slotFilled;    // images written into each slot's current batch
+
+    std::mutex m_mutex;
+    std::condition_variable m_batchReady;
+    std::condition_variable m_slotFreed;
+    size_t m_nextImage = 0;           // next image to hand to a decoder
+    int m_nextBatch = 0;              // next batch next() returns
+    int m_releasedBatches = 0;        // batches whose slot may be overwritten
+    bool m_stopping = false;
+    std::vector<std::thread> m_threads;
+};
@@ -0,0 +1,116 @@
+#include "calibration_cache.h"
+#include "file_utils.h"
+#include <NvInferVersion.h>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+bool parseHexFloat(const std::string& hex, float& value) {
+    if (hex.empty() || hex.size() > 8) return false;
+    uint32_t bits = 0;
+    for (char c : hex) {
+        bits <<= 4;
+        if (c >= '0' && c <= '9') bits |= static_cast<uint32_t>(c - '0');
+        else if (c >= 'a' && c <= 'f') bits |= static_cast<uint32_t>(c - 'a' + 10);
+        else if (c >= 'A' && c <= 'F') bits |= static_cast<uint32_t>(c - 'A' + 10);
+        else return false;
+    }
+    std::memcpy(&value, &bits, sizeof(value));
+    return true;
+}
+
+std::string trim(const std::string& s) {
+    size_t begin = s.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos) return "";
+    size_t end = s.find_last_not_of(" \t\r\n");
+    return s.substr(begin, end - begin + 1);
+}
+
+} // namespace
+
+bool CalibrationCache::loadFromFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Error: Cannot open calibration cache: " << path << "\n";
+        return false;
+    }
+    std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (!loadFromString(text)) {
+        std::cerr << "Error: Invalid calibration cache: " << path << "\n";
+        return false;
+    }
+    return true;
+}
+
+bool CalibrationCache::loadFromString(const std::string& text) {
+    header.clear();
+    scales.clear();
+    std::istringstream in(text);
+    std::string line;
+    while (std::getline(in, line)) {
+        line = trim(line);
+        if (line.empty()) continue;
+        if (header.empty()) {
+            if (line.compare(0, 4, "TRT-") != 0) return false;
+            header = line;
+            continue;
+        }
+        // Tensor names may themselves contain ':' so split on the last one
+        size_t colon = line.rfind(':');
+        if (colon == std::string::npos) return false;
+        float scale = 0.0f;
+        if (!parseHexFloat(trim(line.substr(colon + 1)), scale)) return false;
+        scales[trim(line.substr(0, colon))] = scale;
+    }
+    return !header.empty();
+}
+
+std::string CalibrationCache::toString() const {
+    std::string text = header + "\n";
+    char hex[16];
+    for (const auto& entry : scales) {
+        uint32_t bits = 0;
+        std::memcpy(&bits, &entry.second, sizeof(bits));
+        std::snprintf(hex, sizeof(hex), "%08x", bits);
+        text += entry.first + ": " + hex + "\n";
+    }
+    return text;
+}
+
+bool CalibrationCache::saveToFile(const std::string& path) const {
+    // The exporter may read this cache while a tool rewrites it: never expose a partial file
+    std::string text = toString();
+    return writeFileAtomic(path, text.data(), text.size());
+}
+
+float CalibrationCache::amax(const std::string& tensorName) const {
+    auto it = scales.find(tensorName);
+    return it == scales.end() ? 0.0f : it->second * 127.0f;
+}
+
+CalibrationCacheCheck CalibrationCache::check(const std::set<std::string>& tensorNames) const {
+    CalibrationCacheCheck result;
+    result.headerMatches = header == defaultHeader();
+    for (const auto& entry : scales) {
+        if (!std::isfinite(entry.second) || entry.second <= 0.0f) result.invalid.push_back(entry.first);
+        if (tensorNames.count(entry.first)) {
+            ++result.matched;
+        } else if (entry.first.compare(0, 14, "(Unnamed Layer") != 0) {
+            result.unknown.push_back(entry.first);
+        }
+    }
+    result.uncovered = tensorNames.size() - result.matched;
+    return result;
+}
+
+std::string CalibrationCache::defaultHeader() {
+    // Same version number as getInferLibVersion(); the calibrator is IInt8EntropyCalibrator2
+    long version = NV_TENSORRT_MAJOR * 10000L + NV_TENSORRT_MINOR * 100L + NV_TENSORRT_PATCH;
+    return "TRT-" + std::to_string(version) + "-EntropyCalibration2";
+}
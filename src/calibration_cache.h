@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+// How well a cache fits a network's tensor names
+struct CalibrationCacheCheck {
+    size_t matched = 0;                 // scales for tensors the network has
+    size_t uncovered = 0;               // network tensors without a scale (not all need one)
+    std::vector<std::string> unknown;   // scales for tensors the network does not have
+    std::vector<std::string> invalid;   // scales that are not finite positive numbers
+    bool headerMatches = true;          // written by this TensorRT version's entropy calibrator
+
+    // Most names foreign to the network: a cache from another model or export
+    bool isStale() const { return matched == 0 || unknown.size() > matched; }
+};
+
+// TensorRT INT8 calibration cache (text format written by IInt8Calibrator):
+//
+//   TRT-100100-EntropyCalibration2
+//   images: 3c010a14
+//   /model.0/conv/Conv_output_0: 3d8f5c29
+//
+// Each value is the big-endian hex of an IEEE-754 float: the per-tensor
+// INT8 scale, i.e. amax / 127.
+struct CalibrationCache {
+    std::string header;                     // e.g. "TRT-100100-EntropyCalibration2"
+    std::map<std::string, float> scales;    // tensor name -> INT8 scale
+
+    bool loadFromFile(const std::string& path);
+    bool loadFromString(const std::string& text);
+    bool saveToFile(const std::string& path) const;
+    std::string toString() const;
+
+    // amax implied by the INT8 scale, 0 if the tensor has no entry
+    float amax(const std::string& tensorName) const;
+
+    // Builder-generated "(Unnamed Layer* N)" entries are neither matched nor unknown
+    CalibrationCacheCheck check(const std::set<std::string>& tensorNames) const;
+
+    // "TRT-<version>-EntropyCalibration2" for the TensorRT release the tree builds against
+    static std::string defaultHeader();
+};
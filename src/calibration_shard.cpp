@@ -0,0 +1,167 @@
+#include "calibration_shard.h"
+#include "image_preprocess.h"
+#include "sha256.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace {
+
+const char kMagic[8] = {'E', 'X', 'C', 'A', 'L', 'S', 'H', '1'};
+const uint32_t kVersion = 1;
+
+size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+size_t elementSize(uint32_t layout) {
+    return layout == CalibrationShard::NCHW_UINT8 ? 1 : sizeof(float);
+}
+
+} // namespace
+
+bool CalibrationShard::write(const std::string& path, const std::vector<std::string>& images, int batchSize,
+                             int maxBatches, int channels, int height, int width, Layout layout) {
+    CalibrationBatchStream batches(images, batchSize, maxBatches, channels, height, width);
+    if (batches.batchCount() == 0) {
+        std::cerr << "Error: Need at least " << batchSize << " images for one batch, found " << images.size() << "\n";
+        return false;
+    }
+
+    CalibrationShardHeader header = {};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.layout = layout;
+    header.channels = static_cast<uint32_t>(channels);
+    header.height = static_cast<uint32_t>(height);
+    header.width = static_cast<uint32_t>(width);
+    header.batchSize = static_cast<uint32_t>(batchSize);
+    header.batchCount = static_cast<uint32_t>(batches.batchCount());
+    header.batchStride = alignUp(batches.batchFloats() * elementSize(layout), kDataAlignment);
+    header.dataOffset = alignUp(sizeof(CalibrationShardHeader), kDataAlignment);
+    std::strncpy(header.method, ImagePreprocessor::kMethod, sizeof(header.method) - 1);
+    std::strncpy(header.sourceHash, sourceHash(images).c_str(), sizeof(header.sourceHash) - 1);
+
+    // Shards run to gigabytes, so stream them through AtomicFileWriter: a crash
+    // or a concurrent writer never leaves a torn shard under path
+    AtomicFileWriter file(path);
+    if (!file.isOpen()) return false;
+    std::vector<char> block(header.dataOffset, 0);
+    std::memcpy(block.data(), &header, sizeof(header));
+    file.write(block.data(), block.size());
+
+    block.assign(header.batchStride, 0);
+    for (int i = 0; i < batches.batchCount(); ++i) {
+        const float* batch = batches.next();
+        if (layout == NCHW_UINT8) {
+            for (size_t k = 0; k < batches.batchFloats(); ++k) {
+                block[k] = static_cast<char>(static_cast<uint8_t>(std::lround(batch[k] * 255.0f)));
+            }
+        } else {
+            std::memcpy(block.data(), batch, batches.batchFloats() * sizeof(float));
+        }
+        if (!file.write(block.data(), block.size())) break;
+        if ((i + 1) % 20 == 0 || i + 1 == batches.batchCount()) {
+            std::cout << "  Batch " << (i + 1) << "/" << batches.batchCount() << "\n";
+        }
+    }
+    return file.commit();
+}
+
+std::string CalibrationShard::sourceHash(const std::vector<std::string>& images) {
+    // By content: a re-exported image of the same size must not reuse stale batches
+    Sha256 hash;
+    for (const auto& image : images) {
+        hash.update(std::filesystem::path(image).filename().string() + "\n" + Sha256::hashFile(image) + "\n");
+    }
+    return hash.hexDigest();
+}
+
+std::string CalibrationShard::defaultFileName(int channels, int height, int width, int batchSize) {
+    return "calib_" + std::to_string(channels) + "x" + std::to_string(height) + "x" + std::to_string(width) +
+           "_b" + std::to_string(batchSize) + ".shard";
+}
+
+std::string CalibrationShard::findInFolder(const std::string& dir, const std::vector<std::string>& images,
+                                           int channels, int height, int width, int batchSize, int minBatches) {
+    std::string hash = sourceHash(images);
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+        if (entry.path().extension() != ".shard" || !entry.is_regular_file(ec)) continue;
+        CalibrationShardHeader header = {};
+        std::ifstream file(entry.path(), std::ios::binary);
+        if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) continue;
+        if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion) continue;
+        header.sourceHash[sizeof(header.sourceHash) - 1] = '\0';
+        header.method[sizeof(header.method) - 1] = '\0';
+        if (header.channels == static_cast<uint32_t>(channels) && header.height == static_cast<uint32_t>(height) &&
+            header.width == static_cast<uint32_t>(width) && header.batchSize == static_cast<uint32_t>(batchSize) &&
+            header.batchCount >= static_cast<uint32_t>(std::max(minBatches, 1)) && hash == header.sourceHash && std::strcmp(header.method, ImagePreprocessor::kMethod) == 0) {
+            return entry.path().string();
+        }
+    }
+    return "";
+}
+
+bool CalibrationShard::open(const std::string& path) {
+    m_nextBatch = 0;
+    m_batchLimit = 0;
+    if (!m_file.open(path)) return false;
+
+    if (m_file.size() < sizeof(CalibrationShardHeader)) {
+        std::cerr << "Error: Not a calibration shard: " << path << "\n";
+        return false;
+    }
+    std::memcpy(&m_header, m_file.data(), sizeof(m_header));
+    m_header.method[sizeof(m_header.method) - 1] = '\0';
+    m_header.sourceHash[sizeof(m_header.sourceHash) - 1] = '\0';
+    if (std::memcmp(m_header.magic, kMagic, sizeof(kMagic)) != 0 || m_header.version != kVersion) {
+        std::cerr << "Error: Not a calibration shard (or unsupported version): " << path << "\n";
+        return false;
+    }
+    if (m_header.layout != NCHW_FLOAT32 && m_header.layout != NCHW_UINT8) {
+        std::cerr << "Error: Unknown calibration shard layout " << m_header.layout << ": " << path << "\n";
+        return false;
+    }
+    if (std::strcmp(m_header.method, ImagePreprocessor::kMethod) != 0) {
+        std::cerr << "Error: Calibration shard was preprocessed with '" << m_header.method << "', runtime uses '"
+                  << ImagePreprocessor::kMethod << "': " << path << "\n";
+        return false;
+    }
+    uint64_t needed = m_header.dataOffset + static_cast<uint64_t>(m_header.batchCount) * m_header.batchStride;
+    if (m_header.dataOffset % kDataAlignment != 0 || m_header.batchStride < batchFloats() * elementSize(m_header.layout) ||
+        m_file.size() < needed) {
+        std::cerr << "Error: Calibration shard is truncated or corrupt: " << path << "\n";
+        return false;
+    }
+
+    m_batchLimit = static_cast<int>(m_header.batchCount);
+    return true;
+}
+
+void CalibrationShard::setBatchLimit(int limit) {
+    m_batchLimit = std::max(0, std::min(limit, static_cast<int>(m_header.batchCount)));
+}
+
+size_t CalibrationShard::batchFloats() const {
+    return static_cast<size_t>(m_header.batchSize) * m_header.channels * m_header.height * m_header.width;
+}
+
+const float* CalibrationShard::next() {
+    if (m_nextBatch >= m_batchLimit) return nullptr;
+    const unsigned char* batch = m_file.data() + m_header.dataOffset + m_nextBatch * m_header.batchStride;
+    ++m_nextBatch;
+
+    if (m_header.layout == NCHW_FLOAT32) {
+        return reinterpret_cast<const float*>(batch);
+    }
+    const float inv255 = 1.0f / 255.0f;
+    m_converted.resize(batchFloats());
+    for (size_t i = 0; i < m_converted.size(); ++i) {
+        m_converted[i] = batch[i] * inv255;
+    }
+    return m_converted.data();
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "calibration_batches.h"
+#include "file_utils.h"
+
+// On-disk header of a calibration shard, at offset 0 and zero padded to kDataAlignment
+struct CalibrationShardHeader {
+    char magic[8];              // "EXCALSH1"
+    uint32_t version;           // 1
+    uint32_t layout;            // CalibrationShard::Layout
+    uint32_t channels;
+    uint32_t height;
+    uint32_t width;
+    uint32_t batchSize;
+    uint32_t batchCount;
+    uint32_t reserved;
+    uint64_t batchStride;       // bytes from one batch to the next, a multiple of kDataAlignment
+    uint64_t dataOffset;        // first batch
+    char method[32];            // ImagePreprocessor::kMethod at write time
+    char sourceHash[72];        // sourceHash() of the image folder, hex
+};
+
+// Preprocessed calibration batches in one file, read back through a memory
+// mapping: next() returns pointers into the mapping, so repeated calibration
+// runs cost page-cache reads instead of image decoding. One shard holds one
+// input size, channel count and batch size.
+//
+// Layout: header, then batchCount batches at dataOffset + i * batchStride,
+// each batchSize x channels x height x width values (NCHW). Float32 batches
+// are handed out in place; uint8 batches (value * 255, exact for this
+// preprocessing) are 4x smaller and converted into a buffer on read.
+class CalibrationShard : public CalibrationBatchSource {
+public:
+    enum Layout : uint32_t {
+        NCHW_FLOAT32 = 0,
+        NCHW_UINT8 = 1,
+    };
+    static constexpr size_t kDataAlignment = 4096;
+
+    // Decodes images (in order, up to maxBatches full batches) and writes path atomically
+    static bool write(const std::string& path, const std::vector<std::string>& images, int batchSize,
+                      int maxBatches, int channels, int height, int width, Layout layout = NCHW_FLOAT32);
+
+    // SHA-256 over the file names and contents of images, to notice a changed folder
+    static std::string sourceHash(const std::vector<std::string>& images);
+    // e.g. "calib_3x640x640_b8.shard"
+    static std::string defaultFileName(int channels, int height, int width, int batchSize);
+    // A *.shard in dir written from these images with this shape and at least
+    // minBatches batches; empty if none (a shorter shard would calibrate on less data)
+    static std::string findInFolder(const std::string& dir, const std::vector<std::string>& images,
+                                    int channels, int height, int width, int batchSize, int minBatches);
+
+    // Maps path and checks the header; prints an error and returns false if it is not a usable shard
+    bool open(const std::string& path);
+    const CalibrationShardHeader& header() const { return m_header; }
+    // Hands out at most limit batches
+    void setBatchLimit(int limit);
+
+    int batchCount() const override { return m_batchLimit; }
+    size_t batchFloats() const override;
+    const float* next() override;
+
+private:
+    MappedFile m_file;
+    CalibrationShardHeader m_header = {};
+    int m_batchLimit = 0;
+    int m_nextBatch = 0;
+    std::vector<float> m_converted;     // NCHW_UINT8 only
+};
@@ -0,0 +1,182 @@
+#include "calibration_subset.h"
+#include "image_preprocess.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <thread>
+
+namespace {
+
+constexpr int kThumb = 32;
+constexpr int kColorBins = 4;       // per channel, joint RGB histogram
+constexpr int kOrientationBins = 8; // per quadrant, unsigned orientation
+constexpr int kLanes = 8;
+static_assert(CalibrationSubset::kDescriptorSize % kLanes == 0, "descriptor must split into whole lanes");
+
+// Squared L2 distance. Independent partial sums keep the loop free of a serial
+// dependency, so it compiles to packed SSE/AVX arithmetic without fast-math.
+float distance2(const float* a, const float* b) {
+    float lanes[kLanes] = {};
+    for (int i = 0; i < CalibrationSubset::kDescriptorSize; i += kLanes) {
+        for (int j = 0; j < kLanes; ++j) {
+            float d = a[i + j] - b[i + j];
+            lanes[j] += d * d;
+        }
+    }
+    float sum = 0.0f;
+    for (float lane : lanes) sum += lane;
+    return sum;
+}
+
+} // namespace
+
+bool CalibrationSubset::describe(const std::string& path, float* descriptor) {
+    std::vector<unsigned char> pixels;
+    int width = 0, height = 0, channels = 0;
+    if (!ImagePreprocessor::loadImage(path, pixels, width, height, channels) || width <= 0 || height <= 0) {
+        return false;
+    }
+
+    // Box-filtered RGB thumbnail; grey (and grey+alpha) images repeat their first channel
+    float thumb[3][kThumb * kThumb];
+    int offsets[3] = {0, channels >= 3 ? 1 : 0, channels >= 3 ? 2 : 0};
+    for (int ty = 0; ty < kThumb; ++ty) {
+        int y0 = ty * height / kThumb;
+        int y1 = std::max(y0 + 1, (ty + 1) * height / kThumb);
+        for (int tx = 0; tx < kThumb; ++tx) {
+            int x0 = tx * width / kThumb;
+            int x1 = std::max(x0 + 1, (tx + 1) * width / kThumb);
+            uint32_t sums[3] = {};
+            for (int y = y0; y < y1; ++y) {
+                const unsigned char* row = pixels.data() + static_cast<size_t>(y) * width * channels;
+                for (int x = x0; x < x1; ++x) {
+                    const unsigned char* p = row + static_cast<size_t>(x) * channels;
+                    sums[0] += p[offsets[0]];
+                    sums[1] += p[offsets[1]];
+                    sums[2] += p[offsets[2]];
+                }
+            }
+            float area = static_cast<float>((y1 - y0) * (x1 - x0));
+            for (int c = 0; c < 3; ++c) thumb[c][ty * kThumb + tx] = sums[c] / area;
+        }
+    }
+
+    std::fill(descriptor, descriptor + kDescriptorSize, 0.0f);
+    float* color = descriptor;
+    float* gradient = descriptor + kColorBins * kColorBins * kColorBins;
+
+    const float pixelWeight = 1.0f / (kThumb * kThumb);
+    float luma[kThumb * kThumb];
+    for (int i = 0; i < kThumb * kThumb; ++i) {
+        int bin = 0;
+        for (int c = 0; c < 3; ++c) {
+            bin = bin * kColorBins + std::min(kColorBins - 1, static_cast<int>(thumb[c][i]) * kColorBins / 256);
+        }
+        color[bin] += pixelWeight;
+        luma[i] = (0.299f * thumb[0][i] + 0.587f * thumb[1][i] + 0.114f * thumb[2][i]) / 255.0f;
+    }
+
+    const float pi = 3.14159265f;
+    float totalMagnitude = 0.0f;
+    for (int y = 1; y < kThumb - 1; ++y) {
+        for (int x = 1; x < kThumb - 1; ++x) {
+            float gx = luma[y * kThumb + x + 1] - luma[y * kThumb + x - 1];
+            float gy = luma[(y + 1) * kThumb + x] - luma[(y - 1) * kThumb + x];
+            float magnitude = std::sqrt(gx * gx + gy * gy);
+            if (magnitude <= 0.0f) continue;
+            float angle = std::atan2(gy, gx);
+            if (angle < 0.0f) angle += pi;
+            int bin = std::min(kOrientationBins - 1, static_cast<int>(angle / pi * kOrientationBins));
+            int quadrant = (y >= kThumb / 2 ? 2 : 0) + (x >= kThumb / 2 ? 1 : 0);
+            gradient[quadrant * kOrientationBins + bin] += magnitude;
+            totalMagnitude += magnitude;
+        }
+    }
+    if (totalMagnitude > 1e-6f) {
+        for (int i = 0; i < 4 * kOrientationBins; ++i) gradient[i] /= totalMagnitude;
+    }
+    return true;
+}
+
+std::vector<std::string> CalibrationSubset::select(const std::vector<std::string>& images, size_t count,
+                                                   float* coverage, int threads) {
+    if (coverage) *coverage = 0.0f;
+    if (count >= images.size()) return images;
+
+    const size_t n = images.size();
+    std::vector<float> descriptors(n * kDescriptorSize);
+    std::vector<char> valid(n, 0);
+
+    if (threads <= 0) {
+        threads = static_cast<int>(std::min(8u, std::max(1u, std::thread::hardware_concurrency())));
+    }
+    std::atomic<size_t> nextImage{0};
+    auto describeLoop = [&]() {
+        for (size_t i = nextImage++; i < n; i = nextImage++) {
+            valid[i] = describe(images[i], descriptors.data() + i * kDescriptorSize) ? 1 : 0;
+        }
+    };
+    std::vector<std::thread> pool;
+    for (int i = 0; i < std::min<int>(threads, static_cast<int>(n)); ++i) pool.emplace_back(describeLoop);
+    for (auto& thread : pool) thread.join();
+
+    std::vector<size_t> candidates;
+    for (size_t i = 0; i < n; ++i) {
+        if (valid[i]) {
+            candidates.push_back(i);
+        } else {
+            std::cerr << "Warning: Cannot decode calibration image, not selected: " << images[i] << "\n";
+        }
+    }
+    if (candidates.size() <= count) {
+        std::vector<std::string> subset;
+        for (size_t i : candidates) subset.push_back(images[i]);
+        return subset;
+    }
+
+    // Seed with the image nearest the mean descriptor, the most typical frame
+    std::vector<float> mean(kDescriptorSize, 0.0f);
+    for (size_t i : candidates) {
+        const float* d = descriptors.data() + i * kDescriptorSize;
+        for (int k = 0; k < kDescriptorSize; ++k) mean[k] += d[k];
+    }
+    for (float& value : mean) value /= static_cast<float>(candidates.size());
+    size_t current = candidates.front();
+    float best = std::numeric_limits<float>::max();
+    for (size_t i : candidates) {
+        float d = distance2(descriptors.data() + i * kDescriptorSize, mean.data());
+        if (d < best) {
+            best = d;
+            current = i;
+        }
+    }
+
+    // Farthest-point traversal: each pick is the image worst covered by the picks so far
+    std::vector<float> nearest(n, std::numeric_limits<float>::max());
+    std::vector<char> chosen(n, 0);
+    float radius = 0.0f;
+    for (size_t picked = 0; picked < count; ++picked) {
+        chosen[current] = 1;
+        const float* center = descriptors.data() + current * kDescriptorSize;
+        size_t farthest = current;
+        radius = -1.0f;
+        for (size_t i : candidates) {
+            if (chosen[i]) continue;
+            nearest[i] = std::min(nearest[i], distance2(descriptors.data() + i * kDescriptorSize, center));
+            if (nearest[i] > radius) {
+                radius = nearest[i];
+                farthest = i;
+            }
+        }
+        current = farthest;
+    }
+    if (coverage) *coverage = std::sqrt(std::max(0.0f, radius));
+
+    std::vector<std::string> subset;
+    for (size_t i = 0; i < n; ++i) {
+        if (chosen[i]) subset.push_back(images[i]);
+    }
+    return subset;
+}
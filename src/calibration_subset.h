@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Picks a small, diverse calibration set from a folder of mostly similar
+// images (e.g. frames from the same videos), so fewer batches cover the same
+// range of activations.
+//
+// Each image is reduced to a cheap descriptor: a 4x4x4 RGB colour histogram
+// and 8 gradient-orientation bins in each quadrant of a 32x32 thumbnail,
+// both normalized to sum 1. The subset is then chosen greedily as a k-center
+// cover: start from the most typical image and repeatedly add the image
+// farthest from everything chosen so far.
+class CalibrationSubset {
+public:
+    static constexpr int kDescriptorSize = 64 + 32;
+
+    // Writes kDescriptorSize floats; false if the image cannot be decoded
+    static bool describe(const std::string& path, float* descriptor);
+
+    // Up to count images, returned in list order. Undecodable images are never
+    // chosen; if count covers every image the list is returned unchanged.
+    // coverage receives the largest descriptor distance from any image to the subset.
+    static std::vector<std::string> select(const std::vector<std::string>& images, size_t count,
+                                           float* coverage = nullptr, int threads = 0);
+};
@@ -0,0 +1,476 @@
+#include "command_line.h"
+#include "build_daemon.h"
+#include "config.h"
+#include "engine_container.h"
+#include "engine_exporter.h"
+#include "json.h"
+#include "precision_search_backend.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct BuildJob {
+    std::string name;
+    ExportConfig config;
+    std::vector<BuildVariant> variants;   // empty = single export
+    bool success = false;
+    double seconds = 0.0;
+};
+
+void printUsage(const std::string& program) {
+    std::cout << "Usage:\n";
+    std::cout << "  " << program << "                                   Open the GUI (if built with it)\n";
+    std::cout << "  " << program << " <input.onnx> [settings]           Build one engine\n";
+    std::cout << "  " << program << " --manifest <jobs.json> [settings] Build every job in a manifest\n\n";
+    std::cout << "Options:\n";
+    std::cout << "  -h, --help                      Show this help message\n";
+    std::cout << "  -v, --version                   Show version information\n";
+    std::cout << "  --manifest <jobs.json>          Job manifest (see below)\n";
+    std::cout << "  --workers <n>                   Concurrent builds (default: manifest \"workers\", else 1)\n";
+    std::cout << "  --matrix-resolutions <list>     Build matrix for a single input, e.g. 320,640\n";
+    std::cout << "  --matrix-precisions <list>      e.g. fp16,fp16+fp8,int8 (default: from settings)\n";
+    std::cout << "  --matrix-profiles <list>        e.g. static,1-4-8 (default: static)\n";
+    std::cout << "  --serve <socket>                Run the build daemon on a UNIX-domain socket\n";
+    std::cout << "  --submit <socket>               Send the export to a running daemon and stream its output\n";
+    std::cout << "  --priority <p>                  With --submit: interactive, normal (default), nightly or a number\n";
+    std::cout << "  --daemon-status <socket>        Show queued and running daemon builds\n";
+    std::cout << "  --engine-info <file.engine>     Print the metadata of an engine container (no GPU needed)\n";
+    std::cout << "  --precision-search <clip>       Search per-layer precisions against FP32 on a video or image folder,\n";
+    std::cout << "                                  write <output>.precision.json and build the engine with it\n";
+    std::cout << "  --search-targets <list>         Precisions to lower layers to, in order (default: fp16,int8)\n";
+    std::cout << "  --search-min-f1 <x>             Detection F1 against FP32 to keep (default: 0.98)\n";
+    std::cout << "  --search-min-iou <x>            Mean IoU of matched boxes to keep (default: 0.9)\n";
+    std::cout << "  --search-max-builds <n>         Candidate builds, FP32 baseline included (default: 64)\n";
+    std::cout << "  --search-frames <n>             Validation frames (default: 100)\n\n";
+    ConfigParser::printOptions();
+    std::cout << "\nManifest:\n";
+    std::cout << "  {\"workers\": 2,\n";
+    std::cout << "   \"defaults\": {\"workspace_mb\": 4096, \"timing_cache_dir\": \"timing_cache\"},\n";
+    std::cout << "   \"jobs\": [{\"name\": \"det320\", \"input_onnx_path\": \"det.onnx\", \"input_resolution\": 320},\n";
+    std::cout << "            {\"input_onnx_path\": \"cls.onnx\",\n";
+    std::cout << "             \"matrix\": {\"resolutions\": \"320,640\", \"precisions\": \"fp16,int8\"}}]}\n";
+    std::cout << "  Jobs start from \"defaults\"; command-line settings override both.\n";
+    std::cout << "  Relative paths are resolved against the working directory.\n\n";
+    std::cout << "Exit status: 0 all jobs succeeded, 1 a job failed, 2 bad usage or manifest\n";
+}
+
+bool takeOption(std::vector<std::string>& args, const std::string& name, std::string& value) {
+    for (size_t i = 0; i < args.size(); ++i) {
+        if (args[i] != name) continue;
+        if (i + 1 >= args.size()) {
+            std::cerr << "Error: Missing value for " << name << "\n";
+            return false;
+        }
+        value = args[i + 1];
+        args.erase(args.begin() + static_cast<std::ptrdiff_t>(i), args.begin() + static_cast<std::ptrdiff_t>(i) + 2);
+        return true;
+    }
+    return true;
+}
+
+std::string currentPrecisions(const ExportConfig& config) {
+    std::string precision;
+    if (config.enable_fp16) precision += "fp16";
+    if (config.enable_fp8) precision += precision.empty() ? "fp8" : "+fp8";
+    if (config.enable_int8) precision += precision.empty() ? "int8" : "+int8";
+    return precision.empty() ? "fp32" : precision;
+}
+
+bool expandMatrix(const JsonValue& matrix, const ExportConfig& config, std::vector<BuildVariant>& variants,
+                  std::string& error) {
+    if (!matrix.isObject()) {
+        error = "matrix: expected an object";
+        return false;
+    }
+    std::string lists[3] = {std::to_string(config.input_resolution), currentPrecisions(config), "static"};
+    const char* keys[3] = {"resolutions", "precisions", "profiles"};
+    for (const auto& member : matrix.members()) {
+        auto key = std::find_if(std::begin(keys), std::end(keys),
+                                [&member](const char* k) { return member.first == k; });
+        if (key == std::end(keys) || !member.second.isString()) {
+            error = "matrix: unknown key or non-string value: " + member.first;
+            return false;
+        }
+        lists[key - std::begin(keys)] = member.second.asString();
+    }
+    if (!BuildVariant::expand_matrix(lists[0], lists[1], lists[2], variants, error)) {
+        error = "matrix: " + error;
+        return false;
+    }
+    return true;
+}
+
+bool loadManifest(const std::string& path, const std::vector<std::string>& overrides, std::vector<BuildJob>& jobs,
+                  int& workers) {
+    JsonValue manifest;
+    std::string error;
+    if (!JsonValue::parseFile(path, manifest, error)) {
+        std::cerr << "Error: Cannot read manifest " << path << ": " << error << "\n";
+        return false;
+    }
+
+    // A bare array is a list of jobs without shared defaults
+    const JsonValue* jobList = manifest.isArray() ? &manifest : manifest.find("jobs");
+    const JsonValue* defaults = manifest.find("defaults");
+    if (!jobList || !jobList->isArray()) {
+        std::cerr << "Error: Manifest needs a \"jobs\" array: " << path << "\n";
+        return false;
+    }
+    for (const auto& member : manifest.members()) {
+        if (member.first != "jobs" && member.first != "defaults" && member.first != "workers") {
+            std::cerr << "Error: Unknown manifest key: " << member.first << "\n";
+            return false;
+        }
+    }
+    if (const JsonValue* count = manifest.find("workers")) {
+        if (!count->isNumber() || count->asNumber() < 1) {
+            std::cerr << "Error: Manifest \"workers\" must be a positive number\n";
+            return false;
+        }
+        workers = static_cast<int>(count->asNumber());
+    }
+
+    for (size_t i = 0; i < jobList->size(); ++i) {
+        const JsonValue& entry = jobList->at(i);
+        std::string where = "job " + std::to_string(i + 1);
+        BuildJob job;
+        if (defaults && !ConfigParser::applyJson(*defaults, job.config, error)) {
+            std::cerr << "Error: Manifest defaults: " << error << "\n";
+            return false;
+        }
+        if (!ConfigParser::applyJson(entry, job.config, error, {"name", "matrix"})) {
+            std::cerr << "Error: Manifest " << where << ": " << error << "\n";
+            return false;
+        }
+        std::vector<std::string> positional;
+        if (!ConfigParser::parseCommandLine(overrides, job.config, positional)) {
+            return false;
+        }
+        if (!positional.empty()) {
+            std::cerr << "Error: Unexpected argument with --manifest: " << positional.front() << "\n";
+            return false;
+        }
+        if (!job.config.is_valid()) {
+            std::cerr << "Error: Manifest " << where << " has no input_onnx_path\n";
+            return false;
+        }
+
+        const JsonValue* name = entry.find("name");
+        job.name = name && name->isString() ? name->asString()
+                                            : std::filesystem::path(job.config.input_onnx_path).stem().string();
+        if (const JsonValue* matrix = entry.find("matrix")) {
+            if (!expandMatrix(*matrix, job.config, job.variants, error)) {
+                std::cerr << "Error: Manifest " << where << ": " << error << "\n";
+                return false;
+            }
+        }
+        jobs.push_back(std::move(job));
+    }
+
+    if (jobs.empty()) {
+        std::cerr << "Error: Manifest has no jobs: " << path << "\n";
+        return false;
+    }
+    return true;
+}
+
+// Makes request paths independent of the daemon's working directory
+void absolutizePaths(ExportConfig& config) {
+    for (std::string* path : {&config.input_onnx_path, &config.output_engine_path, &config.int8_calib_cache,
+                              &config.int8_calib_data_dir, &config.precision_policy,
+                              &config.refit_engine}) {
+        if (!path->empty()) *path = std::filesystem::absolute(*path).string();
+    }
+}
+
+std::string textField(const JsonValue& object, const char* key) {
+    const JsonValue* value = object.find(key);
+    return value && value->isString() ? value->asString() : "";
+}
+
+double numberField(const JsonValue& object, const char* key) {
+    const JsonValue* value = object.find(key);
+    return value && value->isNumber() ? value->asNumber() : 0.0;
+}
+
+bool boolField(const JsonValue& object, const char* key) {
+    const JsonValue* value = object.find(key);
+    return value && value->isBool() && value->asBool();
+}
+
+int talkToDaemon(const std::string& socketPath, const JsonValue& request) {
+    LocalSocket socket;
+    if (!LocalSocket::connect(socketPath, socket) || !socket.writeLine(request.dump())) {
+        return 2;
+    }
+
+    std::string line;
+    int exitCode = 2;
+    while (socket.readLine(line)) {
+        JsonValue event;
+        std::string error;
+        if (!JsonValue::parse(line, event, error)) {
+            std::cerr << "Warning: Unreadable daemon message: " << error << "\n";
+            continue;
+        }
+        const JsonValue* name = event.find("event");
+        std::string type = name && name->isString() ? name->asString() : "";
+        if (type == "log") {
+            std::cout << textField(event, "text") << "\n";
+        } else if (type == "queued") {
+            std::cout << "Queued " << textField(event, "key").substr(0, 16);
+            if (boolField(event, "joined")) std::cout << " (joined identical in-flight build)";
+            else std::cout << " (position " << numberField(event, "position") << ")";
+            std::cout << "\n";
+        } else if (type == "started") {
+            std::cout << "Build started\n";
+        } else if (type == "done") {
+            bool success = boolField(event, "success");
+            std::cout << (success ? "Done: " : "Failed: ") << textField(event, "output") << " ("
+                      << numberField(event, "seconds") << " s)\n";
+            exitCode = success ? 0 : 1;
+        } else if (type == "status") {
+            std::cout << event.dump(2) << "\n";
+            exitCode = 0;
+        } else if (type == "error") {
+            std::cerr << "Error: " << textField(event, "message") << "\n";
+            exitCode = 1;
+        }
+    }
+    if (exitCode == 2) {
+        std::cerr << "Error: Daemon closed the connection without a result\n";
+    }
+    return exitCode;
+}
+
+void runJob(BuildJob& job) {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    EngineExporter exporter(job.config);
+    if (job.variants.empty()) {
+        job.success = exporter.exportEngine();
+    } else {
+        std::vector<VariantResult> results;
+        job.success = exporter.exportMatrix(job.variants, results);
+    }
+    auto end_time = std::chrono::high_resolution_clock::now();
+    job.seconds = std::chrono::duration<double>(end_time - start_time).count();
+}
+
+void runJobs(std::vector<BuildJob>& jobs, int workers) {
+    std::atomic<size_t> next{0};
+    std::mutex printMutex;
+    auto worker = [&]() {
+        for (size_t i = next++; i < jobs.size(); i = next++) {
+            {
+                std::lock_guard<std::mutex> lock(printMutex);
+                std::cout << "\n[" << (i + 1) << "/" << jobs.size() << "] " << jobs[i].name << "\n";
+            }
+            try {
+                runJob(jobs[i]);
+            } catch (const std::exception& e) {
+                std::cerr << "Error: " << jobs[i].name << ": " << e.what() << "\n";
+                jobs[i].success = false;
+            }
+        }
+    };
+
+    size_t threadCount = std::min(static_cast<size_t>(workers), jobs.size());
+    if (threadCount <= 1) {
+        worker();
+        return;
+    }
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < threadCount; ++t) threads.emplace_back(worker);
+    for (auto& thread : threads) thread.join();
+}
+
+} // namespace
+
+int runCommandLine(int argc, char* argv[]) {
+    std::string program = argc > 0 ? std::filesystem::path(argv[0]).filename().string() : "EngineExport";
+    std::vector<std::string> args(argv + 1, argv + argc);
+
+    for (const auto& arg : args) {
+        if (arg == "-h" || arg == "--help") {
+            printUsage(program);
+            return 0;
+        }
+        if (arg == "-v" || arg == "--version") {
+            ConfigParser::printVersion();
+            return 0;
+        }
+    }
+
+    std::string manifestPath, workersText, resolutions, precisions, profiles;
+    std::string servePath, submitPath, statusPath, priorityText, infoPath;
+    std::string searchClip, searchTargets, searchMinF1, searchMinIou, searchMaxBuilds, searchFrames;
+    if (!takeOption(args, "--manifest", manifestPath) || !takeOption(args, "--workers", workersText) ||
+        !takeOption(args, "--matrix-resolutions", resolutions) ||
+        !takeOption(args, "--matrix-precisions", precisions) ||
+        !takeOption(args, "--matrix-profiles", profiles) ||
+        !takeOption(args, "--serve", servePath) || !takeOption(args, "--submit", submitPath) ||
+        !takeOption(args, "--daemon-status", statusPath) || !takeOption(args, "--priority", priorityText) ||
+        !takeOption(args, "--engine-info", infoPath) || !takeOption(args, "--precision-search", searchClip) ||
+        !takeOption(args, "--search-targets", searchTargets) || !takeOption(args, "--search-min-f1", searchMinF1) ||
+        !takeOption(args, "--search-min-iou", searchMinIou) ||
+        !takeOption(args, "--search-max-builds", searchMaxBuilds) ||
+        !takeOption(args, "--search-frames", searchFrames)) {
+        return 2;
+    }
+    
+    if (!infoPath.empty()) {
+        JsonValue metadata;
+        if (!EngineContainer::readMetadata(infoPath, metadata)) {
+            return 1;
+        }
+        if (metadata.isNull()) {
+            std::cout << infoPath << ": bare TensorRT plan, no container metadata (build with --container)\n";
+        } else {
+            std::cout << metadata.dump(2) << "\n";
+        }
+        return 0;
+    }
+    
+    if (!servePath.empty()) {
+        int daemonWorkers = 1;
+        if ((!workersText.empty() && !ConfigParser::parseInt(workersText, daemonWorkers)) || daemonWorkers < 1 ||
+            !args.empty()) {
+            std::cerr << "Error: --serve takes only --workers <n>\n";
+            return 2;
+        }
+        BuildDaemon daemon(servePath, daemonWorkers);
+        return daemon.run();
+    }
+    if (!statusPath.empty()) {
+        JsonValue request = JsonValue::makeObject();
+        request.set("type", "status");
+        return talkToDaemon(statusPath, request);
+    }
+
+    int workers = 1;
+    std::vector<BuildJob> jobs;
+    if (!manifestPath.empty()) {
+        if (!submitPath.empty()) {
+            std::cerr << "Error: --submit sends a single export, not a manifest\n";
+            return 2;
+        }
+        if (!resolutions.empty() || !precisions.empty() || !profiles.empty()) {
+            std::cerr << "Error: --matrix-* options apply to a single input; use \"matrix\" in manifest jobs\n";
+            return 2;
+        }
+        if (!searchClip.empty()) {
+            std::cerr << "Error: --precision-search tunes a single input, not a manifest\n";
+            return 2;
+        }
+        if (!loadManifest(manifestPath, args, jobs, workers)) {
+            return 2;
+        }
+    } else {
+        BuildJob job;
+        std::vector<std::string> positional;
+        if (!ConfigParser::parseCommandLine(args, job.config, positional)) {
+            return 2;
+        }
+        if (positional.size() == 1 && job.config.input_onnx_path.empty()) {
+            job.config.input_onnx_path = positional[0];
+        } else if (!positional.empty()) {
+            std::cerr << "Error: Unexpected argument: " << positional.back() << "\n";
+            return 2;
+        }
+        if (!job.config.is_valid()) {
+            std::cerr << "Error: No input ONNX model given\n\n";
+            printUsage(program);
+            return 2;
+        }
+        if (!resolutions.empty() || !precisions.empty() || !profiles.empty()) {
+            std::string error;
+            if (!BuildVariant::expand_matrix(resolutions.empty() ? std::to_string(job.config.input_resolution) : resolutions,
+                                             precisions.empty() ? currentPrecisions(job.config) : precisions,
+                                             profiles, job.variants, error)) {
+                std::cerr << "Error: " << error << "\n";
+                return 2;
+            }
+        }
+        job.name = std::filesystem::path(job.config.input_onnx_path).stem().string();
+        
+        if (!searchClip.empty()) {
+            PrecisionSearchOptions options;
+            int frames = 100;
+            if (!searchTargets.empty()) {
+                options.targets.clear();
+                std::stringstream list(searchTargets);
+                for (std::string target; std::getline(list, target, ',');) options.targets.push_back(target);
+            }
+            if ((!searchFrames.empty() && !ConfigParser::parseInt(searchFrames, frames)) ||
+                (!searchMaxBuilds.empty() && !ConfigParser::parseInt(searchMaxBuilds, options.maxEvaluations)) ||
+                (!searchMinF1.empty() && !ConfigParser::parseDouble(searchMinF1, options.minF1)) ||
+                (!searchMinIou.empty() && !ConfigParser::parseDouble(searchMinIou, options.minMeanIou)) ||
+                options.minF1 < 0.0 || options.minF1 > 1.0 || options.minMeanIou < 0.0 || options.minMeanIou > 1.0) {
+                std::cerr << "Error: --search-frames and --search-max-builds take integers, --search-min-f1 and "
+                          << "--search-min-iou numbers in [0, 1]\n";
+                return 2;
+            }
+            bool validTargets = !options.targets.empty();
+            for (const auto& target : options.targets) {
+                validTargets = validTargets && target != "fp32" && PrecisionPolicy::isPrecision(target);
+            }
+            if (!validTargets || frames < 1 || options.maxEvaluations < 2 || !submitPath.empty() ||
+                !job.variants.empty()) {
+                std::cerr << "Error: --precision-search takes one input; targets are fp16, bf16, int8 or fp8, "
+                          << "at least 1 frame and 2 builds\n";
+                return 2;
+            }
+            return runPrecisionSearch(job.config, searchClip, frames, options);
+        }
+        
+        if (!submitPath.empty()) {
+            int priority = 10;
+            if (!job.variants.empty() || (!priorityText.empty() && !BuildDaemon::parsePriority(priorityText, priority))) {
+                std::cerr << "Error: --submit sends one export; --priority is interactive, normal, nightly or a number\n";
+                return 2;
+            }
+            absolutizePaths(job.config);
+            JsonValue request = JsonValue::makeObject();
+            request.set("type", "build");
+            request.set("priority", priority);
+            request.set("config", ConfigParser::toJson(job.config));
+            return talkToDaemon(submitPath, request);
+        }
+        jobs.push_back(std::move(job));
+    }
+
+    if (!workersText.empty()) {
+        if (!ConfigParser::parseInt(workersText, workers) || workers < 1) {
+            std::cerr << "Error: --workers must be a positive number\n";
+            return 2;
+        }
+    }
+
+    runJobs(jobs, workers);
+
+    size_t failed = 0;
+    if (jobs.size() > 1) {
+        std::cout << "\nJob summary:\n";
+    }
+    for (const auto& job : jobs) {
+        if (!job.success) ++failed;
+        if (jobs.size() > 1) {
+            std::cout << "  " << std::left << std::setw(24) << job.name << std::setw(8) << (job.success ? "OK" : "FAILED")
+                      << std::right << std::fixed << std::setprecision(1) << std::setw(8) << job.seconds << " s\n";
+        }
+    }
+    if (failed > 0) {
+        std::cerr << "Error: " << failed << " of " << jobs.size() << " job(s) failed\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,6 @@
+#pragma once
+
+// Headless build mode: a single export from command-line options, or a JSON
+// manifest of jobs run by a pool of workers. Returns the process exit code
+// (0 = all jobs succeeded, 1 = a job failed, 2 = bad usage or manifest).
+int runCommandLine(int argc, char* argv[]);
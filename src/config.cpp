@@ -1,85 +1,338 @@
 #include "config.h"
+#include "json.h"
 #include <iostream>
 #include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <sstream>
 
-ExportConfig ConfigParser::parseCommandLine(int argc, char* argv[]) {
-    ExportConfig config;
-    std::vector<std::string> args(argv, argv + argc);
-    
-    if (argc < 2) {
-        printUsage(args[0]);
-        return config;
+namespace {
+
+std::vector<std::string> splitList(const std::string& text, char separator) {
+    std::vector<std::string> items;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, separator)) {
+        item.erase(0, item.find_first_not_of(" \t"));
+        item.erase(item.find_last_not_of(" \t") + 1);
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+bool parsePositive(const std::string& text, int& value) {
+    if (text.empty() || text.size() > 6 || text.find_first_not_of("0123456789") != std::string::npos) return false;
+    value = std::stoi(text);
+    return value > 0;
+}
+
+// "n" or "min-opt-max"
+bool parseRange(const std::string& text, DimRange& range) {
+    auto parts = splitList(text, '-');
+    if (parts.size() == 1 && parsePositive(parts[0], range.min)) {
+        range.opt = range.max = range.min;
+        return true;
     }
+    return parts.size() == 3 && parsePositive(parts[0], range.min) && parsePositive(parts[1], range.opt) &&
+           parsePositive(parts[2], range.max) && range.min <= range.opt && range.opt <= range.max;
+}
+
+// Field tables: JSON key (= ExportConfig member name), command-line option, member, help
+struct BoolField {
+    const char* key;
+    const char* option;
+    bool ExportConfig::*member;
+    const char* help;
+};
+
+struct IntField {
+    const char* key;
+    const char* option;
+    int ExportConfig::*member;
+    int minValue;
+    int maxValue;
+    const char* help;
+};
+
+struct StringField {
+    const char* key;
+    const char* option;
+    std::string ExportConfig::*member;
+    const char* help;
+};
+
+const StringField kStringFields[] = {
+    {"input_onnx_path", "input", &ExportConfig::input_onnx_path, "Input ONNX model"},
+    {"output_engine_path", "output", &ExportConfig::output_engine_path, "Output engine (default: generated next to the input)"},
+    {"int8_calib_cache", "calib-cache", &ExportConfig::int8_calib_cache, "INT8 calibration cache"},
+    {"int8_calib_data_dir", "calib-data", &ExportConfig::int8_calib_data_dir, "INT8 calibration image folder or .shard file"},
+    {"timing_cache_dir", "timing-cache-dir", &ExportConfig::timing_cache_dir, "Persistent timing cache folder (empty = off)"},
+    {"engine_store_dir", "engine-store", &ExportConfig::engine_store_dir, "Content-addressed engine store folder (empty = off)"},
+    {"optimization_profiles", "profiles", &ExportConfig::optimization_profiles, "Optimization profiles, e.g. \"1-4-8:640; 1:320-480-640\""},
+    {"precision_policy", "precision-policy", &ExportConfig::precision_policy, "Per-layer precision rules (JSON policy file)"},
+    {"refit_engine", "refit-engine", &ExportConfig::refit_engine, "Refit this engine with the ONNX weights instead of building"},
+    {"hardware_compatibility", "hardware-compat", &ExportConfig::hardware_compatibility, "none, ampere_plus or same_compute_capability"},
+};
+
+const IntField kIntFields[] = {
+    {"input_resolution", "resolution", &ExportConfig::input_resolution, 1, 16384, "Input resolution"},
+    {"workspace_mb", "workspace", &ExportConfig::workspace_mb, 1, 1 << 20, "Workspace size in MB"},
+    {"calib_batch_size", "calib-batch", &ExportConfig::calib_batch_size, 1, 4096, "INT8 calibration batch size"},
+    {"calib_max_batches", "calib-max-batches", &ExportConfig::calib_max_batches, 1, 1000000, "INT8 calibration batch limit"},
+    {"optimization_level", "opt-level", &ExportConfig::optimization_level, 0, 5, "Builder optimization level"},
+    {"nms_max_detections", "nms-max-detections", &ExportConfig::nms_max_detections, 1, 100000, "Fixed NMS output size"},
+    {"batch_min", "batch-min", &ExportConfig::batch_min, 1, 65536, "Dynamic batch minimum"},
+    {"batch_opt", "batch-opt", &ExportConfig::batch_opt, 1, 65536, "Dynamic batch optimum"},
+    {"batch_max", "batch-max", &ExportConfig::batch_max, 1, 65536, "Dynamic batch maximum"},
+    {"engine_store_max_gb", "engine-store-max-gb", &ExportConfig::engine_store_max_gb, 1, 1 << 20, "Engine store size cap in GB"},
+};
+
+const BoolField kBoolFields[] = {
+    {"enable_fp16", "fp16", &ExportConfig::enable_fp16, "FP16 precision"},
+    {"enable_fp8", "fp8", &ExportConfig::enable_fp8, "FP8 precision"},
+    {"enable_int8", "int8", &ExportConfig::enable_int8, "INT8 precision"},
+    {"calib_diverse_subset", "calib-diverse", &ExportConfig::calib_diverse_subset, "Calibrate on a diverse subset of the image folder"},
+    {"assume_qat_quantized", "assume-qat", &ExportConfig::assume_qat_quantized, "ONNX already has Q/DQ nodes (no calibrator)"},
+    {"verbose", "verbose", &ExportConfig::verbose, "Verbose TensorRT logging"},
+    {"enable_gpu_fallback", "gpu-fallback", &ExportConfig::enable_gpu_fallback, "GPU fallback"},
+    {"enable_precision_constraints", "precision-constraints", &ExportConfig::enable_precision_constraints, "Obey layer precision constraints"},
+    {"enable_detailed_profiling", "detailed-profiling", &ExportConfig::enable_detailed_profiling, "Detailed profiling verbosity"},
+    {"enable_tf32", "tf32", &ExportConfig::enable_tf32, "TF32 (Ampere+)"},
+    {"enable_sparse_weights", "sparse-weights", &ExportConfig::enable_sparse_weights, "Sparse weight kernels"},
+    {"enable_direct_io", "direct-io", &ExportConfig::enable_direct_io, "Direct I/O"},
+    {"enable_refit", "refit", &ExportConfig::enable_refit, "Refittable engine"},
+    {"strip_weights", "strip-weights", &ExportConfig::strip_weights, "Weight-stripped engine, refit from the ONNX when loaded"},
+    {"version_compatible", "version-compat", &ExportConfig::version_compatible, "Engine also loads on later TensorRT 10.x runtimes"},
+    {"exclude_lean_runtime", "exclude-lean-runtime", &ExportConfig::exclude_lean_runtime, "Leave the lean runtime out of version-compatible engines"},
+    {"disable_timing_cache", "disable-timing-cache", &ExportConfig::disable_timing_cache, "Build without a timing cache"},
+    {"use_cublas", "cublas", &ExportConfig::use_cublas, "cuBLAS tactics"},
+    {"use_cublas_lt", "cublas-lt", &ExportConfig::use_cublas_lt, "cuBLASLt tactics"},
+    {"use_cudnn", "cudnn", &ExportConfig::use_cudnn, "cuDNN tactics"},
+    {"use_edge_mask_conv", "edge-mask-conv", &ExportConfig::use_edge_mask_conv, "Edge mask convolution tactics"},
+    {"fix_nms_output", "fix-nms-output", &ExportConfig::fix_nms_output, "Fix NMS output shape"},
+    {"dynamic_batch", "dynamic-batch", &ExportConfig::dynamic_batch, "Rewrite to a symbolic batch (see --batch-*)"},
+    {"write_build_report", "build-report", &ExportConfig::write_build_report, "Write <engine>.build.json with phase times and applied flags"},
+    {"engine_container", "container", &ExportConfig::engine_container, "Write the plan in a container with I/O and preprocessing metadata"},
+    {"compress_engine", "compress", &ExportConfig::compress_engine, "Compress the plan in the container (LZ4 blocks, parallel decompression)"},
+    {"allow_bare_refit", "allow-bare-refit", &ExportConfig::allow_bare_refit, "Refit a bare plan (--refit-engine) built with --refit, not --strip-weights"},
+};
+
+} // namespace
+
+std::string ExportConfig::build_fingerprint() const {
+    std::ostringstream out;
+    out << "input_resolution=" << input_resolution << "\n";
+    out << "enable_fp16=" << enable_fp16 << "\n";
+    out << "enable_fp8=" << enable_fp8 << "\n";
+    out << "enable_int8=" << enable_int8 << "\n";
+    out << "calib_batch_size=" << calib_batch_size << "\n";
+    out << "calib_max_batches=" << calib_max_batches << "\n";
+    out << "calib_diverse_subset=" << calib_diverse_subset << "\n";
+    out << "assume_qat_quantized=" << assume_qat_quantized << "\n";
+    out << "workspace_mb=" << workspace_mb << "\n";
+    out << "enable_gpu_fallback=" << enable_gpu_fallback << "\n";
+    out << "enable_precision_constraints=" << enable_precision_constraints << "\n";
+    out << "enable_detailed_profiling=" << enable_detailed_profiling << "\n";
+    out << "enable_tf32=" << enable_tf32 << "\n";
+    out << "enable_sparse_weights=" << enable_sparse_weights << "\n";
+    out << "enable_direct_io=" << enable_direct_io << "\n";
+    out << "enable_refit=" << enable_refit << "\n";
+    out << "strip_weights=" << strip_weights << "\n";
+    out << "hardware_compatibility=" << hardware_compatibility << "\n";
+    out << "version_compatible=" << version_compatible << "\n";
+    out << "exclude_lean_runtime=" << exclude_lean_runtime << "\n";
+    out << "disable_timing_cache=" << disable_timing_cache << "\n";
+    out << "optimization_level=" << optimization_level << "\n";
+    out << "use_cublas=" << use_cublas << "\n";
+    out << "use_cublas_lt=" << use_cublas_lt << "\n";
+    out << "use_cudnn=" << use_cudnn << "\n";
+    out << "use_edge_mask_conv=" << use_edge_mask_conv << "\n";
+    out << "fix_nms_output=" << fix_nms_output << "\n";
+    out << "nms_max_detections=" << nms_max_detections << "\n";
+    out << "dynamic_batch=" << dynamic_batch << "\n";
+    out << "batch_min=" << batch_min << "\n";
+    out << "batch_opt=" << batch_opt << "\n";
+    out << "batch_max=" << batch_max << "\n";
+    out << "optimization_profiles=" << optimization_profiles << "\n";
+    out << "engine_container=" << engine_container << "\n";
+    out << "compress_engine=" << compress_engine << "\n";
     
-    // First non-option argument is input file
-    bool found_input = false;
-    for (size_t i = 1; i < args.size(); ++i) {
-        if (!isOption(args[i]) && !found_input) {
-            config.input_onnx_path = args[i];
-            found_input = true;
+    std::vector<std::string> plugins(selected_plugins.begin(), selected_plugins.end());
+    std::sort(plugins.begin(), plugins.end());
+    for (const auto& plugin : plugins) {
+        out << "plugin=" << plugin << "\n";
+    }
+    return out.str();
+}
+
+bool ConfigParser::parseCommandLine(const std::vector<std::string>& args, ExportConfig& config,
+                                    std::vector<std::string>& positional) {
+    for (size_t i = 0; i < args.size(); ++i) {
+        const std::string& arg = args[i];
+        if (!isOption(arg)) {
+            positional.push_back(arg);
             continue;
         }
-        
-        if (args[i] == "--help" || args[i] == "-h") {
-            printUsage(args[0]);
-            return config;
-        }
-        else if (args[i] == "--version" || args[i] == "-v") {
-            printVersion();
-            return config;
+        std::string name = arg.size() > 2 && arg[1] == '-' ? arg.substr(2) : arg.substr(1);
+        if (arg.size() == 2) {
+            // Short aliases
+            if (name == "r") name = "resolution";
+            else if (name == "o") name = "output";
+            else if (name == "w") name = "workspace";
         }
-        else if (args[i] == "--resolution" || args[i] == "-r") {
-            std::string value = getOptionValue(args, i);
-            config.input_resolution = std::stoi(value);
+        
+        bool handled = false;
+        bool negated = name.compare(0, 3, "no-") == 0;
+        for (const auto& field : kBoolFields) {
+            if (name == field.option || (negated && name.substr(3) == field.option)) {
+                config.*field.member = !negated;
+                handled = true;
+                break;
+            }
         }
-        else if (args[i] == "--output" || args[i] == "-o") {
-            config.output_engine_path = getOptionValue(args, i);
+        if (handled) continue;
+        
+        std::string value;
+        for (const auto& field : kIntFields) {
+            if (name != field.option) continue;
+            if (!getOptionValue(args, i, value)) return false;
+            int number = 0;
+            if (!parseInt(value, number) || number < field.minValue || number > field.maxValue) {
+                std::cerr << "Error: " << arg << " expects an integer in [" << field.minValue << ", "
+                          << field.maxValue << "], got: " << value << "\n";
+                return false;
+            }
+            config.*field.member = number;
+            handled = true;
+            break;
         }
-        else if (args[i] == "--workspace" || args[i] == "-w") {
-            std::string value = getOptionValue(args, i);
-            config.workspace_mb = std::stoi(value);
+        if (handled) continue;
+        
+        for (const auto& field : kStringFields) {
+            if (name != field.option) continue;
+            if (!getOptionValue(args, i, value)) return false;
+            config.*field.member = value;
+            handled = true;
+            break;
         }
-        else if (args[i] == "--fp16") {
-            config.enable_fp16 = true;
+        if (handled) continue;
+        
+        if (name == "plugins") {
+            if (!getOptionValue(args, i, value)) return false;
+            config.selected_plugins.clear();
+            for (const auto& plugin : splitList(value, ',')) config.selected_plugins.insert(plugin);
+            continue;
         }
-        else if (args[i] == "--fp8") {
-            config.enable_fp8 = true;
+        
+        std::cerr << "Error: Unknown option: " << arg << "\n";
+        return false;
+    }
+    return true;
+}
+
+bool ConfigParser::applyJson(const JsonValue& object, ExportConfig& config, std::string& error,
+                             const std::vector<std::string>& ignoredKeys) {
+    if (!object.isObject()) {
+        error = "expected a JSON object of settings";
+        return false;
+    }
+    
+    for (const auto& member : object.members()) {
+        const std::string& key = member.first;
+        const JsonValue& value = member.second;
+        if (std::find(ignoredKeys.begin(), ignoredKeys.end(), key) != ignoredKeys.end()) continue;
+        
+        bool handled = false;
+        for (const auto& field : kBoolFields) {
+            if (key != field.key) continue;
+            if (!value.isBool()) {
+                error = key + ": expected true or false";
+                return false;
+            }
+            config.*field.member = value.asBool();
+            handled = true;
+            break;
         }
-        else if (args[i] == "--verbose") {
-            config.verbose = true;
+        for (const auto& field : kIntFields) {
+            if (handled || key != field.key) continue;
+            double number = value.isNumber() ? value.asNumber() : 0.5;
+            if (number != static_cast<int>(number) || number < field.minValue || number > field.maxValue) {
+                error = key + ": expected an integer in [" + std::to_string(field.minValue) + ", " +
+                        std::to_string(field.maxValue) + "]";
+                return false;
+            }
+            config.*field.member = static_cast<int>(number);
+            handled = true;
         }
-        else if (args[i] == "--no-gpu-fallback") {
-            config.enable_gpu_fallback = false;
+        for (const auto& field : kStringFields) {
+            if (handled || key != field.key) continue;
+            if (!value.isString()) {
+                error = key + ": expected a string";
+                return false;
+            }
+            config.*field.member = value.asString();
+            handled = true;
         }
-        else if (args[i] == "--no-precision-constraints") {
-            config.enable_precision_constraints = false;
+        if (!handled && key == "selected_plugins") {
+            if (!value.isArray()) {
+                error = key + ": expected an array of plugin names";
+                return false;
+            }
+            config.selected_plugins.clear();
+            for (size_t i = 0; i < value.size(); ++i) {
+                if (!value.at(i).isString()) {
+                    error = key + ": expected an array of plugin names";
+                    return false;
+                }
+                config.selected_plugins.insert(value.at(i).asString());
+            }
+            handled = true;
         }
-        else if (args[i] == "--detailed-profiling") {
-            config.enable_detailed_profiling = true;
+        if (!handled) {
+            error = "unknown setting: " + key;
+            return false;
         }
     }
+    return true;
+}
+
+JsonValue ConfigParser::toJson(const ExportConfig& config) {
+    JsonValue object = JsonValue::makeObject();
+    for (const auto& field : kStringFields) object.set(field.key, config.*field.member);
+    for (const auto& field : kIntFields) object.set(field.key, config.*field.member);
+    for (const auto& field : kBoolFields) object.set(field.key, config.*field.member);
     
-    return config;
-}
-
-void ConfigParser::printUsage(const std::string& program_name) {
-    std::cout << "Usage: " << program_name << " <input.onnx> [options]\n\n";
-    std::cout << "Options:\n";
-    std::cout << "  -h, --help                    Show this help message\n";
-    std::cout << "  -v, --version                 Show version information\n";
-    std::cout << "  -r, --resolution <size>       Input resolution (default: 640)\n";
-    std::cout << "  -o, --output <path>           Output engine file path\n";
-    std::cout << "  -w, --workspace <mb>          Workspace size in MB (default: 1024)\n";
-    std::cout << "  --fp16                        Enable FP16 precision\n";
-    std::cout << "  --fp8                         Enable FP8 precision\n";
-    std::cout << "  --verbose                     Enable verbose output\n";
-    std::cout << "  --no-gpu-fallback             Disable GPU fallback\n";
-    std::cout << "  --no-precision-constraints    Disable precision constraints\n";
-    std::cout << "  --detailed-profiling          Enable detailed profiling\n\n";
-    std::cout << "Examples:\n";
-    std::cout << "  " << program_name << " model.onnx\n";
-    std::cout << "  " << program_name << " model.onnx --resolution 640 --fp16\n";
-    std::cout << "  " << program_name << " model.onnx --output custom_name.engine --verbose\n";
+    std::vector<std::string> plugins(config.selected_plugins.begin(), config.selected_plugins.end());
+    std::sort(plugins.begin(), plugins.end());
+    JsonValue pluginList = JsonValue::makeArray();
+    for (const auto& plugin : plugins) pluginList.push(plugin);
+    object.set("selected_plugins", pluginList);
+    return object;
+}
+
+void ConfigParser::printOptions() {
+    auto printRow = [](const std::string& left, const std::string& help) {
+        std::cout << "  " << left;
+        for (size_t pad = left.size(); pad < 32; ++pad) std::cout << ' ';
+        std::cout << help << "\n";
+    };
+    
+    ExportConfig defaults;
+    std::cout << "Settings (JSON manifest key in brackets):\n";
+    for (const auto& field : kStringFields) {
+        printRow(std::string("--") + field.option + " <path>", std::string(field.help) + " [" + field.key + "]");
+    }
+    for (const auto& field : kIntFields) {
+        printRow(std::string("--") + field.option + " <n>", std::string(field.help) + ", default " +
+                 std::to_string(defaults.*field.member) + " [" + field.key + "]");
+    }
+    for (const auto& field : kBoolFields) {
+        printRow(std::string("--[no-]") + field.option, std::string(field.help) + ", default " +
+                 (defaults.*field.member ? "on" : "off") + " [" + field.key + "]");
+    }
+    printRow("--plugins <a,b,...>", "TensorRT plugins to enable [selected_plugins, JSON array]");
+    printRow("-r, -o, -w", "Short for --resolution, --output, --workspace");
 }
 
 void ConfigParser::printVersion() {
@@ -87,16 +340,178 @@ void ConfigParser::printVersion() {
     std::cout << "TensorRT ONNX to Engine Converter\n";
 }
 
+bool ConfigParser::parseInt(const std::string& text, int& value) {
+    if (text.empty() || text.size() > 9) return false;
+    size_t start = text[0] == '-' ? 1 : 0;
+    if (start == text.size() || text.find_first_not_of("0123456789", start) != std::string::npos) return false;
+    value = std::stoi(text);
+    return true;
+}
+
+bool ConfigParser::parseDouble(const std::string& text, double& value) {
+    if (text.empty() || text.find_first_of(" \t\n") != std::string::npos) return false;
+    char* end = nullptr;
+    double number = std::strtod(text.c_str(), &end);
+    if (end != text.c_str() + text.size() || !std::isfinite(number)) return false;
+    value = number;
+    return true;
+}
+
 bool ConfigParser::isOption(const std::string& arg) {
-    return arg.size() > 0 && arg[0] == '-';
+    return arg.size() > 1 && arg[0] == '-';
 }
 
-std::string ConfigParser::getOptionValue(const std::vector<std::string>& args, size_t& index) {
-    if (index + 1 >= args.size() || isOption(args[index + 1])) {
+bool ConfigParser::getOptionValue(const std::vector<std::string>& args, size_t& index, std::string& value) {
+    if (index + 1 >= args.size()) {
         std::cerr << "Error: Option " << args[index] << " requires a value\n";
-        return "";
+        return false;
+    }
+    value = args[++index];
+    return true;
+}
+
+void BuildVariant::apply_to(ExportConfig& config) const {
+    std::string outputDir;
+    if (!config.output_engine_path.empty()) {
+        outputDir = std::filesystem::path(config.output_engine_path).parent_path().string();
+    }
+    
+    config.input_resolution = input_resolution;
+    config.enable_fp16 = enable_fp16;
+    config.enable_fp8 = enable_fp8;
+    config.enable_int8 = enable_int8;
+    config.dynamic_batch = dynamic_batch;
+    config.batch_min = batch_min;
+    config.batch_opt = batch_opt;
+    config.batch_max = batch_max;
+    
+    config.output_engine_path.clear();
+    if (!outputDir.empty()) {
+        std::filesystem::path name = std::filesystem::path(config.get_output_path()).filename();
+        config.output_engine_path = (std::filesystem::path(outputDir) / name).string();
+    }
+}
+
+std::string BuildVariant::label() const {
+    std::string precision;
+    if (enable_fp16) precision += "fp16";
+    if (enable_fp8) precision += precision.empty() ? "fp8" : "+fp8";
+    if (enable_int8) precision += precision.empty() ? "int8" : "+int8";
+    if (precision.empty()) precision = "fp32";
+    
+    std::string text = std::to_string(input_resolution) + " " + precision;
+    if (dynamic_batch) {
+        text += " b" + std::to_string(batch_min) + "-" + std::to_string(batch_opt) + "-" + std::to_string(batch_max);
+    }
+    return text;
+}
+
+bool BuildVariant::expand_matrix(const std::string& resolutions, const std::string& precisions,
+                                 const std::string& profiles, std::vector<BuildVariant>& variants,
+                                 std::string& error) {
+    variants.clear();
+    
+    std::vector<int> resolutionList;
+    for (const auto& item : splitList(resolutions, ',')) {
+        int value = 0;
+        if (!parsePositive(item, value)) {
+            error = "Invalid resolution: " + item;
+            return false;
+        }
+        resolutionList.push_back(value);
+    }
+    
+    std::vector<BuildVariant> precisionList;
+    for (const auto& item : splitList(precisions, ',')) {
+        BuildVariant variant;
+        for (const auto& flag : splitList(item, '+')) {
+            if (flag == "fp16") variant.enable_fp16 = true;
+            else if (flag == "fp8") variant.enable_fp8 = true;
+            else if (flag == "int8") variant.enable_int8 = true;
+            else if (flag != "fp32") {
+                error = "Unknown precision: " + flag + " (fp32, fp16, fp8, int8 joined by '+')";
+                return false;
+            }
+        }
+        precisionList.push_back(variant);
+    }
+    
+    std::vector<BuildVariant> profileList;
+    for (const auto& item : splitList(profiles.empty() ? "static" : profiles, ',')) {
+        BuildVariant variant;
+        if (item != "static") {
+            auto parts = splitList(item, '-');
+            if (parts.size() != 3 || !parsePositive(parts[0], variant.batch_min) ||
+                !parsePositive(parts[1], variant.batch_opt) || !parsePositive(parts[2], variant.batch_max) ||
+                variant.batch_min > variant.batch_opt || variant.batch_opt > variant.batch_max) {
+                error = "Invalid batch profile (static or min-opt-max): " + item;
+                return false;
+            }
+            variant.dynamic_batch = true;
+        }
+        profileList.push_back(variant);
     }
-    return args[++index];
+    
+    if (resolutionList.empty() || precisionList.empty()) {
+        error = "Build matrix needs at least one resolution and one precision";
+        return false;
+    }
+    
+    for (int resolution : resolutionList) {
+        for (const auto& precision : precisionList) {
+            for (const auto& profile : profileList) {
+                BuildVariant variant = profile;
+                variant.input_resolution = resolution;
+                variant.enable_fp16 = precision.enable_fp16;
+                variant.enable_fp8 = precision.enable_fp8;
+                variant.enable_int8 = precision.enable_int8;
+                variants.push_back(variant);
+            }
+        }
+    }
+    return true;
+}
+
+std::string DimRange::label() const {
+    if (min == opt && opt == max) return std::to_string(opt);
+    return std::to_string(min) + "-" + std::to_string(opt) + "-" + std::to_string(max);
+}
+
+std::string OptimizationProfileSpec::label() const {
+    std::string text = "b" + batch.label();
+    if (has_size) {
+        text += " " + height.label();
+        if (width.min != height.min || width.opt != height.opt || width.max != height.max) {
+            text += "x" + width.label();
+        }
+    }
+    return text;
+}
+
+bool OptimizationProfileSpec::parse_list(const std::string& text, std::vector<OptimizationProfileSpec>& profiles,
+                                         std::string& error) {
+    profiles.clear();
+    for (const auto& item : splitList(text, ';')) {
+        OptimizationProfileSpec profile;
+        auto parts = splitList(item, ':');
+        bool valid = (parts.size() == 1 || parts.size() == 2) && parseRange(parts[0], profile.batch);
+        if (valid && parts.size() == 2) {
+            auto sides = splitList(parts[1], 'x');
+            profile.has_size = true;
+            valid = (sides.size() == 1 || sides.size() == 2) && parseRange(sides[0], profile.height) &&
+                    parseRange(sides.back(), profile.width);
+        }
+        if (!valid) {
+            error = "Invalid optimization profile (batch[:size], each a value or min-opt-max): " + item;
+            return false;
+        }
+        profiles.push_back(profile);
+    }
+    if (profiles.empty()) {
+        error = "No optimization profiles given";
+        return false;
+    }
+    return true;
 }
 
 // PluginManager implementation
@@ -144,4 +559,13 @@ std::string PluginManager::getPluginDescription(TensorRTPlugin plugin) {
         }
     }
     return "Unknown plugin";
-}
\ No newline at end of file
+}
+
+bool PluginManager::isBuiltInPlugin(const std::string& name) {
+    for (const auto& p : getAvailablePlugins()) {
+        if (p.name == name) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -4,6 +4,8 @@
 #include <vector>
 #include <unordered_set>
 
+class JsonValue;
+
 struct ExportConfig {
     std::string input_onnx_path;
     std::string output_engine_path;
@@ -13,10 +15,13 @@ struct ExportConfig {
     bool enable_int8 = false;  // INT8 양자화
     // INT8 calibration (cache-first; data dir optional)
     std::string int8_calib_cache;      // e.g., calib.cache
-    std::string int8_calib_data_dir;   // optional; not used unless a data-driven calibrator is implemented
+    std::string int8_calib_data_dir;   // images (.jpg/.png/.bmp) or a calib_tool shard, used when the cache above is missing
     int calib_batch_size = 8;
-    int calib_max_batches = 200;
+    int calib_max_batches = 200;       // uses up to calib_batch_size * calib_max_batches images
+    bool calib_diverse_subset = false; // pick those images as a diverse subset of the folder instead of the first ones
     bool assume_qat_quantized = false; // set true if ONNX has Q/DQ (no calibrator needed)
+    // Per-layer precision rules (PrecisionPolicy JSON), applied on top of the flags above
+    std::string precision_policy;
 
     int workspace_mb = 2048;  // 넉넉한 워크스페이스로 더 aggressive한 커널 선택 허용
     bool verbose = false;
@@ -31,7 +36,16 @@ struct ExportConfig {
     bool enable_sparse_weights = true;  // 희소 가중치 최적화
     bool enable_direct_io = true;       // Direct I/O
     bool enable_refit = true;           // Refit 가능 엔진
+    bool strip_weights = false;         // Weight-stripped plan; refit from the same ONNX at load (EngineRefit)
+    
+    // Fleet compatibility: "none" (this GPU model only), "ampere_plus" (any sm80+ GPU)
+    // or "same_compute_capability". version_compatible plans also load on later
+    // TensorRT 10.x runtimes, through the lean runtime embedded unless excluded.
+    std::string hardware_compatibility = "none";
+    bool version_compatible = false;
+    bool exclude_lean_runtime = false;
     bool disable_timing_cache = false;   // 타이밍 캐시 사용 (빌드 느림, 성능↑)
+    std::string timing_cache_dir = "timing_cache";  // 영구 타이밍 캐시 폴더 (GPU/TRT 버전/정밀도별 파일, 비우면 사용 안 함)
     int optimization_level = 5;         // 최적화 레벨 (1-5)
     
     // Tactic Sources
@@ -44,14 +58,54 @@ struct ExportConfig {
     bool fix_nms_output = true;
     int nms_max_detections = 200;
     
+    // Dynamic batch (static batch-1 ONNX is rewritten to a symbolic batch before parsing)
+    bool dynamic_batch = false;
+    int batch_min = 1;
+    int batch_opt = 1;
+    int batch_max = 8;
+    
+    // Optimization profiles (empty = one profile from input_resolution and the batch settings above).
+    // ';'-separated, each "batch[:size]": a value or min-opt-max, size square or HxW,
+    // e.g. "1-4-8:640; 1:320-480-640". Overrides input_resolution and batch_*; batch
+    // ranges rewrite a static batch-1 ONNX like dynamic_batch, size ranges need dynamic H/W.
+    std::string optimization_profiles;
+    
     // Plugin settings
     std::unordered_set<std::string> selected_plugins;
     
+    // Engine store (content-addressed cache of built engines, empty = off)
+    std::string engine_store_dir;
+    int engine_store_max_gb = 20;
+    
+    // <engine stem>.build.json next to each built engine (phase times, memory, applied flags)
+    bool write_build_report = true;
+    
+    // Engine file as a container: a JSON header (I/O tensors, preprocessing,
+    // class names, NMS settings, source model hash, this config) ahead of the
+    // plan (EngineContainer). Off writes a bare plan for plain TensorRT loaders.
+    bool engine_container = false;
+    // Container with the plan in independently LZ4-compressed blocks (implies
+    // engine_container); loaders decompress them in parallel
+    bool compress_engine = false;
+    
+    // Refit-only update: this refittable engine gets the weights of input_onnx_path
+    // (same topology, retrained) and is written to the output path without a build
+    std::string refit_engine;
+    // A bare plan carries no build settings; refitting one needs this confirmation
+    // that it was built with enable_refit, not strip_weights
+    bool allow_bare_refit = false;
+    
     // Validation
     bool is_valid() const {
         return !input_onnx_path.empty();
     }
     
+    // Every setting that changes the built engine, one "name=value" per line.
+    // Paths, logging and cache locations are left out. New fields that affect
+    // the engine must be added here, or the engine store will serve stale builds.
+    // New fields also need an entry in the ConfigParser field table (config.cpp).
+    std::string build_fingerprint() const;
+    
     // Generate output path if not specified
     std::string get_output_path() const {
         if (!output_engine_path.empty()) {
@@ -63,19 +117,89 @@ struct ExportConfig {
         base += "_" + std::to_string(input_resolution);
         if (enable_fp16) base += "_fp16";
         if (enable_fp8) base += "_fp8";
+        if (enable_int8) base += "_int8";
+        if (!hardware_compatibility.empty() && hardware_compatibility != "none") base += "_" + hardware_compatibility;
+        if (version_compatible) base += "_vc";
+        if (dynamic_batch) base += "_b" + std::to_string(batch_min) + "-" + std::to_string(batch_max);
+        if (!optimization_profiles.empty()) base += "_profiles";
         return base + ".engine";
     }
 };
 
+// One cell of a build matrix: resolution x precision x batch profile,
+// applied on top of a base ExportConfig that carries everything else
+struct BuildVariant {
+    int input_resolution = 320;
+    bool enable_fp16 = false;
+    bool enable_fp8 = false;
+    bool enable_int8 = false;
+    bool dynamic_batch = false;
+    int batch_min = 1;
+    int batch_opt = 1;
+    int batch_max = 1;
+    
+    // Copies the variant settings and derives a per-variant output path
+    // (in the directory of the base output, if one was given)
+    void apply_to(ExportConfig& config) const;
+    std::string label() const;   // e.g. "640 fp16+fp8 b1-4-8"
+    
+    // Cross product of comma-separated lists:
+    //   resolutions "320,640", precisions "fp16,fp16+fp8,int8" (fp32 = none),
+    //   profiles "static,1-4-8" (static = batch 1 as exported, else min-opt-max)
+    static bool expand_matrix(const std::string& resolutions, const std::string& precisions,
+                              const std::string& profiles, std::vector<BuildVariant>& variants,
+                              std::string& error);
+};
+
+// min/opt/max of one input dimension
+struct DimRange {
+    int min = 1;
+    int opt = 1;
+    int max = 1;
+    
+    bool is_fixed() const { return min == max; }
+    std::string label() const;   // "640" or "320-640-640"
+};
+
+// One optimization profile of the main input: batch, height and width ranges.
+// has_size = false takes the size from input_resolution.
+struct OptimizationProfileSpec {
+    DimRange batch;
+    DimRange height;
+    DimRange width;
+    bool has_size = false;
+    
+    std::string label() const;   // e.g. "b1-4-8 320-640-640"
+    
+    // Parses ExportConfig::optimization_profiles
+    static bool parse_list(const std::string& text, std::vector<OptimizationProfileSpec>& profiles,
+                           std::string& error);
+};
+
+// Maps every ExportConfig field to a command-line option and a JSON key.
+// Options: "--name value" for numbers/paths, "--name" / "--no-name" for switches.
+// JSON keys are the ExportConfig field names.
 class ConfigParser {
 public:
-    static ExportConfig parseCommandLine(int argc, char* argv[]);
-    static void printUsage(const std::string& program_name);
+    // Applies options to config; non-option arguments are appended to positional.
+    // Prints an error and returns false on bad input.
+    static bool parseCommandLine(const std::vector<std::string>& args, ExportConfig& config,
+                                 std::vector<std::string>& positional);
+    // Applies a JSON object of field values; unknown keys are errors unless listed in ignoredKeys
+    static bool applyJson(const JsonValue& object, ExportConfig& config, std::string& error,
+                          const std::vector<std::string>& ignoredKeys = {});
+    // Every field as a JSON object; applyJson of the result reproduces config
+    static JsonValue toJson(const ExportConfig& config);
+    static void printOptions();
     static void printVersion();
+    // Whole-string number parsers for option values: no trailing text, no
+    // whitespace, no inf/nan; value is left alone on failure
+    static bool parseInt(const std::string& text, int& value);
+    static bool parseDouble(const std::string& text, double& value);
     
 private:
     static bool isOption(const std::string& arg);
-    static std::string getOptionValue(const std::vector<std::string>& args, size_t& index);
+    static bool getOptionValue(const std::vector<std::string>& args, size_t& index, std::string& value);
 };
 
 // Available TensorRT plugins
@@ -127,4 +251,7 @@ public:
     static std::vector<PluginInfo> getAvailablePlugins();
     static std::string getPluginName(TensorRTPlugin plugin);
     static std::string getPluginDescription(TensorRTPlugin plugin);
+
+    // selected_plugins holds built-in names and custom plugin library paths
+    static bool isBuiltInPlugin(const std::string& name);
 };
\ No newline at end of file
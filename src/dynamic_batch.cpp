@@ -0,0 +1,325 @@
+#include "dynamic_batch.h"
+#include "onnx_shape_inference.h"
+#include <unordered_set>
+
+namespace {
+
+// Second batch size used to tell baked literals from batch-derived values
+constexpr int64_t kProbeBatch = 2;
+
+// Tensors whose contents depend on a runtime graph input
+std::unordered_set<std::string> runtimeDependentTensors(const OnnxGraph& graph) {
+    std::unordered_set<std::string> dependent;
+    for (const OnnxValueInfo* input : graph.runtimeInputs()) {
+        dependent.insert(input->name);
+    }
+    for (const auto& node : graph.nodes) {
+        bool isDependent = false;
+        for (const auto& name : node.inputs) {
+            if (!name.empty() && dependent.count(name)) {
+                isDependent = true;
+                break;
+            }
+        }
+        if (isDependent) {
+            for (const auto& name : node.outputs) dependent.insert(name);
+        }
+    }
+    return dependent;
+}
+
+const OnnxTensor* findConstant(const OnnxGraph& graph, const std::string& name) {
+    if (const OnnxTensor* tensor = graph.findInitializer(name)) return tensor;
+    for (const auto& node : graph.nodes) {
+        if (node.opType == "Constant" && !node.outputs.empty() && node.outputs[0] == name) {
+            const OnnxAttribute* value = node.attr("value");
+            return value ? &value->t : nullptr;
+        }
+    }
+    return nullptr;
+}
+
+OnnxNode makeNode(const std::string& opType, const std::string& name,
+                  const std::vector<std::string>& inputs, const std::vector<std::string>& outputs) {
+    OnnxNode node;
+    node.opType = opType;
+    node.name = name;
+    node.inputs = inputs;
+    node.outputs = outputs;
+    return node;
+}
+
+// Rewrites Reshape targets whose literal at the batch axis was baked in at export
+int rewriteReshapes(OnnxModel& model, const OnnxShapeInference& atOne, const OnnxShapeInference& atProbe,
+                    DynamicBatchReport& report) {
+    OnnxGraph& graph = model.graph;
+    int rewritten = 0;
+    for (auto& node : graph.nodes) {
+        if (node.opType != "Reshape" || node.inputs.size() < 2) continue;
+        if (node.attrInt("allowzero", 0) != 0) continue;
+        const OnnxShapeInfo* data = atOne.find(node.inputs[0]);
+        const OnnxShapeInfo* shape = atOne.find(node.inputs[1]);
+        const OnnxShapeInfo* out = node.outputs.empty() ? nullptr : atOne.find(node.outputs[0]);
+        const OnnxShapeInfo* probeShape = atProbe.find(node.inputs[1]);
+        if (!data || !shape || !out || !probeShape) continue;
+        if (!shape->hasValue || shape->valueBatchIndex >= 0) continue;
+        if (data->batchAxis < 0 || out->batchAxis != data->batchAxis) continue;
+        size_t p = static_cast<size_t>(data->batchAxis);
+        if (p >= shape->value.size() || shape->value[p] <= 0) continue;
+        // A value that moves with the batch size was computed, not baked
+        if (!probeShape->hasValue || probeShape->value != shape->value) continue;
+
+        std::vector<int64_t> target = shape->value;
+        target[p] = 0;
+        std::string name = graph.makeUniqueName(node.inputs[1] + "_dynamic_batch");
+        graph.initializers.push_back(OnnxTensor::fromInt64s(name, {static_cast<int64_t>(target.size())}, target));
+        node.inputs[1] = name;
+        ++rewritten;
+    }
+    report.reshapesRewritten += rewritten;
+    return rewritten;
+}
+
+// Broadcasts one batch-free constant input of a Concat to the runtime batch.
+// Returns false when no such input is left.
+bool broadcastConcatInput(OnnxModel& model, const OnnxShapeInference& inference, DynamicBatchReport& report) {
+    OnnxGraph& graph = model.graph;
+    std::unordered_set<std::string> dependent = runtimeDependentTensors(graph);
+    auto consumers = graph.consumerIndex();
+    auto producers = graph.producerIndex();
+    bool useSliceInputs = model.opsetVersion() >= 10;
+
+    for (size_t n = 0; n < graph.nodes.size(); ++n) {
+        const OnnxNode& concat = graph.nodes[n];
+        if (concat.opType != "Concat") continue;
+        const OnnxShapeInfo* out = concat.outputs.empty() ? nullptr : inference.find(concat.outputs[0]);
+        if (!out || !out->rankKnown) continue;
+
+        // Batch axis and a batch-carrying input to take the runtime extent from
+        int batchAxis = -1;
+        std::string batchSource;
+        for (const auto& name : concat.inputs) {
+            const OnnxShapeInfo* info = inference.find(name);
+            if (info && info->batchAxis >= 0) {
+                batchAxis = info->batchAxis;
+                batchSource = name;
+                break;
+            }
+        }
+        int64_t axis = concat.attrInt("axis", 0);
+        if (axis < 0) axis += static_cast<int64_t>(out->dims.size());
+        if (batchAxis < 0 || batchAxis == axis) continue;
+
+        for (size_t i = 0; i < concat.inputs.size(); ++i) {
+            const std::string& input = concat.inputs[i];
+            const OnnxShapeInfo* info = inference.find(input);
+            if (!info || !info->rankKnown || info->batchAxis >= 0 || dependent.count(input)) continue;
+            if (static_cast<size_t>(batchAxis) >= info->dims.size() || info->dims[batchAxis] != 1) continue;
+            bool fixedDims = true;
+            for (int64_t d : info->dims) fixedDims = fixedDims && d >= 0;
+            if (!fixedDims) continue;
+
+            // Target shape: the input's dims with the batch extent spliced in
+            std::string base = concat.outputs[0] + "_batch";
+            std::string shapeName = graph.makeUniqueName(base + "_shape");
+            std::string startsName = graph.makeUniqueName(base + "_starts");
+            std::string endsName = graph.makeUniqueName(base + "_ends");
+            std::string axesName = graph.makeUniqueName(base + "_axes");
+            std::string extentName = graph.makeUniqueName(base + "_extent");
+            std::string prefixName = graph.makeUniqueName(base + "_prefix");
+            std::string suffixName = graph.makeUniqueName(base + "_suffix");
+            std::string targetName = graph.makeUniqueName(base + "_target");
+
+            std::vector<int64_t> prefix(info->dims.begin(), info->dims.begin() + batchAxis);
+            std::vector<int64_t> suffix(info->dims.begin() + batchAxis + 1, info->dims.end());
+            std::vector<std::string> targetParts;
+            if (!prefix.empty()) {
+                graph.initializers.push_back(OnnxTensor::fromInt64s(prefixName, {static_cast<int64_t>(prefix.size())}, prefix));
+                targetParts.push_back(prefixName);
+            }
+            targetParts.push_back(extentName);
+            if (!suffix.empty()) {
+                graph.initializers.push_back(OnnxTensor::fromInt64s(suffixName, {static_cast<int64_t>(suffix.size())}, suffix));
+                targetParts.push_back(suffixName);
+            }
+
+            std::vector<OnnxNode> inserted;
+            inserted.push_back(makeNode("Shape", graph.makeUniqueName(base + "/Shape"), {batchSource}, {shapeName}));
+            OnnxNode slice = makeNode("Slice", graph.makeUniqueName(base + "/Slice"), {shapeName}, {extentName});
+            if (useSliceInputs) {
+                graph.initializers.push_back(OnnxTensor::fromInt64s(startsName, {1}, {batchAxis}));
+                graph.initializers.push_back(OnnxTensor::fromInt64s(endsName, {1}, {batchAxis + 1}));
+                graph.initializers.push_back(OnnxTensor::fromInt64s(axesName, {1}, {0}));
+                slice.inputs = {shapeName, startsName, endsName, axesName};
+            } else {
+                slice.setAttr(OnnxAttribute::makeInts("starts", {batchAxis}));
+                slice.setAttr(OnnxAttribute::makeInts("ends", {batchAxis + 1}));
+                slice.setAttr(OnnxAttribute::makeInts("axes", {0}));
+            }
+            inserted.push_back(slice);
+            OnnxNode target = makeNode("Concat", graph.makeUniqueName(base + "/Concat"), targetParts, {targetName});
+            target.setAttr(OnnxAttribute::makeInt("axis", 0));
+            inserted.push_back(target);
+
+            // An Expand that only feeds this Concat is regenerated in place
+            // rather than stacking a second Expand on top of it
+            auto producer = producers.find(input);
+            bool rewire = false;
+            if (producer != producers.end()) {
+                const OnnxNode& expand = graph.nodes[producer->second];
+                auto users = consumers.find(input);
+                rewire = expand.opType == "Expand" && users != consumers.end() && users->second.size() == 1 &&
+                         findConstant(graph, expand.input(1)) != nullptr &&
+                         graph.findOutput(input) == nullptr;
+            }
+
+            if (rewire) {
+                OnnxNode expand = graph.nodes[producer->second];
+                expand.inputs[1] = targetName;
+                inserted.push_back(expand);
+                size_t at = n;
+                graph.nodes.insert(graph.nodes.begin() + static_cast<std::ptrdiff_t>(at), inserted.begin(), inserted.end());
+                graph.nodes.erase(graph.nodes.begin() + static_cast<std::ptrdiff_t>(producer->second));
+                ++report.expandsRewritten;
+            } else {
+                std::string expandedName = graph.makeUniqueName(input + "_batched");
+                inserted.push_back(makeNode("Expand", graph.makeUniqueName(base + "/Expand"),
+                                            {input, targetName}, {expandedName}));
+                graph.nodes[n].inputs[i] = expandedName;
+                graph.nodes.insert(graph.nodes.begin() + static_cast<std::ptrdiff_t>(n), inserted.begin(), inserted.end());
+                ++report.expandsInserted;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+void setBatchDim(OnnxValueInfo& valueInfo, size_t axis, const std::string& batchParam) {
+    if (!valueInfo.hasShape || axis >= valueInfo.dims.size()) return;
+    OnnxDim& dim = valueInfo.dims[axis];
+    if (dim.isSymbolic()) return;
+    dim.value = -1;
+    dim.param = batchParam;
+}
+
+} // namespace
+
+bool DynamicBatchConverter::convert(OnnxModel& model, const DynamicBatchOptions& options, DynamicBatchReport& report) {
+    OnnxGraph& graph = model.graph;
+
+    // 1. Symbolic leading dimension on every runtime input
+    std::unordered_set<std::string> initializerNames;
+    for (const auto& tensor : graph.initializers) initializerNames.insert(tensor.name);
+    for (auto& input : graph.inputs) {
+        if (initializerNames.count(input.name)) continue;
+        if (!input.isTensor || !input.hasShape || input.dims.empty()) {
+            report.warnings.push_back("input '" + input.name + "' has no known rank, left unchanged");
+            continue;
+        }
+        OnnxDim& dim = input.dims[0];
+        if (dim.isSymbolic()) continue;
+        if (dim.value != 1) {
+            report.errors.push_back("input '" + input.name + "' has leading dimension " +
+                                    std::to_string(dim.value) + ", expected a batch-1 export");
+            continue;
+        }
+        dim.value = -1;
+        dim.param = options.batchParam;
+        report.inputsChanged.push_back(input.name);
+    }
+    if (!report.errors.empty()) return false;
+
+    // 2. Reshape targets. Inference at batch 1 locates the batch axis; a second
+    //    run at another size separates baked literals from computed values.
+    {
+        OnnxShapeInference atOne(model);
+        OnnxShapeInference atProbe(model);
+        atOne.setBatchSize(1);
+        atProbe.setBatchSize(kProbeBatch);
+        if (!atOne.run()) {
+            for (const auto& e : atOne.errors()) report.errors.push_back(e);
+            return false;
+        }
+        atProbe.run();
+        rewriteReshapes(model, atOne, atProbe, report);
+    }
+
+    // 3. Batch-free constants concatenated with activations, one at a time since
+    //    each rewrite shifts node indices
+    for (size_t guard = 0; guard < graph.nodes.size(); ++guard) {
+        OnnxShapeInference inference(model);
+        inference.setBatchSize(1);
+        inference.run();
+        if (!broadcastConcatInput(model, inference, report)) break;
+    }
+    graph.pruneUnusedInitializers();
+
+    // 4. Declared output and intermediate shapes
+    OnnxShapeInference result(model);
+    result.setBatchSize(1);
+    if (!result.run()) {
+        for (const auto& e : result.errors()) report.errors.push_back(e);
+        return false;
+    }
+    for (const auto& w : result.warnings()) report.warnings.push_back(w);
+    for (auto& output : graph.outputs) {
+        const OnnxShapeInfo* info = result.find(output.name);
+        if (!info || info->batchAxis < 0) {
+            report.warnings.push_back("output '" + output.name + "' does not carry the batch dimension");
+            continue;
+        }
+        if (!output.hasShape && info->rankKnown) {
+            output.hasShape = true;
+            output.dims.resize(info->dims.size());
+            for (size_t i = 0; i < info->dims.size(); ++i) output.dims[i].value = info->dims[i];
+        }
+        setBatchDim(output, static_cast<size_t>(info->batchAxis), options.batchParam);
+    }
+    for (auto& valueInfo : graph.valueInfo) {
+        const OnnxShapeInfo* info = result.find(valueInfo.name);
+        if (info && info->batchAxis >= 0) {
+            setBatchDim(valueInfo, static_cast<size_t>(info->batchAxis), options.batchParam);
+        }
+    }
+
+    // 5. CPU check at the requested batch sizes
+    std::vector<std::string> verifyErrors;
+    if (!verify(model, options.checkBatchSizes, verifyErrors)) {
+        for (const auto& e : verifyErrors) report.errors.push_back(e);
+        return false;
+    }
+    return true;
+}
+
+bool DynamicBatchConverter::verify(const OnnxModel& model, const std::vector<int64_t>& batchSizes,
+                                   std::vector<std::string>& errors) {
+    size_t before = errors.size();
+    bool hasBatch = false;
+    for (const OnnxValueInfo* input : model.graph.runtimeInputs()) {
+        hasBatch = hasBatch || (input->hasShape && !input->dims.empty() && !input->dims[0].isFixed());
+    }
+    if (!hasBatch) {
+        errors.push_back("no graph input has a symbolic leading dimension");
+        return false;
+    }
+    for (int64_t batch : batchSizes) {
+        OnnxShapeInference inference(model);
+        inference.setBatchSize(batch);
+        std::string prefix = "batch " + std::to_string(batch) + ": ";
+        if (!inference.run()) {
+            for (const auto& e : inference.errors()) errors.push_back(prefix + e);
+            continue;
+        }
+        for (const auto& output : model.graph.outputs) {
+            const OnnxShapeInfo* info = inference.find(output.name);
+            if (!info || !info->rankKnown) {
+                errors.push_back(prefix + "output '" + output.name + "' has unknown shape");
+            } else if (info->batchAxis < 0 || info->dims[info->batchAxis] != batch) {
+                errors.push_back(prefix + "output '" + output.name + "' " + info->toString() +
+                                 " does not carry the batch dimension");
+            }
+        }
+    }
+    return errors.size() == before;
+}
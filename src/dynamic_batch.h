@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "onnx_model.h"
+
+struct DynamicBatchOptions {
+    std::string batchParam = "batch";                    // symbolic name given to the leading dimension
+    std::vector<int64_t> checkBatchSizes = {1, 2, 8};    // batch sizes verified after the rewrite
+};
+
+struct DynamicBatchReport {
+    std::vector<std::string> inputsChanged;
+    int reshapesRewritten = 0;
+    int expandsInserted = 0;
+    int expandsRewritten = 0;
+    std::vector<std::string> warnings;
+    std::vector<std::string> errors;
+};
+
+// Turns the leading dimension of a static batch-1 ONNX export into a symbolic
+// batch dimension.
+//
+// Exporters bake batch=1 into Reshape targets ([1, 3, 85, -1]) and into
+// constant tensors concatenated with activations (class tokens, anchors).
+// Shape inference at batch 1 finds both: a Reshape target whose literal sits
+// on the input's batch axis is rewritten to 0 ("copy from input"), and a
+// batch-free constant concatenated with batch-carrying tensors is broadcast
+// to the runtime batch through Shape -> Slice -> Concat -> Expand. The result
+// is then checked by running shape inference at several batch sizes.
+class DynamicBatchConverter {
+public:
+    static bool convert(OnnxModel& model, const DynamicBatchOptions& options, DynamicBatchReport& report);
+
+    // CPU shape check: every output must carry the batch dimension at each size
+    static bool verify(const OnnxModel& model, const std::vector<int64_t>& batchSizes,
+                       std::vector<std::string>& errors);
+};
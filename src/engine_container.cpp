@@ -0,0 +1,193 @@
+#include "engine_container.h"
+#include "plan_codec.h"
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+
+namespace {
+
+const char kMagic[8] = {'T', 'R', 'T', 'X', 'E', 'N', 'G', '1'};
+const size_t kFixedSize = 24;
+const uint32_t kMaxMetadataSize = 16u << 20;
+
+// Hosts are little-endian (x86-64 / ARM64), like the onnx_model wire helpers
+template <typename T>
+void appendRaw(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+T readRaw(const unsigned char* data) {
+    T value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+// Fixed fields and metadata; the caller has checked that the metadata is in range
+bool parseHeader(const unsigned char* bytes, JsonValue& metadata) {
+    uint32_t version = readRaw<uint32_t>(bytes + 8);
+    uint32_t metadataSize = readRaw<uint32_t>(bytes + 12);
+    uint64_t planOffset = readRaw<uint64_t>(bytes + 16);
+    if (version > EngineContainer::kVersion) {
+        std::cerr << "Error: Engine container version " << version << " is newer than this tool ("
+                  << EngineContainer::kVersion << ")\n";
+        return false;
+    }
+    if (metadataSize > kMaxMetadataSize || planOffset < kFixedSize + metadataSize ||
+        planOffset % EngineContainer::kPlanAlignment != 0) {
+        std::cerr << "Error: Engine container header is damaged\n";
+        return false;
+    }
+
+    std::string error;
+    std::string json(reinterpret_cast<const char*>(bytes + kFixedSize), metadataSize);
+    if (!JsonValue::parse(json, metadata, error) || !metadata.isObject()) {
+        std::cerr << "Error: Engine container metadata is damaged: " << error << "\n";
+        metadata = JsonValue();
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+std::string EngineContainer::makeHeader(const JsonValue& metadata) {
+    std::string json = metadata.dump(2);
+    uint64_t planOffset = (kFixedSize + json.size() + kPlanAlignment - 1) / kPlanAlignment * kPlanAlignment;
+
+    std::string header(kMagic, sizeof(kMagic));
+    appendRaw(header, kVersion);
+    appendRaw(header, static_cast<uint32_t>(json.size()));
+    appendRaw(header, planOffset);
+    header += json;
+    header.resize(static_cast<size_t>(planOffset), '\0');
+    return header;
+}
+
+bool EngineContainer::isContainer(const void* data, size_t size) {
+    return size >= kFixedSize && std::memcmp(data, kMagic, sizeof(kMagic)) == 0;
+}
+
+bool EngineContainer::read(const void* data, size_t size, JsonValue& metadata, uint64_t& planOffset) {
+    if (!isContainer(data, size)) {
+        std::cerr << "Error: Not an engine container\n";
+        return false;
+    }
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    uint32_t metadataSize = readRaw<uint32_t>(bytes + 12);
+    planOffset = readRaw<uint64_t>(bytes + 16);
+    if (metadataSize > size - kFixedSize || planOffset > size) {
+        std::cerr << "Error: Engine container is truncated\n";
+        return false;
+    }
+    return parseHeader(bytes, metadata);
+}
+
+bool EngineContainer::unpack(const char* data, size_t size, EnginePlan& plan) {
+    plan = EnginePlan();
+    if (!isContainer(data, size)) {
+        plan.data = data;
+        plan.size = size;
+        return true;
+    }
+    uint64_t planOffset = 0;
+    if (!read(data, size, plan.metadata, planOffset)) {
+        return false;
+    }
+    const JsonValue* encoding = plan.metadata.find("plan_encoding");
+    std::string name = encoding ? encoding->asString() : kEncodingRaw;
+    if (name == kEncodingRaw) {
+        plan.data = data + planOffset;
+        plan.size = size - static_cast<size_t>(planOffset);
+        return true;
+    }
+    if (name != kEncodingBlocks) {
+        std::cerr << "Error: Unknown engine plan encoding: " << name << "\n";
+        return false;
+    }
+    if (!PlanDecompressor::run(data + planOffset, size - static_cast<size_t>(planOffset), plan.decoded)) {
+        return false;
+    }
+    plan.data = plan.decoded.data();
+    plan.size = plan.decoded.size();
+    plan.compressed = true;
+    return true;
+}
+
+bool EngineContainer::readMetadata(const std::string& path, JsonValue& metadata) {
+    metadata = JsonValue();
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        std::cerr << "Error: Cannot open engine file: " << path << "\n";
+        return false;
+    }
+    uint64_t fileSize = static_cast<uint64_t>(file.tellg());
+    file.seekg(0);
+    std::string header(kFixedSize, '\0');
+    if (!file.read(&header[0], kFixedSize) || !isContainer(header.data(), header.size())) {
+        return true;    // bare plan (or too short to be anything else)
+    }
+
+    // The plan stays on disk; only the fixed fields and the metadata are read
+    const unsigned char* fixed = reinterpret_cast<const unsigned char*>(header.data());
+    uint32_t metadataSize = readRaw<uint32_t>(fixed + 12);
+    uint64_t planOffset = readRaw<uint64_t>(fixed + 16);
+    if (metadataSize > fileSize - kFixedSize || planOffset > fileSize) {
+        std::cerr << "Error: Engine container is truncated: " << path << "\n";
+        return false;
+    }
+    header.resize(kFixedSize + metadataSize);
+    if (!file.read(&header[kFixedSize], metadataSize) ||
+        !parseHeader(reinterpret_cast<const unsigned char*>(header.data()), metadata)) {
+        std::cerr << "Error: Cannot read engine container header: " << path << "\n";
+        metadata = JsonValue();
+        return false;
+    }
+    return true;
+}
+
+std::vector<std::string> EngineContainer::parseClassNames(const std::string& text) {
+    // Python dict repr or JSON list: quoted names, each optionally after an "index:" key
+    std::map<int, std::string> byIndex;
+    int nextIndex = 0;
+    int key = -1;
+    for (size_t i = 0; i < text.size(); ++i) {
+        char c = text[i];
+        if (std::isdigit(static_cast<unsigned char>(c))) {
+            size_t end = i;
+            while (end < text.size() && std::isdigit(static_cast<unsigned char>(text[end]))) ++end;
+            size_t colon = end;
+            while (colon < text.size() && text[colon] == ' ') ++colon;
+            if (colon < text.size() && text[colon] == ':') {
+                key = std::atoi(text.substr(i, end - i).c_str());
+                i = colon;
+            } else {
+                i = end - 1;
+            }
+        } else if (c == '\'' || c == '"') {
+            std::string name;
+            size_t j = i + 1;
+            for (; j < text.size() && text[j] != c; ++j) {
+                if (text[j] == '\\' && j + 1 < text.size()) ++j;
+                name += text[j];
+            }
+            if (j >= text.size()) return {};    // unterminated string
+            int index = key >= 0 ? key : nextIndex;
+            byIndex[index] = name;
+            nextIndex = index + 1;
+            key = -1;
+            i = j;
+        }
+    }
+
+    // Indices are expected to be 0..n-1; a gap means the text was something else
+    std::vector<std::string> names;
+    for (const auto& entry : byIndex) {
+        if (entry.first != static_cast<int>(names.size())) return {};
+        names.push_back(entry.second);
+    }
+    return names;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "json.h"
+
+// TensorRT plan of an engine file, ready for deserializeCudaEngine
+struct EnginePlan {
+    JsonValue metadata;             // null for a bare plan
+    const char* data = nullptr;     // into the file bytes, or into decoded
+    size_t size = 0;
+    std::vector<char> decoded;      // compressed plans only
+    bool compressed = false;
+};
+
+// Engine file that describes itself (ExportConfig::engine_container):
+//
+//   0   char[8]  "TRTXENG1"
+//   8   uint32   format version (little-endian)
+//   12  uint32   metadata size in bytes
+//   16  uint64   plan offset, a multiple of kPlanAlignment
+//   24  metadata JSON, zero padding, then the TensorRT plan up to end of file
+//
+// The metadata names the I/O tensors with their dtypes, shapes and layouts, the
+// preprocessing and postprocessing the model expects, its class names, the
+// source model hash and the ExportConfig, so a loader binds I/O without
+// guessing and tools read it without deserializing the plan. The plan size is
+// not stored: the builder streams the plan after the header. Its metadata
+// "plan_encoding" is "raw", or "lz4_blocks" for PlanCompressor frames.
+class EngineContainer {
+public:
+    static constexpr uint32_t kVersion = 1;
+    static constexpr uint64_t kPlanAlignment = 4096;    // plan starts page-aligned for mapped loads
+    static constexpr const char* kEncodingRaw = "raw";
+    static constexpr const char* kEncodingBlocks = "lz4_blocks";
+
+    // Detection thresholds recorded in the "postprocess" metadata, and what
+    // loaders use when a container (or a bare plan) has none
+    static constexpr double kScoreThreshold = 0.25;
+    static constexpr double kIouThreshold = 0.45;
+
+    // Header bytes (fixed fields, metadata, padding) to write ahead of the plan
+    static std::string makeHeader(const JsonValue& metadata);
+
+    static bool isContainer(const void* data, size_t size);
+
+    // Metadata and plan offset of a container; prints an error and returns false if it is damaged
+    static bool read(const void* data, size_t size, JsonValue& metadata, uint64_t& planOffset);
+
+    // The plan in a bare plan or container (decompressed on all cores if need be);
+    // `data` must outlive `plan`. Prints an error and returns false if it is damaged.
+    static bool unpack(const char* data, size_t size, EnginePlan& plan);
+
+    // Reads only the header. A bare plan leaves metadata null and returns true;
+    // false if the file is unreadable or a damaged container.
+    static bool readMetadata(const std::string& path, JsonValue& metadata);
+
+    // Class names from the ONNX "names" metadata written by Ultralytics,
+    // "{0: 'person', 1: 'bicycle'}", or a JSON list; empty if neither
+    static std::vector<std::string> parseClassNames(const std::string& text);
+};
@@ -1,8 +1,63 @@
 #include "engine_exporter.h"
+#include "build_progress.h"
+#include "dynamic_batch.h"
+#include "engine_container.h"
+#include "engine_file.h"
+#include "engine_refit.h"
+#include "engine_store.h"
+#include "file_utils.h"
+#include "calibration_cache.h"
+#include "calibration_shard.h"
+#include "calibration_subset.h"
+#include "image_preprocess.h"
+#include "int8_calibrator.h"
+#include "onnx_model.h"
+#include "plugin_loader.h"
+#include "precision_policy.h"
+#include "sha256.h"
+#include "timing_cache.h"
+#include <algorithm>
 #include <fstream>
 #include <filesystem>
+#include <iomanip>
 #include <iostream>
 #include <chrono>
+#include <numeric>
+#include <set>
+#include <sstream>
+
+namespace {
+
+const char* dataTypeName(nvinfer1::DataType type) {
+    switch (type) {
+    case nvinfer1::DataType::kFLOAT: return "float32";
+    case nvinfer1::DataType::kHALF: return "float16";
+    case nvinfer1::DataType::kBF16: return "bfloat16";
+    case nvinfer1::DataType::kFP8: return "fp8";
+    case nvinfer1::DataType::kINT8: return "int8";
+    case nvinfer1::DataType::kUINT8: return "uint8";
+    case nvinfer1::DataType::kINT32: return "int32";
+    case nvinfer1::DataType::kINT64: return "int64";
+    case nvinfer1::DataType::kBOOL: return "bool";
+    default: return "other";
+    }
+}
+
+// Name, dtype, shape (-1 = dynamic) and layout of a network input or output
+JsonValue tensorInfo(const nvinfer1::ITensor& tensor) {
+    nvinfer1::Dims dims = tensor.getDimensions();
+    JsonValue shape = JsonValue::makeArray();
+    for (int32_t i = 0; i < dims.nbDims; ++i) shape.push(static_cast<int64_t>(dims.d[i]));
+
+    JsonValue info = JsonValue::makeObject();
+    info.set("name", tensor.getName());
+    info.set("dtype", dataTypeName(tensor.getType()));
+    info.set("shape", shape);
+    if (dims.nbDims == 4) info.set("layout", "NCHW");
+    return info;
+}
+
+} // namespace
 
 EngineExporter::EngineExporter(const ExportConfig& config) 
     : m_config(config), m_logger(config.verbose) {
@@ -13,6 +68,8 @@ EngineExporter::~EngineExporter() = default;
 bool EngineExporter::exportEngine() {
     std::cout << "Starting ONNX to TensorRT engine conversion...\n";
     
+    m_report.reset();
+    m_report.beginPhase("validate");
     if (!validateInputFile()) {
         return false;
     }
@@ -21,9 +78,27 @@ bool EngineExporter::exportEngine() {
         return false;
     }
     
+    if (!m_config.refit_engine.empty()) {
+        return refitEngine();
+    }
+    
+    if (!resolveProfiles()) {
+        return false;
+    }
+    
     auto start_time = std::chrono::high_resolution_clock::now();
     
+    if (!m_config.engine_store_dir.empty()) {
+        m_report.beginPhase("store_lookup");
+    }
+    if (fetchFromEngineStore()) {
+        std::cout << "\nEngine taken from store, build skipped.\n";
+        std::cout << "Output: " << m_config.get_output_path() << "\n";
+        return true;
+    }
+    
     // Create TensorRT builder
+    m_report.beginPhase("parse");
     m_builder.reset(nvinfer1::createInferBuilder(m_logger));
     if (!m_builder) {
         std::cerr << "Error: Failed to create TensorRT builder\n";
@@ -31,18 +106,24 @@ bool EngineExporter::exportEngine() {
     }
     
     if (!loadOnnxModel()) {
-        return false;
+        return finishBuildReport(false);
     }
     
     printModelInfo();
     
     if (!buildEngine()) {
-        return false;
+        return finishBuildReport(false);
     }
     
     if (!saveEngine()) {
-        return false;
+        return finishBuildReport(false);
+    }
+    
+    if (!m_config.engine_store_dir.empty()) {
+        m_report.beginPhase("store_put");
     }
+    putIntoEngineStore();
+    finishBuildReport(true);
     
     auto end_time = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::seconds>(end_time - start_time);
@@ -54,6 +135,136 @@ bool EngineExporter::exportEngine() {
     return true;
 }
 
+bool EngineExporter::exportMatrix(const std::vector<BuildVariant>& variants, std::vector<VariantResult>& results) {
+    std::cout << "Starting build matrix (" << variants.size() << " variants)...\n";
+    results.clear();
+    
+    if (variants.empty()) {
+        std::cerr << "Error: Build matrix is empty\n";
+        return false;
+    }
+    
+    if (!validateInputFile()) {
+        return false;
+    }
+    
+    m_builder.reset(nvinfer1::createInferBuilder(m_logger));
+    if (!m_builder) {
+        std::cerr << "Error: Failed to create TensorRT builder\n";
+        return false;
+    }
+    
+    // Static variants first, so the network is parsed at most twice
+    std::vector<size_t> order(variants.size());
+    std::iota(order.begin(), order.end(), size_t{0});
+    std::stable_sort(order.begin(), order.end(), [&variants](size_t a, size_t b) {
+        return !variants[a].dynamic_batch && variants[b].dynamic_batch;
+    });
+    
+    const ExportConfig base = m_config;
+    bool parsed = false;
+    bool parsedDynamic = false;
+    results.resize(variants.size());
+    for (size_t n = 0; n < order.size(); ++n) {
+        size_t index = order[n];
+        m_config = base;
+        variants[index].apply_to(m_config);
+        
+        VariantResult& result = results[index];
+        result.label = variants[index].label();
+        result.outputPath = m_config.get_output_path();
+        if (m_progress && m_progress->cancelled()) {
+            continue;   // reported as failed, like any variant that was not built
+        }
+        std::cout << "\n=== Variant " << (n + 1) << "/" << order.size() << ": " << result.label << " ===\n";
+        
+        auto start_time = std::chrono::high_resolution_clock::now();
+        result.success = buildVariant(parsed, parsedDynamic, result);
+        auto end_time = std::chrono::high_resolution_clock::now();
+        result.seconds = std::chrono::duration<double>(end_time - start_time).count();
+        
+        std::error_code ec;
+        if (result.success) {
+            result.engineBytes = static_cast<uint64_t>(std::filesystem::file_size(result.outputPath, ec));
+        }
+        m_engineFile.reset();
+    }
+    m_config = base;
+    
+    writeMatrixReport(results);
+    return std::all_of(results.begin(), results.end(), [](const VariantResult& r) { return r.success; });
+}
+
+bool EngineExporter::buildVariant(bool& parsed, bool& parsedDynamic, VariantResult& result) {
+    m_report.reset();
+    m_report.beginPhase("validate");
+    if (!validateOutputPath()) {
+        return false;
+    }
+    
+    if (!resolveProfiles()) {
+        return false;
+    }
+    
+    m_storeKey.clear();
+    if (!m_config.engine_store_dir.empty()) {
+        m_report.beginPhase("store_lookup");
+    }
+    if (fetchFromEngineStore()) {
+        result.fromStore = true;
+        return true;
+    }
+    
+    // The parsed network only depends on the dynamic batch rewrite; resolution,
+    // precision and batch range are all builder config / profile settings
+    if (!parsed || parsedDynamic != needsSymbolicBatch()) {
+        m_report.beginPhase("parse");
+        m_parser.reset();
+        m_network.reset();
+        parsed = false;
+        if (!loadOnnxModel()) {
+            return finishBuildReport(false);
+        }
+        printModelInfo();
+        parsed = true;
+        parsedDynamic = needsSymbolicBatch();
+    }
+    
+    if (!buildEngine() || !saveEngine()) {
+        return finishBuildReport(false);
+    }
+    if (!m_config.engine_store_dir.empty()) {
+        m_report.beginPhase("store_put");
+    }
+    putIntoEngineStore();
+    return finishBuildReport(true);
+}
+
+void EngineExporter::writeMatrixReport(const std::vector<VariantResult>& results) {
+    std::ostringstream table;
+    table << std::left << std::setw(24) << "Variant" << std::setw(8) << "Status"
+          << std::right << std::setw(10) << "Time (s)" << std::setw(12) << "Size (MB)" << "  Output\n";
+    for (const auto& r : results) {
+        const char* status = !r.success ? "FAILED" : (r.fromStore ? "STORE" : "BUILT");
+        table << std::left << std::setw(24) << r.label << std::setw(8) << status
+              << std::right << std::fixed << std::setprecision(1) << std::setw(10) << r.seconds
+              << std::setw(12) << (r.engineBytes / 1024.0 / 1024.0) << "  " << r.outputPath << "\n";
+    }
+    
+    std::cout << "\nBuild matrix summary:\n" << table.str();
+    
+    std::filesystem::path reportDir = std::filesystem::path(results.front().outputPath).parent_path();
+    std::string stem = std::filesystem::path(m_config.input_onnx_path).stem().string();
+    std::filesystem::path reportPath = reportDir / (stem + "_matrix.txt");
+    std::ofstream report(reportPath);
+    report << "Model: " << m_config.input_onnx_path << "\n\n" << table.str();
+    if (report.good()) {
+        std::cout << "Matrix report: " << reportPath.string() << "\n";
+    } else {
+        std::cerr << "Warning: Cannot write matrix report: " << reportPath.string() << "\n";
+    }
+}
+
 bool EngineExporter::validateInputFile() {
     if (!std::filesystem::exists(m_config.input_onnx_path)) {
         std::cerr << "Error: Input ONNX file does not exist: " << m_config.input_onnx_path << "\n";
@@ -98,6 +309,11 @@ bool EngineExporter::loadOnnxModel() {
         return false;
     }
     
+    // Plugins register before the parser looks any op up
+    if (!PluginLoader::load(m_config)) {
+        return false;
+    }
+    
     // Create ONNX parser
     m_parser.reset(nvonnxparser::createParser(*m_network, m_logger));
     if (!m_parser) {
@@ -105,6 +321,20 @@ bool EngineExporter::loadOnnxModel() {
         return false;
     }
     
+    if (needsSymbolicBatch()) {
+        return loadDynamicBatchModel();
+    }
+    
+    // Only the node list is read; the weights are left to the parser
+    std::vector<OnnxNode> nodes;
+    if (!OnnxModel::readNodes(m_config.input_onnx_path, nodes)) {
+        std::cerr << "Error: Cannot read ONNX graph: " << m_config.input_onnx_path << "\n";
+        return false;
+    }
+    if (!PluginLoader::checkGraph(nodes, *m_parser)) {
+        return false;
+    }
+    
     // Parse ONNX file
     if (!m_parser->parseFromFile(m_config.input_onnx_path.c_str(), 
                                 static_cast<int>(nvinfer1::ILogger::Severity::kWARNING))) {
@@ -115,6 +345,47 @@ bool EngineExporter::loadOnnxModel() {
     return true;
 }
 
+bool EngineExporter::loadDynamicBatchModel() {
+    OnnxModel model;
+    if (!model.loadFromFile(m_config.input_onnx_path)) {
+        return false;
+    }
+    if (!PluginLoader::checkGraph(model.graph.nodes, *m_parser)) {
+        return false;
+    }
+    
+    DynamicBatchOptions options;
+    options.checkBatchSizes.clear();
+    for (const auto& profile : m_profiles) {
+        options.checkBatchSizes.push_back(profile.batch.min);
+        options.checkBatchSizes.push_back(profile.batch.opt);
+        options.checkBatchSizes.push_back(profile.batch.max);
+    }
+    std::sort(options.checkBatchSizes.begin(), options.checkBatchSizes.end());
+    options.checkBatchSizes.erase(std::unique(options.checkBatchSizes.begin(), options.checkBatchSizes.end()),
+                                  options.checkBatchSizes.end());
+    std::cout << "Converting to dynamic batch (" << options.checkBatchSizes.front() << "-"
+              << options.checkBatchSizes.back() << ")...\n";
+    DynamicBatchReport report;
+    if (!DynamicBatchConverter::convert(model, options, report)) {
+        for (const auto& e : report.errors) std::cerr << "Error: " << e << "\n";
+        std::cerr << "Error: Dynamic batch conversion failed\n";
+        return false;
+    }
+    for (const auto& w : report.warnings) std::cout << "  Warning: " << w << "\n";
+    std::cout << "  Reshape targets rewritten: " << report.reshapesRewritten
+              << ", Expand nodes inserted/regenerated: " << report.expandsInserted << "/" << report.expandsRewritten << "\n";
+    
+    // Parse from memory; the model path lets the parser resolve external weights
+    std::string buffer = model.serialize();
+    if (!m_parser->parse(buffer.data(), buffer.size(), m_config.input_onnx_path.c_str())) {
+        std::cerr << "Error: Failed to parse converted ONNX model\n";
+        return false;
+    }
+    
+    return true;
+}
+
 void EngineExporter::printModelInfo() {
     if (!m_network) return;
     
@@ -136,6 +407,8 @@ void EngineExporter::printModelInfo() {
 
 bool EngineExporter::buildEngine() {
     std::cout << "\nBuilding TensorRT engine...\n";
+    m_report.beginPhase("config");
+    m_report.set("network_layers", m_network->getNbLayers());
     
     // Create builder config
     m_builderConfig.reset(m_builder->createBuilderConfig());
@@ -145,15 +418,69 @@ bool EngineExporter::buildEngine() {
     }
     
     setupBuilderConfig();
-    setupOptimizationProfile();
+    if (!applyPrecisionPolicy()) {
+        return false;
+    }
+    if (!setupCompatibility()) {
+        return false;
+    }
+    if (!setupOptimizationProfiles()) {
+        return false;
+    }
+    loadTimingCache();
+    if (m_progress) {
+        m_builderConfig->setProgressMonitor(m_progress);
+    }
+    m_report.set("applied", appliedSettings());
+    
+    // Entries the build adds to the timing cache are the layers it had to time
+    // (misses); TensorRT does not count lookups that were served from the cache
+    const nvinfer1::ITimingCache* timingCache = m_builderConfig->getTimingCache();
+    int64_t cacheEntriesBefore = timingCache ? timingCache->queryKeys(nullptr, 0) : 0;
     
-    // Build engine
-    m_engine.reset(m_builder->buildEngineWithConfig(*m_network, *m_builderConfig));
-    if (!m_engine) {
+    // Build engine; the plan streams into a temporary file next to the output
+    m_report.beginPhase("build");
+    m_engineFile = std::make_unique<EngineFileWriter>(m_config.get_output_path());
+    if (!m_engineFile->isOpen()) {
+        m_engineFile.reset();
+        return false;
+    }
+    if (m_config.engine_container || m_config.compress_engine) {
+        std::string header = EngineContainer::makeHeader(engineMetadata());
+        if (m_engineFile->write(header.data(), static_cast<int64_t>(header.size())) < 0) {
+            std::cerr << "Error: Failed to write engine container header\n";
+            m_engineFile.reset();
+            return false;
+        }
+        if (m_config.compress_engine) {
+            m_engineFile->compressFollowingWrites();
+        }
+    }
+    bool built = m_builder->buildSerializedNetworkToStream(*m_network, *m_builderConfig, *m_engineFile);
+    if (timingCache) {
+        int64_t cacheEntriesAfter = timingCache->queryKeys(nullptr, 0);
+        JsonValue cacheFacts = JsonValue::makeObject();
+        cacheFacts.set("file", m_timingCachePath);
+        cacheFacts.set("entries_before", cacheEntriesBefore);
+        cacheFacts.set("entries_after", cacheEntriesAfter);
+        cacheFacts.set("misses", cacheEntriesAfter - cacheEntriesBefore);
+        m_report.set("timing_cache", cacheFacts);
+    }
+    if (!built) {
+        m_engineFile.reset();
+        if (m_progress && m_progress->cancelled()) {
+            // Give back the builder's device memory (calibration buffers included) right away
+            m_builderConfig.reset();
+            m_int8Calibrator.reset();
+            std::cout << "Build cancelled\n";
+            return false;
+        }
         std::cerr << "Error: Failed to build TensorRT engine\n";
         return false;
     }
     
+    saveTimingCache();
+    
     std::cout << "Engine built successfully\n";
     return true;
 }
@@ -186,56 +513,37 @@ void EngineExporter::setupBuilderConfig() {
     
     // ========== 에임봇 최고 속도 최적화 플래그 ==========
     
-    // INT8 정밀도 (cache-driven; or QAT if assume_qat_quantized)
+    // INT8 정밀도 (QAT if assume_qat_quantized, else calibration cache or calibration images)
     if (m_config.enable_int8 && m_builder->platformHasFastInt8()) {
         // 1) QAT 경로: ONNX에 Q/DQ가 있다고 가정 → 바로 INT8 활성화
         if (m_config.assume_qat_quantized) {
             m_builderConfig->setFlag(nvinfer1::BuilderFlag::kINT8);
             std::cout << "  INT8 precision: Enabled (assume QAT)\n";
         }
-        // 2) Calibration cache 경로: 데이터 없이 캐시만 사용
-        else if (!m_config.int8_calib_cache.empty()) {
-            class CacheOnlyCalibrator final : public nvinfer1::IInt8EntropyCalibrator2 {
-            public:
-                explicit CacheOnlyCalibrator(const std::string& cachePath, int batch)
-                    : m_cachePath(cachePath), m_batchSize(batch) {
-                    std::ifstream f(m_cachePath, std::ios::binary);
-                    if (f) {
-                        m_cache.assign(std::istreambuf_iterator<char>(f), {});
-                    }
-                }
-                int getBatchSize() const noexcept override { return m_batchSize; }
-                bool getBatch(void*[], const char*[], int) noexcept override { return false; }
-                const void* readCalibrationCache(size_t& length) noexcept override {
-                    if (m_cache.empty()) { length = 0; return nullptr; }
-                    length = m_cache.size();
-                    return m_cache.data();
-                }
-                void writeCalibrationCache(const void* cache, size_t length) noexcept override {
-                    try {
-                        std::ofstream f(m_cachePath, std::ios::binary);
-                        f.write(reinterpret_cast<const char*>(cache), static_cast<std::streamsize>(length));
-                        f.close();
-                    } catch (...) {}
-                }
-            private:
-                std::string m_cachePath;
-                int m_batchSize;
-                std::vector<char> m_cache;
-            };
-            if (std::filesystem::exists(m_config.int8_calib_cache)) {
-                m_int8Calibrator.reset(new CacheOnlyCalibrator(m_config.int8_calib_cache, m_config.calib_batch_size));
+        // 2) Calibration cache 경로: 캐시가 있으면 데이터 없이 캐시만 사용
+        else if (!m_config.int8_calib_cache.empty() && std::filesystem::exists(m_config.int8_calib_cache)) {
+            if (checkCalibrationCache()) {
+                m_int8Calibrator.reset(new Int8EntropyCalibrator(m_config.int8_calib_cache, m_network->getInput(0)->getName(),
+                                                                 m_config.calib_batch_size));
                 m_builderConfig->setFlag(nvinfer1::BuilderFlag::kINT8);
                 m_builderConfig->setInt8Calibrator(m_int8Calibrator.get());
                 std::cout << "  INT8 precision: Enabled (cache)\n";
-            } else {
-                std::cout << "  INT8 requested but no calibration cache found: " << m_config.int8_calib_cache << "\n";
-                std::cout << "  -> Provide a valid cache or enable 'Assume QAT' for Q/DQ models.\n";
             }
         }
-        // 3) Neither QAT nor cache → 안내만 출력
+        // 3) Calibration data 경로: 이미지 폴더로 보정 (캐시 경로가 있으면 결과 저장)
+        else if (!m_config.int8_calib_data_dir.empty()) {
+            if (setupDataCalibrator()) {
+                m_builderConfig->setFlag(nvinfer1::BuilderFlag::kINT8);
+                m_builderConfig->setInt8Calibrator(m_int8Calibrator.get());
+            }
+        }
+        else if (!m_config.int8_calib_cache.empty()) {
+            std::cout << "  INT8 requested but no calibration cache found: " << m_config.int8_calib_cache << "\n";
+            std::cout << "  -> Provide a valid cache, a calibration data folder, or enable 'Assume QAT' for Q/DQ models.\n";
+        }
+        // 4) Neither QAT, cache nor data → 안내만 출력
         else {
-            std::cout << "  INT8 requested but neither QAT nor calibration cache provided. Skipping INT8.\n";
+            std::cout << "  INT8 requested but neither QAT, calibration cache nor calibration data provided. Skipping INT8.\n";
         }
     }
     
@@ -263,7 +571,12 @@ void EngineExporter::setupBuilderConfig() {
         m_builderConfig->setFlag(nvinfer1::BuilderFlag::kSPARSE_WEIGHTS);
     }
     
-    if (m_config.enable_refit) {
+    if (m_config.strip_weights) {
+        // Weights come back from the same ONNX at load time, so they are identical
+        // by construction and the builder may still specialize kernels on them
+        m_builderConfig->setFlag(nvinfer1::BuilderFlag::kSTRIP_PLAN);
+        m_builderConfig->setFlag(nvinfer1::BuilderFlag::kREFIT_IDENTICAL);
+    } else if (m_config.enable_refit) {
         m_builderConfig->setFlag(nvinfer1::BuilderFlag::kREFIT);
     }
     
@@ -298,7 +611,11 @@ void EngineExporter::setupBuilderConfig() {
     if (m_config.enable_tf32) std::cout << "  - TF32: Enabled\n";
     if (m_config.enable_sparse_weights) std::cout << "  - Sparse Weights: Enabled\n";
     if (m_config.enable_direct_io) std::cout << "  - Direct I/O: Enabled\n";
-    if (m_config.enable_refit) std::cout << "  - REFIT: Enabled\n";
+    if (m_config.strip_weights) {
+        std::cout << "  - Weights: Stripped (refit from " << m_config.input_onnx_path << " at load)\n";
+    } else if (m_config.enable_refit) {
+        std::cout << "  - REFIT: Enabled\n";
+    }
     if (m_config.disable_timing_cache) std::cout << "  - Timing Cache: Disabled\n";
     std::cout << "  - Optimization Level: " << m_config.optimization_level << "\n";
     std::cout << "  - Tactic Sources: ";
@@ -314,85 +631,766 @@ void EngineExporter::setupBuilderConfig() {
     }
 }
 
-void EngineExporter::setupOptimizationProfile() {
-    if (m_network->getNbInputs() == 0) return;
+bool EngineExporter::applyPrecisionPolicy() {
+    if (m_config.precision_policy.empty()) {
+        return true;
+    }
+    PrecisionPolicy policy;
+    if (!policy.loadFromFile(m_config.precision_policy)) {
+        return false;
+    }
+    
+    // FP16/BF16 rules enable their precision; INT8 and FP8 need scales, which
+    // only the global settings (calibration, Q/DQ) provide
+    if (policy.uses("fp16")) {
+        m_builderConfig->setFlag(nvinfer1::BuilderFlag::kFP16);
+    }
+    if (policy.uses("bf16")) {
+        m_builderConfig->setFlag(nvinfer1::BuilderFlag::kBF16);
+    }
+    if (policy.uses("int8") && !m_builderConfig->getFlag(nvinfer1::BuilderFlag::kINT8)) {
+        std::cerr << "Error: Precision policy has INT8 rules but INT8 is not enabled "
+                  << "(needs a calibration cache, calibration images or a Q/DQ model)\n";
+        return false;
+    }
+    if (policy.uses("fp8") && !m_builderConfig->getFlag(nvinfer1::BuilderFlag::kFP8)) {
+        std::cerr << "Error: Precision policy has FP8 rules but FP8 is not enabled\n";
+        return false;
+    }
+    // Without a constraints flag TensorRT treats layer precisions as hints it may ignore
+    m_builderConfig->clearFlag(policy.obey() ? nvinfer1::BuilderFlag::kPREFER_PRECISION_CONSTRAINTS
+                                             : nvinfer1::BuilderFlag::kOBEY_PRECISION_CONSTRAINTS);
+    m_builderConfig->setFlag(policy.obey() ? nvinfer1::BuilderFlag::kOBEY_PRECISION_CONSTRAINTS
+                                           : nvinfer1::BuilderFlag::kPREFER_PRECISION_CONSTRAINTS);
+    
+    policy.apply(*m_network);
+    std::cout << "  Precision policy: " << m_config.precision_policy << " (" << (policy.obey() ? "obey" : "prefer") << ")\n";
+    JsonValue report = policy.toJson();
+    JsonValue rules = JsonValue::makeArray();
+    for (size_t i = 0; i < policy.rules().size(); ++i) {
+        const PrecisionRule& rule = policy.rules()[i];
+        std::string pattern = rule.layer.empty() ? "op " + rule.op
+                            : rule.op.empty() ? rule.layer : rule.layer + " op " + rule.op;
+        std::string types = rule.precision + (rule.output.empty() ? "" : "/" + rule.output);
+        std::cout << "    Rule " << i + 1 << ": " << pattern << " -> " << types << ": " << rule.matched << " layers\n";
+        if (rule.matched == 0) {
+            std::cout << "  Warning: Precision rule " << i + 1 << " (" << pattern << ") matches no layer\n";
+        }
+        JsonValue item = report.find("rules")->at(i);
+        item.set("matched", rule.matched);
+        rules.push(item);
+    }
+    report.set("rules", rules);
+    report.set("path", m_config.precision_policy);
+    m_report.set("precision_policy", report);
+    return true;
+}
+
+bool EngineExporter::setupCompatibility() {
+    const std::string& level = m_config.hardware_compatibility;
+    if (level == "ampere_plus" || level == "same_compute_capability") {
+        TimingCacheId device;
+        if (level == "ampere_plus" && TimingCacheId::forCurrentDevice("", device) && device.smMajor < 8) {
+            std::cerr << "Error: hardware_compatibility ampere_plus needs an Ampere or newer build GPU (this one is sm"
+                      << device.smMajor << device.smMinor << ")\n";
+            return false;
+        }
+        m_builderConfig->setHardwareCompatibilityLevel(level == "ampere_plus"
+            ? nvinfer1::HardwareCompatibilityLevel::kAMPERE_PLUS
+            : nvinfer1::HardwareCompatibilityLevel::kSAME_COMPUTE_CAPABILITY);
+        // TensorRT drops the cuDNN/cuBLAS/cuBLASLt tactic sources for these engines
+        std::cout << "  Hardware compatibility: " << level << "\n";
+    } else if (!level.empty() && level != "none") {
+        std::cerr << "Error: Unknown hardware_compatibility: " << level
+                  << " (none, ampere_plus, same_compute_capability)\n";
+        return false;
+    }
+    
+    if (m_config.version_compatible) {
+        m_builderConfig->setFlag(nvinfer1::BuilderFlag::kVERSION_COMPATIBLE);
+        if (m_config.exclude_lean_runtime) {
+            // Smaller plan, but every runtime then needs the lean runtime library at hand (IRuntime::loadRuntime)
+            m_builderConfig->setFlag(nvinfer1::BuilderFlag::kEXCLUDE_LEAN_RUNTIME);
+        }
+        std::cout << "  Version compatible: Enabled (lean runtime "
+                  << (m_config.exclude_lean_runtime ? "excluded" : "embedded") << ")\n";
+    } else if (m_config.exclude_lean_runtime) {
+        std::cerr << "Warning: exclude_lean_runtime only applies to version_compatible engines\n";
+    }
+    return true;
+}
+
+void EngineExporter::loadTimingCache() {
+    if (m_config.disable_timing_cache || m_config.timing_cache_dir.empty()) return;
+    
+    // Key on the flags actually applied (e.g. FP16 is skipped on GPUs without fast FP16)
+    std::string precision = TimingCacheId::precisionTag(
+        m_builderConfig->getFlag(nvinfer1::BuilderFlag::kFP16),
+        m_builderConfig->getFlag(nvinfer1::BuilderFlag::kFP8),
+        m_builderConfig->getFlag(nvinfer1::BuilderFlag::kINT8),
+        m_builderConfig->getFlag(nvinfer1::BuilderFlag::kTF32));
+    TimingCacheId id;
+    if (!TimingCacheId::forCurrentDevice(precision, id)) {
+        std::cout << "  Timing cache: No CUDA device info, persistent cache disabled\n";
+        return;
+    }
+    m_timingCachePath = (std::filesystem::path(m_config.timing_cache_dir) / id.fileName()).string();
+    
+    std::vector<char> data;
+    if (!TimingCacheFile::read(m_timingCachePath, data)) {
+        data.clear();
+    }
+    
+    // A build matrix keeps one in-memory cache for all variants; fold in this variant's file
+    if (m_timingCache) {
+        if (!data.empty()) {
+            std::unique_ptr<nvinfer1::ITimingCache> onDisk(m_builderConfig->createTimingCache(data.data(), data.size()));
+            if (!onDisk || !m_timingCache->combine(*onDisk, false)) {
+                std::cerr << "Warning: Timing cache could not be merged: " << m_timingCachePath << "\n";
+            }
+        }
+        if (!m_builderConfig->setTimingCache(*m_timingCache, false)) {
+            std::cerr << "Warning: Failed to attach shared timing cache\n";
+        }
+        std::cout << "  Timing cache: " << m_timingCachePath << " (shared)\n";
+        return;
+    }
     
-    // Create optimization profile for dynamic inputs
-    auto profile = m_builder->createOptimizationProfile();
-    if (!profile) {
-        std::cerr << "Warning: Failed to create optimization profile\n";
+    m_timingCache.reset(m_builderConfig->createTimingCache(data.empty() ? nullptr : data.data(), data.size()));
+    if (!m_timingCache && !data.empty()) {
+        std::cerr << "Warning: Timing cache is corrupt, starting cold: " << m_timingCachePath << "\n";
+        m_timingCache.reset(m_builderConfig->createTimingCache(nullptr, 0));
+    }
+    if (!m_timingCache || !m_builderConfig->setTimingCache(*m_timingCache, false)) {
+        std::cerr << "Warning: Failed to attach timing cache, building without it\n";
+        m_timingCache.reset();
+        m_timingCachePath.clear();
         return;
     }
     
-    // Set up profile for the first input (assuming it's the main input)
+    if (data.empty()) {
+        std::cout << "  Timing cache: " << m_timingCachePath << " (new)\n";
+    } else {
+        std::cout << "  Timing cache: " << m_timingCachePath << " (" << (data.size() / 1024) << " KB loaded)\n";
+    }
+}
+
+void EngineExporter::saveTimingCache() {
+    if (!m_timingCache || m_timingCachePath.empty()) return;
+    
+    const nvinfer1::ITimingCache* cache = m_builderConfig->getTimingCache();
+    if (!cache) return;
+    if (TimingCacheFile::mergeAndWrite(m_timingCachePath, *m_builderConfig, *cache)) {
+        std::cout << "Timing cache saved: " << m_timingCachePath << "\n";
+    } else {
+        // The engine is still good; only the next build starts colder
+        std::cerr << "Warning: Failed to save timing cache: " << m_timingCachePath << "\n";
+    }
+}
+
+bool EngineExporter::fetchFromEngineStore() {
+    if (m_config.engine_store_dir.empty()) return false;
+    
+    std::string device = EngineStore::currentDeviceTag(m_config.hardware_compatibility);
+    if (device.empty()) {
+        std::cout << "  Engine store: No CUDA device info, store disabled\n";
+        return false;
+    }
+    m_storeKey = EngineStore::makeKey(m_config, device, m_storeKeyMaterial);
+    if (m_storeKey.empty()) return false;
+    
+    EngineStore store(m_config.engine_store_dir, static_cast<uint64_t>(m_config.engine_store_max_gb) << 30);
+    if (!store.fetch(m_storeKey, m_config.get_output_path())) {
+        std::cout << "  Engine store: Miss (" << m_storeKey.substr(0, 16) << ")\n";
+        return false;
+    }
+    std::cout << "  Engine store: Hit (" << m_storeKey.substr(0, 16) << ")\n";
+    
+    // The checksum file of an earlier build at this path describes a different engine
+    std::string output = m_config.get_output_path();
+    std::string digest = Sha256::hashFile(output);
+    std::error_code ec;
+    if (digest.empty() || !EngineChecksum::write(output, digest)) {
+        std::filesystem::remove(EngineChecksum::pathFor(output), ec);
+    }
+    return true;
+}
+
+void EngineExporter::putIntoEngineStore() {
+    if (m_storeKey.empty()) return;
+    
+    EngineStore store(m_config.engine_store_dir, static_cast<uint64_t>(m_config.engine_store_max_gb) << 30);
+    if (store.put(m_storeKey, m_config.get_output_path(), m_storeKeyMaterial)) {
+        std::cout << "Engine stored: " << m_config.engine_store_dir << "\n";
+    } else {
+        std::cerr << "Warning: Failed to add engine to store: " << m_config.engine_store_dir << "\n";
+    }
+}
+
+JsonValue EngineExporter::appliedSettings() const {
+    // Read back from the builder config, not m_config: INT8 may have been
+    // dropped, and FP8 without hardware support never sets its flag
+    static const std::pair<nvinfer1::BuilderFlag, const char*> kFlags[] = {
+        {nvinfer1::BuilderFlag::kFP16, "fp16"},
+        {nvinfer1::BuilderFlag::kFP8, "fp8"},
+        {nvinfer1::BuilderFlag::kINT8, "int8"},
+        {nvinfer1::BuilderFlag::kTF32, "tf32"},
+        {nvinfer1::BuilderFlag::kSPARSE_WEIGHTS, "sparse_weights"},
+        {nvinfer1::BuilderFlag::kREFIT, "refit"},
+        {nvinfer1::BuilderFlag::kREFIT_IDENTICAL, "refit_identical"},
+        {nvinfer1::BuilderFlag::kSTRIP_PLAN, "strip_plan"},
+        {nvinfer1::BuilderFlag::kVERSION_COMPATIBLE, "version_compatible"},
+        {nvinfer1::BuilderFlag::kEXCLUDE_LEAN_RUNTIME, "exclude_lean_runtime"},
+        {nvinfer1::BuilderFlag::kDIRECT_IO, "direct_io"},
+        {nvinfer1::BuilderFlag::kGPU_FALLBACK, "gpu_fallback"},
+        {nvinfer1::BuilderFlag::kBF16, "bf16"},
+        {nvinfer1::BuilderFlag::kPREFER_PRECISION_CONSTRAINTS, "prefer_precision_constraints"},
+        {nvinfer1::BuilderFlag::kOBEY_PRECISION_CONSTRAINTS, "obey_precision_constraints"},
+        {nvinfer1::BuilderFlag::kDISABLE_TIMING_CACHE, "disable_timing_cache"},
+    };
+    static const std::pair<nvinfer1::TacticSource, const char*> kTacticSources[] = {
+        {nvinfer1::TacticSource::kCUBLAS, "cublas"},
+        {nvinfer1::TacticSource::kCUBLAS_LT, "cublas_lt"},
+        {nvinfer1::TacticSource::kCUDNN, "cudnn"},
+        {nvinfer1::TacticSource::kEDGE_MASK_CONVOLUTIONS, "edge_mask_convolutions"},
+        {nvinfer1::TacticSource::kJIT_CONVOLUTIONS, "jit_convolutions"},
+    };
+
+    JsonValue applied = JsonValue::makeObject();
+    JsonValue flags = JsonValue::makeArray();
+    for (const auto& flag : kFlags) {
+        if (m_builderConfig->getFlag(flag.first)) flags.push(flag.second);
+    }
+    applied.set("flags", flags);
+    applied.set("int8_calibrator", m_int8Calibrator != nullptr);
+    switch (m_builderConfig->getHardwareCompatibilityLevel()) {
+    case nvinfer1::HardwareCompatibilityLevel::kAMPERE_PLUS:
+        applied.set("hardware_compatibility", "ampere_plus");
+        break;
+    case nvinfer1::HardwareCompatibilityLevel::kSAME_COMPUTE_CAPABILITY:
+        applied.set("hardware_compatibility", "same_compute_capability");
+        break;
+    default:
+        applied.set("hardware_compatibility", "none");
+        break;
+    }
+    applied.set("optimization_level", m_builderConfig->getBuilderOptimizationLevel());
+    applied.set("workspace_mb", static_cast<uint64_t>(
+        m_builderConfig->getMemoryPoolLimit(nvinfer1::MemoryPoolType::kWORKSPACE) >> 20));
+
+    JsonValue tactics = JsonValue::makeArray();
+    nvinfer1::TacticSources sources = m_builderConfig->getTacticSources();
+    for (const auto& source : kTacticSources) {
+        if (sources & (1U << static_cast<uint32_t>(source.first))) {
+            tactics.push(source.second);
+        }
+    }
+    applied.set("tactic_sources", tactics);
+    applied.set("optimization_profiles", m_builderConfig->getNbOptimizationProfiles());
+    applied.set("timing_cache_attached", m_builderConfig->getTimingCache() != nullptr);
+    applied.set("profiling_verbosity_detailed",
+                m_builderConfig->getProfilingVerbosity() == nvinfer1::ProfilingVerbosity::kDETAILED);
+    return applied;
+}
+
+bool EngineExporter::finishBuildReport(bool success) {
+    if (m_config.write_build_report) {
+        m_report.set("engine", m_config.get_output_path());
+        m_report.set("cancelled", m_progress != nullptr && m_progress->cancelled());
+        m_report.set("requested", ConfigParser::toJson(m_config));
+        m_report.write(BuildReport::pathFor(m_config.get_output_path()), success);
+    }
+    return success;
+}
+
+JsonValue EngineExporter::sourceModelInfo() const {
+    JsonValue source = JsonValue::makeObject();
+    source.set("path", std::filesystem::path(m_config.input_onnx_path).filename().string());
+    source.set("sha256", Sha256::hashFile(m_config.input_onnx_path));
+    return source;
+}
+
+JsonValue EngineExporter::engineMetadata() const {
+    JsonValue metadata = JsonValue::makeObject();
+    metadata.set("container_version", static_cast<int>(EngineContainer::kVersion));
+    metadata.set("tensorrt", std::to_string(NV_TENSORRT_MAJOR) + "." + std::to_string(NV_TENSORRT_MINOR) + "." +
+                             std::to_string(NV_TENSORRT_PATCH));
+    metadata.set("source_model", sourceModelInfo());
+    metadata.set("plan_encoding", m_config.compress_engine ? EngineContainer::kEncodingBlocks
+                                                           : EngineContainer::kEncodingRaw);
+
+    JsonValue inputs = JsonValue::makeArray();
+    for (int32_t i = 0; i < m_network->getNbInputs(); ++i) inputs.push(tensorInfo(*m_network->getInput(i)));
+    metadata.set("inputs", inputs);
+    JsonValue outputs = JsonValue::makeArray();
+    for (int32_t i = 0; i < m_network->getNbOutputs(); ++i) outputs.push(tensorInfo(*m_network->getOutput(i)));
+    metadata.set("outputs", outputs);
+
+    JsonValue profiles = JsonValue::makeArray();
+    for (const auto& profile : m_profiles) profiles.push(profile.label());
+    metadata.set("profiles", profiles);
+
+    // What ImagePreprocessor does, which is also what INT8 calibration saw
+    JsonValue preprocess = JsonValue::makeObject();
+    preprocess.set("method", ImagePreprocessor::kMethod);
+    preprocess.set("resize", "stretch");
+    preprocess.set("interpolation", "nearest");
+    preprocess.set("letterbox", false);
+    preprocess.set("channel_order", "rgb");
+    preprocess.set("scale", 1.0 / 255.0);
+    JsonValue mean = JsonValue::makeArray();
+    JsonValue stddev = JsonValue::makeArray();
+    for (int c = 0; c < 3; ++c) {
+        mean.push(0.0);
+        stddev.push(1.0);
+    }
+    preprocess.set("mean", mean);
+    preprocess.set("std", stddev);
+    preprocess.set("layout", "CHW");
+    metadata.set("preprocess", preprocess);
+
+    // Class names as the Ultralytics exporter stores them in the ONNX metadata
+    std::map<std::string, std::string> props;
+    std::vector<std::string> classNames;
+    if (OnnxModel::readMetadataProps(m_config.input_onnx_path, props) && props.count("names")) {
+        classNames = EngineContainer::parseClassNames(props["names"]);
+    }
+    JsonValue classes = JsonValue::makeArray();
+    for (const auto& name : classNames) classes.push(name);
+    metadata.set("classes", classes);
+
+    // Detection head: [batch, N, 6] is NMS already applied (x1 y1 x2 y2 score class),
+    // otherwise [batch, 4 + classes, anchors] raw boxes (either axis order)
+    for (int32_t i = 0; i < m_network->getNbOutputs(); ++i) {
+        nvinfer1::Dims dims = m_network->getOutput(i)->getDimensions();
+        if (dims.nbDims != 3) continue;
+
+        JsonValue postprocess = JsonValue::makeObject();
+        postprocess.set("output", m_network->getOutput(i)->getName());
+        if (dims.d[2] == 6) {
+            postprocess.set("type", "nms");
+            postprocess.set("box_format", "xyxy");
+            postprocess.set("max_detections", m_config.fix_nms_output ? m_config.nms_max_detections
+                                                                       : static_cast<int>(dims.d[1]));
+        } else {
+            // The anchor axis is the long one, or the dynamic one
+            bool anchorsLast = dims.d[2] < 0 || (dims.d[1] > 0 && dims.d[2] > dims.d[1]);
+            int64_t values = anchorsLast ? dims.d[1] : dims.d[2];
+            int numClasses = !classNames.empty() ? static_cast<int>(classNames.size())
+                                                 : std::max(0, static_cast<int>(values) - 4);
+            postprocess.set("type", "raw");
+            postprocess.set("box_format", "cxcywh");
+            postprocess.set("anchor_axis", anchorsLast ? 2 : 1);
+            postprocess.set("num_classes", numClasses);
+            postprocess.set("iou_threshold", EngineContainer::kIouThreshold);
+        }
+        postprocess.set("score_threshold", EngineContainer::kScoreThreshold);
+        metadata.set("postprocess", postprocess);
+        break;
+    }
+
+    metadata.set("config", ConfigParser::toJson(m_config));
+    return metadata;
+}
+
+bool EngineExporter::checkCalibrationCache() {
+    // TensorRT takes any cache bytes it is given; a cache from another model builds a wrong INT8 engine
+    CalibrationCache cache;
+    if (!cache.loadFromFile(m_config.int8_calib_cache)) {
+        std::cout << "  INT8 calibration cache unreadable. Skipping INT8.\n";
+        return false;
+    }
+    std::set<std::string> tensorNames;
+    for (int i = 0; i < m_network->getNbInputs(); ++i) tensorNames.insert(m_network->getInput(i)->getName());
+    for (int i = 0; i < m_network->getNbLayers(); ++i) {
+        auto layer = m_network->getLayer(i);
+        for (int j = 0; j < layer->getNbOutputs(); ++j) tensorNames.insert(layer->getOutput(j)->getName());
+    }
+    
+    CalibrationCacheCheck check = cache.check(tensorNames);
+    if (!check.invalid.empty()) {
+        std::cout << "  INT8 calibration cache has " << check.invalid.size() << " invalid scales (e.g. "
+                  << check.invalid.front() << "). Skipping INT8.\n";
+        return false;
+    }
+    if (check.isStale()) {
+        std::cout << "  INT8 calibration cache does not match this network (" << check.matched << " tensors matched, "
+                  << check.unknown.size() << " unknown, e.g. " << (check.unknown.empty() ? "-" : check.unknown.front())
+                  << "). Skipping INT8.\n";
+        std::cout << "  -> Delete " << m_config.int8_calib_cache << " to recalibrate, or check it with calib_tool cache-check.\n";
+        return false;
+    }
+    if (!check.headerMatches) {
+        std::cout << "  Warning: calibration cache header " << cache.header << " differs from "
+                  << CalibrationCache::defaultHeader() << "\n";
+    }
+    if (!check.unknown.empty()) {
+        std::cout << "  Warning: calibration cache has " << check.unknown.size() << " tensors not in this network\n";
+    }
+    std::cout << "  Calibration cache: " << check.matched << " scales for " << tensorNames.size() << " network tensors\n";
+    return true;
+}
+
+bool EngineExporter::setupDataCalibrator() {
+    auto input = m_network->getInput(0);
+    nvinfer1::Dims dims = input->getDimensions();
+    if (dims.nbDims != 4) {
+        std::cout << "  INT8 calibration data needs a 4-D image input (NCHW). Skipping INT8.\n";
+        return false;
+    }
+    
+    // Calibrate at the first profile's OPT size; fixed axes keep their exported extent
+    const OptimizationProfileSpec& first = m_profiles.front();
+    int channels = dims.d[1] > 0 ? static_cast<int>(dims.d[1]) : 3;
+    int height = dims.d[2] > 0 ? static_cast<int>(dims.d[2]) : (first.has_size ? first.height.opt : m_config.input_resolution);
+    int width = dims.d[3] > 0 ? static_cast<int>(dims.d[3]) : (first.has_size ? first.width.opt : m_config.input_resolution);
+    bool dynamicBatch = dims.d[0] <= 0;
+    int batch = dynamicBatch ? m_config.calib_batch_size : static_cast<int>(dims.d[0]);
+    // Same number of images whatever batch the network accepts
+    int64_t imageBudget = static_cast<int64_t>(m_config.calib_batch_size) * m_config.calib_max_batches;
+    int maxBatches = static_cast<int>(std::max<int64_t>(1, imageBudget / batch));
+    
+    // A prepared shard (calib_tool shard) is read by mmap instead of decoding every image again:
+    // either named directly, or found in the image folder with a matching shape and image list
+    std::unique_ptr<CalibrationBatchSource> source;
+    std::string shardPath;
+    std::vector<std::string> images;
+    if (std::filesystem::is_regular_file(m_config.int8_calib_data_dir)) {
+        shardPath = m_config.int8_calib_data_dir;
+    } else {
+        images = CalibrationBatchStream::listImages(m_config.int8_calib_data_dir);
+        // Near-duplicate frames add calibration time but no new activation ranges
+        size_t imageCount = static_cast<size_t>(maxBatches) * batch;
+        if (m_config.calib_diverse_subset && images.size() > imageCount) {
+            float coverage = 0.0f;
+            size_t available = images.size();
+            images = CalibrationSubset::select(images, imageCount, &coverage);
+            std::cout << "  Calibration subset: " << images.size() << " of " << available
+                      << " images (coverage radius " << coverage << ")\n";
+        }
+        int wantedBatches = static_cast<int>(std::min<size_t>(static_cast<size_t>(maxBatches), images.size() / batch));
+        shardPath = CalibrationShard::findInFolder(m_config.int8_calib_data_dir, images, channels, height, width, batch,
+                                                   wantedBatches);
+    }
+    
+    if (!shardPath.empty()) {
+        auto shard = std::make_unique<CalibrationShard>();
+        if (!shard->open(shardPath)) {
+            std::cout << "  INT8 calibration shard unusable. Skipping INT8.\n";
+            return false;
+        }
+        const CalibrationShardHeader& header = shard->header();
+        // A directly named shard may fill dynamic axes with its own shape; fixed axes must match
+        bool fits = (dims.d[1] <= 0 || header.channels == static_cast<uint32_t>(dims.d[1])) &&
+                    (dims.d[2] <= 0 || header.height == static_cast<uint32_t>(dims.d[2])) &&
+                    (dims.d[3] <= 0 || header.width == static_cast<uint32_t>(dims.d[3])) &&
+                    (dynamicBatch || header.batchSize == static_cast<uint32_t>(batch));
+        if (!fits) {
+            std::cout << "  INT8 calibration shard " << header.batchSize << "x" << header.channels << "x" << header.height
+                      << "x" << header.width << " does not fit the network input. Skipping INT8.\n";
+            return false;
+        }
+        batch = static_cast<int>(header.batchSize);
+        channels = static_cast<int>(header.channels);
+        height = static_cast<int>(header.height);
+        width = static_cast<int>(header.width);
+        shard->setBatchLimit(static_cast<int>(std::max<int64_t>(1, imageBudget / batch)));
+        std::cout << "  Calibration shard: " << shardPath << "\n";
+        source = std::move(shard);
+    } else {
+        if (images.size() < static_cast<size_t>(batch)) {
+            std::cout << "  INT8 requested but " << m_config.int8_calib_data_dir << " has " << images.size()
+                      << " images (need at least " << batch << "). Skipping INT8.\n";
+            return false;
+        }
+        source = std::make_unique<CalibrationBatchStream>(std::move(images), batch, maxBatches, channels, height, width);
+    }
+    int batches = source->batchCount();
+    m_int8Calibrator.reset(new Int8EntropyCalibrator(m_config.int8_calib_cache, input->getName(), batch, std::move(source)));
+    
+    // Dynamic axes need a calibration profile; TensorRT calibrates at its OPT shape
+    bool dynamicShape = false;
+    for (int i = 0; i < dims.nbDims; ++i) dynamicShape = dynamicShape || dims.d[i] < 0;
+    if (dynamicShape) {
+        nvinfer1::Dims calibDims{4, {batch, channels, height, width}};
+        auto profile = m_builder->createOptimizationProfile();
+        profile->setDimensions(input->getName(), nvinfer1::OptProfileSelector::kMIN, calibDims);
+        profile->setDimensions(input->getName(), nvinfer1::OptProfileSelector::kOPT, calibDims);
+        profile->setDimensions(input->getName(), nvinfer1::OptProfileSelector::kMAX, calibDims);
+        if (!m_builderConfig->setCalibrationProfile(profile)) {
+            std::cout << "  Failed to set calibration profile " << batch << "x" << channels << "x" << height << "x" << width
+                      << ". Skipping INT8.\n";
+            m_int8Calibrator.reset();
+            return false;
+        }
+    }
+    
+    std::cout << "  INT8 precision: Enabled (calibration data, " << batches << " batches of " << batch << " at "
+              << height << "x" << width << ")\n";
+    return true;
+}
+
+bool EngineExporter::resolveProfiles() {
+    m_profiles.clear();
+    if (!m_config.optimization_profiles.empty()) {
+        std::string error;
+        if (!OptimizationProfileSpec::parse_list(m_config.optimization_profiles, m_profiles, error)) {
+            std::cerr << "Error: " << error << "\n";
+            return false;
+        }
+        return true;
+    }
+    
+    // Legacy single profile: fixed resolution, batch range if dynamic_batch
+    OptimizationProfileSpec profile;
+    if (m_config.dynamic_batch) {
+        if (!(1 <= m_config.batch_min && m_config.batch_min <= m_config.batch_opt && m_config.batch_opt <= m_config.batch_max)) {
+            std::cerr << "Error: Batch range must satisfy 1 <= min <= opt <= max\n";
+            return false;
+        }
+        profile.batch = {m_config.batch_min, m_config.batch_opt, m_config.batch_max};
+    }
+    m_profiles.push_back(profile);
+    return true;
+}
+
+bool EngineExporter::needsSymbolicBatch() const {
+    if (m_config.dynamic_batch) return true;
+    return std::any_of(m_profiles.begin(), m_profiles.end(),
+                       [](const OptimizationProfileSpec& profile) { return profile.batch.max > 1; });
+}
+
+bool EngineExporter::setupOptimizationProfiles() {
+    if (m_network->getNbInputs() == 0) return true;
+    
+    // Profiles cover the first input (assuming it's the main input)
     auto input = m_network->getInput(0);
     const char* inputName = input->getName();
     nvinfer1::Dims inputDims = input->getDimensions();
     
-    // For YOLO models or similar, typically [batch, channels, height, width]
-    if (inputDims.nbDims == 4) {
-        int resolution = m_config.input_resolution;
-        nvinfer1::Dims dims{4, {1, 3, resolution, resolution}};
-        
-        profile->setDimensions(inputName, nvinfer1::OptProfileSelector::kMIN, dims);
-        profile->setDimensions(inputName, nvinfer1::OptProfileSelector::kOPT, dims);
-        profile->setDimensions(inputName, nvinfer1::OptProfileSelector::kMAX, dims);
+    for (size_t index = 0; index < m_profiles.size(); ++index) {
+        const OptimizationProfileSpec& spec = m_profiles[index];
+        auto profile = m_builder->createOptimizationProfile();
+        if (!profile) {
+            std::cerr << "Warning: Failed to create optimization profile\n";
+            return true;
+        }
         
-        std::cout << "  Input resolution: " << resolution << "x" << resolution << "\n";
-    }
-    
-    // NMS 출력 고정 크기 설정 (NMS가 모델에 포함된 경우)
-    if (m_config.fix_nms_output) {
-        // 모든 출력을 확인하여 NMS 출력 찾기
-        for (int i = 0; i < m_network->getNbOutputs(); ++i) {
-            auto output = m_network->getOutput(i);
-            const char* outputName = output->getName();
-            nvinfer1::Dims outputDims = output->getDimensions();
+        // For YOLO models or similar, typically [batch, channels, height, width]
+        if (inputDims.nbDims == 4) {
+            DimRange height{m_config.input_resolution, m_config.input_resolution, m_config.input_resolution};
+            DimRange width = height;
+            if (spec.has_size) {
+                height = spec.height;
+                width = spec.width;
+                // A size range on an axis the ONNX export fixed cannot be built
+                for (int axis = 2; axis < 4; ++axis) {
+                    const DimRange& range = axis == 2 ? height : width;
+                    int64_t fixed = inputDims.d[axis];
+                    if (fixed > 0 && (range.min != fixed || range.max != fixed)) {
+                        std::cerr << "Error: Input '" << inputName << "' has fixed " << (axis == 2 ? "height " : "width ")
+                                  << fixed << "; profile " << spec.label() << " needs an ONNX exported with dynamic H/W\n";
+                        return false;
+                    }
+                }
+            }
+            int channels = inputDims.d[1] > 0 ? static_cast<int>(inputDims.d[1]) : 3;
+            bool dynamicBatch = inputDims.d[0] == -1 || needsSymbolicBatch();
             
-            // NMS 출력은 보통 [batch, num_detections, 6] 형태
-            // 동적 차원(-1)을 고정 크기로 설정
-            if (outputDims.nbDims == 3 && outputDims.d[2] == 6) {
-                // 사용자가 설정한 크기로 고정
-                nvinfer1::Dims fixedDims{3, {1, m_config.nms_max_detections, 6}};
-                
-                profile->setDimensions(outputName, nvinfer1::OptProfileSelector::kMIN, fixedDims);
-                profile->setDimensions(outputName, nvinfer1::OptProfileSelector::kOPT, fixedDims);
-                profile->setDimensions(outputName, nvinfer1::OptProfileSelector::kMAX, fixedDims);
+            nvinfer1::Dims minDims{4, {dynamicBatch ? spec.batch.min : 1, channels, height.min, width.min}};
+            nvinfer1::Dims optDims{4, {dynamicBatch ? spec.batch.opt : 1, channels, height.opt, width.opt}};
+            nvinfer1::Dims maxDims{4, {dynamicBatch ? spec.batch.max : 1, channels, height.max, width.max}};
+            profile->setDimensions(inputName, nvinfer1::OptProfileSelector::kMIN, minDims);
+            profile->setDimensions(inputName, nvinfer1::OptProfileSelector::kOPT, optDims);
+            profile->setDimensions(inputName, nvinfer1::OptProfileSelector::kMAX, maxDims);
+            
+            std::cout << "  Profile " << index << ": batch " << minDims.d[0] << " / " << optDims.d[0] << " / " << maxDims.d[0]
+                      << ", input " << height.min << "x" << width.min << " / " << height.opt << "x" << width.opt
+                      << " / " << height.max << "x" << width.max << " (min/opt/max)\n";
+        }
+        
+        // NMS 출력 고정 크기 설정 (NMS가 모델에 포함된 경우)
+        if (m_config.fix_nms_output) {
+            // 모든 출력을 확인하여 NMS 출력 찾기
+            for (int i = 0; i < m_network->getNbOutputs(); ++i) {
+                auto output = m_network->getOutput(i);
+                const char* outputName = output->getName();
+                nvinfer1::Dims outputDims = output->getDimensions();
                 
-                std::cout << "  NMS output fixed to: [1, " << m_config.nms_max_detections << ", 6]\n";
+                // NMS 출력은 보통 [batch, num_detections, 6] 형태
+                // 동적 차원(-1)을 고정 크기로 설정
+                if (outputDims.nbDims == 3 && outputDims.d[2] == 6) {
+                    // 사용자가 설정한 크기로 고정
+                    nvinfer1::Dims fixedDims{3, {1, m_config.nms_max_detections, 6}};
+                    
+                    profile->setDimensions(outputName, nvinfer1::OptProfileSelector::kMIN, fixedDims);
+                    profile->setDimensions(outputName, nvinfer1::OptProfileSelector::kOPT, fixedDims);
+                    profile->setDimensions(outputName, nvinfer1::OptProfileSelector::kMAX, fixedDims);
+                    
+                    if (index == 0) {
+                        std::cout << "  NMS output fixed to: [1, " << m_config.nms_max_detections << ", 6]\n";
+                    }
+                }
             }
         }
+        
+        m_builderConfig->addOptimizationProfile(profile);
     }
-    
-    m_builderConfig->addOptimizationProfile(profile);
+    return true;
 }
 
-bool EngineExporter::saveEngine() {
-    std::cout << "Saving engine to: " << m_config.get_output_path() << "\n";
+bool EngineExporter::refitEngine() {
+    std::cout << "Refitting " << m_config.refit_engine << " with weights from " << m_config.input_onnx_path << "\n";
+    auto start_time = std::chrono::high_resolution_clock::now();
+    m_report.set("refit_engine", m_config.refit_engine);
     
-    auto serializedEngine = std::unique_ptr<nvinfer1::IHostMemory>(m_engine->serialize());
-    if (!serializedEngine) {
-        std::cerr << "Error: Failed to serialize engine\n";
-        return false;
+    m_report.beginPhase("load");
+    std::vector<char> plan;
+    if (!readFileBytes(m_config.refit_engine, plan)) {
+        std::cerr << "Error: Cannot read engine: " << m_config.refit_engine << "\n";
+        return finishBuildReport(false);
+    }
+    if (!EngineChecksum::verify(m_config.refit_engine, plan.data(), plan.size())) {
+        return finishBuildReport(false);
+    }
+    // A container keeps its header and encoding; only the plan inside goes to TensorRT
+    EnginePlan unpacked;
+    if (!EngineContainer::unpack(plan.data(), plan.size(), unpacked)) {
+        return finishBuildReport(false);
+    }
+    JsonValue metadata = unpacked.metadata;
+    bool compressed = unpacked.compressed;
+    // Stripped engines are built with kREFIT_IDENTICAL, which is undefined for any
+    // other weights; only kREFIT (enable_refit) engines take retrained ones
+    const JsonValue* sourceConfig = metadata.find("config");
+    const JsonValue* sourceStripped = sourceConfig ? sourceConfig->find("strip_weights") : nullptr;
+    if (sourceStripped && sourceStripped->isBool() && sourceStripped->asBool()) {
+        std::cerr << "Error: " << m_config.refit_engine << " was built with strip_weights (kREFIT_IDENTICAL) and "
+                  << "only takes the weights it was built from; rebuild it with enable_refit to refit retrained weights\n";
+        return finishBuildReport(false);
+    }
+    if (!metadata.isObject() && !m_config.allow_bare_refit) {
+        std::cerr << "Error: " << m_config.refit_engine << " is a bare plan, so its refit mode is unknown. "
+                  << "Only engines built with enable_refit (kREFIT), not strip_weights, take retrained weights; "
+                  << "pass --allow-bare-refit to confirm this one was\n";
+        return finishBuildReport(false);
+    }
+    // Plugin layers need their creators to deserialize
+    if (!PluginLoader::load(m_config)) {
+        return finishBuildReport(false);
+    }
+    // The runtime has to outlive the engine it deserialized
+    std::unique_ptr<nvinfer1::IRuntime> runtime(nvinfer1::createInferRuntime(m_logger));
+    if (runtime) {
+        runtime->setEngineHostCodeAllowed(true);    // version-compatible plans carry their lean runtime
+    }
+    std::unique_ptr<nvinfer1::ICudaEngine> engine(
+        runtime ? runtime->deserializeCudaEngine(unpacked.data, unpacked.size) : nullptr);
+    unpacked = EnginePlan();
+    std::vector<char>().swap(plan);
+    if (!engine) {
+        std::cerr << "Error: Failed to deserialize engine: " << m_config.refit_engine << "\n";
+        return finishBuildReport(false);
     }
     
-    std::ofstream engineFile(m_config.get_output_path(), std::ios::binary);
-    if (!engineFile) {
-        std::cerr << "Error: Cannot create output file: " << m_config.get_output_path() << "\n";
-        return false;
+    // Refuses with a topology diff unless the ONNX matches the engine's weights and I/O
+    m_report.beginPhase("refit");
+    if (!EngineRefit::fromOnnx(*engine, m_logger, m_config.input_onnx_path)) {
+        return finishBuildReport(false);
     }
     
-    engineFile.write(reinterpret_cast<const char*>(serializedEngine->data()), serializedEngine->size());
-    engineFile.close();
+    m_report.beginPhase("write");
+    std::unique_ptr<nvinfer1::ISerializationConfig> serializationConfig(engine->createSerializationConfig());
+    if (!serializationConfig) {
+        std::cerr << "Error: Failed to create serialization config\n";
+        return finishBuildReport(false);
+    }
+    // Stays refittable for the next retrain. The source was not stripped (refused
+    // above), so the refitted weights are written with the plan whatever
+    // m_config.strip_weights says.
+    serializationConfig->setFlag(nvinfer1::SerializationFlag::kINCLUDE_REFIT);
+    std::unique_ptr<nvinfer1::IHostMemory> serialized(engine->serializeWithConfig(*serializationConfig));
+    if (!serialized) {
+        std::cerr << "Error: Failed to serialize engine\n";
+        return finishBuildReport(false);
+    }
+    EngineFileWriter engineFile(m_config.get_output_path());
+    if (metadata.isObject()) {
+        metadata.set("source_model", sourceModelInfo());
+        std::string header = EngineContainer::makeHeader(metadata);
+        if (engineFile.write(header.data(), static_cast<int64_t>(header.size())) < 0) {
+            std::cerr << "Error: Failed to write engine container header\n";
+            return finishBuildReport(false);
+        }
+        if (compressed) {
+            engineFile.compressFollowingWrites();
+        }
+    }
+    if (engineFile.write(serialized->data(), static_cast<int64_t>(serialized->size())) < 0 || !engineFile.commit()) {
+        std::cerr << "Error: Failed to write engine file\n";
+        return finishBuildReport(false);
+    }
+    m_report.set("engine_bytes", engineFile.size());
+    m_report.set("engine_sha256", engineFile.sha256());
+    finishBuildReport(true);
+    
+    auto end_time = std::chrono::high_resolution_clock::now();
+    std::cout << "\nEngine refitted, build skipped.\n";
+    std::cout << "Output: " << m_config.get_output_path() << "\n";
+    std::cout << "Time taken: " << std::fixed << std::setprecision(1)
+              << std::chrono::duration<double>(end_time - start_time).count() << " seconds\n";
+    return true;
+}
+
+bool EngineExporter::saveEngine() {
+    std::cout << "Saving engine to: " << m_config.get_output_path() << "\n";
     
-    if (!engineFile.good()) {
+    // Renaming replaces the directory entry, so an old output that is a hard
+    // link into the engine store is never written through
+    m_report.beginPhase("write");
+    std::unique_ptr<EngineFileWriter> engineFile = std::move(m_engineFile);
+    if (!engineFile || !engineFile->commit()) {
         std::cerr << "Error: Failed to write engine file\n";
         return false;
     }
+    m_report.set("engine_bytes", engineFile->size());
+    m_report.set("engine_sha256", engineFile->sha256());
     
-    // Print file size
-    auto file_size = std::filesystem::file_size(m_config.get_output_path());
-    std::cout << "Engine file size: " << (file_size / 1024.0 / 1024.0) << " MB\n";
+    std::cout << "Engine file size: " << (engineFile->size() / 1024.0 / 1024.0) << " MB";
+    if (m_config.compress_engine) {
+        m_report.set("engine_uncompressed_bytes", engineFile->uncompressedSize());
+        std::cout << " (" << (engineFile->uncompressedSize() / 1024.0 / 1024.0) << " MB uncompressed)";
+    }
+    std::cout << "\n";
+    std::cout << "Engine SHA-256: " << engineFile->sha256() << "\n";
     
+    if (m_config.write_build_report) {
+        reportEngineLayers();
+    }
     return true;
+}
+
+void EngineExporter::reportEngineLayers() {
+    // The plan went straight to disk, so the layer count after fusion needs the
+    // written engine loaded back; an extra phase, only paid for the build report
+    m_report.beginPhase("inspect");
+    std::vector<char> bytes;
+    EnginePlan plan;
+    if (!readFileBytes(m_config.get_output_path(), bytes) ||
+        !EngineContainer::unpack(bytes.data(), bytes.size(), plan)) {
+        std::cout << "  Warning: Cannot read the engine back; build report has no engine_layers\n";
+        return;
+    }
+    // The runtime has to outlive the engine it deserialized
+    std::unique_ptr<nvinfer1::IRuntime> runtime(nvinfer1::createInferRuntime(m_logger));
+    if (runtime) {
+        runtime->setEngineHostCodeAllowed(true);    // version-compatible plans carry their lean runtime
+    }
+    std::unique_ptr<nvinfer1::ICudaEngine> engine(
+        runtime ? runtime->deserializeCudaEngine(plan.data, plan.size) : nullptr);
+    if (!engine) {
+        std::cout << "  Warning: Cannot deserialize the engine; build report has no engine_layers\n";
+        return;
+    }
+    m_report.set("engine_layers", engine->getNbLayers());
 }
\ No newline at end of file
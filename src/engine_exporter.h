@@ -2,28 +2,71 @@
 
 #include <NvInfer.h>
 #include <NvOnnxParser.h>
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <vector>
+#include "build_report.h"
 #include "config.h"
 #include "logger.h"
 
+class BuildProgress;
+class EngineFileWriter;
+
+// Outcome of one build matrix cell
+struct VariantResult {
+    std::string label;
+    std::string outputPath;
+    bool success = false;
+    bool fromStore = false;
+    double seconds = 0.0;
+    uint64_t engineBytes = 0;
+};
+
 class EngineExporter {
 public:
     explicit EngineExporter(const ExportConfig& config);
     ~EngineExporter();
     
     bool exportEngine();
+    // Builds every variant back to back from a single parse of the ONNX
+    // (one more if static and dynamic-batch profiles are mixed), sharing one timing cache.
+    // Writes <output dir>/<model>_matrix.txt summarizing all variants.
+    bool exportMatrix(const std::vector<BuildVariant>& variants, std::vector<VariantResult>& results);
+    
+    // Reports builder phases to progress and stops at its next step once it is cancelled;
+    // must outlive the export
+    void setProgressMonitor(BuildProgress* progress) { m_progress = progress; }
     
 private:
     bool loadOnnxModel();
+    bool loadDynamicBatchModel();
     bool buildEngine();
     bool saveEngine();
+    bool refitEngine();
+    bool setupCompatibility();
+    bool applyPrecisionPolicy();
     bool validateInputFile();
     bool validateOutputPath();
     
     void setupBuilderConfig();
-    void setupOptimizationProfile();
+    bool checkCalibrationCache();
+    bool setupDataCalibrator();
+    bool resolveProfiles();
+    bool needsSymbolicBatch() const;
+    bool setupOptimizationProfiles();
     void printModelInfo();
+    void loadTimingCache();
+    void saveTimingCache();
+    bool fetchFromEngineStore();
+    void putIntoEngineStore();
+    bool buildVariant(bool& parsed, bool& parsedDynamic, VariantResult& result);
+    void writeMatrixReport(const std::vector<VariantResult>& results);
+    JsonValue appliedSettings() const;
+    bool finishBuildReport(bool success);
+    void reportEngineLayers();
+    JsonValue sourceModelInfo() const;
+    JsonValue engineMetadata() const;    // EngineContainer header of the network being built
     
     ExportConfig m_config;
     TensorRTLogger m_logger;
@@ -31,8 +74,15 @@ private:
     std::unique_ptr<nvinfer1::IBuilder> m_builder;
     std::unique_ptr<nvinfer1::INetworkDefinition> m_network;
     std::unique_ptr<nvinfer1::IBuilderConfig> m_builderConfig;
+    std::unique_ptr<nvinfer1::ITimingCache> m_timingCache;
+    std::string m_timingCachePath;
+    std::string m_storeKey;
+    std::string m_storeKeyMaterial;
     std::unique_ptr<nvonnxparser::IParser> m_parser;
-    std::unique_ptr<nvinfer1::ICudaEngine> m_engine;
-    // Optional calibrator (cache-only) lifetime holder
+    std::unique_ptr<EngineFileWriter> m_engineFile;    // built plan, published by saveEngine()
+    std::vector<OptimizationProfileSpec> m_profiles;   // from resolveProfiles()
+    // Optional INT8 calibrator (cache replay or image data) lifetime holder
     std::unique_ptr<nvinfer1::IInt8Calibrator> m_int8Calibrator;
+    BuildProgress* m_progress = nullptr;
+    BuildReport m_report;
 };
\ No newline at end of file
@@ -0,0 +1,80 @@
+#include "engine_file.h"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+EngineFileWriter::EngineFileWriter(const std::string& enginePath) : m_file(enginePath) {
+}
+
+int64_t EngineFileWriter::write(void const* data, int64_t nbBytes) {
+    if (nbBytes < 0) {
+        return -1;    // TensorRT stops serializing and the build reports failure
+    }
+    m_uncompressedBytes += static_cast<uint64_t>(nbBytes);
+    if (m_compressor) {
+        m_compressor->add(data, static_cast<size_t>(nbBytes), m_compressed);
+        if (!writeFile(m_compressed.data(), m_compressed.size())) return -1;
+        m_compressed.clear();
+    } else if (!writeFile(data, static_cast<size_t>(nbBytes))) {
+        return -1;
+    }
+    return nbBytes;
+}
+
+bool EngineFileWriter::writeFile(const void* data, size_t size) {
+    if (size == 0) return true;
+    if (!m_file.write(data, size)) return false;
+    m_hash.update(data, size);
+    return true;
+}
+
+bool EngineFileWriter::commit() {
+    // The old checksum must not outlive the engine it describes, even briefly
+    std::error_code ec;
+    std::filesystem::remove(EngineChecksum::pathFor(m_file.path()), ec);
+
+    if (m_compressor) {
+        m_compressor->finish(m_compressed);
+        bool written = writeFile(m_compressed.data(), m_compressed.size());
+        m_compressed.clear();
+        if (!written) {
+            m_file.abort();
+            return false;
+        }
+    }
+    if (!m_file.commit()) return false;
+    m_digest = m_hash.hexDigest();
+    if (!EngineChecksum::write(m_file.path(), m_digest)) {
+        std::cerr << "Warning: Cannot write engine checksum: " << EngineChecksum::pathFor(m_file.path()) << "\n";
+    }
+    return true;
+}
+
+std::string EngineChecksum::pathFor(const std::string& enginePath) {
+    return enginePath + ".sha256";
+}
+
+bool EngineChecksum::write(const std::string& enginePath, const std::string& digest) {
+    std::string line = digest + "  " + std::filesystem::path(enginePath).filename().string() + "\n";
+    return writeFileAtomic(pathFor(enginePath), line.data(), line.size());
+}
+
+std::string EngineChecksum::read(const std::string& enginePath) {
+    std::ifstream file(pathFor(enginePath));
+    std::string digest;
+    if (!(file >> digest) || digest.size() != 64) return "";
+    return digest;
+}
+
+bool EngineChecksum::verify(const std::string& enginePath, const void* data, size_t size) {
+    std::string expected = read(enginePath);
+    if (expected.empty()) return true;
+
+    Sha256 hash;
+    hash.update(data, size);
+    if (hash.hexDigest() != expected) {
+        std::cerr << "Error: Engine does not match its checksum (truncated or corrupted): " << enginePath << "\n";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <NvInfer.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "file_utils.h"
+#include "plan_codec.h"
+#include "sha256.h"
+
+// IStreamWriter that takes the serialized plan straight from the builder
+// (IBuilder::buildSerializedNetworkToStream) into a temporary file next to the
+// engine, hashing it on the way. Nothing holds the whole plan in host memory,
+// and commit() publishes it with an atomic rename, so a crash or a failed build
+// leaves the previous engine untouched instead of a truncated one.
+class EngineFileWriter : public nvinfer1::IStreamWriter {
+public:
+    explicit EngineFileWriter(const std::string& enginePath);
+
+    bool isOpen() const { return m_file.isOpen(); }
+
+    int64_t write(void const* data, int64_t nbBytes) override;
+
+    // Everything written from now on is block-compressed (PlanCompressor);
+    // the container header goes out before this is called
+    void compressFollowingWrites() { m_compressor = std::make_unique<PlanCompressor>(); }
+
+    // Flushes and renames the engine into place, then writes its checksum file
+    bool commit();
+
+    uint64_t size() const { return m_file.bytesWritten(); }
+    // Bytes handed to write(); size() is smaller by what compression saved
+    uint64_t uncompressedSize() const { return m_uncompressedBytes; }
+    const std::string& sha256() const { return m_digest; }    // set by commit()
+
+private:
+    bool writeFile(const void* data, size_t size);
+
+    AtomicFileWriter m_file;
+    Sha256 m_hash;
+    std::string m_digest;
+    std::unique_ptr<PlanCompressor> m_compressor;
+    std::string m_compressed;    // frames waiting to be written
+    uint64_t m_uncompressedBytes = 0;
+};
+
+// "<engine>.sha256" next to the engine, in `sha256sum -c` format. Consumers
+// compare it against the bytes they already read for deserialization, which
+// catches a truncated or corrupted engine before TensorRT sees it.
+class EngineChecksum {
+public:
+    static std::string pathFor(const std::string& enginePath);
+
+    static bool write(const std::string& enginePath, const std::string& digest);
+
+    // Expected digest, or empty if there is no readable checksum file
+    static std::string read(const std::string& enginePath);
+
+    // True if there is no checksum file or it matches `data`; prints an error otherwise
+    static bool verify(const std::string& enginePath, const void* data, size_t size);
+};
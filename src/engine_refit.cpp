@@ -0,0 +1,105 @@
+#include "engine_refit.h"
+#include "file_utils.h"
+#include "onnx_model.h"
+#include <NvOnnxParser.h>
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+
+std::vector<RefitWeight> EngineRefit::describe(nvinfer1::IRefitter& refitter) {
+    int32_t count = refitter.getAllWeights(0, nullptr);
+    std::vector<const char*> names(static_cast<size_t>(std::max(count, 0)));
+    refitter.getAllWeights(count, names.data());
+
+    std::vector<RefitWeight> weights;
+    weights.reserve(names.size());
+    for (const char* name : names) {
+        weights.push_back({name, refitter.getWeightsPrototype(name).count});
+    }
+    return weights;
+}
+
+bool EngineRefit::fromOnnx(nvinfer1::ICudaEngine& engine, nvinfer1::ILogger& logger, const std::string& onnxPath) {
+    if (!engine.isRefittable()) {
+        std::cerr << "Error: Engine is not refittable; rebuild it with enable_refit (kREFIT) to refit its weights\n";
+        return false;
+    }
+    std::unique_ptr<nvinfer1::IRefitter> refitter(nvinfer1::createInferRefitter(engine, logger));
+    if (!refitter) {
+        std::cerr << "Error: Failed to create TensorRT refitter\n";
+        return false;
+    }
+
+    MappedFile onnx;
+    if (!onnx.open(onnxPath)) {
+        return false;
+    }
+
+    // Name and size check first: the parser refitter only reports a generic
+    // failure for a different model, and a same-shaped one would load silently
+    std::vector<RefitWeight> engineWeights = describe(*refitter);
+    RefitWeightCheck check;
+    {
+        // Names and dims only: the weights are read once, by the parser refitter below
+        OnnxModel model;
+        if (!model.loadFromBuffer(onnx.data(), onnx.size(), false)) {
+            std::cerr << "Error: Cannot parse ONNX model: " << onnxPath << "\n";
+            return false;
+        }
+        check = RefitWeights::check(engineWeights, RefitWeights::fromOnnx(model.graph));
+
+        std::vector<std::string> engineInputs, engineOutputs, onnxInputs, onnxOutputs;
+        for (int32_t i = 0; i < engine.getNbIOTensors(); ++i) {
+            const char* name = engine.getIOTensorName(i);
+            bool isInput = engine.getTensorIOMode(name) == nvinfer1::TensorIOMode::kINPUT;
+            (isInput ? engineInputs : engineOutputs).push_back(name);
+        }
+        for (const OnnxValueInfo* input : model.graph.runtimeInputs()) onnxInputs.push_back(input->name);
+        for (const auto& output : model.graph.outputs) onnxOutputs.push_back(output.name);
+        RefitWeights::checkTensors("input", engineInputs, onnxInputs, check);
+        RefitWeights::checkTensors("output", engineOutputs, onnxOutputs, check);
+    }
+    if (check.isForeign()) {
+        const size_t kMaxLines = 20;
+        std::cerr << "Error: " << onnxPath << " does not match the topology of this engine ("
+                  << check.matched.size() << " of " << engineWeights.size() << " weights match):\n";
+        for (size_t i = 0; i < check.differences.size() && i < kMaxLines; ++i) {
+            std::cerr << "  " << check.differences[i] << "\n";
+        }
+        if (check.differences.size() > kMaxLines) {
+            std::cerr << "  ... " << (check.differences.size() - kMaxLines) << " more\n";
+        }
+        return false;
+    }
+
+    std::unique_ptr<nvonnxparser::IParserRefitter> parserRefitter(
+        nvonnxparser::createParserRefitter(*refitter, logger));
+    if (!parserRefitter) {
+        std::cerr << "Error: Failed to create ONNX parser refitter\n";
+        return false;
+    }
+    // The path only locates external weight files next to the model
+    std::string absolutePath = std::filesystem::absolute(onnxPath).string();
+    if (!parserRefitter->refitFromBytes(onnx.data(), onnx.size(), absolutePath.c_str())) {
+        for (int32_t i = 0; i < parserRefitter->getNbErrors(); ++i) {
+            std::cerr << "Error: " << parserRefitter->getError(i)->desc() << "\n";
+        }
+        std::cerr << "Error: Failed to refit weights from " << onnxPath << "\n";
+        return false;
+    }
+
+    int32_t missing = refitter->getMissingWeights(0, nullptr);
+    if (missing > 0) {
+        std::cerr << "Error: " << missing << " weights still missing after refit from " << onnxPath << "\n";
+        return false;
+    }
+    if (!refitter->refitCudaEngine()) {
+        std::cerr << "Error: TensorRT refit failed\n";
+        return false;
+    }
+
+    std::cout << "  Refit: " << engineWeights.size() << " weights from " << onnxPath
+              << " (" << check.derived.size() << " derived by the parser)\n";
+    return true;
+}
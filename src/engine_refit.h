@@ -0,0 +1,19 @@
+#pragma once
+
+#include <NvInfer.h>
+#include <string>
+#include <vector>
+#include "refit_weights.h"
+
+// Loader side of weight-stripped engines (ExportConfig::strip_weights). The
+// ONNX the engine was built from is memory-mapped, checked against the
+// engine's refittable weights by name and size, then handed to the ONNX
+// parser's refitter, which fills in every weight from the mapping.
+class EngineRefit {
+public:
+    // Names and element counts of the engine's refittable weights
+    static std::vector<RefitWeight> describe(nvinfer1::IRefitter& refitter);
+
+    // Prints what went wrong and returns false; the engine must not be run then
+    static bool fromOnnx(nvinfer1::ICudaEngine& engine, nvinfer1::ILogger& logger, const std::string& onnxPath);
+};
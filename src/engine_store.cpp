@@ -0,0 +1,163 @@
+#include "engine_store.h"
+#include "calibration_batches.h"
+#include "file_utils.h"
+#include "sha256.h"
+#include "timing_cache.h"
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const char* kEngineExtension = ".engine";
+
+// A shard by its content; an image folder by its sorted image list with sizes
+// and modification times, which change when images are replaced in place
+std::string hashCalibrationData(const std::string& path) {
+    std::error_code ec;
+    if (fs::is_regular_file(path, ec)) return Sha256::hashFile(path);
+    std::string listing;
+    for (const auto& image : CalibrationBatchStream::listImages(path)) {
+        uintmax_t size = fs::file_size(image, ec);
+        auto modified = fs::last_write_time(image, ec).time_since_epoch().count();
+        listing += fs::path(image).filename().string() + " " + std::to_string(size) + " " +
+                   std::to_string(modified) + "\n";
+    }
+    return Sha256::hashString(listing);
+}
+
+} // namespace
+
+EngineStore::EngineStore(const std::string& dir, uint64_t maxBytes)
+    : m_dir(dir), m_maxBytes(maxBytes) {
+}
+
+std::string EngineStore::makeKey(const ExportConfig& config, const std::string& deviceTag, std::string& material) {
+    std::string modelHash = Sha256::hashFile(config.input_onnx_path);
+    if (modelHash.empty()) return "";
+
+    material = "model=" + modelHash + "\n";
+    material += config.build_fingerprint();
+    if (!config.int8_calib_cache.empty()) {
+        // The cache content matters, not its path; a missing file hashes as empty
+        material += "int8_calib_cache=" + Sha256::hashFile(config.int8_calib_cache) + "\n";
+    }
+    if (config.enable_int8 && !config.int8_calib_data_dir.empty()) {
+        material += "int8_calib_data=" + hashCalibrationData(config.int8_calib_data_dir) + "\n";
+    }
+    if (!config.precision_policy.empty()) {
+        material += "precision_policy=" + Sha256::hashFile(config.precision_policy) + "\n";
+    }
+    // A refit-only update is its own artifact: the old engine's bytes, not a build of the ONNX
+    if (!config.refit_engine.empty()) {
+        material += "refit_engine=" + Sha256::hashFile(config.refit_engine) + "\n";
+    }
+    // A rebuilt plugin library changes the engine even if its path does not
+    std::vector<std::string> plugins(config.selected_plugins.begin(), config.selected_plugins.end());
+    std::sort(plugins.begin(), plugins.end());
+    for (const auto& plugin : plugins) {
+        if (!PluginManager::isBuiltInPlugin(plugin)) {
+            material += "plugin_library=" + Sha256::hashFile(plugin) + "\n";
+        }
+    }
+    material += "device=" + deviceTag + "\n";
+    return Sha256::hashString(material);
+}
+
+std::string EngineStore::currentDeviceTag(const std::string& hardwareCompatibility) {
+    TimingCacheId id;
+    if (!TimingCacheId::forCurrentDevice("", id)) return "";
+    std::string sm = "sm" + std::to_string(id.smMajor) + std::to_string(id.smMinor);
+    std::string trt = "_trt" + std::to_string(id.trtVersion);
+    if (hardwareCompatibility == "ampere_plus") return "ampere_plus" + trt;
+    if (hardwareCompatibility == "same_compute_capability") return sm + trt;
+    return id.deviceName + "_" + sm + trt;
+}
+
+std::string EngineStore::entryPath(const std::string& key) const {
+    return (fs::path(m_dir) / (key + kEngineExtension)).string();
+}
+
+bool EngineStore::fetch(const std::string& key, const std::string& outputPath) {
+    std::string entry = entryPath(key);
+    if (!fs::exists(entry)) return false;
+
+    FileLock lock((fs::path(m_dir) / "store").string());
+    std::error_code ec;
+    if (!fs::exists(entry, ec)) return false;    // evicted while waiting for the lock
+
+    // Never write through an existing hard link into the store
+    fs::remove(outputPath, ec);
+    fs::create_hard_link(entry, outputPath, ec);
+    if (ec) {
+        // Different volume or no link support
+        ec.clear();
+        fs::copy_file(entry, outputPath, fs::copy_options::overwrite_existing, ec);
+        if (ec) {
+            std::cerr << "Warning: Cannot copy engine from store: " << ec.message() << "\n";
+            return false;
+        }
+    }
+    fs::last_write_time(entry, fs::file_time_type::clock::now(), ec);
+    return true;
+}
+
+bool EngineStore::put(const std::string& key, const std::string& enginePath, const std::string& keyMaterial) {
+    std::error_code ec;
+    fs::create_directories(m_dir, ec);
+    if (ec) {
+        std::cerr << "Warning: Cannot create engine store directory: " << m_dir << "\n";
+        return false;
+    }
+
+    std::vector<char> engine;
+    if (!readFileBytes(enginePath, engine)) {
+        std::cerr << "Warning: Cannot read engine for store: " << enginePath << "\n";
+        return false;
+    }
+
+    FileLock lock((fs::path(m_dir) / "store").string());
+    std::string entry = entryPath(key);
+    if (!writeFileAtomic(entry, engine.data(), engine.size())) {
+        return false;
+    }
+    std::string info = (fs::path(m_dir) / (key + ".txt")).string();
+    writeFileAtomic(info, keyMaterial.data(), keyMaterial.size());
+
+    evict();
+    return true;
+}
+
+void EngineStore::evict() {
+    struct Entry {
+        fs::path path;
+        uint64_t size;
+        fs::file_time_type lastUsed;
+    };
+    std::vector<Entry> entries;
+    uint64_t total = 0;
+    std::error_code ec;
+    for (const auto& item : fs::directory_iterator(m_dir, ec)) {
+        if (!item.is_regular_file(ec) || item.path().extension() != kEngineExtension) continue;
+        Entry entry{item.path(), static_cast<uint64_t>(item.file_size(ec)), item.last_write_time(ec)};
+        total += entry.size;
+        entries.push_back(entry);
+    }
+    if (total <= m_maxBytes) return;
+
+    std::sort(entries.begin(), entries.end(),
+              [](const Entry& a, const Entry& b) { return a.lastUsed < b.lastUsed; });
+    // Keep at least the newest entry, even if it alone exceeds the cap
+    for (size_t i = 0; i + 1 < entries.size() && total > m_maxBytes; ++i) {
+        fs::path info = entries[i].path;
+        info.replace_extension(".txt");
+        if (fs::remove(entries[i].path, ec)) {
+            total -= entries[i].size;
+            fs::remove(info, ec);
+            std::cout << "  Engine store: Evicted " << entries[i].path.filename().string() << "\n";
+        }
+    }
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "config.h"
+
+// Content-addressed cache of built engines, shared between builds and machines.
+// Entries are <key>.engine plus a <key>.txt describing what went into the key.
+// All access is serialized through a lock file in the store directory.
+class EngineStore {
+public:
+    EngineStore(const std::string& dir, uint64_t maxBytes);
+
+    // SHA-256 over the ONNX content, the config fingerprint, the content of the
+    // INT8 cache, calibration data (with INT8 on), precision policy, plugin
+    // libraries and refit source engine, and the device/TensorRT identity. Empty if the model is unreadable.
+    // material receives the hashed text, kept next to the entry for inspection.
+    static std::string makeKey(const ExportConfig& config, const std::string& deviceTag, std::string& material);
+    // "<device>_sm<XY>_trt<N>", or empty without a CUDA device. Hardware-compatible
+    // engines are keyed by what they run on instead ("ampere_plus_trt<N>", "sm<XY>_trt<N>"),
+    // so one store entry serves every GPU of the fleet.
+    static std::string currentDeviceTag(const std::string& hardwareCompatibility = "none");
+
+    // Hard-links (or copies) a stored engine to outputPath and marks it recently used
+    bool fetch(const std::string& key, const std::string& outputPath);
+    // Copies a freshly built engine into the store, then evicts down to the size cap
+    bool put(const std::string& key, const std::string& enginePath, const std::string& keyMaterial);
+
+private:
+    std::string entryPath(const std::string& key) const;
+    void evict();
+
+    std::string m_dir;
+    uint64_t m_maxBytes;
+};
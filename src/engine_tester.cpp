@@ -1,6 +1,7 @@
 ﻿#include <NvInfer.h>
 #include <cuda_runtime.h>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <memory>
 #include <chrono>
@@ -10,10 +11,15 @@
 #include <cstring>
 #include <string>
 #include <cstdint>
+#include <filesystem>
 #include "config.h"
+#include "engine_container.h"
+#include "engine_file.h"
+#include "engine_refit.h"
+#include "image_preprocess.h"
+#include "sha256.h"
 
-// STB Image libraries for image loading/saving
-#define STB_IMAGE_IMPLEMENTATION
+// STB Image libraries for image loading/saving (stb_image is implemented in image_preprocess.cpp)
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include "stb_image.h"
 #include "stb_image_write.h"
@@ -60,18 +66,24 @@ private:
     std::string inputTensorName;
     std::string outputTensorName;
 
-    std::vector<int> resizeXIndices;
-    std::vector<int> resizeYIndices;
-    int cachedSrcWidth = -1;
-    int cachedSrcHeight = -1;
+    ImagePreprocessor preprocessor;
 
     // Model dimensions
+    int inputBatch = 1;
     int inputC = 3;
     int inputH = 640;
     int inputW = 640;
     int numClasses = 80;
     int maxDetections = 8400;
 
+    // Output layout; from the container metadata when there is one, else guessed
+    int valuesPerDetection = 84;
+    bool anchorsLast = false;       // [batch, values, anchors] instead of [batch, anchors, values]
+    bool nmsOutput = false;         // [batch, N, 6] x1 y1 x2 y2 score class, NMS already applied
+    float scoreThreshold = static_cast<float>(EngineContainer::kScoreThreshold);
+    float iouThreshold = static_cast<float>(EngineContainer::kIouThreshold);
+    std::vector<std::string> classNames;
+
     bool checkCuda(cudaError_t status, const char* msg) {
         if (status != cudaSuccess) {
             std::cerr << msg << ": " << cudaGetErrorString(status) << std::endl;
@@ -98,6 +110,15 @@ private:
             hostOutput = nullptr;
         }
     }
+
+    static std::string formatDims(const Dims& dims) {
+        std::string text;
+        for (int i = 0; i < dims.nbDims; ++i) {
+            if (i > 0) text += "x";
+            text += std::to_string(dims.d[i]);
+        }
+        return text;
+    }
     
 public:
     TRTEngine()
@@ -120,7 +141,14 @@ public:
         if (stream) cudaStreamDestroy(stream);
     }
 
-    bool loadEngine(const std::string& enginePath) {
+    bool loadEngine(const std::string& enginePath, int profileIndex = 0, const std::string& refitOnnx = "") {
+        // Load time by phase, to compare raw and compressed engines (drop the page cache for cold loads)
+        using Clock = std::chrono::steady_clock;
+        auto elapsedMs = [](Clock::time_point since) {
+            return std::chrono::duration<double, std::milli>(Clock::now() - since).count();
+        };
+        auto phaseStart = Clock::now();
+        
         std::ifstream file(enginePath, std::ios::binary);
         if (!file.good()) {
             std::cerr << "Cannot open engine file: " << enginePath << std::endl;
@@ -135,12 +163,83 @@ public:
         file.read(engineData.data(), size);
         file.close();
         
+        if (!EngineChecksum::verify(enginePath, engineData.data(), size)) {
+            return false;
+        }
+        double readMs = elapsedMs(phaseStart);
+        
+        phaseStart = Clock::now();
+        EnginePlan plan;
+        if (!EngineContainer::unpack(engineData.data(), size, plan)) {
+            return false;
+        }
+        double unpackMs = elapsedMs(phaseStart);
+        const JsonValue metadata = plan.metadata;
+        if (metadata.isObject()) {
+            const JsonValue* source = metadata.find("source_model");
+            std::cout << "Engine container from " << (source && source->find("path") ? source->find("path")->asString() : "?")
+                      << (plan.compressed ? " (compressed)" : "") << std::endl;
+        }
+        
+        // A weight-stripped container names the ONNX it was built from: refit from
+        // that file next to the engine unless --refit names a copy elsewhere. Its
+        // weights are only defined for that exact model, so the SHA-256 must match.
+        std::string refitPath = refitOnnx;
+        const JsonValue* builtConfig = metadata.isObject() ? metadata.find("config") : nullptr;
+        const JsonValue* stripped = builtConfig ? builtConfig->find("strip_weights") : nullptr;
+        if (stripped && stripped->isBool() && stripped->asBool()) {
+            const JsonValue* source = metadata.find("source_model");
+            const JsonValue* sourceName = source ? source->find("path") : nullptr;
+            const JsonValue* sourceHash = source ? source->find("sha256") : nullptr;
+            if (refitPath.empty() && sourceName && sourceName->isString()) {
+                refitPath = (std::filesystem::path(enginePath).parent_path() / sourceName->asString()).string();
+            }
+            if (refitPath.empty() || !std::filesystem::is_regular_file(refitPath)) {
+                std::cerr << "Engine is weight-stripped and its ONNX "
+                          << (refitPath.empty() ? "is unknown" : "was not found: " + refitPath)
+                          << "; pass --refit model.onnx" << std::endl;
+                return false;
+            }
+            if (sourceHash && sourceHash->isString() && Sha256::hashFile(refitPath) != sourceHash->asString()) {
+                std::cerr << refitPath << " is not the ONNX this weight-stripped engine was built from (SHA-256 differs)"
+                          << std::endl;
+                return false;
+            }
+        }
+        
+        phaseStart = Clock::now();
         std::unique_ptr<IRuntime> runtime{createInferRuntime(gLogger)};
-        engine.reset(runtime->deserializeCudaEngine(engineData.data(), size));
+        runtime->setEngineHostCodeAllowed(true);    // version-compatible engines carry their lean runtime
+        engine.reset(runtime->deserializeCudaEngine(plan.data, plan.size));
         if (!engine) {
             std::cerr << "Failed to deserialize engine" << std::endl;
             return false;
         }
+        std::ios::fmtflags coutFlags = std::cout.flags();
+        std::streamsize coutPrecision = std::cout.precision();
+        std::cout << std::fixed << std::setprecision(1)
+                  << "Engine load: " << size / 1048576.0 << " MB file, " << plan.size / 1048576.0 << " MB plan; read "
+                  << readMs << " ms, " << (plan.compressed ? "decompress " : "unpack ") << unpackMs << " ms, deserialize "
+                  << elapsedMs(phaseStart) << " ms" << std::endl;
+        std::cout.flags(coutFlags);
+        std::cout.precision(coutPrecision);
+        plan = EnginePlan();
+        std::vector<char>().swap(engineData);
+        switch (engine->getHardwareCompatibilityLevel()) {
+        case HardwareCompatibilityLevel::kAMPERE_PLUS:
+            std::cout << "Hardware compatibility: Ampere and newer" << std::endl;
+            break;
+        case HardwareCompatibilityLevel::kSAME_COMPUTE_CAPABILITY:
+            std::cout << "Hardware compatibility: same compute capability" << std::endl;
+            break;
+        default:
+            break;
+        }
+        
+        // Weight-stripped engines get their weights back before any context exists
+        if (!refitPath.empty() && !EngineRefit::fromOnnx(*engine, gLogger, refitPath)) {
+            return false;
+        }
         
         context.reset(engine->createExecutionContext());
         if (!context) {
@@ -154,16 +253,28 @@ public:
         inputTensorName.clear();
         outputTensorName.clear();
         
+        // Container engines name their image input and detection output; bare plans
+        // fall back to the Ultralytics names
+        std::string wantedInput = "images";
+        std::string wantedOutput = "output0";
+        const JsonValue* postprocessInfo = metadata.find("postprocess");
+        if (const JsonValue* inputs = metadata.find("inputs")) {
+            if (inputs->size() > 0 && inputs->at(0).find("name")) wantedInput = inputs->at(0).find("name")->asString();
+        }
+        if (postprocessInfo && postprocessInfo->find("output")) {
+            wantedOutput = postprocessInfo->find("output")->asString();
+        }
+        
         for (int i = 0; i < engine->getNbIOTensors(); i++) {
             const char* tensorName = engine->getIOTensorName(i);
             auto mode = engine->getTensorIOMode(tensorName);
             if (mode == nvinfer1::TensorIOMode::kINPUT) {
-                if (inputIndex == -1 || strcmp(tensorName, "images") == 0) {
+                if (inputIndex == -1 || wantedInput == tensorName) {
                     inputIndex = i;
                     inputTensorName = tensorName;
                 }
             } else if (mode == nvinfer1::TensorIOMode::kOUTPUT) {
-                if (outputIndex == -1 || strcmp(tensorName, "output0") == 0) {
+                if (outputIndex == -1 || wantedOutput == tensorName) {
                     outputIndex = i;
                     outputTensorName = tensorName;
                 }
@@ -179,34 +290,91 @@ public:
             return false;
         }
         
-        auto inputDims = engine->getTensorShape(engine->getIOTensorName(inputIndex));
-        auto outputDims = engine->getTensorShape(engine->getIOTensorName(outputIndex));
-        
+        if (!stream) {
+            if (cudaStreamCreateWithFlags(&stream, cudaStreamNonBlocking) != cudaSuccess) {
+                std::cerr << "Failed to create CUDA stream" << std::endl;
+                return false;
+            }
+        }
+
+        // Engines built with several optimization profiles: list them and bind the requested one
+        int profileCount = engine->getNbOptimizationProfiles();
+        if (profileIndex < 0 || profileIndex >= profileCount) {
+            std::cerr << "Profile " << profileIndex << " out of range (engine has " << profileCount << ")" << std::endl;
+            return false;
+        }
+        for (int p = 0; p < profileCount; ++p) {
+            std::cout << (p == profileIndex ? "* " : "  ") << "Profile " << p << ": "
+                      << formatDims(engine->getProfileShape(inputTensorName.c_str(), p, OptProfileSelector::kMIN)) << " / "
+                      << formatDims(engine->getProfileShape(inputTensorName.c_str(), p, OptProfileSelector::kOPT)) << " / "
+                      << formatDims(engine->getProfileShape(inputTensorName.c_str(), p, OptProfileSelector::kMAX))
+                      << " (min/opt/max)" << std::endl;
+        }
+        if (!context->setOptimizationProfileAsync(profileIndex, stream) ||
+            !checkCuda(cudaStreamSynchronize(stream), "Failed to select optimization profile")) {
+            std::cerr << "Failed to select optimization profile " << profileIndex << std::endl;
+            return false;
+        }
+
+        // Dynamic axes take the profile's OPT size; the batch is the smallest the profile allows
+        auto inputDims = engine->getTensorShape(inputTensorName.c_str());
+        auto minDims = engine->getProfileShape(inputTensorName.c_str(), profileIndex, OptProfileSelector::kMIN);
+        auto optDims = engine->getProfileShape(inputTensorName.c_str(), profileIndex, OptProfileSelector::kOPT);
         if (inputDims.nbDims >= 4) {
-            inputC = std::max(1, static_cast<int>(inputDims.d[1]));
-            inputH = std::max(1, static_cast<int>(inputDims.d[2]));
-            inputW = std::max(1, static_cast<int>(inputDims.d[3]));
+            auto pick = [&](int axis, const Dims& fallback) {
+                return std::max(1, static_cast<int>(inputDims.d[axis] > 0 ? inputDims.d[axis] : fallback.d[axis]));
+            };
+            inputBatch = pick(0, minDims);
+            inputC = pick(1, optDims);
+            inputH = pick(2, optDims);
+            inputW = pick(3, optDims);
         }
 
-        if (outputDims.nbDims >= 3) {
-            maxDetections = std::max(1, static_cast<int>(outputDims.d[1]));
-            numClasses = std::max(0, static_cast<int>(outputDims.d[2]) - 4);
+        nvinfer1::Dims inputShape;
+        inputShape.nbDims = 4;
+        inputShape.d[0] = inputBatch;
+        inputShape.d[1] = inputC;
+        inputShape.d[2] = inputH;
+        inputShape.d[3] = inputW;
+        if (!context->setInputShape(inputTensorName.c_str(), inputShape)) {
+            std::cerr << "Failed to set input shape on execution context" << std::endl;
+            return false;
         }
 
-        inputSize = static_cast<size_t>(inputC) * inputH * inputW * sizeof(float);
-        outputSize = static_cast<size_t>(maxDetections) * (numClasses + 4) * sizeof(float);
+        // Output shape as resolved for the bound input shape
+        auto outputDims = context->getTensorShape(outputTensorName.c_str());
+        classNames.clear();
+        if (const JsonValue* classes = metadata.find("classes")) {
+            for (size_t i = 0; i < classes->size(); ++i) classNames.push_back(classes->at(i).asString());
+        }
+        if (postprocessInfo) {
+            auto number = [postprocessInfo](const char* key, double fallback) {
+                const JsonValue* value = postprocessInfo->find(key);
+                return value && value->isNumber() ? value->asNumber() : fallback;
+            };
+            const JsonValue* type = postprocessInfo->find("type");
+            nmsOutput = type && type->asString() == "nms";
+            anchorsLast = !nmsOutput && number("anchor_axis", 1) == 2;
+            scoreThreshold = static_cast<float>(number("score_threshold", EngineContainer::kScoreThreshold));
+            iouThreshold = static_cast<float>(number("iou_threshold", EngineContainer::kIouThreshold));
+        }
+        if (outputDims.nbDims >= 3) {
+            maxDetections = std::max(1, static_cast<int>(outputDims.d[anchorsLast ? 2 : 1]));
+            valuesPerDetection = std::max(1, static_cast<int>(outputDims.d[anchorsLast ? 1 : 2]));
+            numClasses = std::max(0, valuesPerDetection - 4);
+        }
+        if (postprocessInfo && postprocessInfo->find("num_classes")) {
+            numClasses = std::min(numClasses, static_cast<int>(postprocessInfo->find("num_classes")->asNumber()));
+        }
 
-        if (!stream) {
-            if (cudaStreamCreateWithFlags(&stream, cudaStreamNonBlocking) != cudaSuccess) {
-                std::cerr << "Failed to create CUDA stream" << std::endl;
-                return false;
-            }
+        // One frame per inference; further batch slots stay zero
+        inputSize = static_cast<size_t>(inputBatch) * inputC * inputH * inputW * sizeof(float);
+        outputSize = sizeof(float);
+        for (int i = 0; i < outputDims.nbDims; ++i) {
+            outputSize *= static_cast<size_t>(std::max<int64_t>(1, outputDims.d[i]));
         }
 
-        cachedSrcWidth = -1;
-        cachedSrcHeight = -1;
-        resizeXIndices.clear();
-        resizeYIndices.clear();
+        preprocessor.setOutputSize(inputC, inputH, inputW);
 
         releaseBuffers();
 
@@ -227,23 +395,11 @@ public:
             releaseBuffers();
             return false;
         }
-
-        nvinfer1::Dims inputShape;
-        inputShape.nbDims = 4;
-        inputShape.d[0] = 1;
-        inputShape.d[1] = inputC;
-        inputShape.d[2] = inputH;
-        inputShape.d[3] = inputW;
-        if (!context->setInputShape(inputTensorName.c_str(), inputShape)) {
-            std::cerr << "Failed to set input shape on execution context" << std::endl;
-            return false;
-        }
+        std::memset(hostInput, 0, inputSize);
 
         std::cout << "Engine loaded successfully!" << std::endl;
-        std::cout << "Input shape: " << inputDims.d[0] << "x" << inputDims.d[1]
-                  << "x" << inputDims.d[2] << "x" << inputDims.d[3] << std::endl;
-        std::cout << "Output shape: " << outputDims.d[0] << "x" << outputDims.d[1]
-                  << "x" << outputDims.d[2] << std::endl;
+        std::cout << "Input shape: " << formatDims(inputShape) << std::endl;
+        std::cout << "Output shape: " << formatDims(outputDims) << std::endl;
         
         return true;
     }
@@ -258,55 +414,7 @@ public:
             std::cerr << "CUDA stream is not available" << std::endl;
             return {};
         }
-        const int planeSize = inputH * inputW;
-        const int copyChannels = std::min(channels, inputC);
-        const float inv255 = 1.0f / 255.0f;
-        if (channels < inputC) {
-            std::fill(hostInput + copyChannels * planeSize, hostInput + inputC * planeSize, 0.0f);
-        }
-
-        if (width != cachedSrcWidth) {
-            resizeXIndices.resize(inputW);
-            float scaleX = static_cast<float>(width) / static_cast<float>(inputW);
-            int maxX = std::max(width - 1, 0);
-            for (int x = 0; x < inputW; ++x) {
-                int srcX = static_cast<int>(x * scaleX);
-                resizeXIndices[x] = std::min(srcX, maxX);
-            }
-            cachedSrcWidth = width;
-        }
-        if (height != cachedSrcHeight) {
-            resizeYIndices.resize(inputH);
-            float scaleY = static_cast<float>(height) / static_cast<float>(inputH);
-            int maxY = std::max(height - 1, 0);
-            for (int y = 0; y < inputH; ++y) {
-                int srcY = static_cast<int>(y * scaleY);
-                resizeYIndices[y] = std::min(srcY, maxY);
-            }
-            cachedSrcHeight = height;
-        }
-
-        if (resizeXIndices.size() != static_cast<size_t>(inputW)) {
-            resizeXIndices.assign(inputW, 0);
-        }
-        if (resizeYIndices.size() != static_cast<size_t>(inputH)) {
-            resizeYIndices.assign(inputH, 0);
-        }
-
-        for (int y = 0; y < inputH; y++) {
-            int srcY = resizeYIndices[y];
-            int rowBase = (srcY * width) * channels;
-            int dstRowBase = y * inputW;
-            for (int x = 0; x < inputW; x++) {
-                int srcX = resizeXIndices[x];
-                int srcIdx = rowBase + srcX * channels;
-                int dstIdx = dstRowBase + x;
-
-                for (int c = 0; c < copyChannels; ++c) {
-                    hostInput[c * planeSize + dstIdx] = imageData[srcIdx + c] * inv255;
-                }
-            }
-        }
+        preprocessor.run(imageData, width, height, channels, hostInput);
 
         // Copy to GPU
         if (!checkCuda(cudaMemcpyAsync(buffers[0], hostInput, inputSize,
@@ -345,29 +453,55 @@ public:
         return postprocess(hostOutput);
     }
 
+    // Class name from the container metadata, "Class <id>" without one
+    std::string classLabel(int classId) const {
+        if (classId >= 0 && classId < static_cast<int>(classNames.size())) return classNames[classId];
+        return "Class " + std::to_string(classId);
+    }
+
 private:
-    std::vector<Detection> postprocess(float* output, float confThreshold = 0.25f) {
+    std::vector<Detection> postprocess(float* output) {
         std::vector<Detection> detections;
         detections.reserve(maxDetections);
 
+        // Value j of detection i in either axis order
+        auto value = [&](int i, int j) {
+            return anchorsLast ? output[static_cast<size_t>(j) * maxDetections + i]
+                               : output[static_cast<size_t>(i) * valuesPerDetection + j];
+        };
+
+        if (nmsOutput) {
+            for (int i = 0; i < maxDetections; i++) {
+                float score = value(i, 4);
+                if (score <= scoreThreshold) continue;
+                Detection det;
+                det.x = (value(i, 0) + value(i, 2)) / 2;
+                det.y = (value(i, 1) + value(i, 3)) / 2;
+                det.w = value(i, 2) - value(i, 0);
+                det.h = value(i, 3) - value(i, 1);
+                det.confidence = score;
+                det.classId = static_cast<int>(value(i, 5));
+                detections.push_back(det);
+            }
+            return detections;
+        }
+
         for (int i = 0; i < maxDetections; i++) {
-            float* ptr = output + i * (numClasses + 4);
-            
             float maxScore = 0;
             int maxClassId = 0;
             for (int j = 4; j < numClasses + 4; j++) {
-                if (ptr[j] > maxScore) {
-                    maxScore = ptr[j];
+                if (value(i, j) > maxScore) {
+                    maxScore = value(i, j);
                     maxClassId = j - 4;
                 }
             }
             
-            if (maxScore > confThreshold) {
+            if (maxScore > scoreThreshold) {
                 Detection det;
-                det.x = ptr[0];
-                det.y = ptr[1];
-                det.w = ptr[2];
-                det.h = ptr[3];
+                det.x = value(i, 0);
+                det.y = value(i, 1);
+                det.w = value(i, 2);
+                det.h = value(i, 3);
                 det.confidence = maxScore;
                 det.classId = maxClassId;
                 detections.push_back(det);
@@ -389,7 +523,7 @@ private:
                 if (detections[i].classId != detections[j].classId) continue;
 
                 float iou = calculateIoU(detections[i], detections[j]);
-                if (iou > 0.45f) {
+                if (iou > iouThreshold) {
                     suppressed[j] = 1;
                 }
             }
@@ -489,17 +623,32 @@ public:
 
 int main(int argc, char** argv) {
     if (argc < 3) {
-        std::cout << "Usage: " << argv[0] << " <engine_file> <video_file>" << std::endl;
+        std::cout << "Usage: " << argv[0] << " <engine_file> <video_file> [--profile N] [--refit model.onnx]" << std::endl;
         std::cout << "Example: " << argv[0] << " model.engine test/test_det.mp4" << std::endl;
+        std::cout << "  --profile N  optimization profile for the execution context (default 0)" << std::endl;
+        std::cout << "  --refit F    refit a weight-stripped engine from the ONNX it was built from" << std::endl;
+        std::cout << "               (containers find it next to the engine by their source_model metadata)" << std::endl;
         return -1;
     }
     
     std::string enginePath = argv[1];
     std::string videoPath = argv[2];
+    int profileIndex = 0;
+    std::string refitOnnx;
+    for (int i = 3; i < argc; ++i) {
+        if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc) {
+            profileIndex = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--refit") == 0 && i + 1 < argc) {
+            refitOnnx = argv[++i];
+        } else {
+            std::cerr << "Unknown argument: " << argv[i] << std::endl;
+            return -1;
+        }
+    }
     
     // Initialize TensorRT engine
     TRTEngine engine;
-    if (!engine.loadEngine(enginePath)) {
+    if (!engine.loadEngine(enginePath, profileIndex, refitOnnx)) {
         std::cerr << "Failed to load engine" << std::endl;
         return -1;
     }
@@ -619,9 +768,9 @@ int main(int argc, char** argv) {
                     
                     drawList->AddRect(p1, p2, IM_COL32(0, 255, 0, 255), 0.0f, 0, 2.0f);
                     
-                    char label[64];
-                    snprintf(label, sizeof(label), "Class %d: %.0f%%", 
-                            det.classId, det.confidence * 100);
+                    char label[96];
+                    snprintf(label, sizeof(label), "%s: %.0f%%",
+                            engine.classLabel(det.classId).c_str(), det.confidence * 100);
                     drawList->AddText(p1, IM_COL32(255, 255, 0, 255), label);
                 }
                 
@@ -0,0 +1,279 @@
+#include "file_utils.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <process.h>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+int currentProcessId() {
+#ifdef _WIN32
+    return _getpid();
+#else
+    return static_cast<int>(getpid());
+#endif
+}
+
+} // namespace
+
+FileLock::FileLock(const std::string& path) : m_lockPath(path + ".lock") {
+#ifdef _WIN32
+    HANDLE handle = CreateFileA(m_lockPath.c_str(), GENERIC_READ | GENERIC_WRITE,
+                                FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                                OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        std::cerr << "Warning: Cannot open lock file: " << m_lockPath << "\n";
+        return;
+    }
+    OVERLAPPED overlapped = {};
+    if (!LockFileEx(handle, LOCKFILE_EXCLUSIVE_LOCK, 0, MAXDWORD, MAXDWORD, &overlapped)) {
+        std::cerr << "Warning: Cannot lock: " << m_lockPath << "\n";
+        CloseHandle(handle);
+        return;
+    }
+    m_handle = handle;
+    m_locked = true;
+#else
+    m_fd = open(m_lockPath.c_str(), O_RDWR | O_CREAT, 0644);
+    if (m_fd < 0) {
+        std::cerr << "Warning: Cannot open lock file: " << m_lockPath << "\n";
+        return;
+    }
+    if (flock(m_fd, LOCK_EX) != 0) {
+        std::cerr << "Warning: Cannot lock: " << m_lockPath << "\n";
+        close(m_fd);
+        m_fd = -1;
+        return;
+    }
+    m_locked = true;
+#endif
+}
+
+FileLock::~FileLock() {
+#ifdef _WIN32
+    if (m_handle) {
+        OVERLAPPED overlapped = {};
+        UnlockFileEx(static_cast<HANDLE>(m_handle), 0, MAXDWORD, MAXDWORD, &overlapped);
+        CloseHandle(static_cast<HANDLE>(m_handle));
+    }
+#else
+    if (m_fd >= 0) {
+        flock(m_fd, LOCK_UN);
+        close(m_fd);
+    }
+#endif
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string& path) {
+    close();
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        std::cerr << "Error: Cannot open file: " << path << "\n";
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        std::cerr << "Error: Cannot map empty file: " << path << "\n";
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!view) {
+        std::cerr << "Error: Cannot map file: " << path << "\n";
+        if (mapping) CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    m_file = file;
+    m_mapping = mapping;
+    m_data = static_cast<const unsigned char*>(view);
+    m_size = static_cast<size_t>(size.QuadPart);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Error: Cannot open file: " << path << "\n";
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        std::cerr << "Error: Cannot map empty file: " << path << "\n";
+        ::close(fd);
+        return false;
+    }
+    void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);    // the mapping keeps the file referenced
+    if (view == MAP_FAILED) {
+        std::cerr << "Error: Cannot map file: " << path << "\n";
+        return false;
+    }
+    madvise(view, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+    m_data = static_cast<const unsigned char*>(view);
+    m_size = static_cast<size_t>(info.st_size);
+#endif
+    return true;
+}
+
+void MappedFile::close() {
+    if (!m_data) return;
+#ifdef _WIN32
+    UnmapViewOfFile(m_data);
+    CloseHandle(static_cast<HANDLE>(m_mapping));
+    CloseHandle(static_cast<HANDLE>(m_file));
+    m_file = nullptr;
+    m_mapping = nullptr;
+#else
+    munmap(const_cast<unsigned char*>(m_data), m_size);
+#endif
+    m_data = nullptr;
+    m_size = 0;
+}
+
+bool readFileBytes(const std::string& path, std::vector<char>& data) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return !file.bad();
+}
+
+AtomicFileWriter::AtomicFileWriter(const std::string& path) : m_path(path) {
+    // Unique per process and per writer, so concurrent writers never share a temp file
+    static std::atomic<unsigned> counter{0};
+    m_tempPath = path + ".tmp." + std::to_string(currentProcessId()) + "." + std::to_string(counter++);
+#ifdef _WIN32
+    HANDLE handle = CreateFileA(m_tempPath.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+                                FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (handle != INVALID_HANDLE_VALUE) m_handle = handle;
+#else
+    m_fd = ::open(m_tempPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+#endif
+    if (!isOpen()) {
+        std::cerr << "Error: Cannot create file: " << m_tempPath << "\n";
+        m_failed = true;
+    }
+}
+
+AtomicFileWriter::~AtomicFileWriter() {
+    abort();
+}
+
+bool AtomicFileWriter::isOpen() const {
+#ifdef _WIN32
+    return m_handle != nullptr;
+#else
+    return m_fd >= 0;
+#endif
+}
+
+bool AtomicFileWriter::write(const void* data, size_t size) {
+    if (m_failed || !isOpen()) return false;
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+#ifdef _WIN32
+        DWORD chunk = static_cast<DWORD>(std::min<size_t>(size, 1u << 30));
+        DWORD written = 0;
+        if (!WriteFile(static_cast<HANDLE>(m_handle), bytes, chunk, &written, nullptr) || written == 0) {
+            m_failed = true;
+            return false;
+        }
+#else
+        ssize_t written = ::write(m_fd, bytes, std::min<size_t>(size, 1u << 30));
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) {
+            m_failed = true;
+            return false;
+        }
+#endif
+        bytes += written;
+        size -= static_cast<size_t>(written);
+        m_bytes += static_cast<uint64_t>(written);
+    }
+    return true;
+}
+
+bool AtomicFileWriter::commit() {
+    if (!isOpen()) return false;
+    if (m_failed) {
+        std::cerr << "Error: Failed to write file: " << m_tempPath << "\n";
+        abort();
+        return false;
+    }
+    // Without the flush a crash shortly after the rename can leave the new name
+    // pointing at a file whose data never reached the disk
+#ifdef _WIN32
+    bool flushed = FlushFileBuffers(static_cast<HANDLE>(m_handle)) != 0;
+#else
+    bool flushed = fsync(m_fd) == 0;
+#endif
+    if (!flushed) {
+        std::cerr << "Error: Failed to flush file: " << m_tempPath << "\n";
+        abort();
+        return false;
+    }
+    closeHandle();
+
+#ifdef _WIN32
+    bool replaced = MoveFileExA(m_tempPath.c_str(), m_path.c_str(),
+                                MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    bool replaced = std::rename(m_tempPath.c_str(), m_path.c_str()) == 0;
+#endif
+    if (!replaced) {
+        std::cerr << "Error: Cannot replace file: " << m_path << "\n";
+        std::remove(m_tempPath.c_str());
+        return false;
+    }
+
+#ifndef _WIN32
+    // Persist the rename itself; best effort, the contents are already safe
+    size_t slash = m_path.find_last_of('/');
+    std::string dir = slash == std::string::npos ? "." : (slash == 0 ? "/" : m_path.substr(0, slash));
+    int dirFd = ::open(dir.c_str(), O_RDONLY | O_CLOEXEC);
+    if (dirFd >= 0) {
+        fsync(dirFd);
+        ::close(dirFd);
+    }
+#endif
+    return true;
+}
+
+void AtomicFileWriter::abort() {
+    if (!isOpen()) return;
+    closeHandle();
+    std::remove(m_tempPath.c_str());
+}
+
+void AtomicFileWriter::closeHandle() {
+#ifdef _WIN32
+    CloseHandle(static_cast<HANDLE>(m_handle));
+    m_handle = nullptr;
+#else
+    ::close(m_fd);
+    m_fd = -1;
+#endif
+}
+
+bool writeFileAtomic(const std::string& path, const void* data, size_t size) {
+    AtomicFileWriter file(path);
+    file.write(data, size);
+    return file.commit();
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Cross-process advisory lock on "<path>.lock" (LockFileEx on Windows, flock elsewhere).
+// Blocks in the constructor until the lock is held; released on destruction.
+class FileLock {
+public:
+    explicit FileLock(const std::string& path);
+    ~FileLock();
+
+    FileLock(const FileLock&) = delete;
+    FileLock& operator=(const FileLock&) = delete;
+
+    bool isLocked() const { return m_locked; }
+
+private:
+    std::string m_lockPath;
+    bool m_locked = false;
+#ifdef _WIN32
+    void* m_handle = nullptr;
+#else
+    int m_fd = -1;
+#endif
+};
+
+// Read-only memory mapping of a whole file (MapViewOfFile on Windows, mmap elsewhere)
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Prints an error and returns false if the file cannot be mapped
+    bool open(const std::string& path);
+    void close();
+
+    const unsigned char* data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+private:
+    const unsigned char* m_data = nullptr;
+    size_t m_size = 0;
+#ifdef _WIN32
+    void* m_file = nullptr;
+    void* m_mapping = nullptr;
+#endif
+};
+
+// Streams into a temporary file in the same directory as `path`; commit() flushes
+// it to disk and renames it over `path`, so readers only ever see the old or the
+// complete new contents, even after a crash. Destroying an uncommitted writer
+// removes the temporary file.
+class AtomicFileWriter {
+public:
+    explicit AtomicFileWriter(const std::string& path);
+    ~AtomicFileWriter();
+
+    AtomicFileWriter(const AtomicFileWriter&) = delete;
+    AtomicFileWriter& operator=(const AtomicFileWriter&) = delete;
+
+    bool isOpen() const;
+    bool write(const void* data, size_t size);
+    // Prints an error and returns false if any write, the flush or the rename failed
+    bool commit();
+    void abort();
+
+    const std::string& path() const { return m_path; }
+    uint64_t bytesWritten() const { return m_bytes; }
+
+private:
+    void closeHandle();
+
+    std::string m_path;
+    std::string m_tempPath;
+    uint64_t m_bytes = 0;
+    bool m_failed = false;
+#ifdef _WIN32
+    void* m_handle = nullptr;
+#else
+    int m_fd = -1;
+#endif
+};
+
+// Reads a whole file. Returns false if it cannot be opened.
+bool readFileBytes(const std::string& path, std::vector<char>& data);
+
+// Writes to a temporary file in the same directory and renames it over `path`,
+// so readers only ever see the old or the complete new contents.
+bool writeFileAtomic(const std::string& path, const void* data, size_t size);
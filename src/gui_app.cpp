@@ -1,5 +1,6 @@
 ﻿#include "gui_app.h"
 #include "engine_exporter.h"
+#include "build_progress.h"
 #include "config.h"
 
 #include <imgui.h>
@@ -7,6 +8,7 @@
 #include <imgui_impl_opengl3.h>
 #include <GLFW/glfw3.h>
 
+#include <cstdio>
 #include <iostream>
 #include <filesystem>
 #include <fstream>
@@ -109,7 +111,10 @@ void GuiApp::run() {
 }
 
 void GuiApp::shutdown() {
-    // Wait for export thread to finish
+    // Closing the window abandons the build: stop it instead of waiting it out
+    if (m_buildProgress) {
+        m_buildProgress->cancel();
+    }
     if (m_exportThread && m_exportThread->joinable()) {
         m_exportThread->join();
     }
@@ -249,8 +254,24 @@ void GuiApp::renderExportOptions() {
     ImGui::Checkbox("Assume QAT (ONNX has Q/DQ)", &m_assumeQat);
     ImGui::SameLine();
     helpMarker("If your ONNX contains QuantizeLinear/DequantizeLinear nodes, enable this to build INT8 without a dataset.");
+    if (!m_assumeQat) {
+        ImGui::InputText("Calibration Cache", m_calibCache, sizeof(m_calibCache));
+        ImGui::SameLine();
+        helpMarker("Used as is when the file exists; otherwise written after calibrating with the images below");
+        ImGui::InputText("Calibration Images", m_calibDataDir, sizeof(m_calibDataDir));
+        ImGui::SameLine();
+        helpMarker("Folder of .jpg/.png/.bmp images, preprocessed like engine_tester (stretch, RGB, 0-1)");
+        ImGui::Checkbox("Diverse Subset", &m_calibDiverse);
+        ImGui::SameLine();
+        helpMarker("Calibrate on the most varied images of a large folder (e.g. video frames) instead of the first ones");
+    }
     ImGui::Unindent();
 
+    ImGui::InputText("Precision Policy", m_precisionPolicy, sizeof(m_precisionPolicy));
+    ImGui::SameLine();
+    helpMarker("Optional JSON file of per-layer precision rules (layer name / layer type globs),\n"
+               "e.g. keep the first conv and the detection head in FP16 while the backbone runs in INT8");
+
     ImGui::Spacing();
     ImGui::Separator();
     ImGui::Spacing();
@@ -278,10 +299,57 @@ void GuiApp::renderExportOptions() {
         ImGui::SameLine();
         helpMarker("Create refittable engine (allows weight updates without rebuild)");
         
+        ImGui::Checkbox("Strip Weights", &m_stripWeights);
+        ImGui::SameLine();
+        helpMarker("Leave the weights out of the engine; the loader refits them from the same ONNX.\n"
+                   "Engines shrink to a fraction and one ONNX backs every resolution/precision variant");
+        
+        ImGui::Checkbox("Engine Container", &m_engineContainer);
+        ImGui::SameLine();
+        helpMarker("Store I/O tensors, preprocessing, class names and NMS settings in the engine file.\n"
+                   "Loaders that expect a bare TensorRT plan cannot read it");
+        
+        ImGui::Checkbox("Compress Engine", &m_compressEngine);
+        ImGui::SameLine();
+        helpMarker("Store the plan LZ4-compressed in the container (kernels compress, weights mostly do not).\n"
+                   "Smaller artifacts to sync; loading decompresses on all cores");
+        
+        const char* compatibility_items[] = { "This GPU only", "Ampere and newer", "Same compute capability" };
+        ImGui::Text("Hardware Compatibility:");
+        ImGui::Combo("##HardwareCompat", &m_hardwareCompatIndex, compatibility_items, IM_ARRAYSIZE(compatibility_items));
+        ImGui::SameLine();
+        helpMarker("Let one engine run on other GPU models of the fleet.\n"
+                   "Costs some speed: cuDNN/cuBLAS tactics and some fusions are unavailable");
+        
+        ImGui::Checkbox("Version Compatible", &m_versionCompatible);
+        ImGui::SameLine();
+        helpMarker("Engine also loads on later TensorRT 10.x runtimes");
+        if (m_versionCompatible) {
+            ImGui::Checkbox("Exclude Lean Runtime", &m_excludeLeanRuntime);
+            ImGui::SameLine();
+            helpMarker("Smaller engine; the runtime machine must provide the lean runtime library");
+        }
+        
         ImGui::Checkbox("Disable Timing Cache", &m_disableTimingCache);
         ImGui::SameLine();
         helpMarker("Disable timing cache for faster build (may affect kernel selection)");
         
+        if (!m_disableTimingCache) {
+            ImGui::Text("Timing Cache Folder:");
+            ImGui::InputText("##TimingCacheDir", m_timingCacheDir, sizeof(m_timingCacheDir));
+            ImGui::SameLine();
+            helpMarker("Tactic timings are saved here per GPU, TensorRT version and precision, and reused by later builds (empty = off)");
+        }
+        
+        ImGui::Text("Engine Store Folder:");
+        ImGui::InputText("##EngineStoreDir", m_engineStoreDir, sizeof(m_engineStoreDir));
+        ImGui::SameLine();
+        helpMarker("Built engines are kept here by model content, settings, GPU and TensorRT version; identical exports are copied out instead of rebuilt (empty = off)");
+        if (m_engineStoreDir[0] != '\0') {
+            ImGui::InputInt("Store Limit (GB)", &m_engineStoreMaxGb);
+            if (m_engineStoreMaxGb < 1) m_engineStoreMaxGb = 1;
+        }
+        
         ImGui::Text("Optimization Level:");
         ImGui::SliderInt("##OptLevel", &m_optimizationLevel, 1, 5, "Level %d");
         helpMarker("Higher levels = more aggressive optimization (5 = maximum)");
@@ -345,6 +413,57 @@ void GuiApp::renderExportOptions() {
         ImGui::Unindent();
     }
 
+    ImGui::Spacing();
+    
+    // Dynamic batch
+    ImGui::Text("Batch Settings:");
+    ImGui::Checkbox("Dynamic Batch", &m_dynamicBatch);
+    ImGui::SameLine();
+    helpMarker("Rewrite a static batch-1 ONNX to a symbolic batch and build a profile spanning the range below");
+    
+    if (m_dynamicBatch) {
+        ImGui::Indent();
+        ImGui::SetNextItemWidth(100);
+        ImGui::InputInt("Min##BatchMin", &m_batchMin);
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(100);
+        ImGui::InputInt("Opt##BatchOpt", &m_batchOpt);
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(100);
+        ImGui::InputInt("Max##BatchMax", &m_batchMax);
+        if (m_batchMin < 1) m_batchMin = 1;
+        if (m_batchMax < m_batchMin) m_batchMax = m_batchMin;
+        if (m_batchOpt < m_batchMin) m_batchOpt = m_batchMin;
+        if (m_batchOpt > m_batchMax) m_batchOpt = m_batchMax;
+        ImGui::Unindent();
+    }
+    
+    ImGui::InputText("Optimization Profiles", m_optimizationProfiles, sizeof(m_optimizationProfiles));
+    ImGui::SameLine();
+    helpMarker("Several profiles in one engine, ';'-separated, each batch[:size] with a value or min-opt-max, "
+               "e.g. 1-4-8:640; 1:320-480-640. Replaces the resolution and batch settings; size ranges need an ONNX with dynamic H/W");
+
+    ImGui::Spacing();
+    
+    // Build matrix
+    ImGui::Checkbox("Build Matrix", &m_buildMatrix);
+    ImGui::SameLine();
+    helpMarker("Build every resolution x precision x profile combination in one run: the ONNX is parsed once and the timing cache is shared. Engines go to the output folder with generated names");
+    
+    if (m_buildMatrix) {
+        ImGui::Indent();
+        ImGui::InputText("Resolutions##Matrix", m_matrixResolutions, sizeof(m_matrixResolutions));
+        ImGui::SameLine();
+        helpMarker("Comma-separated, e.g. 320,416,640");
+        ImGui::InputText("Precisions##Matrix", m_matrixPrecisions, sizeof(m_matrixPrecisions));
+        ImGui::SameLine();
+        helpMarker("Comma-separated; combine with '+', e.g. fp16,fp16+fp8,int8 (fp32 = no reduced precision)");
+        ImGui::InputText("Profiles##Matrix", m_matrixProfiles, sizeof(m_matrixProfiles));
+        ImGui::SameLine();
+        helpMarker("Comma-separated batch profiles: static, or min-opt-max for dynamic batch, e.g. static,1-4-8");
+        ImGui::Unindent();
+    }
+
     ImGui::Spacing();
 
     // Verbose output
@@ -389,7 +508,7 @@ void GuiApp::renderExportOptions() {
 }
 
 void GuiApp::renderExportButton() {
-    bool canExport = m_exportStatus == ExportStatus::IDLE && validateInputs();
+    bool canExport = m_exportStatus != ExportStatus::RUNNING && validateInputs();
     
     if (!canExport) {
         ImGui::BeginDisabled();
@@ -405,19 +524,54 @@ void GuiApp::renderExportButton() {
     
     if (m_exportStatus == ExportStatus::RUNNING) {
         ImGui::SameLine();
-        ImGui::Text("Converting...");
+        bool cancelling = m_buildProgress->cancelled();
+        if (cancelling) {
+            ImGui::BeginDisabled();
+        }
+        if (ImGui::Button("Cancel", ImVec2(100, 40))) {
+            m_buildProgress->cancel();
+            addLog("Cancelling build...");
+        }
+        if (cancelling) {
+            ImGui::EndDisabled();
+        }
+        ImGui::SameLine();
+        ImGui::Text(cancelling ? "Cancelling..." : "Converting...");
     } else if (m_exportStatus == ExportStatus::COMPLETED) {
         ImGui::SameLine();
         ImGui::TextColored(ImVec4(0.0f, 1.0f, 0.0f, 1.0f), "Conversion Completed!");
     } else if (m_exportStatus == ExportStatus::FAILED) {
         ImGui::SameLine();
         ImGui::TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), "Conversion Failed");
+    } else if (m_exportStatus == ExportStatus::CANCELLED) {
+        ImGui::SameLine();
+        ImGui::TextColored(ImVec4(1.0f, 0.8f, 0.0f, 1.0f), "Conversion Cancelled");
     }
 }
 
 void GuiApp::renderProgressBar() {
-    if (m_exportStatus == ExportStatus::RUNNING) {
+    if (m_exportStatus != ExportStatus::RUNNING) {
+        return;
+    }
+    
+    BuildProgress::Snapshot progress = m_buildProgress->snapshot();
+    if (!progress.active) {
+        // Parsing, calibration setup, engine store lookup: no builder phases yet
         ImGui::ProgressBar(m_exportProgress.load(), ImVec2(-1.0f, 0.0f));
+        return;
+    }
+    
+    char overlay[256];
+    if (progress.etaSeconds >= 0.0) {
+        int eta = static_cast<int>(progress.etaSeconds + 0.5);
+        snprintf(overlay, sizeof(overlay), "%s  %d/%d  (ETA %d:%02d)", progress.countedPhase.c_str(),
+                 progress.step, progress.steps, eta / 60, eta % 60);
+    } else {
+        snprintf(overlay, sizeof(overlay), "%s", progress.phase.c_str());
+    }
+    ImGui::ProgressBar(progress.fraction, ImVec2(-1.0f, 0.0f), overlay);
+    if (progress.phase != progress.countedPhase) {
+        ImGui::TextDisabled("%s, %d s elapsed", progress.phase.c_str(), static_cast<int>(progress.elapsedSeconds));
     }
 }
 
@@ -518,6 +672,7 @@ void GuiApp::startExport() {
     
     m_exportStatus = ExportStatus::RUNNING;
     m_exportProgress = 0.0f;
+    m_buildProgress = std::make_shared<BuildProgress>();
     m_exportError.clear();
     
     m_exportThread = std::make_unique<std::thread>(&GuiApp::exportThreadFunc, this);
@@ -534,17 +689,36 @@ void GuiApp::exportThreadFunc() {
         config.enable_fp8 = m_enableFp8;
         config.enable_int8 = m_enableInt8;
         config.assume_qat_quantized = m_assumeQat;
+        config.int8_calib_cache = std::string(m_calibCache);
+        config.int8_calib_data_dir = std::string(m_calibDataDir);
+        config.calib_diverse_subset = m_calibDiverse;
+        config.precision_policy = std::string(m_precisionPolicy);
         config.workspace_mb = m_workspaceMb;
         config.verbose = m_verbose;
         config.fix_nms_output = m_fixNmsOutput;
         config.nms_max_detections = m_nmsMaxDetections;
+        config.dynamic_batch = m_dynamicBatch;
+        config.batch_min = m_batchMin;
+        config.batch_opt = m_batchOpt;
+        config.batch_max = m_batchMax;
+        config.optimization_profiles = std::string(m_optimizationProfiles);
         
         // Advanced optimization settings
         config.enable_tf32 = m_enableTf32;
         config.enable_sparse_weights = m_enableSparseWeights;
         config.enable_direct_io = m_enableDirectIO;
         config.enable_refit = m_enableRefit;
+        config.strip_weights = m_stripWeights;
+        config.engine_container = m_engineContainer;
+        config.compress_engine = m_compressEngine;
+        const char* compatibility_levels[] = { "none", "ampere_plus", "same_compute_capability" };
+        config.hardware_compatibility = compatibility_levels[m_hardwareCompatIndex];
+        config.version_compatible = m_versionCompatible;
+        config.exclude_lean_runtime = m_excludeLeanRuntime;
         config.disable_timing_cache = m_disableTimingCache;
+        config.timing_cache_dir = std::string(m_timingCacheDir);
+        config.engine_store_dir = std::string(m_engineStoreDir);
+        config.engine_store_max_gb = m_engineStoreMaxGb;
         config.optimization_level = m_optimizationLevel;
         
         // Tactic sources
@@ -598,13 +772,37 @@ void GuiApp::exportThreadFunc() {
         m_exportProgress = 0.1f;
         
         // Create and run exporter
+        std::shared_ptr<BuildProgress> progress = m_buildProgress;
         EngineExporter exporter(config);
+        exporter.setProgressMonitor(progress.get());
         
         m_exportProgress = 0.2f;
         
-        bool success = exporter.exportEngine();
+        bool success = false;
+        if (m_buildMatrix) {
+            std::vector<BuildVariant> variants;
+            std::string error;
+            if (!BuildVariant::expand_matrix(m_matrixResolutions, m_matrixPrecisions, m_matrixProfiles, variants, error)) {
+                m_exportStatus = ExportStatus::FAILED;
+                addLog("Invalid build matrix: " + error, true);
+                return;
+            }
+            addLog("Building " + std::to_string(variants.size()) + " variants");
+            
+            std::vector<VariantResult> results;
+            success = exporter.exportMatrix(variants, results);
+            for (const auto& result : results) {
+                std::string status = !result.success ? "failed" : (result.fromStore ? "from store" : "built");
+                addLog("  " + result.label + ": " + status + " -> " + result.outputPath, !result.success);
+            }
+        } else {
+            success = exporter.exportEngine();
+        }
         
-        if (success) {
+        if (progress->cancelled()) {
+            m_exportStatus = ExportStatus::CANCELLED;
+            addLog("Engine export cancelled");
+        } else if (success) {
             m_exportProgress = 1.0f;
             m_exportStatus = ExportStatus::COMPLETED;
             addLog("Engine export completed successfully!");
@@ -649,6 +847,9 @@ std::string GuiApp::generateOutputPath() {
     baseName += "_" + std::to_string(m_resolution);
     if (m_enableFp16) baseName += "_fp16";
     if (m_enableFp8) baseName += "_fp8";
+    if (m_enableInt8) baseName += "_int8";
+    if (m_dynamicBatch) baseName += "_b" + std::to_string(m_batchMin) + "-" + std::to_string(m_batchMax);
+    if (strlen(m_optimizationProfiles) > 0) baseName += "_profiles";
     
     std::filesystem::path outputPath = inputPath.parent_path() / (baseName + ".engine");
     return outputPath.string();
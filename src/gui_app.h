@@ -10,6 +10,7 @@
 
 struct GLFWwindow;
 class EngineExporter;
+class BuildProgress;
 struct ExportConfig;
 struct PluginInfo;
 struct CustomPluginInfo;
@@ -18,7 +19,8 @@ enum class ExportStatus {
     IDLE,
     RUNNING,
     COMPLETED,
-    FAILED
+    FAILED,
+    CANCELLED
 };
 
 struct LogEntry {
@@ -50,17 +52,39 @@ private:
     bool m_enableFp8 = true;
     bool m_enableInt8 = false;
     bool m_assumeQat = false; // Assume Q/DQ (QAT) present in ONNX for INT8 without dataset
+    char m_calibCache[512] = "";
+    char m_calibDataDir[512] = "";
+    bool m_calibDiverse = false;
+    char m_precisionPolicy[512] = "";
     int m_workspaceMb = 2048;
     bool m_verbose = true;
     bool m_fixNmsOutput = true;
     int m_nmsMaxDetections = 200;
+    bool m_dynamicBatch = false;
+    int m_batchMin = 1;
+    int m_batchOpt = 1;
+    int m_batchMax = 8;
+    char m_optimizationProfiles[256] = "";
+    bool m_buildMatrix = false;
+    char m_matrixResolutions[128] = "320,416,640";
+    char m_matrixPrecisions[128] = "fp16,fp16+fp8,int8";
+    char m_matrixProfiles[128] = "static";
     
     // Advanced optimization settings
     bool m_enableTf32 = true;
     bool m_enableSparseWeights = true;
     bool m_enableDirectIO = true;
     bool m_enableRefit = false;
+    bool m_stripWeights = false;
+    bool m_engineContainer = false;
+    bool m_compressEngine = false;
+    int m_hardwareCompatIndex = 0;      // none, ampere_plus, same_compute_capability
+    bool m_versionCompatible = false;
+    bool m_excludeLeanRuntime = false;
     bool m_disableTimingCache = false;
+    char m_timingCacheDir[512] = "timing_cache";
+    char m_engineStoreDir[512] = "";
+    int m_engineStoreMaxGb = 20;
     int m_optimizationLevel = 5;
     
     // Tactic sources
@@ -87,6 +111,7 @@ private:
     // Export state
     std::atomic<ExportStatus> m_exportStatus{ExportStatus::IDLE};
     std::atomic<float> m_exportProgress{0.0f};
+    std::shared_ptr<BuildProgress> m_buildProgress;    // builder phases of the running export, cancel flag
     std::string m_exportError;
     
     // Threading
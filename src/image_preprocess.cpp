@@ -0,0 +1,62 @@
+#include "image_preprocess.h"
+#include <algorithm>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+void ImagePreprocessor::setOutputSize(int channels, int height, int width) {
+    m_channels = channels;
+    m_height = height;
+    m_width = width;
+    m_cachedSrcWidth = -1;
+    m_cachedSrcHeight = -1;
+}
+
+void ImagePreprocessor::run(const unsigned char* image, int width, int height, int channels, float* output) {
+    const int planeSize = m_height * m_width;
+    const int copyChannels = std::min(channels, m_channels);
+    const float inv255 = 1.0f / 255.0f;
+    if (channels < m_channels) {
+        std::fill(output + copyChannels * planeSize, output + m_channels * planeSize, 0.0f);
+    }
+
+    if (width != m_cachedSrcWidth) {
+        m_xIndices.resize(m_width);
+        float scaleX = static_cast<float>(width) / static_cast<float>(m_width);
+        int maxX = std::max(width - 1, 0);
+        for (int x = 0; x < m_width; ++x) {
+            m_xIndices[x] = std::min(static_cast<int>(x * scaleX), maxX);
+        }
+        m_cachedSrcWidth = width;
+    }
+    if (height != m_cachedSrcHeight) {
+        m_yIndices.resize(m_height);
+        float scaleY = static_cast<float>(height) / static_cast<float>(m_height);
+        int maxY = std::max(height - 1, 0);
+        for (int y = 0; y < m_height; ++y) {
+            m_yIndices[y] = std::min(static_cast<int>(y * scaleY), maxY);
+        }
+        m_cachedSrcHeight = height;
+    }
+
+    for (int y = 0; y < m_height; y++) {
+        int rowBase = (m_yIndices[y] * width) * channels;
+        int dstRowBase = y * m_width;
+        for (int x = 0; x < m_width; x++) {
+            int srcIdx = rowBase + m_xIndices[x] * channels;
+            int dstIdx = dstRowBase + x;
+            for (int c = 0; c < copyChannels; ++c) {
+                output[c * planeSize + dstIdx] = image[srcIdx + c] * inv255;
+            }
+        }
+    }
+}
+
+bool ImagePreprocessor::loadImage(const std::string& path, std::vector<unsigned char>& pixels,
+                                  int& width, int& height, int& channels) {
+    unsigned char* data = stbi_load(path.c_str(), &width, &height, &channels, 0);
+    if (!data) return false;
+    pixels.assign(data, data + static_cast<size_t>(width) * height * channels);
+    stbi_image_free(data);
+    return true;
+}
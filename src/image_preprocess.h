@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Runtime input preprocessing, shared by engine_tester and INT8 calibration so
+// calibration sees exactly what inference sees: nearest-neighbour stretch to
+// the network size, channels in file order (RGB), scaled to [0, 1], planar CHW.
+// Source channels beyond the network's are dropped, missing ones are zero.
+class ImagePreprocessor {
+public:
+    // Recorded in calibration shards; change it whenever run() changes its output
+    static constexpr const char* kMethod = "nearest-stretch/rgb/unit/chw";
+
+
+    void setOutputSize(int channels, int height, int width);
+
+    // Writes channels * height * width floats to output
+    void run(const unsigned char* image, int width, int height, int channels, float* output);
+
+    // Decodes a JPEG/PNG/BMP file with stb_image (channels as stored); false if unreadable
+    static bool loadImage(const std::string& path, std::vector<unsigned char>& pixels,
+                          int& width, int& height, int& channels);
+
+private:
+    int m_channels = 3;
+    int m_height = 0;
+    int m_width = 0;
+
+    // Source index per output column/row, rebuilt when the source size changes
+    std::vector<int> m_xIndices;
+    std::vector<int> m_yIndices;
+    int m_cachedSrcWidth = -1;
+    int m_cachedSrcHeight = -1;
+};
@@ -0,0 +1,63 @@
+#include "int8_calibrator.h"
+#include "file_utils.h"
+#include <cuda_runtime.h>
+#include <iostream>
+
+Int8EntropyCalibrator::Int8EntropyCalibrator(const std::string& cachePath, const std::string& inputName,
+                                             int batchSize, std::unique_ptr<CalibrationBatchSource> source)
+    : m_cachePath(cachePath), m_inputName(inputName), m_batchSize(batchSize), m_source(std::move(source)) {
+}
+
+Int8EntropyCalibrator::~Int8EntropyCalibrator() {
+    if (m_deviceInput) cudaFree(m_deviceInput);
+}
+
+bool Int8EntropyCalibrator::getBatch(void* bindings[], const char* names[], int32_t nbBindings) noexcept {
+    if (!m_source) return false;
+
+    const float* batch = m_source->next();
+    if (!batch) return false;
+
+    size_t bytes = m_source->batchFloats() * sizeof(float);
+    if (!m_deviceInput && cudaMalloc(&m_deviceInput, bytes) != cudaSuccess) {
+        std::cerr << "Error: Cannot allocate calibration input buffer\n";
+        m_deviceInput = nullptr;
+        return false;
+    }
+    if (cudaMemcpy(m_deviceInput, batch, bytes, cudaMemcpyHostToDevice) != cudaSuccess) {
+        std::cerr << "Error: Cannot copy calibration batch to the device\n";
+        return false;
+    }
+
+    for (int32_t i = 0; i < nbBindings; ++i) {
+        if (m_inputName != names[i]) {
+            std::cerr << "Error: Calibration data only covers input '" << m_inputName << "', not '" << names[i] << "'\n";
+            return false;
+        }
+        bindings[i] = m_deviceInput;
+    }
+
+    ++m_batchesServed;
+    if (m_batchesServed % 20 == 0 || m_batchesServed == m_source->batchCount()) {
+        std::cout << "  Calibration batch " << m_batchesServed << "/" << m_source->batchCount() << "\n";
+    }
+    return true;
+}
+
+const void* Int8EntropyCalibrator::readCalibrationCache(size_t& length) noexcept {
+    length = 0;
+    if (m_cachePath.empty() || !readFileBytes(m_cachePath, m_cache) || m_cache.empty()) {
+        return nullptr;
+    }
+    length = m_cache.size();
+    return m_cache.data();
+}
+
+void Int8EntropyCalibrator::writeCalibrationCache(const void* cache, size_t length) noexcept {
+    if (m_cachePath.empty()) return;
+    if (writeFileAtomic(m_cachePath, cache, length)) {
+        std::cout << "  Calibration cache written: " << m_cachePath << "\n";
+    } else {
+        std::cerr << "Warning: Failed to write calibration cache: " << m_cachePath << "\n";
+    }
+}
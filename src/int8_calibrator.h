@@ -0,0 +1,33 @@
+#pragma once
+
+#include <NvInfer.h>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+#include "calibration_batches.h"
+
+// Entropy calibrator (IInt8EntropyCalibrator2) for the main network input.
+// With a batch source it feeds real data; without one it can only replay an
+// existing cache. An existing cache file is always used in preference to
+// recalibrating, and a new cache is written there after calibration.
+class Int8EntropyCalibrator final : public nvinfer1::IInt8EntropyCalibrator2 {
+public:
+    Int8EntropyCalibrator(const std::string& cachePath, const std::string& inputName, int batchSize,
+                          std::unique_ptr<CalibrationBatchSource> source = nullptr);
+    ~Int8EntropyCalibrator() override;
+
+    int32_t getBatchSize() const noexcept override { return m_batchSize; }
+    bool getBatch(void* bindings[], const char* names[], int32_t nbBindings) noexcept override;
+    const void* readCalibrationCache(size_t& length) noexcept override;
+    void writeCalibrationCache(const void* cache, size_t length) noexcept override;
+
+private:
+    std::string m_cachePath;
+    std::string m_inputName;
+    int m_batchSize;
+    std::unique_ptr<CalibrationBatchSource> m_source;
+    void* m_deviceInput = nullptr;
+    int m_batchesServed = 0;
+    std::vector<char> m_cache;
+};
@@ -0,0 +1,350 @@
+#include "json.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+class JsonParser {
+public:
+    explicit JsonParser(const std::string& text) : m_text(text) {}
+
+    bool parseDocument(JsonValue& value, std::string& error) {
+        skipWhitespace();
+        if (!parseValue(value, 0)) {
+            error = "line " + std::to_string(m_line) + ": " + m_error;
+            return false;
+        }
+        skipWhitespace();
+        if (m_pos != m_text.size()) {
+            error = "line " + std::to_string(m_line) + ": unexpected trailing characters";
+            return false;
+        }
+        return true;
+    }
+
+private:
+    static constexpr int kMaxDepth = 256;
+
+    bool fail(const std::string& message) {
+        if (m_error.empty()) m_error = message;
+        return false;
+    }
+
+    void skipWhitespace() {
+        while (m_pos < m_text.size()) {
+            char c = m_text[m_pos];
+            if (c == '\n') {
+                ++m_line;
+            } else if (c != ' ' && c != '\t' && c != '\r') {
+                break;
+            }
+            ++m_pos;
+        }
+    }
+
+    bool consume(const char* literal) {
+        size_t length = std::char_traits<char>::length(literal);
+        if (m_text.compare(m_pos, length, literal) != 0) return false;
+        m_pos += length;
+        return true;
+    }
+
+    bool parseValue(JsonValue& value, int depth) {
+        if (depth > kMaxDepth) return fail("nesting too deep");
+        if (m_pos >= m_text.size()) return fail("unexpected end of input");
+
+        char c = m_text[m_pos];
+        if (c == '{') return parseObject(value, depth);
+        if (c == '[') return parseArray(value, depth);
+        if (c == '"') {
+            std::string text;
+            if (!parseString(text)) return false;
+            value = JsonValue(std::move(text));
+            return true;
+        }
+        if (consume("true")) { value = JsonValue(true); return true; }
+        if (consume("false")) { value = JsonValue(false); return true; }
+        if (consume("null")) { value = JsonValue(); return true; }
+        if (c == '-' || (c >= '0' && c <= '9')) return parseNumber(value);
+        return fail(std::string("unexpected character '") + c + "'");
+    }
+
+    bool parseObject(JsonValue& value, int depth) {
+        value = JsonValue::makeObject();
+        ++m_pos;
+        skipWhitespace();
+        if (m_pos < m_text.size() && m_text[m_pos] == '}') {
+            ++m_pos;
+            return true;
+        }
+        while (true) {
+            skipWhitespace();
+            if (m_pos >= m_text.size() || m_text[m_pos] != '"') return fail("expected object key");
+            std::string key;
+            if (!parseString(key)) return false;
+            skipWhitespace();
+            if (m_pos >= m_text.size() || m_text[m_pos] != ':') return fail("expected ':' after key");
+            ++m_pos;
+            skipWhitespace();
+            JsonValue member;
+            if (!parseValue(member, depth + 1)) return false;
+            value.set(key, std::move(member));
+            skipWhitespace();
+            if (m_pos < m_text.size() && m_text[m_pos] == ',') {
+                ++m_pos;
+                continue;
+            }
+            if (m_pos < m_text.size() && m_text[m_pos] == '}') {
+                ++m_pos;
+                return true;
+            }
+            return fail("expected ',' or '}'");
+        }
+    }
+
+    bool parseArray(JsonValue& value, int depth) {
+        value = JsonValue::makeArray();
+        ++m_pos;
+        skipWhitespace();
+        if (m_pos < m_text.size() && m_text[m_pos] == ']') {
+            ++m_pos;
+            return true;
+        }
+        while (true) {
+            skipWhitespace();
+            JsonValue item;
+            if (!parseValue(item, depth + 1)) return false;
+            value.push(std::move(item));
+            skipWhitespace();
+            if (m_pos < m_text.size() && m_text[m_pos] == ',') {
+                ++m_pos;
+                continue;
+            }
+            if (m_pos < m_text.size() && m_text[m_pos] == ']') {
+                ++m_pos;
+                return true;
+            }
+            return fail("expected ',' or ']'");
+        }
+    }
+
+    bool parseHex4(unsigned& code) {
+        if (m_pos + 4 > m_text.size()) return fail("truncated \\u escape");
+        code = 0;
+        for (int i = 0; i < 4; ++i) {
+            char h = m_text[m_pos++];
+            code <<= 4;
+            if (h >= '0' && h <= '9') code |= static_cast<unsigned>(h - '0');
+            else if (h >= 'a' && h <= 'f') code |= static_cast<unsigned>(h - 'a' + 10);
+            else if (h >= 'A' && h <= 'F') code |= static_cast<unsigned>(h - 'A' + 10);
+            else return fail("invalid \\u escape");
+        }
+        return true;
+    }
+
+    static void appendUtf8(std::string& out, unsigned code) {
+        if (code < 0x80) {
+            out += static_cast<char>(code);
+        } else if (code < 0x800) {
+            out += static_cast<char>(0xC0 | (code >> 6));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else if (code < 0x10000) {
+            out += static_cast<char>(0xE0 | (code >> 12));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (code >> 18));
+            out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+    }
+
+    bool parseString(std::string& out) {
+        ++m_pos;    // opening quote
+        while (m_pos < m_text.size()) {
+            char c = m_text[m_pos++];
+            if (c == '"') return true;
+            if (static_cast<unsigned char>(c) < 0x20) return fail("control character in string");
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (m_pos >= m_text.size()) break;
+            char e = m_text[m_pos++];
+            switch (e) {
+                case '"': out += '"'; break;
+                case '\\': out += '\\'; break;
+                case '/': out += '/'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u': {
+                    unsigned code = 0;
+                    if (!parseHex4(code)) return false;
+                    if (code >= 0xD800 && code < 0xDC00 && m_text.compare(m_pos, 2, "\\u") == 0) {
+                        m_pos += 2;
+                        unsigned low = 0;
+                        if (!parseHex4(low)) return false;
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    appendUtf8(out, code);
+                    break;
+                }
+                default:
+                    return fail(std::string("invalid escape '\\") + e + "'");
+            }
+        }
+        return fail("unterminated string");
+    }
+
+    bool parseNumber(JsonValue& value) {
+        const char* begin = m_text.c_str() + m_pos;
+        char* end = nullptr;
+        double number = std::strtod(begin, &end);
+        if (end == begin) return fail("invalid number");
+        m_pos += static_cast<size_t>(end - begin);
+        value = JsonValue(number);
+        return true;
+    }
+
+    const std::string& m_text;
+    size_t m_pos = 0;
+    int m_line = 1;
+    std::string m_error;
+};
+
+void appendEscaped(std::string& out, const std::string& text) {
+    out += '"';
+    for (char c : text) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char buf[8];
+                    std::snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned>(c));
+                    out += buf;
+                } else {
+                    out += c;
+                }
+        }
+    }
+    out += '"';
+}
+
+void appendNewline(std::string& out, int indent, int depth) {
+    if (indent < 0) return;
+    out += '\n';
+    out.append(static_cast<size_t>(indent * depth), ' ');
+}
+
+} // namespace
+
+JsonValue JsonValue::makeArray() {
+    JsonValue value;
+    value.m_type = Type::Array;
+    return value;
+}
+
+JsonValue JsonValue::makeObject() {
+    JsonValue value;
+    value.m_type = Type::Object;
+    return value;
+}
+
+bool JsonValue::parse(const std::string& text, JsonValue& value, std::string& error) {
+    JsonParser parser(text);
+    return parser.parseDocument(value, error);
+}
+
+bool JsonValue::parseFile(const std::string& path, JsonValue& value, std::string& error) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        error = "cannot open " + path;
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return parse(buffer.str(), value, error);
+}
+
+const JsonValue* JsonValue::find(const std::string& key) const {
+    if (m_type != Type::Object) return nullptr;
+    for (const auto& member : m_members) {
+        if (member.first == key) return &member.second;
+    }
+    return nullptr;
+}
+
+void JsonValue::set(const std::string& key, JsonValue value) {
+    for (auto& member : m_members) {
+        if (member.first == key) {
+            member.second = std::move(value);
+            return;
+        }
+    }
+    m_members.emplace_back(key, std::move(value));
+}
+
+std::string JsonValue::dump(int indent) const {
+    std::string out;
+    dumpTo(out, indent, 0);
+    return out;
+}
+
+void JsonValue::dumpTo(std::string& out, int indent, int depth) const {
+    switch (m_type) {
+        case Type::Null:
+            out += "null";
+            break;
+        case Type::Bool:
+            out += m_bool ? "true" : "false";
+            break;
+        case Type::Number: {
+            if (!std::isfinite(m_number)) {
+                out += "null";
+            } else if (m_number == std::floor(m_number) && std::fabs(m_number) < 1e15) {
+                out += std::to_string(static_cast<long long>(m_number));
+            } else {
+                char buf[32];
+                std::snprintf(buf, sizeof(buf), "%.17g", m_number);
+                out += buf;
+            }
+            break;
+        }
+        case Type::String:
+            appendEscaped(out, m_string);
+            break;
+        case Type::Array:
+            out += '[';
+            for (size_t i = 0; i < m_items.size(); ++i) {
+                if (i > 0) out += ',';
+                appendNewline(out, indent, depth + 1);
+                m_items[i].dumpTo(out, indent, depth + 1);
+            }
+            if (!m_items.empty()) appendNewline(out, indent, depth);
+            out += ']';
+            break;
+        case Type::Object:
+            out += '{';
+            for (size_t i = 0; i < m_members.size(); ++i) {
+                if (i > 0) out += ',';
+                appendNewline(out, indent, depth + 1);
+                appendEscaped(out, m_members[i].first);
+                out += indent < 0 ? ":" : ": ";
+                m_members[i].second.dumpTo(out, indent, depth + 1);
+            }
+            if (!m_members.empty()) appendNewline(out, indent, depth);
+            out += '}';
+            break;
+    }
+}
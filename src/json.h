@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Minimal JSON value for job manifests and build reports.
+// Objects keep insertion order so written files stay diff-friendly.
+class JsonValue {
+public:
+    enum class Type { Null, Bool, Number, String, Array, Object };
+
+    JsonValue() = default;
+    JsonValue(bool value) : m_type(Type::Bool), m_bool(value) {}
+    JsonValue(int value) : m_type(Type::Number), m_number(value) {}
+    JsonValue(int64_t value) : m_type(Type::Number), m_number(static_cast<double>(value)) {}
+    JsonValue(uint64_t value) : m_type(Type::Number), m_number(static_cast<double>(value)) {}
+    JsonValue(double value) : m_type(Type::Number), m_number(value) {}
+    JsonValue(const char* value) : m_type(Type::String), m_string(value) {}
+    JsonValue(std::string value) : m_type(Type::String), m_string(std::move(value)) {}
+
+    static JsonValue makeArray();
+    static JsonValue makeObject();
+
+    // Parses a complete document; error gets "line N: message" on failure
+    static bool parse(const std::string& text, JsonValue& value, std::string& error);
+    static bool parseFile(const std::string& path, JsonValue& value, std::string& error);
+
+    Type type() const { return m_type; }
+    bool isNull() const { return m_type == Type::Null; }
+    bool isBool() const { return m_type == Type::Bool; }
+    bool isNumber() const { return m_type == Type::Number; }
+    bool isString() const { return m_type == Type::String; }
+    bool isArray() const { return m_type == Type::Array; }
+    bool isObject() const { return m_type == Type::Object; }
+
+    bool asBool() const { return m_bool; }
+    double asNumber() const { return m_number; }
+    const std::string& asString() const { return m_string; }
+
+    // Arrays
+    size_t size() const { return m_type == Type::Object ? m_members.size() : m_items.size(); }
+    const JsonValue& at(size_t index) const { return m_items[index]; }
+    void push(JsonValue value) { m_items.push_back(std::move(value)); }
+
+    // Objects; find returns nullptr for missing keys or non-objects
+    const JsonValue* find(const std::string& key) const;
+    void set(const std::string& key, JsonValue value);
+    const std::vector<std::pair<std::string, JsonValue>>& members() const { return m_members; }
+
+    // Compact when indent < 0, otherwise pretty-printed with that many spaces
+    std::string dump(int indent = -1) const;
+
+private:
+    void dumpTo(std::string& out, int indent, int depth) const;
+
+    Type m_type = Type::Null;
+    bool m_bool = false;
+    double m_number = 0.0;
+    std::string m_string;
+    std::vector<JsonValue> m_items;
+    std::vector<std::pair<std::string, JsonValue>> m_members;
+};
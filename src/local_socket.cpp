@@ -0,0 +1,195 @@
+#include "local_socket.h"
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <utility>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <afunix.h>
+using SocketHandle = SOCKET;
+#else
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+using SocketHandle = int;
+#endif
+
+namespace {
+
+#ifdef _WIN32
+bool ensureWinsock() {
+    static const bool started = [] {
+        WSADATA data;
+        return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+    }();
+    return started;
+}
+
+void closeHandle(SocketHandle handle) {
+    closesocket(handle);
+}
+
+const int kSendFlags = 0;
+#else
+bool ensureWinsock() {
+    return true;
+}
+
+void closeHandle(SocketHandle handle) {
+    ::close(handle);
+}
+
+const int kSendFlags = MSG_NOSIGNAL;    // a vanished client must not kill the daemon
+#endif
+
+SocketHandle toHandle(intptr_t value) {
+    return static_cast<SocketHandle>(value);
+}
+
+bool makeAddress(const std::string& path, sockaddr_un& address) {
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Error: Socket path is empty or too long: " << path << "\n";
+        return false;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size());
+    return true;
+}
+
+bool openSocket(intptr_t& handle) {
+    if (!ensureWinsock()) {
+        std::cerr << "Error: Winsock initialization failed\n";
+        return false;
+    }
+    SocketHandle s = socket(AF_UNIX, SOCK_STREAM, 0);
+#ifdef _WIN32
+    if (s == INVALID_SOCKET) {
+#else
+    if (s < 0) {
+#endif
+        std::cerr << "Error: Cannot create UNIX-domain socket\n";
+        return false;
+    }
+    handle = static_cast<intptr_t>(s);
+    return true;
+}
+
+} // namespace
+
+LocalSocket::~LocalSocket() {
+    close();
+}
+
+LocalSocket::LocalSocket(LocalSocket&& other) noexcept
+    : m_handle(other.m_handle), m_buffer(std::move(other.m_buffer)), m_unlinkPath(std::move(other.m_unlinkPath)) {
+    other.m_handle = kInvalid;
+    other.m_unlinkPath.clear();
+}
+
+LocalSocket& LocalSocket::operator=(LocalSocket&& other) noexcept {
+    if (this != &other) {
+        close();
+        m_handle = other.m_handle;
+        m_buffer = std::move(other.m_buffer);
+        m_unlinkPath = std::move(other.m_unlinkPath);
+        other.m_handle = kInvalid;
+        other.m_unlinkPath.clear();
+    }
+    return *this;
+}
+
+void LocalSocket::close() {
+    if (m_handle != kInvalid) {
+        closeHandle(toHandle(m_handle));
+        m_handle = kInvalid;
+    }
+    if (!m_unlinkPath.empty()) {
+        std::remove(m_unlinkPath.c_str());
+        m_unlinkPath.clear();
+    }
+    m_buffer.clear();
+}
+
+bool LocalSocket::listen(const std::string& path, LocalSocket& server) {
+    sockaddr_un address;
+    if (!makeAddress(path, address)) return false;
+
+    // A leftover socket file from a crashed server blocks bind(); only remove it if nobody answers
+    {
+        LocalSocket probe;
+        if (openSocket(probe.m_handle) &&
+            ::connect(toHandle(probe.m_handle), reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0) {
+            std::cerr << "Error: A build daemon is already listening on " << path << "\n";
+            return false;
+        }
+    }
+    std::remove(path.c_str());
+
+    server.close();
+    if (!openSocket(server.m_handle)) return false;
+    if (::bind(toHandle(server.m_handle), reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::listen(toHandle(server.m_handle), 16) != 0) {
+        std::cerr << "Error: Cannot listen on " << path << "\n";
+        server.close();
+        return false;
+    }
+    server.m_unlinkPath = path;
+    return true;
+}
+
+bool LocalSocket::connect(const std::string& path, LocalSocket& client) {
+    sockaddr_un address;
+    if (!makeAddress(path, address)) return false;
+
+    client.close();
+    if (!openSocket(client.m_handle)) return false;
+    if (::connect(toHandle(client.m_handle), reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        std::cerr << "Error: No build daemon on " << path << "\n";
+        client.close();
+        return false;
+    }
+    return true;
+}
+
+bool LocalSocket::accept(LocalSocket& client) {
+    SocketHandle s = ::accept(toHandle(m_handle), nullptr, nullptr);
+#ifdef _WIN32
+    if (s == INVALID_SOCKET) return false;
+#else
+    if (s < 0) return false;
+#endif
+    client.close();
+    client.m_handle = static_cast<intptr_t>(s);
+    return true;
+}
+
+bool LocalSocket::readLine(std::string& line) {
+    while (true) {
+        size_t newline = m_buffer.find('\n');
+        if (newline != std::string::npos) {
+            line = m_buffer.substr(0, newline);
+            m_buffer.erase(0, newline + 1);
+            return true;
+        }
+        if (m_handle == kInvalid) return false;
+
+        char chunk[4096];
+        int received = static_cast<int>(::recv(toHandle(m_handle), chunk, sizeof(chunk), 0));
+        if (received <= 0) return false;
+        m_buffer.append(chunk, static_cast<size_t>(received));
+    }
+}
+
+bool LocalSocket::writeLine(const std::string& line) {
+    if (m_handle == kInvalid) return false;
+    std::string data = line + "\n";
+    size_t sent = 0;
+    while (sent < data.size()) {
+        int n = static_cast<int>(::send(toHandle(m_handle), data.data() + sent, static_cast<int>(data.size() - sent), kSendFlags));
+        if (n <= 0) return false;
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Line-oriented stream socket on a UNIX-domain path (AF_UNIX; also
+// available on Windows 10 1803 and later). Move-only; closes on destruction.
+class LocalSocket {
+public:
+    LocalSocket() = default;
+    ~LocalSocket();
+    LocalSocket(LocalSocket&& other) noexcept;
+    LocalSocket& operator=(LocalSocket&& other) noexcept;
+    LocalSocket(const LocalSocket&) = delete;
+    LocalSocket& operator=(const LocalSocket&) = delete;
+
+    // Fails if another server is answering on path; a stale socket file is replaced
+    static bool listen(const std::string& path, LocalSocket& server);
+    static bool connect(const std::string& path, LocalSocket& client);
+    bool accept(LocalSocket& client);
+
+    // Reads up to the next '\n' (not included); false on EOF or error
+    bool readLine(std::string& line);
+    // Sends text plus '\n'; false once the peer has gone away
+    bool writeLine(const std::string& line);
+
+    bool isOpen() const { return m_handle != kInvalid; }
+    void close();
+
+private:
+    static constexpr intptr_t kInvalid = -1;
+
+    intptr_t m_handle = kInvalid;
+    std::string m_buffer;
+    std::string m_unlinkPath;   // servers remove their socket file on close
+};
@@ -1,6 +1,9 @@
 #include <iostream>
 #include <exception>
+#include "command_line.h"
+#ifndef ENGINE_EXPORT_HEADLESS
 #include "gui_app.h"
+#endif
 
 #ifdef _WIN32
 #include <windows.h>
@@ -8,14 +11,16 @@
 
 int main(int argc, char* argv[]) {
     try {
-        // Check for console mode (if arguments provided)
+        // Any argument selects the headless command-line mode
         if (argc > 1) {
-            // For now, just show message about GUI mode
-            std::cout << "EngineExport now runs in GUI mode.\n";
-            std::cout << "Please run without arguments to open the GUI interface.\n";
-            return 0;
+            return runCommandLine(argc, argv);
         }
 
+#ifdef ENGINE_EXPORT_HEADLESS
+        // Built without GLFW/ImGui: there is no GUI to fall back to
+        return runCommandLine(argc, argv);
+#else
+
 #ifdef _WIN32
         // Keep console window open for debugging
         // ShowWindow(GetConsoleWindow(), SW_HIDE);
@@ -32,6 +37,7 @@ int main(int argc, char* argv[]) {
         app.run();
         
         return 0;
+#endif
         
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
@@ -40,4 +46,4 @@ int main(int argc, char* argv[]) {
         std::cerr << "Unknown error occurred" << std::endl;
         return 1;
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,1238 @@
+#include "onnx_model.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <cstring>
+#include <unordered_set>
+
+// Protobuf wire format helpers. Hosts are assumed little-endian (x86-64 / ARM64),
+// which matches the byte order of fixed32/fixed64 fields and ONNX raw_data.
+namespace {
+
+enum WireType : uint32_t {
+    WIRE_VARINT = 0,
+    WIRE_FIXED64 = 1,
+    WIRE_LENGTH_DELIMITED = 2,
+    WIRE_FIXED32 = 5
+};
+
+class ProtoReader {
+public:
+    ProtoReader(const char* data, size_t size) : m_data(data), m_size(size) {}
+
+    bool atEnd() const { return m_pos >= m_size; }
+    size_t position() const { return m_pos; }
+    const char* data() const { return m_data; }
+
+    bool readTag(uint32_t& field, uint32_t& wireType) {
+        uint64_t key = 0;
+        if (!readVarint(key)) return false;
+        field = static_cast<uint32_t>(key >> 3);
+        wireType = static_cast<uint32_t>(key & 7);
+        return field != 0;
+    }
+
+    bool readVarint(uint64_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (m_pos >= m_size) return false;
+            uint8_t byte = static_cast<uint8_t>(m_data[m_pos++]);
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) return true;
+        }
+        return false;
+    }
+
+    bool readFixed32(uint32_t& value) {
+        if (m_size - m_pos < 4) return false;
+        std::memcpy(&value, m_data + m_pos, 4);
+        m_pos += 4;
+        return true;
+    }
+
+    bool readFixed64(uint64_t& value) {
+        if (m_size - m_pos < 8) return false;
+        std::memcpy(&value, m_data + m_pos, 8);
+        m_pos += 8;
+        return true;
+    }
+
+    bool readBytes(const char*& ptr, size_t& length) {
+        uint64_t n = 0;
+        if (!readVarint(n) || n > m_size - m_pos) return false;
+        ptr = m_data + m_pos;
+        length = static_cast<size_t>(n);
+        m_pos += length;
+        return true;
+    }
+
+    bool readString(std::string& out) {
+        const char* ptr = nullptr;
+        size_t length = 0;
+        if (!readBytes(ptr, length)) return false;
+        out.assign(ptr, length);
+        return true;
+    }
+
+    bool skipField(uint32_t wireType) {
+        uint64_t v64 = 0;
+        uint32_t v32 = 0;
+        const char* ptr = nullptr;
+        size_t length = 0;
+        switch (wireType) {
+            case WIRE_VARINT: return readVarint(v64);
+            case WIRE_FIXED64: return readFixed64(v64);
+            case WIRE_LENGTH_DELIMITED: return readBytes(ptr, length);
+            case WIRE_FIXED32: return readFixed32(v32);
+            default: return false;  // groups are not used by ONNX
+        }
+    }
+
+private:
+    const char* m_data;
+    size_t m_size;
+    size_t m_pos = 0;
+};
+
+class ProtoWriter {
+public:
+    explicit ProtoWriter(std::string& out) : m_out(out) {}
+
+    void varint(uint64_t value) {
+        while (value >= 0x80) {
+            m_out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        m_out.push_back(static_cast<char>(value));
+    }
+
+    void tag(uint32_t field, uint32_t wireType) {
+        varint((static_cast<uint64_t>(field) << 3) | wireType);
+    }
+
+    void int64Field(uint32_t field, int64_t value) {
+        tag(field, WIRE_VARINT);
+        varint(static_cast<uint64_t>(value));
+    }
+
+    void floatField(uint32_t field, float value) {
+        tag(field, WIRE_FIXED32);
+        char bytes[4];
+        std::memcpy(bytes, &value, 4);
+        m_out.append(bytes, 4);
+    }
+
+    void bytesField(uint32_t field, const std::string& value) {
+        tag(field, WIRE_LENGTH_DELIMITED);
+        varint(value.size());
+        m_out.append(value);
+    }
+
+    void packedInt64s(uint32_t field, const std::vector<int64_t>& values) {
+        if (values.empty()) return;
+        std::string body;
+        ProtoWriter w(body);
+        for (int64_t v : values) w.varint(static_cast<uint64_t>(v));
+        bytesField(field, body);
+    }
+
+    void packedFloats(uint32_t field, const std::vector<float>& values) {
+        if (values.empty()) return;
+        std::string body(values.size() * sizeof(float), '\0');
+        std::memcpy(&body[0], values.data(), body.size());
+        bytesField(field, body);
+    }
+
+    void raw(const std::string& bytes) { m_out.append(bytes); }
+
+private:
+    std::string& m_out;
+};
+
+// Captures an unparsed field (tag included) into `extra`
+bool keepUnknown(ProtoReader& r, size_t fieldStart, uint32_t wireType, std::string& extra) {
+    if (!r.skipField(wireType)) return false;
+    extra.append(r.data() + fieldStart, r.position() - fieldStart);
+    return true;
+}
+
+template <typename T>
+bool readVarints(ProtoReader& r, uint32_t wireType, std::vector<T>& out) {
+    uint64_t v = 0;
+    if (wireType == WIRE_VARINT) {
+        if (!r.readVarint(v)) return false;
+        out.push_back(static_cast<T>(v));
+        return true;
+    }
+    if (wireType != WIRE_LENGTH_DELIMITED) return false;
+    const char* ptr = nullptr;
+    size_t length = 0;
+    if (!r.readBytes(ptr, length)) return false;
+    ProtoReader packed(ptr, length);
+    while (!packed.atEnd()) {
+        if (!packed.readVarint(v)) return false;
+        out.push_back(static_cast<T>(v));
+    }
+    return true;
+}
+
+template <typename T>
+bool readFixed(ProtoReader& r, uint32_t wireType, std::vector<T>& out) {
+    static_assert(sizeof(T) == 4 || sizeof(T) == 8, "fixed fields are 32 or 64 bits wide");
+    const uint32_t expected = sizeof(T) == 4 ? WIRE_FIXED32 : WIRE_FIXED64;
+    T value;
+    if (wireType == expected) {
+        if constexpr (sizeof(T) == 4) {
+            uint32_t bits = 0;
+            if (!r.readFixed32(bits)) return false;
+            std::memcpy(&value, &bits, sizeof(T));
+        } else {
+            uint64_t bits = 0;
+            if (!r.readFixed64(bits)) return false;
+            std::memcpy(&value, &bits, sizeof(T));
+        }
+        out.push_back(value);
+        return true;
+    }
+    if (wireType != WIRE_LENGTH_DELIMITED) return false;
+    const char* ptr = nullptr;
+    size_t length = 0;
+    if (!r.readBytes(ptr, length) || length % sizeof(T) != 0) return false;
+    size_t offset = out.size();
+    out.resize(offset + length / sizeof(T));
+    if (length > 0) std::memcpy(out.data() + offset, ptr, length);
+    return true;
+}
+
+float halfToFloat(uint16_t h) {
+    uint32_t sign = static_cast<uint32_t>(h & 0x8000u) << 16;
+    uint32_t exponent = (h >> 10) & 0x1Fu;
+    uint32_t mantissa = h & 0x3FFu;
+    uint32_t bits;
+    if (exponent == 0) {
+        if (mantissa == 0) {
+            bits = sign;
+        } else {
+            // Subnormal: renormalize
+            exponent = 127 - 15 + 1;
+            while ((mantissa & 0x400u) == 0) {
+                mantissa <<= 1;
+                --exponent;
+            }
+            mantissa &= 0x3FFu;
+            bits = sign | (exponent << 23) | (mantissa << 13);
+        }
+    } else if (exponent == 0x1F) {
+        bits = sign | 0x7F800000u | (mantissa << 13);
+    } else {
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    }
+    float result;
+    std::memcpy(&result, &bits, 4);
+    return result;
+}
+
+template <typename T>
+T loadElement(const std::string& raw, size_t index) {
+    T value;
+    std::memcpy(&value, raw.data() + index * sizeof(T), sizeof(T));
+    return value;
+}
+
+// Packs typed *_data values into raw little-endian bytes of the tensor's element size
+template <typename T>
+void foldTypedData(OnnxTensor& tensor, const std::vector<T>& values) {
+    size_t elemSize = onnxElementSize(tensor.dataType);
+    if (values.empty() || elemSize == 0) return;
+    if (tensor.dataType == static_cast<int32_t>(OnnxDataType::COMPLEX64) ||
+        tensor.dataType == static_cast<int32_t>(OnnxDataType::COMPLEX128)) {
+        elemSize /= 2;  // two scalar components per element
+    }
+    tensor.rawData.assign(values.size() * elemSize, '\0');
+    for (size_t i = 0; i < values.size(); ++i) {
+        // Truncating copy: int32_data holds 8/16-bit types in its low bytes
+        std::memcpy(&tensor.rawData[i * elemSize], &values[i], std::min(elemSize, sizeof(T)));
+    }
+}
+
+// withData false: name, type and dims only, the element data is skipped
+bool parseTensor(const char* data, size_t size, OnnxTensor& tensor, bool withData = true) {
+    ProtoReader r(data, size);
+    std::vector<float> floatData;
+    std::vector<int32_t> int32Data;
+    std::vector<int64_t> int64Data;
+    std::vector<double> doubleData;
+    std::vector<uint64_t> uint64Data;
+    while (!r.atEnd()) {
+        size_t start = r.position();
+        uint32_t field = 0, wt = 0;
+        if (!r.readTag(field, wt)) return false;
+        bool ok = true;
+        bool isData = field == 4 || field == 5 || field == 6 || field == 7 || (field >= 9 && field <= 11);
+        if (!withData && isData) {
+            if (!r.skipField(wt)) return false;
+            continue;
+        }
+        switch (field) {
+            case 1: ok = readVarints(r, wt, tensor.dims); break;
+            case 2: {
+                std::vector<int64_t> v;
+                ok = readVarints(r, wt, v);
+                if (ok && !v.empty()) tensor.dataType = static_cast<int32_t>(v.back());
+                break;
+            }
+            case 4: ok = readFixed<float>(r, wt, floatData); break;
+            case 5: ok = readVarints(r, wt, int32Data); break;
+            case 6: {
+                std::string s;
+                ok = wt == WIRE_LENGTH_DELIMITED && r.readString(s);
+                tensor.stringData.push_back(s);
+                break;
+            }
+            case 7: ok = readVarints(r, wt, int64Data); break;
+            case 8: ok = wt == WIRE_LENGTH_DELIMITED && r.readString(tensor.name); break;
+            case 9: ok = wt == WIRE_LENGTH_DELIMITED && r.readString(tensor.rawData); break;
+            case 10: ok = readFixed<double>(r, wt, doubleData); break;
+            case 11: ok = readVarints(r, wt, uint64Data); break;
+            case 14: {
+                // data_location: EXTERNAL = 1. Kept verbatim together with external_data.
+                uint64_t location = 0;
+                ok = wt == WIRE_VARINT && r.readVarint(location);
+                if (ok && location == 1) tensor.isExternal = true;
+                tensor.extraFields.append(data + start, r.position() - start);
+                break;
+            }
+            default: ok = keepUnknown(r, start, wt, tensor.extraFields); break;
+        }
+        if (!ok) return false;
+    }
+    if (tensor.rawData.empty() && !tensor.isExternal) {
+        if (!floatData.empty()) foldTypedData(tensor, floatData);
+        else if (!int32Data.empty()) foldTypedData(tensor, int32Data);
+        else if (!int64Data.empty()) foldTypedData(tensor, int64Data);
+        else if (!doubleData.empty()) foldTypedData(tensor, doubleData);
+        else if (!uint64Data.empty()) foldTypedData(tensor, uint64Data);
+    }
+    return true;
+}
+
+bool parseAttribute(const char* data, size_t size, OnnxAttribute& attr, bool withData = true) {
+    ProtoReader r(data, size);
+    while (!r.atEnd()) {
+        size_t start = r.position();
+        uint32_t field = 0, wt = 0;
+        if (!r.readTag(field, wt)) return false;
+        bool ok = true;
+        uint64_t v = 0;
+        uint32_t bits = 0;
+        const char* ptr = nullptr;
+        size_t length = 0;
+        switch (field) {
+            case 1: ok = wt == WIRE_LENGTH_DELIMITED && r.readString(attr.name); break;
+            case 2:
+                ok = wt == WIRE_FIXED32 && r.readFixed32(bits);
+                std::memcpy(&attr.f, &bits, 4);
+                break;
+            case 3:
+                ok = wt == WIRE_VARINT && r.readVarint(v);
+                attr.i = static_cast<int64_t>(v);
+                break;
+            case 4: ok = wt == WIRE_LENGTH_DELIMITED && r.readString(attr.s); break;
+            case 5:
+                ok = wt == WIRE_LENGTH_DELIMITED && r.readBytes(ptr, length) &&
+                     parseTensor(ptr, length, attr.t, withData);
+                break;
+            case 7: ok = readFixed<float>(r, wt, attr.floats); break;
+            case 8: ok = readVarints(r, wt, attr.ints); break;
+            case 9: {
+                std::string s;
+                ok = wt == WIRE_LENGTH_DELIMITED && r.readString(s);
+                attr.strings.push_back(s);
+                break;
+            }
+            case 20:
+                ok = wt == WIRE_VARINT && r.readVarint(v);
+                attr.type = static_cast<int32_t>(v);
+                break;
+            default: ok = keepUnknown(r, start, wt, attr.extraFields); break;
+        }
+        if (!ok) return false;
+    }
+    return true;
+}
+
+bool parseNode(const char* data, size_t size, OnnxNode& node, bool withData = true) {
+    ProtoReader r(data, size);
+    while (!r.atEnd()) {
+        size_t start = r.position();
+        uint32_t field = 0, wt = 0;
+        if (!r.readTag(field, wt)) return false;
+        bool ok = true;
+        std::string s;
+        const char* ptr = nullptr;
+        size_t length = 0;
+        switch (field) {
+            case 1:
+                ok = wt == WIRE_LENGTH_DELIMITED && r.readString(s);
+                node.inputs.push_back(s);
+                break;
+            case 2:
+                ok = wt == WIRE_LENGTH_DELIMITED && r.readString(s);
+                node.outputs.push_back(s);
+                break;
+            case 3: ok = wt == WIRE_LENGTH_DELIMITED && r.readString(node.name); break;
+            case 4: ok = wt == WIRE_LENGTH_DELIMITED && r.readString(node.opType); break;
+            case 5:
+                node.attributes.emplace_back();
+                ok = wt == WIRE_LENGTH_DELIMITED && r.readBytes(ptr, length) &&
+                     parseAttribute(ptr, length, node.attributes.back(), withData);
+                break;
+            case 7: ok = wt == WIRE_LENGTH_DELIMITED && r.readString(node.domain); break;
+            default: ok = keepUnknown(r, start, wt, node.extraFields); break;
+        }
+        if (!ok) return false;
+    }
+    return true;
+}
+
+bool parseDim(const char* data, size_t size, OnnxDim& dim) {
+    ProtoReader r(data, size);
+    while (!r.atEnd()) {
+        size_t start = r.position();
+        uint32_t field = 0, wt = 0;
+        if (!r.readTag(field, wt)) return false;
+        bool ok = true;
+        uint64_t v = 0;
+        switch (field) {
+            case 1:
+                ok = wt == WIRE_VARINT && r.readVarint(v);
+                dim.value = static_cast<int64_t>(v);
+                break;
+            case 2: ok = wt == WIRE_LENGTH_DELIMITED && r.readString(dim.param); break;
+            default: ok = keepUnknown(r, start, wt, dim.extraFields); break;
+        }
+        if (!ok) return false;
+    }
+    return true;
+}
+
+bool parseTensorType(const char* data, size_t size, OnnxValueInfo& info) {
+    ProtoReader r(data, size);
+    while (!r.atEnd()) {
+        uint32_t field = 0, wt = 0;
+        if (!r.readTag(field, wt)) return false;
+        bool ok = true;
+        uint64_t v = 0;
+        const char* ptr = nullptr;
+        size_t length = 0;
+        switch (field) {
+            case 1:
+                ok = wt == WIRE_VARINT && r.readVarint(v);
+                info.elemType = static_cast<int32_t>(v);
+                break;
+            case 2: {
+                ok = wt == WIRE_LENGTH_DELIMITED && r.readBytes(ptr, length);
+                if (!ok) break;
+                info.hasShape = true;
+                ProtoReader shape(ptr, length);
+                while (ok && !shape.atEnd()) {
+                    uint32_t shapeField = 0, shapeWt = 0;
+                    const char* dimPtr = nullptr;
+                    size_t dimLength = 0;
+                    ok = shape.readTag(shapeField, shapeWt);
+                    if (!ok) break;
+                    if (shapeField == 1 && shapeWt == WIRE_LENGTH_DELIMITED) {
+                        info.dims.emplace_back();
+                        ok = shape.readBytes(dimPtr, dimLength) && parseDim(dimPtr, dimLength, info.dims.back());
+                    } else {
+                        ok = shape.skipField(shapeWt);
+                    }
+                }
+                break;
+            }
+            default: ok = r.skipField(wt); break;
+        }
+        if (!ok) return false;
+    }
+    return true;
+}
+
+bool parseValueInfo(const char* data, size_t size, OnnxValueInfo& info) {
+    ProtoReader r(data, size);
+    bool sawType = false;
+    while (!r.atEnd()) {
+        size_t start = r.position();
+        uint32_t field = 0, wt = 0;
+        if (!r.readTag(field, wt)) return false;
+        bool ok = true;
+        const char* ptr = nullptr;
+        size_t length = 0;
+        switch (field) {
+            case 1: ok = wt == WIRE_LENGTH_DELIMITED && r.readString(info.name); break;
+            case 2: {
+                ok = wt == WIRE_LENGTH_DELIMITED && r.readBytes(ptr, length);
+                if (!ok) break;
+                sawType = true;
+                bool sawTensor = false;
+                ProtoReader type(ptr, length);
+                while (ok && !type.atEnd()) {
+                    size_t typeStart = type.position();
+                    uint32_t typeField = 0, typeWt = 0;
+                    const char* tensorPtr = nullptr;
+                    size_t tensorLength = 0;
+                    ok = type.readTag(typeField, typeWt);
+                    if (!ok) break;
+                    if (typeField == 1 && typeWt == WIRE_LENGTH_DELIMITED) {
+                        sawTensor = true;
+                        ok = type.readBytes(tensorPtr, tensorLength) && parseTensorType(tensorPtr, tensorLength, info);
+                    } else {
+                        ok = keepUnknown(type, typeStart, typeWt, info.typeExtraFields);
+                    }
+                }
+                info.isTensor = sawTensor;
+                break;
+            }
+            default: ok = keepUnknown(r, start, wt, info.extraFields); break;
+        }
+        if (!ok) return false;
+    }
+    if (!sawType) info.isTensor = true;
+    return true;
+}
+
+bool parseGraph(const char* data, size_t size, OnnxGraph& graph, bool withData = true) {
+    ProtoReader r(data, size);
+    while (!r.atEnd()) {
+        size_t start = r.position();
+        uint32_t field = 0, wt = 0;
+        if (!r.readTag(field, wt)) return false;
+        bool ok = true;
+        const char* ptr = nullptr;
+        size_t length = 0;
+        if (wt == WIRE_LENGTH_DELIMITED && (field == 1 || field == 5 || field == 11 || field == 12 || field == 13)) {
+            if (!r.readBytes(ptr, length)) return false;
+        }
+        switch (field) {
+            case 1:
+                graph.nodes.emplace_back();
+                ok = ptr && parseNode(ptr, length, graph.nodes.back(), withData);
+                break;
+            case 2: ok = wt == WIRE_LENGTH_DELIMITED && r.readString(graph.name); break;
+            case 5:
+                graph.initializers.emplace_back();
+                ok = ptr && parseTensor(ptr, length, graph.initializers.back(), withData);
+                break;
+            case 11:
+                graph.inputs.emplace_back();
+                ok = ptr && parseValueInfo(ptr, length, graph.inputs.back());
+                break;
+            case 12:
+                graph.outputs.emplace_back();
+                ok = ptr && parseValueInfo(ptr, length, graph.outputs.back());
+                break;
+            case 13:
+                graph.valueInfo.emplace_back();
+                ok = ptr && parseValueInfo(ptr, length, graph.valueInfo.back());
+                break;
+            default: ok = keepUnknown(r, start, wt, graph.extraFields); break;
+        }
+        if (!ok) return false;
+    }
+    return true;
+}
+
+void writeTensor(std::string& out, const OnnxTensor& tensor) {
+    ProtoWriter w(out);
+    w.packedInt64s(1, tensor.dims);
+    w.int64Field(2, tensor.dataType);
+    for (const auto& s : tensor.stringData) w.bytesField(6, s);
+    if (!tensor.name.empty()) w.bytesField(8, tensor.name);
+    if (!tensor.isExternal && tensor.dataType != static_cast<int32_t>(OnnxDataType::STRING)) {
+        w.bytesField(9, tensor.rawData);
+    }
+    w.raw(tensor.extraFields);
+}
+
+void writeAttribute(std::string& out, const OnnxAttribute& attr) {
+    ProtoWriter w(out);
+    w.bytesField(1, attr.name);
+    const bool any = attr.type == OnnxAttribute::UNDEFINED;
+    if (attr.type == OnnxAttribute::FLOAT || (any && attr.f != 0.0f)) w.floatField(2, attr.f);
+    if (attr.type == OnnxAttribute::INT || (any && attr.i != 0)) w.int64Field(3, attr.i);
+    if (attr.type == OnnxAttribute::STRING || (any && !attr.s.empty())) w.bytesField(4, attr.s);
+    if (attr.type == OnnxAttribute::TENSOR) {
+        std::string body;
+        writeTensor(body, attr.t);
+        w.bytesField(5, body);
+    }
+    w.packedFloats(7, attr.floats);
+    w.packedInt64s(8, attr.ints);
+    for (const auto& s : attr.strings) w.bytesField(9, s);
+    if (attr.type != OnnxAttribute::UNDEFINED) w.int64Field(20, attr.type);
+    w.raw(attr.extraFields);
+}
+
+void writeNode(std::string& out, const OnnxNode& node) {
+    ProtoWriter w(out);
+    for (const auto& s : node.inputs) w.bytesField(1, s);
+    for (const auto& s : node.outputs) w.bytesField(2, s);
+    if (!node.name.empty()) w.bytesField(3, node.name);
+    w.bytesField(4, node.opType);
+    for (const auto& attr : node.attributes) {
+        std::string body;
+        writeAttribute(body, attr);
+        w.bytesField(5, body);
+    }
+    if (!node.domain.empty()) w.bytesField(7, node.domain);
+    w.raw(node.extraFields);
+}
+
+void writeValueInfo(std::string& out, const OnnxValueInfo& info) {
+    ProtoWriter w(out);
+    w.bytesField(1, info.name);
+    bool hasTensorType = info.isTensor && (info.elemType != 0 || info.hasShape);
+    if (hasTensorType || !info.typeExtraFields.empty()) {
+        std::string type;
+        ProtoWriter tw(type);
+        if (hasTensorType) {
+            std::string tensorType;
+            ProtoWriter ttw(tensorType);
+            ttw.int64Field(1, info.elemType);
+            if (info.hasShape) {
+                std::string shape;
+                ProtoWriter sw(shape);
+                for (const auto& dim : info.dims) {
+                    std::string dimBody;
+                    ProtoWriter dw(dimBody);
+                    if (dim.value >= 0) dw.int64Field(1, dim.value);
+                    else if (!dim.param.empty()) dw.bytesField(2, dim.param);
+                    dw.raw(dim.extraFields);
+                    sw.bytesField(1, dimBody);
+                }
+                ttw.bytesField(2, shape);
+            }
+            tw.bytesField(1, tensorType);
+        }
+        tw.raw(info.typeExtraFields);
+        w.bytesField(2, type);
+    }
+    w.raw(info.extraFields);
+}
+
+void writeGraph(std::string& out, const OnnxGraph& graph) {
+    ProtoWriter w(out);
+    std::string body;
+    for (const auto& node : graph.nodes) {
+        body.clear();
+        writeNode(body, node);
+        w.bytesField(1, body);
+    }
+    if (!graph.name.empty()) w.bytesField(2, graph.name);
+    for (const auto& tensor : graph.initializers) {
+        body.clear();
+        writeTensor(body, tensor);
+        w.bytesField(5, body);
+    }
+    for (const auto& info : graph.inputs) {
+        body.clear();
+        writeValueInfo(body, info);
+        w.bytesField(11, body);
+    }
+    for (const auto& info : graph.outputs) {
+        body.clear();
+        writeValueInfo(body, info);
+        w.bytesField(12, body);
+    }
+    for (const auto& info : graph.valueInfo) {
+        body.clear();
+        writeValueInfo(body, info);
+        w.bytesField(13, body);
+    }
+    w.raw(graph.extraFields);
+}
+
+// ProtoReader over a file, for reading a few top-level fields of a large model
+// without loading its weights
+class ProtoFileReader {
+public:
+    explicit ProtoFileReader(const std::string& path) : m_file(path, std::ios::binary) {}
+
+    bool isOpen() const { return m_file.is_open(); }
+    bool atEnd() { return m_file.peek() == std::char_traits<char>::eof(); }
+    uint64_t position() { return static_cast<uint64_t>(m_file.tellg()); }
+
+    // False at end of file or on a malformed tag
+    bool next(uint32_t& field, uint32_t& wireType) {
+        uint64_t key = 0;
+        if (atEnd() || !readVarint(key)) return false;
+        field = static_cast<uint32_t>(key >> 3);
+        wireType = static_cast<uint32_t>(key & 7);
+        return field != 0;
+    }
+
+    bool readVarint(uint64_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            int byte = m_file.get();
+            if (byte == std::char_traits<char>::eof()) return false;
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) return true;
+        }
+        return false;
+    }
+
+    bool readMessage(std::string& out) {
+        uint64_t length = 0;
+        if (!readVarint(length)) return false;
+        out.resize(static_cast<size_t>(length));
+        return length == 0 || static_cast<bool>(m_file.read(&out[0], static_cast<std::streamsize>(length)));
+    }
+
+    bool skip(uint32_t wireType) {
+        uint64_t value = 0;
+        switch (wireType) {
+            case WIRE_VARINT: return readVarint(value);
+            case WIRE_FIXED64: return seek(8);
+            case WIRE_FIXED32: return seek(4);
+            case WIRE_LENGTH_DELIMITED: return readVarint(value) && seek(value);
+            default: return false;
+        }
+    }
+
+private:
+    bool seek(uint64_t bytes) {
+        m_file.seekg(static_cast<std::streamoff>(bytes), std::ios::cur);
+        return static_cast<bool>(m_file);
+    }
+
+    std::ifstream m_file;
+};
+
+} // namespace
+
+size_t onnxElementSize(int32_t dataType) {
+    switch (static_cast<OnnxDataType>(dataType)) {
+        case OnnxDataType::UINT8:
+        case OnnxDataType::INT8:
+        case OnnxDataType::BOOL:
+        case OnnxDataType::FLOAT8E4M3FN:
+        case OnnxDataType::FLOAT8E4M3FNUZ:
+        case OnnxDataType::FLOAT8E5M2:
+        case OnnxDataType::FLOAT8E5M2FNUZ:
+            return 1;
+        case OnnxDataType::UINT16:
+        case OnnxDataType::INT16:
+        case OnnxDataType::FLOAT16:
+        case OnnxDataType::BFLOAT16:
+            return 2;
+        case OnnxDataType::FLOAT:
+        case OnnxDataType::INT32:
+        case OnnxDataType::UINT32:
+            return 4;
+        case OnnxDataType::INT64:
+        case OnnxDataType::DOUBLE:
+        case OnnxDataType::UINT64:
+        case OnnxDataType::COMPLEX64:
+            return 8;
+        case OnnxDataType::COMPLEX128:
+            return 16;
+        default:
+            return 0;
+    }
+}
+
+std::string onnxDataTypeName(int32_t dataType) {
+    static const char* names[] = {
+        "undefined", "float32", "uint8", "int8", "uint16", "int16", "int32", "int64", "string", "bool",
+        "float16", "float64", "uint32", "uint64", "complex64", "complex128", "bfloat16",
+        "float8e4m3fn", "float8e4m3fnuz", "float8e5m2", "float8e5m2fnuz"
+    };
+    if (dataType >= 0 && dataType < static_cast<int32_t>(sizeof(names) / sizeof(names[0]))) {
+        return names[dataType];
+    }
+    return "type" + std::to_string(dataType);
+}
+
+// OnnxTensor
+
+int64_t OnnxTensor::numElements() const {
+    int64_t count = 1;
+    for (int64_t d : dims) count *= d;
+    return count;
+}
+
+std::vector<float> OnnxTensor::toFloats() const {
+    std::vector<float> values;
+    if (!hasData()) return values;
+    size_t elemSize = onnxElementSize(dataType);
+    if (elemSize == 0) return values;
+    size_t count = rawData.size() / elemSize;
+    values.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        switch (static_cast<OnnxDataType>(dataType)) {
+            case OnnxDataType::FLOAT: values[i] = loadElement<float>(rawData, i); break;
+            case OnnxDataType::DOUBLE: values[i] = static_cast<float>(loadElement<double>(rawData, i)); break;
+            case OnnxDataType::FLOAT16: values[i] = halfToFloat(loadElement<uint16_t>(rawData, i)); break;
+            case OnnxDataType::BFLOAT16: {
+                uint32_t bits = static_cast<uint32_t>(loadElement<uint16_t>(rawData, i)) << 16;
+                std::memcpy(&values[i], &bits, 4);
+                break;
+            }
+            case OnnxDataType::INT8: values[i] = loadElement<int8_t>(rawData, i); break;
+            case OnnxDataType::UINT8:
+            case OnnxDataType::BOOL: values[i] = loadElement<uint8_t>(rawData, i); break;
+            case OnnxDataType::INT16: values[i] = loadElement<int16_t>(rawData, i); break;
+            case OnnxDataType::UINT16: values[i] = loadElement<uint16_t>(rawData, i); break;
+            case OnnxDataType::INT32: values[i] = static_cast<float>(loadElement<int32_t>(rawData, i)); break;
+            case OnnxDataType::UINT32: values[i] = static_cast<float>(loadElement<uint32_t>(rawData, i)); break;
+            case OnnxDataType::INT64: values[i] = static_cast<float>(loadElement<int64_t>(rawData, i)); break;
+            case OnnxDataType::UINT64: values[i] = static_cast<float>(loadElement<uint64_t>(rawData, i)); break;
+            default: return {};
+        }
+    }
+    return values;
+}
+
+std::vector<int64_t> OnnxTensor::toInt64s() const {
+    std::vector<int64_t> values;
+    if (!hasData()) return values;
+    size_t elemSize = onnxElementSize(dataType);
+    if (elemSize == 0) return values;
+    size_t count = rawData.size() / elemSize;
+    values.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        switch (static_cast<OnnxDataType>(dataType)) {
+            case OnnxDataType::INT64: values[i] = loadElement<int64_t>(rawData, i); break;
+            case OnnxDataType::UINT64: values[i] = static_cast<int64_t>(loadElement<uint64_t>(rawData, i)); break;
+            case OnnxDataType::INT32: values[i] = loadElement<int32_t>(rawData, i); break;
+            case OnnxDataType::UINT32: values[i] = loadElement<uint32_t>(rawData, i); break;
+            case OnnxDataType::INT16: values[i] = loadElement<int16_t>(rawData, i); break;
+            case OnnxDataType::UINT16: values[i] = loadElement<uint16_t>(rawData, i); break;
+            case OnnxDataType::INT8: values[i] = loadElement<int8_t>(rawData, i); break;
+            case OnnxDataType::UINT8:
+            case OnnxDataType::BOOL: values[i] = loadElement<uint8_t>(rawData, i); break;
+            case OnnxDataType::FLOAT: values[i] = static_cast<int64_t>(loadElement<float>(rawData, i)); break;
+            case OnnxDataType::DOUBLE: values[i] = static_cast<int64_t>(loadElement<double>(rawData, i)); break;
+            default: return {};
+        }
+    }
+    return values;
+}
+
+OnnxTensor OnnxTensor::fromFloats(const std::string& name, const std::vector<int64_t>& dims,
+                                  const std::vector<float>& values) {
+    OnnxTensor tensor;
+    tensor.name = name;
+    tensor.dataType = static_cast<int32_t>(OnnxDataType::FLOAT);
+    tensor.dims = dims;
+    tensor.rawData.assign(values.size() * sizeof(float), '\0');
+    if (!values.empty()) std::memcpy(&tensor.rawData[0], values.data(), tensor.rawData.size());
+    return tensor;
+}
+
+OnnxTensor OnnxTensor::fromInt64s(const std::string& name, const std::vector<int64_t>& dims,
+                                  const std::vector<int64_t>& values) {
+    OnnxTensor tensor;
+    tensor.name = name;
+    tensor.dataType = static_cast<int32_t>(OnnxDataType::INT64);
+    tensor.dims = dims;
+    tensor.rawData.assign(values.size() * sizeof(int64_t), '\0');
+    if (!values.empty()) std::memcpy(&tensor.rawData[0], values.data(), tensor.rawData.size());
+    return tensor;
+}
+
+// OnnxAttribute
+
+OnnxAttribute OnnxAttribute::makeInt(const std::string& name, int64_t value) {
+    OnnxAttribute attr;
+    attr.name = name;
+    attr.type = INT;
+    attr.i = value;
+    return attr;
+}
+
+OnnxAttribute OnnxAttribute::makeInts(const std::string& name, const std::vector<int64_t>& values) {
+    OnnxAttribute attr;
+    attr.name = name;
+    attr.type = INTS;
+    attr.ints = values;
+    return attr;
+}
+
+OnnxAttribute OnnxAttribute::makeFloat(const std::string& name, float value) {
+    OnnxAttribute attr;
+    attr.name = name;
+    attr.type = FLOAT;
+    attr.f = value;
+    return attr;
+}
+
+OnnxAttribute OnnxAttribute::makeString(const std::string& name, const std::string& value) {
+    OnnxAttribute attr;
+    attr.name = name;
+    attr.type = STRING;
+    attr.s = value;
+    return attr;
+}
+
+OnnxAttribute OnnxAttribute::makeTensor(const std::string& name, const OnnxTensor& value) {
+    OnnxAttribute attr;
+    attr.name = name;
+    attr.type = TENSOR;
+    attr.t = value;
+    return attr;
+}
+
+// OnnxNode
+
+const OnnxAttribute* OnnxNode::attr(const std::string& attrName) const {
+    for (const auto& a : attributes) {
+        if (a.name == attrName) return &a;
+    }
+    return nullptr;
+}
+
+OnnxAttribute* OnnxNode::attr(const std::string& attrName) {
+    for (auto& a : attributes) {
+        if (a.name == attrName) return &a;
+    }
+    return nullptr;
+}
+
+int64_t OnnxNode::attrInt(const std::string& attrName, int64_t defaultValue) const {
+    const OnnxAttribute* a = attr(attrName);
+    return a ? a->i : defaultValue;
+}
+
+float OnnxNode::attrFloat(const std::string& attrName, float defaultValue) const {
+    const OnnxAttribute* a = attr(attrName);
+    return a ? a->f : defaultValue;
+}
+
+std::string OnnxNode::attrString(const std::string& attrName, const std::string& defaultValue) const {
+    const OnnxAttribute* a = attr(attrName);
+    return a ? a->s : defaultValue;
+}
+
+std::vector<int64_t> OnnxNode::attrInts(const std::string& attrName) const {
+    const OnnxAttribute* a = attr(attrName);
+    return a ? a->ints : std::vector<int64_t>{};
+}
+
+void OnnxNode::setAttr(const OnnxAttribute& attribute) {
+    if (OnnxAttribute* existing = attr(attribute.name)) {
+        *existing = attribute;
+    } else {
+        attributes.push_back(attribute);
+    }
+}
+
+const std::string& OnnxNode::input(size_t index) const {
+    static const std::string empty;
+    return index < inputs.size() ? inputs[index] : empty;
+}
+
+bool OnnxNode::subgraphs(std::vector<OnnxGraph>& graphs, bool withTensorData) const {
+    for (const auto& attribute : attributes) {
+        // AttributeProto.g (6) and .graphs (11) are not decoded on load
+        ProtoReader r(attribute.extraFields.data(), attribute.extraFields.size());
+        while (!r.atEnd()) {
+            uint32_t field = 0, wt = 0;
+            if (!r.readTag(field, wt)) return false;
+            if ((field != 6 && field != 11) || wt != WIRE_LENGTH_DELIMITED) {
+                if (!r.skipField(wt)) return false;
+                continue;
+            }
+            const char* ptr = nullptr;
+            size_t length = 0;
+            graphs.emplace_back();
+            if (!r.readBytes(ptr, length) || !parseGraph(ptr, length, graphs.back(), withTensorData)) return false;
+        }
+    }
+    return true;
+}
+
+// OnnxGraph
+
+OnnxTensor* OnnxGraph::findInitializer(const std::string& tensorName) {
+    for (auto& t : initializers) {
+        if (t.name == tensorName) return &t;
+    }
+    return nullptr;
+}
+
+const OnnxTensor* OnnxGraph::findInitializer(const std::string& tensorName) const {
+    for (const auto& t : initializers) {
+        if (t.name == tensorName) return &t;
+    }
+    return nullptr;
+}
+
+OnnxValueInfo* OnnxGraph::findInput(const std::string& tensorName) {
+    for (auto& v : inputs) {
+        if (v.name == tensorName) return &v;
+    }
+    return nullptr;
+}
+
+OnnxValueInfo* OnnxGraph::findOutput(const std::string& tensorName) {
+    for (auto& v : outputs) {
+        if (v.name == tensorName) return &v;
+    }
+    return nullptr;
+}
+
+OnnxValueInfo* OnnxGraph::findValueInfo(const std::string& tensorName) {
+    for (auto& v : valueInfo) {
+        if (v.name == tensorName) return &v;
+    }
+    return nullptr;
+}
+
+std::vector<const OnnxValueInfo*> OnnxGraph::runtimeInputs() const {
+    std::unordered_set<std::string> initializerNames;
+    for (const auto& t : initializers) initializerNames.insert(t.name);
+    std::vector<const OnnxValueInfo*> result;
+    for (const auto& v : inputs) {
+        if (!initializerNames.count(v.name)) result.push_back(&v);
+    }
+    return result;
+}
+
+std::unordered_map<std::string, size_t> OnnxGraph::producerIndex() const {
+    std::unordered_map<std::string, size_t> producers;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        for (const auto& out : nodes[i].outputs) {
+            if (!out.empty()) producers[out] = i;
+        }
+    }
+    return producers;
+}
+
+std::unordered_map<std::string, std::vector<size_t>> OnnxGraph::consumerIndex() const {
+    std::unordered_map<std::string, std::vector<size_t>> consumers;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        for (const auto& in : nodes[i].inputs) {
+            if (!in.empty()) consumers[in].push_back(i);
+        }
+    }
+    return consumers;
+}
+
+std::string OnnxGraph::makeUniqueName(const std::string& base) const {
+    std::unordered_set<std::string> used;
+    for (const auto& node : nodes) {
+        used.insert(node.name);
+        for (const auto& s : node.inputs) used.insert(s);
+        for (const auto& s : node.outputs) used.insert(s);
+    }
+    for (const auto& t : initializers) used.insert(t.name);
+    for (const auto& v : inputs) used.insert(v.name);
+    for (const auto& v : outputs) used.insert(v.name);
+
+    if (!used.count(base)) return base;
+    for (int suffix = 1;; ++suffix) {
+        std::string candidate = base + "_" + std::to_string(suffix);
+        if (!used.count(candidate)) return candidate;
+    }
+}
+
+size_t OnnxGraph::pruneUnusedInitializers() {
+    // Subgraph bodies (If/Loop/Scan) are kept undecoded, so their references are invisible
+    for (const auto& node : nodes) {
+        for (const auto& a : node.attributes) {
+            if (a.type == OnnxAttribute::GRAPH || a.type == OnnxAttribute::GRAPHS) return 0;
+        }
+    }
+
+    std::unordered_set<std::string> used;
+    for (const auto& node : nodes) {
+        for (const auto& s : node.inputs) used.insert(s);
+    }
+    for (const auto& v : outputs) used.insert(v.name);
+
+    size_t before = initializers.size();
+    std::unordered_set<std::string> removed;
+    std::vector<OnnxTensor> kept;
+    kept.reserve(initializers.size());
+    for (auto& t : initializers) {
+        if (used.count(t.name)) {
+            kept.push_back(std::move(t));
+        } else {
+            removed.insert(t.name);
+        }
+    }
+    initializers = std::move(kept);
+
+    if (!removed.empty()) {
+        std::vector<OnnxValueInfo> keptInputs;
+        for (auto& v : inputs) {
+            if (!removed.count(v.name)) keptInputs.push_back(std::move(v));
+        }
+        inputs = std::move(keptInputs);
+    }
+    return before - initializers.size();
+}
+
+// OnnxModel
+
+bool OnnxModel::loadFromFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Error: Cannot open ONNX file: " << path << "\n";
+        return false;
+    }
+    std::string buffer((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (!loadFromBuffer(buffer.data(), buffer.size())) {
+        std::cerr << "Error: Failed to decode ONNX model: " << path << "\n";
+        return false;
+    }
+    return true;
+}
+
+bool OnnxModel::readMetadataProps(const std::string& path, std::map<std::string, std::string>& props) {
+    ProtoFileReader file(path);
+    if (!file.isOpen()) {
+        return false;
+    }
+    uint32_t field = 0, wireType = 0;
+    std::string entry;
+    while (file.next(field, wireType)) {
+        if (field != 14 || wireType != WIRE_LENGTH_DELIMITED) {    // metadata_props
+            if (!file.skip(wireType)) return false;
+            continue;
+        }
+        if (!file.readMessage(entry)) return false;
+        ProtoReader reader(entry.data(), entry.size());
+        std::string name, value;
+        while (!reader.atEnd() && reader.readTag(field, wireType)) {
+            if (field == 1 && wireType == WIRE_LENGTH_DELIMITED) reader.readString(name);
+            else if (field == 2 && wireType == WIRE_LENGTH_DELIMITED) reader.readString(value);
+            else if (!reader.skipField(wireType)) break;
+        }
+        props[name] = value;
+    }
+    return file.atEnd();
+}
+
+bool OnnxModel::readNodes(const std::string& path, std::vector<OnnxNode>& nodes) {
+    ProtoFileReader file(path);
+    if (!file.isOpen()) {
+        return false;
+    }
+    uint32_t field = 0, wireType = 0;
+    std::string message;
+    while (file.next(field, wireType)) {
+        if (field != 7 || wireType != WIRE_LENGTH_DELIMITED) {    // graph
+            if (!file.skip(wireType)) return false;
+            continue;
+        }
+        // Step into the graph: nodes are decoded, initializers and the rest skipped
+        uint64_t graphSize = 0;
+        if (!file.readVarint(graphSize)) return false;
+        uint64_t graphEnd = file.position() + graphSize;
+        while (file.position() < graphEnd && file.next(field, wireType)) {
+            if (field != 1 || wireType != WIRE_LENGTH_DELIMITED) {
+                if (!file.skip(wireType)) return false;
+                continue;
+            }
+            OnnxNode node;
+            if (!file.readMessage(message) || !parseNode(message.data(), message.size(), node)) return false;
+            nodes.push_back(std::move(node));
+        }
+    }
+    return file.atEnd();
+}
+
+bool OnnxModel::loadFromBuffer(const void* data, size_t size, bool withTensorData) {
+    *this = OnnxModel();
+    ProtoReader r(static_cast<const char*>(data), size);
+    bool sawGraph = false;
+    while (!r.atEnd()) {
+        size_t start = r.position();
+        uint32_t field = 0, wt = 0;
+        if (!r.readTag(field, wt)) return false;
+        bool ok = true;
+        uint64_t v = 0;
+        const char* ptr = nullptr;
+        size_t length = 0;
+        switch (field) {
+            case 1:
+                ok = wt == WIRE_VARINT && r.readVarint(v);
+                irVersion = static_cast<int64_t>(v);
+                break;
+            case 7:
+                ok = wt == WIRE_LENGTH_DELIMITED && r.readBytes(ptr, length) &&
+                     parseGraph(ptr, length, graph, withTensorData);
+                sawGraph = true;
+                break;
+            case 8: {
+                ok = wt == WIRE_LENGTH_DELIMITED && r.readBytes(ptr, length);
+                if (!ok) break;
+                OnnxOpsetId opset;
+                ProtoReader o(ptr, length);
+                while (ok && !o.atEnd()) {
+                    uint32_t opField = 0, opWt = 0;
+                    ok = o.readTag(opField, opWt);
+                    if (!ok) break;
+                    if (opField == 1 && opWt == WIRE_LENGTH_DELIMITED) {
+                        ok = o.readString(opset.domain);
+                    } else if (opField == 2 && opWt == WIRE_VARINT) {
+                        ok = o.readVarint(v);
+                        opset.version = static_cast<int64_t>(v);
+                    } else {
+                        ok = o.skipField(opWt);
+                    }
+                }
+                opsetImports.push_back(opset);
+                break;
+            }
+            default: ok = keepUnknown(r, start, wt, extraFields); break;
+        }
+        if (!ok) return false;
+    }
+    return sawGraph;
+}
+
+std::string OnnxModel::serialize() const {
+    std::string out;
+    ProtoWriter w(out);
+    w.int64Field(1, irVersion);
+    std::string body;
+    writeGraph(body, graph);
+    w.bytesField(7, body);
+    for (const auto& opset : opsetImports) {
+        std::string opsetBody;
+        ProtoWriter ow(opsetBody);
+        if (!opset.domain.empty()) ow.bytesField(1, opset.domain);
+        ow.int64Field(2, opset.version);
+        w.bytesField(8, opsetBody);
+    }
+    w.raw(extraFields);
+    return out;
+}
+
+bool OnnxModel::saveToFile(const std::string& path) const {
+    std::string buffer = serialize();
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Error: Cannot create ONNX file: " << path << "\n";
+        return false;
+    }
+    file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    file.close();
+    if (!file.good()) {
+        std::cerr << "Error: Failed to write ONNX file: " << path << "\n";
+        return false;
+    }
+    return true;
+}
+
+int64_t OnnxModel::opsetVersion(const std::string& domain) const {
+    bool defaultDomain = domain.empty() || domain == "ai.onnx";
+    for (const auto& opset : opsetImports) {
+        bool match = defaultDomain ? (opset.domain.empty() || opset.domain == "ai.onnx") : opset.domain == domain;
+        if (match) return opset.version;
+    }
+    return 0;
+}
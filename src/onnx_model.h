@@ -0,0 +1,196 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+// Minimal ONNX (ModelProto) reader/writer for the CPU-side graph tools.
+// Only the fields the tools inspect or edit are decoded; every other field
+// is kept as raw protobuf bytes and written back verbatim, so a load/save
+// round trip does not lose information.
+
+// TensorProto.DataType
+enum class OnnxDataType : int32_t {
+    UNDEFINED = 0,
+    FLOAT = 1,
+    UINT8 = 2,
+    INT8 = 3,
+    UINT16 = 4,
+    INT16 = 5,
+    INT32 = 6,
+    INT64 = 7,
+    STRING = 8,
+    BOOL = 9,
+    FLOAT16 = 10,
+    DOUBLE = 11,
+    UINT32 = 12,
+    UINT64 = 13,
+    COMPLEX64 = 14,
+    COMPLEX128 = 15,
+    BFLOAT16 = 16,
+    FLOAT8E4M3FN = 17,
+    FLOAT8E4M3FNUZ = 18,
+    FLOAT8E5M2 = 19,
+    FLOAT8E5M2FNUZ = 20
+};
+
+// Size in bytes of one element, 0 for STRING/UNDEFINED
+size_t onnxElementSize(int32_t dataType);
+std::string onnxDataTypeName(int32_t dataType);
+
+struct OnnxTensor {
+    std::string name;
+    int32_t dataType = 0;
+    std::vector<int64_t> dims;
+    std::string rawData;                 // little-endian element bytes (typed *_data fields are folded in on load)
+    std::vector<std::string> stringData;
+    bool isExternal = false;             // data lives in an external file, rawData is empty
+    std::string extraFields;             // undecoded fields, written back verbatim
+
+    int64_t numElements() const;
+    bool hasData() const { return !isExternal && (!rawData.empty() || numElements() == 0); }
+
+    // Element conversion (FLOAT, FLOAT16, BFLOAT16, DOUBLE and integer types)
+    std::vector<float> toFloats() const;
+    std::vector<int64_t> toInt64s() const;
+
+    static OnnxTensor fromFloats(const std::string& name, const std::vector<int64_t>& dims,
+                                 const std::vector<float>& values);
+    static OnnxTensor fromInt64s(const std::string& name, const std::vector<int64_t>& dims,
+                                 const std::vector<int64_t>& values);
+};
+
+struct OnnxAttribute {
+    // AttributeProto.AttributeType
+    enum Type : int32_t {
+        UNDEFINED = 0, FLOAT = 1, INT = 2, STRING = 3, TENSOR = 4, GRAPH = 5,
+        FLOATS = 6, INTS = 7, STRINGS = 8, TENSORS = 9, GRAPHS = 10
+    };
+
+    std::string name;
+    int32_t type = UNDEFINED;
+    float f = 0.0f;
+    int64_t i = 0;
+    std::string s;
+    OnnxTensor t;
+    std::vector<float> floats;
+    std::vector<int64_t> ints;
+    std::vector<std::string> strings;
+    std::string extraFields;             // subgraphs, tensor lists, doc strings, ...
+
+    static OnnxAttribute makeInt(const std::string& name, int64_t value);
+    static OnnxAttribute makeInts(const std::string& name, const std::vector<int64_t>& values);
+    static OnnxAttribute makeFloat(const std::string& name, float value);
+    static OnnxAttribute makeString(const std::string& name, const std::string& value);
+    static OnnxAttribute makeTensor(const std::string& name, const OnnxTensor& value);
+};
+
+struct OnnxGraph;
+
+struct OnnxNode {
+    std::vector<std::string> inputs;
+    std::vector<std::string> outputs;
+    std::string name;
+    std::string opType;
+    std::string domain;
+    std::vector<OnnxAttribute> attributes;
+    std::string extraFields;
+
+    const OnnxAttribute* attr(const std::string& attrName) const;
+    OnnxAttribute* attr(const std::string& attrName);
+    int64_t attrInt(const std::string& attrName, int64_t defaultValue) const;
+    float attrFloat(const std::string& attrName, float defaultValue) const;
+    std::string attrString(const std::string& attrName, const std::string& defaultValue = "") const;
+    std::vector<int64_t> attrInts(const std::string& attrName) const;
+    void setAttr(const OnnxAttribute& attribute);
+
+    // Empty names mark omitted optional inputs
+    const std::string& input(size_t index) const;
+
+    // Graph-valued attributes (If branches, Loop and Scan bodies), decoded from
+    // the kept attribute bytes; withTensorData as in OnnxModel::loadFromBuffer.
+    // False if one is malformed.
+    bool subgraphs(std::vector<OnnxGraph>& graphs, bool withTensorData = true) const;
+};
+
+struct OnnxDim {
+    int64_t value = -1;                  // >= 0 when fixed
+    std::string param;                   // symbolic name, e.g. "batch"
+    std::string extraFields;
+
+    bool isFixed() const { return value >= 0; }
+    bool isSymbolic() const { return !param.empty(); }
+};
+
+struct OnnxValueInfo {
+    std::string name;
+    bool isTensor = true;                // false for sequence/map/optional types (kept in typeExtraFields)
+    int32_t elemType = 0;
+    bool hasShape = false;
+    std::vector<OnnxDim> dims;
+    std::string typeExtraFields;         // undecoded TypeProto fields
+    std::string extraFields;
+};
+
+struct OnnxGraph {
+    std::string name;
+    std::vector<OnnxNode> nodes;
+    std::vector<OnnxTensor> initializers;
+    std::vector<OnnxValueInfo> inputs;
+    std::vector<OnnxValueInfo> outputs;
+    std::vector<OnnxValueInfo> valueInfo;
+    std::string extraFields;
+
+    OnnxTensor* findInitializer(const std::string& tensorName);
+    const OnnxTensor* findInitializer(const std::string& tensorName) const;
+    OnnxValueInfo* findInput(const std::string& tensorName);
+    OnnxValueInfo* findOutput(const std::string& tensorName);
+    OnnxValueInfo* findValueInfo(const std::string& tensorName);
+
+    // Graph inputs that are not initializers (older IR versions list both)
+    std::vector<const OnnxValueInfo*> runtimeInputs() const;
+
+    // Map tensor name -> index of the node producing it
+    std::unordered_map<std::string, size_t> producerIndex() const;
+    // Map tensor name -> indices of the nodes consuming it
+    std::unordered_map<std::string, std::vector<size_t>> consumerIndex() const;
+
+    // Returns base, or base with a numeric suffix, not used by any tensor or node
+    std::string makeUniqueName(const std::string& base) const;
+
+    // Drops initializers no node or graph output references. Returns the count removed.
+    size_t pruneUnusedInitializers();
+};
+
+struct OnnxOpsetId {
+    std::string domain;
+    int64_t version = 0;
+};
+
+class OnnxModel {
+public:
+    int64_t irVersion = 0;
+    std::vector<OnnxOpsetId> opsetImports;
+    OnnxGraph graph;
+    std::string extraFields;
+
+    bool loadFromFile(const std::string& path);
+    // Model-level metadata_props (e.g. Ultralytics "names", "stride") read straight
+    // from the file; the graph is skipped, not decoded. False if the file is unreadable.
+    static bool readMetadataProps(const std::string& path, std::map<std::string, std::string>& props);
+    // Nodes of the main graph only (no initializers or value infos), also read
+    // straight from the file; false if it is unreadable or malformed
+    static bool readNodes(const std::string& path, std::vector<OnnxNode>& nodes);
+    // withTensorData false: initializers and Constant values keep name, type and
+    // dims but no elements, so inspecting a large model copies none of its
+    // weights. Such a model must not be saved.
+    bool loadFromBuffer(const void* data, size_t size, bool withTensorData = true);
+    bool saveToFile(const std::string& path) const;
+    std::string serialize() const;
+
+    // Opset version for a domain ("" and "ai.onnx" are the default domain), 0 if not imported
+    int64_t opsetVersion(const std::string& domain = "") const;
+};
@@ -0,0 +1,1316 @@
+#include "onnx_shape_inference.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+
+namespace {
+
+using Dims = std::vector<int64_t>;
+
+// Integer tensors up to this size have their contents folded
+constexpr int64_t kMaxFoldedElements = 64;
+
+int64_t normalizeAxis(int64_t axis, size_t rank) {
+    return axis < 0 ? axis + static_cast<int64_t>(rank) : axis;
+}
+
+int64_t product(const Dims& dims, size_t begin, size_t end) {
+    int64_t result = 1;
+    for (size_t i = begin; i < end && i < dims.size(); ++i) {
+        if (dims[i] < 0) return -1;
+        result *= dims[i];
+    }
+    return result;
+}
+
+// Multidirectional (numpy) broadcasting. Returns false on incompatible extents.
+bool broadcastDims(const Dims& a, const Dims& b, Dims& out) {
+    size_t rank = std::max(a.size(), b.size());
+    out.assign(rank, -1);
+    for (size_t i = 0; i < rank; ++i) {
+        int64_t da = i < rank - a.size() ? 1 : a[i - (rank - a.size())];
+        int64_t db = i < rank - b.size() ? 1 : b[i - (rank - b.size())];
+        if (da == db) out[i] = da;
+        else if (da == 1) out[i] = db;
+        else if (db == 1) out[i] = da;
+        else if (da < 0) out[i] = db;
+        else if (db < 0) out[i] = da;
+        else return false;
+    }
+    return true;
+}
+
+bool isIntegerType(int32_t elemType) {
+    switch (static_cast<OnnxDataType>(elemType)) {
+        case OnnxDataType::INT64:
+        case OnnxDataType::INT32:
+        case OnnxDataType::INT16:
+        case OnnxDataType::INT8:
+        case OnnxDataType::UINT8:
+        case OnnxDataType::UINT16:
+        case OnnxDataType::UINT32:
+        case OnnxDataType::UINT64:
+        case OnnxDataType::BOOL:
+            return true;
+        default:
+            return false;
+    }
+}
+
+std::string nodeLabel(const OnnxNode& node) {
+    return node.opType + " '" + (node.name.empty() ? node.outputs.empty() ? "?" : node.outputs[0] : node.name) + "'";
+}
+
+std::string dimsToString(const Dims& dims) {
+    std::ostringstream ss;
+    ss << "[";
+    for (size_t i = 0; i < dims.size(); ++i) {
+        if (i) ss << ",";
+        if (dims[i] < 0) ss << "?";
+        else ss << dims[i];
+    }
+    ss << "]";
+    return ss.str();
+}
+
+OnnxShapeInfo fromTensor(const OnnxTensor& tensor) {
+    OnnxShapeInfo info;
+    info.rankKnown = true;
+    info.dims = tensor.dims;
+    info.elemType = tensor.dataType;
+    if (isIntegerType(tensor.dataType) && tensor.numElements() <= kMaxFoldedElements && tensor.hasData()) {
+        info.value = tensor.toInt64s();
+        info.hasValue = static_cast<int64_t>(info.value.size()) == tensor.numElements();
+    }
+    return info;
+}
+
+} // namespace
+
+int64_t OnnxShapeInfo::numElements() const {
+    if (!rankKnown) return -1;
+    return product(dims, 0, dims.size());
+}
+
+std::string OnnxShapeInfo::toString() const {
+    if (!rankKnown) return "[unknown]";
+    std::ostringstream ss;
+    ss << "[";
+    for (size_t i = 0; i < dims.size(); ++i) {
+        if (i) ss << ",";
+        if (static_cast<int>(i) == batchAxis) ss << "N=";
+        if (dims[i] < 0) ss << "?";
+        else ss << dims[i];
+    }
+    ss << "]";
+    return ss.str();
+}
+
+OnnxShapeInference::OnnxShapeInference(const OnnxModel& model)
+    : m_model(model), m_opset(model.opsetVersion()) {
+}
+
+void OnnxShapeInference::setInputShape(const std::string& name, const std::vector<int64_t>& dims) {
+    m_inputOverrides[name] = dims;
+}
+
+bool OnnxShapeInference::run() {
+    m_infos.clear();
+    m_constants.clear();
+    m_warnedOps.clear();
+    m_errors.clear();
+    m_warnings.clear();
+
+    const OnnxGraph& graph = m_model.graph;
+    for (const auto& tensor : graph.initializers) {
+        m_infos[tensor.name] = fromTensor(tensor);
+        m_constants[tensor.name] = &tensor;
+    }
+
+    for (const OnnxValueInfo* input : graph.runtimeInputs()) {
+        OnnxShapeInfo info;
+        info.elemType = input->elemType;
+        auto it = m_inputOverrides.find(input->name);
+        if (it != m_inputOverrides.end()) {
+            info.rankKnown = true;
+            info.dims = it->second;
+        } else if (input->hasShape) {
+            info.rankKnown = true;
+            for (size_t i = 0; i < input->dims.size(); ++i) {
+                const OnnxDim& dim = input->dims[i];
+                if (dim.isFixed()) {
+                    info.dims.push_back(dim.value);
+                } else if (i == 0) {
+                    info.dims.push_back(m_batchSize);
+                    info.batchAxis = 0;
+                } else {
+                    info.dims.push_back(-1);
+                }
+            }
+        }
+        m_infos[input->name] = info;
+    }
+
+    for (const auto& node : graph.nodes) {
+        if (node.opType == "Constant") {
+            const OnnxAttribute* value = node.attr("value");
+            if (value && !node.outputs.empty()) m_constants[node.outputs[0]] = &value->t;
+        }
+        inferNode(node);
+    }
+    return m_errors.empty();
+}
+
+const OnnxShapeInfo* OnnxShapeInference::find(const std::string& tensorName) const {
+    auto it = m_infos.find(tensorName);
+    return it == m_infos.end() ? nullptr : &it->second;
+}
+
+bool OnnxShapeInference::constantFloats(const std::string& tensorName, std::vector<float>& values) const {
+    auto it = m_constants.find(tensorName);
+    if (it == m_constants.end() || !it->second->hasData()) return false;
+    values = it->second->toFloats();
+    return static_cast<int64_t>(values.size()) == it->second->numElements();
+}
+
+const OnnxShapeInfo& OnnxShapeInference::in(const OnnxNode& node, size_t index) const {
+    static const OnnxShapeInfo unknown;
+    if (index >= node.inputs.size() || node.inputs[index].empty()) return unknown;
+    auto it = m_infos.find(node.inputs[index]);
+    return it == m_infos.end() ? unknown : it->second;
+}
+
+bool OnnxShapeInference::hasInput(const OnnxNode& node, size_t index) const {
+    return index < node.inputs.size() && !node.inputs[index].empty();
+}
+
+void OnnxShapeInference::setOutput(const OnnxNode& node, size_t index, OnnxShapeInfo info) {
+    if (index >= node.outputs.size() || node.outputs[index].empty()) return;
+    if (info.hasValue && static_cast<int64_t>(info.value.size()) != std::max<int64_t>(info.numElements(), 0)) {
+        info.hasValue = false;
+        info.value.clear();
+    }
+    if (!info.hasValue) info.valueBatchIndex = -1;
+    m_infos[node.outputs[index]] = std::move(info);
+}
+
+void OnnxShapeInference::error(const OnnxNode& node, const std::string& message) {
+    m_errors.push_back(nodeLabel(node) + ": " + message);
+}
+
+void OnnxShapeInference::warn(const OnnxNode& node, const std::string& message) {
+    m_warnings.push_back(nodeLabel(node) + ": " + message);
+}
+
+bool OnnxShapeInference::axesFrom(const OnnxNode& node, const std::string& attrName, size_t inputIndex,
+                                  std::vector<int64_t>& axes, bool& present) const {
+    present = false;
+    if (const OnnxAttribute* a = node.attr(attrName)) {
+        axes = a->ints;
+        present = true;
+        return true;
+    }
+    if (hasInput(node, inputIndex)) {
+        const OnnxShapeInfo& info = in(node, inputIndex);
+        if (!info.hasValue) return false;
+        axes = info.value;
+        present = true;
+    }
+    return true;
+}
+
+void OnnxShapeInference::inferNode(const OnnxNode& node) {
+    static const std::unordered_set<std::string> elementwise = {
+        "Identity", "Relu", "Sigmoid", "Tanh", "LeakyRelu", "HardSigmoid", "HardSwish", "Elu", "Selu",
+        "Celu", "Softplus", "Softsign", "Erf", "Exp", "Log", "Sqrt", "Neg", "Abs", "Reciprocal", "Floor",
+        "Ceil", "Round", "Clip", "Dropout", "Softmax", "LogSoftmax", "Hardmax", "BatchNormalization",
+        "InstanceNormalization", "LayerNormalization", "GroupNormalization", "LpNormalization",
+        "QuantizeLinear", "DequantizeLinear", "Not", "Sign", "Mish", "Gelu", "Sin", "Cos", "IsNaN",
+        "IsInf", "Cast", "CastLike", "Shrink", "ThresholdedRelu", "LRN", "MeanVarianceNormalization",
+        "Trilu", "CumSum", "ScatterND", "ScatterElements", "BitwiseNot"
+    };
+    static const std::unordered_set<std::string> broadcast = {
+        "Add", "Sub", "Mul", "Div", "Pow", "Max", "Min", "Sum", "Mean", "Equal", "Less", "Greater",
+        "LessOrEqual", "GreaterOrEqual", "And", "Or", "Xor", "Mod", "PRelu", "BitShift", "Where",
+        "BitwiseAnd", "BitwiseOr", "BitwiseXor"
+    };
+    static const std::unordered_set<std::string> convPool = {
+        "Conv", "ConvTranspose", "MaxPool", "AveragePool", "LpPool", "GlobalAveragePool",
+        "GlobalMaxPool", "GlobalLpPool", "ConvInteger", "QLinearConv"
+    };
+    static const std::unordered_set<std::string> reduce = {
+        "ReduceMean", "ReduceSum", "ReduceMax", "ReduceMin", "ReduceProd", "ReduceL1", "ReduceL2",
+        "ReduceLogSum", "ReduceLogSumExp", "ReduceSumSquare", "ArgMax", "ArgMin"
+    };
+
+    const std::string& op = node.opType;
+    bool defaultDomain = node.domain.empty() || node.domain == "ai.onnx";
+    if (!defaultDomain) {
+        if (m_warnedOps.insert(node.domain + "::" + op).second) {
+            warn(node, "custom-domain op '" + node.domain + "' has no shape rule; downstream shapes are unknown");
+        }
+        for (size_t i = 0; i < node.outputs.size(); ++i) setOutput(node, i, OnnxShapeInfo());
+        return;
+    }
+
+    if (elementwise.count(op)) inferElementwise(node);
+    else if (broadcast.count(op)) inferBroadcast(node);
+    else if (convPool.count(op)) inferConvPool(node);
+    else if (reduce.count(op)) inferReduce(node);
+    else if (op == "Resize" || op == "Upsample") inferResize(node);
+    else if (op == "Concat") inferConcat(node);
+    else if (op == "Split") inferSplit(node);
+    else if (op == "Slice") inferSlice(node);
+    else if (op == "Reshape") inferReshape(node);
+    else if (op == "Expand") inferExpand(node);
+    else if (op == "Transpose") inferTranspose(node);
+    else if (op == "Flatten") inferFlatten(node);
+    else if (op == "Squeeze") inferSqueeze(node, false);
+    else if (op == "Unsqueeze") inferSqueeze(node, true);
+    else if (op == "Gather" || op == "GatherElements") inferGather(node);
+    else if (op == "Shape" || op == "Size") inferShape(node);
+    else if (op == "Constant" || op == "ConstantOfShape") inferConstant(node);
+    else if (op == "MatMul" || op == "MatMulInteger") inferMatMul(node);
+    else if (op == "Gemm") inferGemm(node);
+    else if (op == "Pad") inferPad(node);
+    else if (op == "Tile") inferTile(node);
+    else if (op == "Range") inferRange(node);
+    else if (op == "TopK") inferTopK(node);
+    else if (op == "NonZero") {
+        OnnxShapeInfo out;
+        out.rankKnown = in(node, 0).rankKnown;
+        out.dims = {static_cast<int64_t>(in(node, 0).dims.size()), -1};
+        out.elemType = static_cast<int32_t>(OnnxDataType::INT64);
+        setOutput(node, 0, out);
+    } else if (op == "NonMaxSuppression") {
+        OnnxShapeInfo out;
+        out.rankKnown = true;
+        out.dims = {-1, 3};
+        out.elemType = static_cast<int32_t>(OnnxDataType::INT64);
+        setOutput(node, 0, out);
+    } else if (op == "DepthToSpace" || op == "SpaceToDepth") {
+        const OnnxShapeInfo& x = in(node, 0);
+        OnnxShapeInfo out = x;
+        out.hasValue = false;
+        int64_t block = node.attrInt("blocksize", 1);
+        if (x.rankKnown && x.dims.size() == 4) {
+            bool toSpace = op == "DepthToSpace";
+            auto scale = [&](int64_t d, bool up) { return d < 0 ? d : (up ? d * block : d / block); };
+            out.dims[1] = x.dims[1] < 0 ? -1 : (toSpace ? x.dims[1] / (block * block) : x.dims[1] * block * block);
+            out.dims[2] = scale(x.dims[2], toSpace);
+            out.dims[3] = scale(x.dims[3], toSpace);
+        }
+        setOutput(node, 0, out);
+    } else if (op == "GridSample") {
+        const OnnxShapeInfo& x = in(node, 0);
+        const OnnxShapeInfo& grid = in(node, 1);
+        OnnxShapeInfo out;
+        out.elemType = x.elemType;
+        if (x.rankKnown && grid.rankKnown && x.dims.size() == 4 && grid.dims.size() == 4) {
+            out.rankKnown = true;
+            out.dims = {x.dims[0], x.dims[1], grid.dims[1], grid.dims[2]};
+            out.batchAxis = x.batchAxis == 0 ? 0 : -1;
+        }
+        setOutput(node, 0, out);
+    } else {
+        if (m_warnedOps.insert(op).second) {
+            warn(node, "no shape rule for this op; downstream shapes are unknown");
+        }
+        for (size_t i = 0; i < node.outputs.size(); ++i) setOutput(node, i, OnnxShapeInfo());
+    }
+}
+
+void OnnxShapeInference::inferElementwise(const OnnxNode& node) {
+    OnnxShapeInfo out = in(node, 0);
+    const std::string& op = node.opType;
+    bool keepsValue = op == "Identity" || op == "Cast" || op == "CastLike";
+    if (!keepsValue) {
+        out.hasValue = false;
+        out.value.clear();
+    }
+    if (op == "Cast") {
+        out.elemType = static_cast<int32_t>(node.attrInt("to", out.elemType));
+        if (!isIntegerType(out.elemType)) out.hasValue = false;
+    } else if (op == "CastLike") {
+        out.elemType = in(node, 1).elemType;
+    } else if (op == "QuantizeLinear") {
+        out.elemType = hasInput(node, 2) ? in(node, 2).elemType : static_cast<int32_t>(OnnxDataType::UINT8);
+        if (const OnnxAttribute* t = node.attr("output_dtype")) {
+            if (t->i != 0) out.elemType = static_cast<int32_t>(t->i);
+        }
+    } else if (op == "DequantizeLinear") {
+        out.elemType = hasInput(node, 1) ? in(node, 1).elemType : static_cast<int32_t>(OnnxDataType::FLOAT);
+    } else if (op == "IsNaN" || op == "IsInf") {
+        out.elemType = static_cast<int32_t>(OnnxDataType::BOOL);
+    }
+    setOutput(node, 0, out);
+    if (op == "Dropout" && node.outputs.size() > 1) {
+        OnnxShapeInfo mask = out;
+        mask.elemType = static_cast<int32_t>(OnnxDataType::BOOL);
+        setOutput(node, 1, mask);
+    }
+}
+
+void OnnxShapeInference::inferBroadcast(const OnnxNode& node) {
+    OnnxShapeInfo out;
+    out.rankKnown = true;
+    const std::string& op = node.opType;
+    size_t dataStart = op == "Where" ? 1 : 0;
+    out.elemType = in(node, dataStart).elemType;
+    if (op == "Equal" || op == "Less" || op == "Greater" || op == "LessOrEqual" || op == "GreaterOrEqual" ||
+        op == "And" || op == "Or" || op == "Xor") {
+        out.elemType = static_cast<int32_t>(OnnxDataType::BOOL);
+    }
+
+    for (size_t i = 0; i < node.inputs.size(); ++i) {
+        const OnnxShapeInfo& x = in(node, i);
+        if (!x.rankKnown) {
+            setOutput(node, 0, OnnxShapeInfo());
+            return;
+        }
+        Dims merged;
+        if (!broadcastDims(out.dims, x.dims, merged)) {
+            error(node, "cannot broadcast " + dimsToString(out.dims) + " with " + dimsToString(x.dims));
+            setOutput(node, 0, OnnxShapeInfo());
+            return;
+        }
+        out.dims = merged;
+    }
+    for (size_t i = 0; i < node.inputs.size() && out.batchAxis < 0; ++i) {
+        const OnnxShapeInfo& x = in(node, i);
+        if (x.batchAxis >= 0) out.batchAxis = x.batchAxis + static_cast<int>(out.dims.size() - x.dims.size());
+    }
+
+    // Fold integer shape arithmetic (e.g. Mul(Gather(Shape(x)), 2))
+    if ((op == "Add" || op == "Sub" || op == "Mul" || op == "Div") && node.inputs.size() == 2) {
+        const OnnxShapeInfo& a = in(node, 0);
+        const OnnxShapeInfo& b = in(node, 1);
+        if (a.hasValue && b.hasValue && isIntegerType(out.elemType) &&
+            (a.value.size() == b.value.size() || a.value.size() == 1 || b.value.size() == 1)) {
+            size_t n = std::max(a.value.size(), b.value.size());
+            out.value.resize(n);
+            out.hasValue = true;
+            for (size_t i = 0; i < n; ++i) {
+                int64_t va = a.value[a.value.size() == 1 ? 0 : i];
+                int64_t vb = b.value[b.value.size() == 1 ? 0 : i];
+                if (op == "Add") out.value[i] = va + vb;
+                else if (op == "Sub") out.value[i] = va - vb;
+                else if (op == "Mul") out.value[i] = va * vb;
+                else if (vb != 0) out.value[i] = va / vb;
+                else out.hasValue = false;
+            }
+        }
+    }
+    setOutput(node, 0, out);
+}
+
+void OnnxShapeInference::inferConvPool(const OnnxNode& node) {
+    const OnnxShapeInfo& x = in(node, 0);
+    const std::string& op = node.opType;
+    OnnxShapeInfo out;
+    out.elemType = x.elemType;
+    if (op == "ConvInteger") out.elemType = static_cast<int32_t>(OnnxDataType::INT32);
+    if (op == "QLinearConv") out.elemType = in(node, 7).elemType;
+    if (!x.rankKnown || x.dims.size() < 3) {
+        setOutput(node, 0, out);
+        return;
+    }
+    out.rankKnown = true;
+    out.dims = x.dims;
+    out.batchAxis = x.batchAxis == 0 ? 0 : -1;
+    size_t spatial = x.dims.size() - 2;
+
+    if (op == "GlobalAveragePool" || op == "GlobalMaxPool" || op == "GlobalLpPool") {
+        for (size_t i = 0; i < spatial; ++i) out.dims[2 + i] = 1;
+        setOutput(node, 0, out);
+        return;
+    }
+
+    bool isConv = op == "Conv" || op == "ConvTranspose" || op == "ConvInteger" || op == "QLinearConv";
+    const OnnxShapeInfo& w = in(node, op == "QLinearConv" ? 3 : 1);
+    Dims kernel = node.attrInts("kernel_shape");
+    if (kernel.empty() && isConv && w.rankKnown && w.dims.size() == x.dims.size()) {
+        kernel.assign(w.dims.begin() + 2, w.dims.end());
+    }
+    if (isConv) {
+        int64_t group = node.attrInt("group", 1);
+        if (op == "ConvTranspose") out.dims[1] = w.rankKnown && w.dims.size() > 1 && w.dims[1] >= 0 ? w.dims[1] * group : -1;
+        else out.dims[1] = w.rankKnown && !w.dims.empty() ? w.dims[0] : -1;
+    }
+    if (kernel.size() != spatial) {
+        for (size_t i = 0; i < spatial; ++i) out.dims[2 + i] = -1;
+        setOutput(node, 0, out);
+        return;
+    }
+
+    Dims pads = node.attrInts("pads");
+    Dims strides = node.attrInts("strides");
+    Dims dilations = node.attrInts("dilations");
+    Dims outputPadding = node.attrInts("output_padding");
+    Dims outputShape = node.attrInts("output_shape");
+    pads.resize(2 * spatial, 0);
+    strides.resize(spatial, 1);
+    dilations.resize(spatial, 1);
+    outputPadding.resize(spatial, 0);
+    std::string autoPad = node.attrString("auto_pad", "NOTSET");
+    bool ceilMode = node.attrInt("ceil_mode", 0) != 0;
+
+    for (size_t i = 0; i < spatial; ++i) {
+        int64_t size = x.dims[2 + i];
+        if (size < 0) {
+            out.dims[2 + i] = -1;
+            continue;
+        }
+        int64_t effectiveKernel = (kernel[i] - 1) * dilations[i] + 1;
+        if (op == "ConvTranspose") {
+            if (outputShape.size() == spatial) {
+                out.dims[2 + i] = outputShape[i];
+            } else if (autoPad == "SAME_UPPER" || autoPad == "SAME_LOWER") {
+                out.dims[2 + i] = size * strides[i];
+            } else {
+                out.dims[2 + i] = strides[i] * (size - 1) + outputPadding[i] + effectiveKernel - pads[i] - pads[i + spatial];
+            }
+        } else if (autoPad == "SAME_UPPER" || autoPad == "SAME_LOWER") {
+            out.dims[2 + i] = (size + strides[i] - 1) / strides[i];
+        } else {
+            int64_t padded = size + (autoPad == "VALID" ? 0 : pads[i] + pads[i + spatial]);
+            int64_t span = padded - effectiveKernel;
+            if (span < 0) {
+                error(node, "kernel larger than padded input on spatial axis " + std::to_string(i));
+                out.dims[2 + i] = -1;
+                continue;
+            }
+            out.dims[2 + i] = (ceilMode ? (span + strides[i] - 1) / strides[i] : span / strides[i]) + 1;
+        }
+    }
+    setOutput(node, 0, out);
+    if (op == "MaxPool" && node.outputs.size() > 1) {
+        OnnxShapeInfo indices = out;
+        indices.elemType = static_cast<int32_t>(OnnxDataType::INT64);
+        setOutput(node, 1, indices);
+    }
+}
+
+void OnnxShapeInference::inferResize(const OnnxNode& node) {
+    const OnnxShapeInfo& x = in(node, 0);
+    OnnxShapeInfo out;
+    out.elemType = x.elemType;
+    if (!x.rankKnown) {
+        setOutput(node, 0, out);
+        return;
+    }
+    out.rankKnown = true;
+    out.dims.assign(x.dims.size(), -1);
+
+    Dims axes = node.attrInts("axes");
+    if (axes.empty()) {
+        for (size_t i = 0; i < x.dims.size(); ++i) axes.push_back(static_cast<int64_t>(i));
+    }
+    for (auto& a : axes) a = normalizeAxis(a, x.dims.size());
+    for (size_t i = 0; i < x.dims.size(); ++i) {
+        if (std::find(axes.begin(), axes.end(), static_cast<int64_t>(i)) == axes.end()) out.dims[i] = x.dims[i];
+    }
+
+    // Resize-11+: X, roi, scales, sizes. Resize-10 / Upsample-9: X, scales. Upsample-7: scales attribute.
+    size_t scalesIndex = node.opType == "Resize" && m_opset >= 11 ? 2 : 1;
+    size_t sizesIndex = 3;
+    std::vector<float> scales;
+    if (node.opType == "Resize" && hasInput(node, sizesIndex) && in(node, sizesIndex).hasValue) {
+        const Dims& sizes = in(node, sizesIndex).value;
+        if (sizes.size() == axes.size()) {
+            for (size_t i = 0; i < axes.size(); ++i) out.dims[axes[i]] = sizes[i];
+        }
+        if (in(node, sizesIndex).valueBatchIndex >= 0) {
+            out.batchAxis = static_cast<int>(axes[in(node, sizesIndex).valueBatchIndex]);
+        } else if (x.batchAxis >= 0 && out.dims[x.batchAxis] == x.dims[x.batchAxis]) {
+            out.batchAxis = x.batchAxis;
+        }
+    } else {
+        bool haveScales = false;
+        if (const OnnxAttribute* a = node.attr("scales")) {
+            scales = a->floats;
+            haveScales = true;
+        } else if (hasInput(node, scalesIndex)) {
+            haveScales = constantFloats(node.inputs[scalesIndex], scales);
+        }
+        if (haveScales && scales.size() == axes.size()) {
+            for (size_t i = 0; i < axes.size(); ++i) {
+                int64_t d = x.dims[axes[i]];
+                out.dims[axes[i]] = d < 0 ? -1 : static_cast<int64_t>(std::floor(d * static_cast<double>(scales[i])));
+            }
+            if (x.batchAxis >= 0) {
+                auto it = std::find(axes.begin(), axes.end(), x.batchAxis);
+                if (it == axes.end() || scales[it - axes.begin()] == 1.0f) out.batchAxis = x.batchAxis;
+            }
+        } else if (x.batchAxis >= 0) {
+            out.batchAxis = x.batchAxis;
+        }
+    }
+    setOutput(node, 0, out);
+}
+
+void OnnxShapeInference::inferConcat(const OnnxNode& node) {
+    const OnnxShapeInfo& first = in(node, 0);
+    OnnxShapeInfo out;
+    out.elemType = first.elemType;
+    for (size_t i = 0; i < node.inputs.size(); ++i) {
+        if (!in(node, i).rankKnown) {
+            setOutput(node, 0, out);
+            return;
+        }
+    }
+    if (!first.rankKnown) {
+        setOutput(node, 0, out);
+        return;
+    }
+    size_t rank = first.dims.size();
+    int64_t axis = normalizeAxis(node.attrInt("axis", 0), rank);
+    if (axis < 0 || axis >= static_cast<int64_t>(rank)) {
+        error(node, "axis out of range");
+        setOutput(node, 0, out);
+        return;
+    }
+    out.rankKnown = true;
+    out.dims = first.dims;
+    out.dims[axis] = 0;
+    out.hasValue = rank == 1;
+    for (size_t i = 0; i < node.inputs.size(); ++i) {
+        const OnnxShapeInfo& x = in(node, i);
+        if (x.dims.size() != rank) {
+            error(node, "input " + std::to_string(i) + " has rank " + std::to_string(x.dims.size()) +
+                        ", expected " + std::to_string(rank));
+            setOutput(node, 0, OnnxShapeInfo());
+            return;
+        }
+        for (size_t d = 0; d < rank; ++d) {
+            if (static_cast<int64_t>(d) == axis) continue;
+            if (out.dims[d] < 0) {
+                out.dims[d] = x.dims[d];
+            } else if (x.dims[d] >= 0 && x.dims[d] != out.dims[d]) {
+                error(node, "input " + std::to_string(i) + " " + dimsToString(x.dims) +
+                            " does not match " + dimsToString(first.dims) + " on axis " + std::to_string(d));
+            }
+        }
+        out.dims[axis] = (out.dims[axis] < 0 || x.dims[axis] < 0) ? -1 : out.dims[axis] + x.dims[axis];
+        if (x.batchAxis >= 0 && x.batchAxis != axis && out.batchAxis < 0) out.batchAxis = x.batchAxis;
+        if (out.hasValue && x.hasValue) {
+            if (x.valueBatchIndex >= 0 && out.valueBatchIndex < 0) {
+                out.valueBatchIndex = static_cast<int>(out.value.size()) + x.valueBatchIndex;
+            }
+            out.value.insert(out.value.end(), x.value.begin(), x.value.end());
+        } else {
+            out.hasValue = false;
+        }
+    }
+    setOutput(node, 0, out);
+}
+
+void OnnxShapeInference::inferSplit(const OnnxNode& node) {
+    const OnnxShapeInfo& x = in(node, 0);
+    size_t count = node.outputs.size();
+    if (!x.rankKnown || count == 0) {
+        for (size_t i = 0; i < count; ++i) setOutput(node, i, OnnxShapeInfo());
+        return;
+    }
+    int64_t axis = normalizeAxis(node.attrInt("axis", 0), x.dims.size());
+    Dims splits = node.attrInts("split");
+    if (splits.empty() && hasInput(node, 1) && in(node, 1).hasValue) splits = in(node, 1).value;
+    int64_t total = axis >= 0 && axis < static_cast<int64_t>(x.dims.size()) ? x.dims[axis] : -1;
+    if (splits.empty()) {
+        if (total >= 0) {
+            // Equal split; opset 18 puts the remainder in the last chunk
+            int64_t chunk = (total + static_cast<int64_t>(count) - 1) / static_cast<int64_t>(count);
+            for (size_t i = 0; i < count; ++i) {
+                int64_t remaining = total - chunk * static_cast<int64_t>(i);
+                splits.push_back(std::max<int64_t>(0, std::min(chunk, remaining)));
+            }
+        }
+    } else if (total >= 0) {
+        int64_t sum = 0;
+        for (int64_t s : splits) sum += s;
+        if (sum != total) {
+            error(node, "split sizes sum to " + std::to_string(sum) + " but axis has " + std::to_string(total));
+        }
+    }
+    for (size_t i = 0; i < count; ++i) {
+        OnnxShapeInfo out = x;
+        out.hasValue = false;
+        out.value.clear();
+        if (axis >= 0 && axis < static_cast<int64_t>(out.dims.size())) {
+            out.dims[axis] = i < splits.size() ? splits[i] : -1;
+        }
+        if (out.batchAxis == axis) out.batchAxis = -1;
+        setOutput(node, i, out);
+    }
+}
+
+void OnnxShapeInference::inferSlice(const OnnxNode& node) {
+    const OnnxShapeInfo& x = in(node, 0);
+    OnnxShapeInfo out;
+    out.elemType = x.elemType;
+    if (!x.rankKnown) {
+        setOutput(node, 0, out);
+        return;
+    }
+    out.rankKnown = true;
+    out.dims = x.dims;
+    out.batchAxis = x.batchAxis;
+
+    Dims starts, ends, axes, steps;
+    bool known = true;
+    if (m_opset < 10) {
+        starts = node.attrInts("starts");
+        ends = node.attrInts("ends");
+        axes = node.attrInts("axes");
+    } else {
+        known = in(node, 1).hasValue && in(node, 2).hasValue;
+        if (known) {
+            starts = in(node, 1).value;
+            ends = in(node, 2).value;
+        }
+        if (hasInput(node, 3)) {
+            known = known && in(node, 3).hasValue;
+            axes = in(node, 3).value;
+        }
+        if (hasInput(node, 4)) {
+            known = known && in(node, 4).hasValue;
+            steps = in(node, 4).value;
+        }
+    }
+    if (!known || starts.size() != ends.size()) {
+        // Sliced axes unknown: every extent may change
+        if (m_opset >= 10 && hasInput(node, 3) && in(node, 3).hasValue) {
+            for (int64_t a : in(node, 3).value) {
+                int64_t axis = normalizeAxis(a, x.dims.size());
+                if (axis >= 0 && axis < static_cast<int64_t>(out.dims.size())) out.dims[axis] = -1;
+            }
+        } else {
+            std::fill(out.dims.begin(), out.dims.end(), -1);
+            out.batchAxis = -1;
+        }
+        setOutput(node, 0, out);
+        return;
+    }
+    if (axes.empty()) {
+        for (size_t i = 0; i < starts.size(); ++i) axes.push_back(static_cast<int64_t>(i));
+    }
+    steps.resize(starts.size(), 1);
+
+    // Remember which source elements survive, for value folding of 1-D tensors
+    std::vector<int64_t> keptIndices;
+    bool foldValue = x.hasValue && x.dims.size() == 1;
+    if (foldValue) {
+        for (int64_t i = 0; i < x.dims[0]; ++i) keptIndices.push_back(i);
+    }
+
+    for (size_t i = 0; i < starts.size() && i < axes.size(); ++i) {
+        int64_t axis = normalizeAxis(axes[i], x.dims.size());
+        if (axis < 0 || axis >= static_cast<int64_t>(x.dims.size())) {
+            error(node, "axis out of range");
+            continue;
+        }
+        int64_t d = x.dims[axis];
+        int64_t step = steps[i];
+        if (step == 0) {
+            error(node, "step must not be zero");
+            continue;
+        }
+        // Full-range slice on the batch axis keeps it batch-carrying
+        bool fullRange = starts[i] == 0 && step == 1 && ends[i] >= std::numeric_limits<int32_t>::max();
+        if (axis == x.batchAxis && !fullRange) out.batchAxis = -1;
+        if (d < 0) {
+            out.dims[axis] = -1;
+            foldValue = false;
+            continue;
+        }
+        int64_t s = starts[i] < 0 ? starts[i] + d : starts[i];
+        int64_t e = ends[i] < 0 ? ends[i] + d : ends[i];
+        int64_t length;
+        if (step > 0) {
+            s = std::clamp<int64_t>(s, 0, d);
+            e = std::clamp<int64_t>(e, 0, d);
+            length = e > s ? (e - s + step - 1) / step : 0;
+        } else {
+            s = std::clamp<int64_t>(s, 0, d - 1);
+            e = std::clamp<int64_t>(e, -1, d - 1);
+            length = s > e ? (s - e + (-step) - 1) / (-step) : 0;
+        }
+        out.dims[axis] = length;
+        if (foldValue && axis == 0) {
+            std::vector<int64_t> selected;
+            for (int64_t k = 0; k < length; ++k) selected.push_back(keptIndices[s + k * step]);
+            keptIndices = selected;
+        }
+    }
+
+    if (foldValue) {
+        out.hasValue = true;
+        for (size_t k = 0; k < keptIndices.size(); ++k) {
+            out.value.push_back(x.value[keptIndices[k]]);
+            if (keptIndices[k] == x.valueBatchIndex) out.valueBatchIndex = static_cast<int>(k);
+        }
+    }
+    setOutput(node, 0, out);
+}
+
+void OnnxShapeInference::inferReshape(const OnnxNode& node) {
+    const OnnxShapeInfo& x = in(node, 0);
+    const OnnxShapeInfo& shapeInfo = in(node, 1);
+    OnnxShapeInfo out;
+    out.elemType = x.elemType;
+    if (!shapeInfo.hasValue) {
+        if (shapeInfo.rankKnown && shapeInfo.dims.size() == 1 && shapeInfo.dims[0] >= 0) {
+            out.rankKnown = true;
+            out.dims.assign(static_cast<size_t>(shapeInfo.dims[0]), -1);
+        }
+        setOutput(node, 0, out);
+        return;
+    }
+
+    const Dims& shape = shapeInfo.value;
+    bool allowZero = node.attrInt("allowzero", 0) != 0;
+    out.rankKnown = true;
+    out.dims = shape;
+    int inferIndex = -1;
+    for (size_t i = 0; i < shape.size(); ++i) {
+        if (shape[i] == 0 && !allowZero) {
+            if (!x.rankKnown || i >= x.dims.size()) {
+                out.dims[i] = -1;
+                if (x.rankKnown) error(node, "shape entry 0 at position " + std::to_string(i) + " has no input dim to copy");
+            } else {
+                out.dims[i] = x.dims[i];
+            }
+        } else if (shape[i] == -1) {
+            if (inferIndex >= 0) error(node, "more than one -1 in target shape");
+            inferIndex = static_cast<int>(i);
+        } else if (shape[i] < -1) {
+            error(node, "invalid target extent " + std::to_string(shape[i]));
+        }
+    }
+
+    int64_t total = x.numElements();
+    if (inferIndex >= 0) {
+        int64_t others = 1;
+        bool othersKnown = true;
+        for (size_t i = 0; i < out.dims.size(); ++i) {
+            if (static_cast<int>(i) == inferIndex) continue;
+            if (out.dims[i] < 0) othersKnown = false;
+            else others *= out.dims[i];
+        }
+        out.dims[inferIndex] = -1;
+        if (total >= 0 && othersKnown) {
+            if (others == 0 || total % others != 0) {
+                error(node, "cannot reshape " + x.toString() + " (" + std::to_string(total) + " elements) into " +
+                            dimsToString(shape));
+            } else {
+                out.dims[inferIndex] = total / others;
+            }
+        }
+    } else if (total >= 0) {
+        int64_t target = product(out.dims, 0, out.dims.size());
+        if (target >= 0 && target != total) {
+            error(node, "cannot reshape " + x.toString() + " (" + std::to_string(total) + " elements) into " +
+                        dimsToString(out.dims));
+        }
+    }
+
+    // Track the batch axis: either the target shape was computed from the batch
+    // dimension, or it lines up with the input's batch axis (same prefix and
+    // suffix volume around it).
+    if (shapeInfo.valueBatchIndex >= 0) {
+        out.batchAxis = shapeInfo.valueBatchIndex;
+    } else if (x.batchAxis >= 0 && x.rankKnown) {
+        size_t p = static_cast<size_t>(x.batchAxis);
+        bool aligned = p < out.dims.size() &&
+                       product(x.dims, 0, p) >= 0 && product(x.dims, 0, p) == product(out.dims, 0, p) &&
+                       out.dims[p] == x.dims[p] &&
+                       product(x.dims, p + 1, x.dims.size()) == product(out.dims, p + 1, out.dims.size()) &&
+                       product(out.dims, p + 1, out.dims.size()) >= 0;
+        if (aligned) {
+            out.batchAxis = static_cast<int>(p);
+        } else {
+            warn(node, "batch axis is folded into another dimension " + x.toString() + " -> " + dimsToString(out.dims));
+        }
+    }
+
+    if (x.hasValue) {
+        out.hasValue = true;
+        out.value = x.value;
+        out.valueBatchIndex = x.valueBatchIndex;
+    }
+    setOutput(node, 0, out);
+}
+
+void OnnxShapeInference::inferExpand(const OnnxNode& node) {
+    const OnnxShapeInfo& x = in(node, 0);
+    const OnnxShapeInfo& shapeInfo = in(node, 1);
+    OnnxShapeInfo out;
+    out.elemType = x.elemType;
+    if (!x.rankKnown || !shapeInfo.hasValue) {
+        if (shapeInfo.rankKnown && shapeInfo.dims.size() == 1 && shapeInfo.dims[0] >= 0 && x.rankKnown) {
+            out.rankKnown = true;
+            out.dims.assign(std::max<size_t>(x.dims.size(), static_cast<size_t>(shapeInfo.dims[0])), -1);
+        }
+        setOutput(node, 0, out);
+        return;
+    }
+    Dims merged;
+    if (!broadcastDims(x.dims, shapeInfo.value, merged)) {
+        error(node, "cannot expand " + x.toString() + " to " + dimsToString(shapeInfo.value));
+        setOutput(node, 0, out);
+        return;
+    }
+    out.rankKnown = true;
+    out.dims = merged;
+    if (x.batchAxis >= 0) {
+        out.batchAxis = x.batchAxis + static_cast<int>(merged.size() - x.dims.size());
+    } else if (shapeInfo.valueBatchIndex >= 0) {
+        out.batchAxis = shapeInfo.valueBatchIndex + static_cast<int>(merged.size() - shapeInfo.value.size());
+    }
+    setOutput(node, 0, out);
+}
+
+void OnnxShapeInference::inferTranspose(const OnnxNode& node) {
+    const OnnxShapeInfo& x = in(node, 0);
+    OnnxShapeInfo out;
+    out.elemType = x.elemType;
+    if (!x.rankKnown) {
+        setOutput(node, 0, out);
+        return;
+    }
+    Dims perm = node.attrInts("perm");
+    if (perm.empty()) {
+        for (size_t i = x.dims.size(); i-- > 0;) perm.push_back(static_cast<int64_t>(i));
+    }
+    if (perm.size() != x.dims.size()) {
+        error(node, "perm size does not match input rank");
+        setOutput(node, 0, out);
+        return;
+    }
+    out.rankKnown = true;
+    for (size_t i = 0; i < perm.size(); ++i) {
+        int64_t source = normalizeAxis(perm[i], x.dims.size());
+        out.dims.push_back(source >= 0 && source < static_cast<int64_t>(x.dims.size()) ? x.dims[source] : -1);
+        if (source == x.batchAxis) out.batchAxis = static_cast<int>(i);
+    }
+    setOutput(node, 0, out);
+}
+
+void OnnxShapeInference::inferFlatten(const OnnxNode& node) {
+    const OnnxShapeInfo& x = in(node, 0);
+    OnnxShapeInfo out;
+    out.elemType = x.elemType;
+    if (!x.rankKnown) {
+        setOutput(node, 0, out);
+        return;
+    }
+    int64_t axis = normalizeAxis(node.attrInt("axis", 1), x.dims.size());
+    out.rankKnown = true;
+    out.dims = {product(x.dims, 0, static_cast<size_t>(axis)), product(x.dims, static_cast<size_t>(axis), x.dims.size())};
+    if (x.batchAxis == 0 && axis == 1) {
+        out.batchAxis = 0;
+    } else if (x.batchAxis >= 0) {
+        warn(node, "batch axis is folded into another dimension");
+    }
+    setOutput(node, 0, out);
+}
+
+void OnnxShapeInference::inferSqueeze(const OnnxNode& node, bool unsqueeze) {
+    const OnnxShapeInfo& x = in(node, 0);
+    OnnxShapeInfo out;
+    out.elemType = x.elemType;
+    Dims axes;
+    bool present = false;
+    bool known = axesFrom(node, "axes", 1, axes, present);
+    if (!x.rankKnown || !known || (unsqueeze && !present)) {
+        setOutput(node, 0, out);
+        return;
+    }
+    out.rankKnown = true;
+    if (unsqueeze) {
+        size_t rank = x.dims.size() + axes.size();
+        for (auto& a : axes) a = normalizeAxis(a, rank);
+        size_t source = 0;
+        for (size_t i = 0; i < rank; ++i) {
+            if (std::find(axes.begin(), axes.end(), static_cast<int64_t>(i)) != axes.end()) {
+                out.dims.push_back(1);
+            } else {
+                if (static_cast<int>(source) == x.batchAxis) out.batchAxis = static_cast<int>(out.dims.size());
+                out.dims.push_back(source < x.dims.size() ? x.dims[source] : -1);
+                ++source;
+            }
+        }
+    } else {
+        for (auto& a : axes) a = normalizeAxis(a, x.dims.size());
+        for (size_t i = 0; i < x.dims.size(); ++i) {
+            bool listed = std::find(axes.begin(), axes.end(), static_cast<int64_t>(i)) != axes.end();
+            // Without explicit axes every unit dim goes, except the batch axis which
+            // is only 1 at the batch size being inferred
+            bool squeezed = present ? listed : (x.dims[i] == 1 && static_cast<int>(i) != x.batchAxis);
+            if (squeezed) {
+                if (static_cast<int>(i) == x.batchAxis) warn(node, "squeezes the batch axis");
+                continue;
+            }
+            if (static_cast<int>(i) == x.batchAxis) out.batchAxis = static_cast<int>(out.dims.size());
+            out.dims.push_back(x.dims[i]);
+        }
+    }
+    if (x.hasValue) {
+        out.hasValue = true;
+        out.value = x.value;
+        out.valueBatchIndex = x.valueBatchIndex;
+    }
+    setOutput(node, 0, out);
+}
+
+void OnnxShapeInference::inferGather(const OnnxNode& node) {
+    const OnnxShapeInfo& data = in(node, 0);
+    const OnnxShapeInfo& indices = in(node, 1);
+    OnnxShapeInfo out;
+    out.elemType = data.elemType;
+    if (!data.rankKnown || !indices.rankKnown) {
+        setOutput(node, 0, out);
+        return;
+    }
+    int64_t axis = normalizeAxis(node.attrInt("axis", 0), data.dims.size());
+    if (axis < 0 || axis >= static_cast<int64_t>(data.dims.size())) {
+        error(node, "axis out of range");
+        setOutput(node, 0, out);
+        return;
+    }
+    out.rankKnown = true;
+
+    if (node.opType == "GatherElements") {
+        out.dims = indices.dims;
+        out.batchAxis = indices.batchAxis >= 0 ? indices.batchAxis : (data.batchAxis != axis ? data.batchAxis : -1);
+        setOutput(node, 0, out);
+        return;
+    }
+
+    out.dims.assign(data.dims.begin(), data.dims.begin() + axis);
+    out.dims.insert(out.dims.end(), indices.dims.begin(), indices.dims.end());
+    out.dims.insert(out.dims.end(), data.dims.begin() + axis + 1, data.dims.end());
+    if (data.batchAxis >= 0 && data.batchAxis < axis) {
+        out.batchAxis = data.batchAxis;
+    } else if (data.batchAxis > axis) {
+        out.batchAxis = data.batchAxis + static_cast<int>(indices.dims.size()) - 1;
+    } else if (indices.batchAxis >= 0) {
+        out.batchAxis = static_cast<int>(axis) + indices.batchAxis;
+    }
+
+    if (data.hasValue && data.dims.size() == 1 && indices.hasValue) {
+        out.hasValue = true;
+        int64_t n = static_cast<int64_t>(data.value.size());
+        for (size_t i = 0; i < indices.value.size(); ++i) {
+            int64_t idx = indices.value[i] < 0 ? indices.value[i] + n : indices.value[i];
+            if (idx < 0 || idx >= n) {
+                error(node, "index " + std::to_string(indices.value[i]) + " out of range");
+                out.hasValue = false;
+                break;
+            }
+            out.value.push_back(data.value[idx]);
+            if (idx == data.valueBatchIndex && out.valueBatchIndex < 0) out.valueBatchIndex = static_cast<int>(i);
+        }
+    }
+    setOutput(node, 0, out);
+}
+
+void OnnxShapeInference::inferShape(const OnnxNode& node) {
+    const OnnxShapeInfo& x = in(node, 0);
+    OnnxShapeInfo out;
+    out.elemType = static_cast<int32_t>(OnnxDataType::INT64);
+    out.rankKnown = true;
+    if (node.opType == "Size") {
+        int64_t n = x.numElements();
+        if (n >= 0) {
+            out.hasValue = true;
+            out.value = {n};
+        }
+        setOutput(node, 0, out);
+        return;
+    }
+    if (!x.rankKnown) {
+        out.rankKnown = false;
+        setOutput(node, 0, out);
+        return;
+    }
+    int64_t rank = static_cast<int64_t>(x.dims.size());
+    int64_t start = node.attrInt("start", 0);
+    int64_t end = node.attrInt("end", rank);
+    start = std::clamp<int64_t>(start < 0 ? start + rank : start, 0, rank);
+    end = std::clamp<int64_t>(end < 0 ? end + rank : end, 0, rank);
+    int64_t length = std::max<int64_t>(0, end - start);
+    out.dims = {length};
+    out.hasValue = true;
+    for (int64_t i = start; i < start + length; ++i) {
+        if (x.dims[i] < 0) out.hasValue = false;
+        out.value.push_back(x.dims[i]);
+        if (i == x.batchAxis) out.valueBatchIndex = static_cast<int>(i - start);
+    }
+    setOutput(node, 0, out);
+}
+
+void OnnxShapeInference::inferConstant(const OnnxNode& node) {
+    OnnxShapeInfo out;
+    if (node.opType == "ConstantOfShape") {
+        const OnnxShapeInfo& shape = in(node, 0);
+        out.elemType = static_cast<int32_t>(OnnxDataType::FLOAT);
+        const OnnxAttribute* value = node.attr("value");
+        if (value) out.elemType = value->t.dataType;
+        if (shape.hasValue) {
+            out.rankKnown = true;
+            out.dims = shape.value;
+            if (shape.valueBatchIndex >= 0) out.batchAxis = shape.valueBatchIndex;
+            int64_t n = out.numElements();
+            if (isIntegerType(out.elemType) && n >= 0 && n <= kMaxFoldedElements) {
+                std::vector<int64_t> fill = value ? value->t.toInt64s() : std::vector<int64_t>{};
+                out.hasValue = true;
+                out.value.assign(static_cast<size_t>(n), fill.empty() ? 0 : fill[0]);
+            }
+        } else if (shape.rankKnown && shape.dims.size() == 1 && shape.dims[0] >= 0) {
+            out.rankKnown = true;
+            out.dims.assign(static_cast<size_t>(shape.dims[0]), -1);
+        }
+        setOutput(node, 0, out);
+        return;
+    }
+
+    if (const OnnxAttribute* value = node.attr("value")) {
+        out = fromTensor(value->t);
+    } else if (const OnnxAttribute* v = node.attr("value_int")) {
+        out.rankKnown = true;
+        out.elemType = static_cast<int32_t>(OnnxDataType::INT64);
+        out.hasValue = true;
+        out.value = {v->i};
+    } else if (const OnnxAttribute* vs = node.attr("value_ints")) {
+        out.rankKnown = true;
+        out.elemType = static_cast<int32_t>(OnnxDataType::INT64);
+        out.dims = {static_cast<int64_t>(vs->ints.size())};
+        out.hasValue = true;
+        out.value = vs->ints;
+    } else if (node.attr("value_float")) {
+        out.rankKnown = true;
+        out.elemType = static_cast<int32_t>(OnnxDataType::FLOAT);
+    } else if (const OnnxAttribute* fs = node.attr("value_floats")) {
+        out.rankKnown = true;
+        out.elemType = static_cast<int32_t>(OnnxDataType::FLOAT);
+        out.dims = {static_cast<int64_t>(fs->floats.size())};
+    }
+    setOutput(node, 0, out);
+}
+
+void OnnxShapeInference::inferMatMul(const OnnxNode& node) {
+    const OnnxShapeInfo& a = in(node, 0);
+    const OnnxShapeInfo& b = in(node, 1);
+    OnnxShapeInfo out;
+    out.elemType = node.opType == "MatMulInteger" ? static_cast<int32_t>(OnnxDataType::INT32) : a.elemType;
+    if (!a.rankKnown || !b.rankKnown || a.dims.empty() || b.dims.empty()) {
+        setOutput(node, 0, out);
+        return;
+    }
+    Dims da = a.dims;
+    Dims db = b.dims;
+    bool vecA = da.size() == 1;
+    bool vecB = db.size() == 1;
+    if (vecA) da.insert(da.begin(), 1);
+    if (vecB) db.push_back(1);
+    int64_t k1 = da[da.size() - 1];
+    int64_t k2 = db[db.size() - 2];
+    if (k1 >= 0 && k2 >= 0 && k1 != k2) {
+        error(node, "inner dimensions differ: " + a.toString() + " x " + b.toString());
+    }
+    Dims batchA(da.begin(), da.end() - 2);
+    Dims batchB(db.begin(), db.end() - 2);
+    Dims batch;
+    if (!broadcastDims(batchA, batchB, batch)) {
+        error(node, "cannot broadcast batch dimensions " + a.toString() + " x " + b.toString());
+        setOutput(node, 0, out);
+        return;
+    }
+    out.rankKnown = true;
+    out.dims = batch;
+    if (!vecA) out.dims.push_back(da[da.size() - 2]);
+    if (!vecB) out.dims.push_back(db[db.size() - 1]);
+
+    int rankA = static_cast<int>(a.dims.size());
+    if (a.batchAxis >= 0 && a.batchAxis < rankA - 1) {
+        out.batchAxis = a.batchAxis + static_cast<int>(batch.size()) - static_cast<int>(batchA.size());
+    } else if (b.batchAxis >= 0 && b.batchAxis < static_cast<int>(b.dims.size()) - 2) {
+        out.batchAxis = b.batchAxis + static_cast<int>(batch.size()) - static_cast<int>(batchB.size());
+    }
+    setOutput(node, 0, out);
+}
+
+void OnnxShapeInference::inferGemm(const OnnxNode& node) {
+    const OnnxShapeInfo& a = in(node, 0);
+    const OnnxShapeInfo& b = in(node, 1);
+    OnnxShapeInfo out;
+    out.elemType = a.elemType;
+    if (!a.rankKnown || !b.rankKnown || a.dims.size() != 2 || b.dims.size() != 2) {
+        setOutput(node, 0, out);
+        return;
+    }
+    bool transA = node.attrInt("transA", 0) != 0;
+    bool transB = node.attrInt("transB", 0) != 0;
+    int64_t m = transA ? a.dims[1] : a.dims[0];
+    int64_t k1 = transA ? a.dims[0] : a.dims[1];
+    int64_t k2 = transB ? b.dims[1] : b.dims[0];
+    int64_t n = transB ? b.dims[0] : b.dims[1];
+    if (k1 >= 0 && k2 >= 0 && k1 != k2) {
+        error(node, "inner dimensions differ: " + a.toString() + " x " + b.toString());
+    }
+    out.rankKnown = true;
+    out.dims = {m, n};
+    if (a.batchAxis == (transA ? 1 : 0)) out.batchAxis = 0;
+    setOutput(node, 0, out);
+}
+
+void OnnxShapeInference::inferReduce(const OnnxNode& node) {
+    const OnnxShapeInfo& x = in(node, 0);
+    OnnxShapeInfo out;
+    bool argReduce = node.opType == "ArgMax" || node.opType == "ArgMin";
+    out.elemType = argReduce ? static_cast<int32_t>(OnnxDataType::INT64) : x.elemType;
+    if (!x.rankKnown) {
+        setOutput(node, 0, out);
+        return;
+    }
+    bool keepDims = node.attrInt("keepdims", 1) != 0;
+    Dims axes;
+    bool present = false;
+    bool known = true;
+    if (argReduce) {
+        axes = {node.attrInt("axis", 0)};
+        present = true;
+    } else {
+        known = axesFrom(node, "axes", 1, axes, present);
+    }
+    if (!known) {
+        out.rankKnown = keepDims;
+        if (keepDims) out.dims.assign(x.dims.size(), -1);
+        setOutput(node, 0, out);
+        return;
+    }
+    if (!present || axes.empty()) {
+        if (node.attrInt("noop_with_empty_axes", 0) != 0) {
+            out = x;
+            out.hasValue = false;
+            setOutput(node, 0, out);
+            return;
+        }
+        axes.clear();
+        for (size_t i = 0; i < x.dims.size(); ++i) axes.push_back(static_cast<int64_t>(i));
+    }
+    for (auto& a : axes) a = normalizeAxis(a, x.dims.size());
+    out.rankKnown = true;
+    for (size_t i = 0; i < x.dims.size(); ++i) {
+        bool reduced = std::find(axes.begin(), axes.end(), static_cast<int64_t>(i)) != axes.end();
+        if (reduced && !keepDims) continue;
+        if (static_cast<int>(i) == x.batchAxis && !reduced) out.batchAxis = static_cast<int>(out.dims.size());
+        out.dims.push_back(reduced ? 1 : x.dims[i]);
+    }
+    setOutput(node, 0, out);
+}
+
+void OnnxShapeInference::inferPad(const OnnxNode& node) {
+    const OnnxShapeInfo& x = in(node, 0);
+    OnnxShapeInfo out;
+    out.elemType = x.elemType;
+    if (!x.rankKnown) {
+        setOutput(node, 0, out);
+        return;
+    }
+    out.rankKnown = true;
+    out.dims = x.dims;
+    out.batchAxis = x.batchAxis;
+    Dims pads = node.attrInts("pads");
+    bool known = true;
+    if (m_opset >= 11) {
+        known = in(node, 1).hasValue;
+        pads = in(node, 1).value;
+    }
+    Dims axes;
+    if (hasInput(node, 3)) {
+        known = known && in(node, 3).hasValue;
+        axes = in(node, 3).value;
+    }
+    if (axes.empty()) {
+        for (size_t i = 0; i < x.dims.size(); ++i) axes.push_back(static_cast<int64_t>(i));
+    }
+    if (!known || pads.size() != 2 * axes.size()) {
+        std::fill(out.dims.begin(), out.dims.end(), -1);
+        setOutput(node, 0, out);
+        return;
+    }
+    for (size_t i = 0; i < axes.size(); ++i) {
+        int64_t axis = normalizeAxis(axes[i], x.dims.size());
+        if (axis < 0 || axis >= static_cast<int64_t>(x.dims.size())) continue;
+        if (out.dims[axis] >= 0) out.dims[axis] += pads[i] + pads[i + axes.size()];
+        if (axis == x.batchAxis && (pads[i] != 0 || pads[i + axes.size()] != 0)) out.batchAxis = -1;
+    }
+    setOutput(node, 0, out);
+}
+
+void OnnxShapeInference::inferTile(const OnnxNode& node) {
+    const OnnxShapeInfo& x = in(node, 0);
+    const OnnxShapeInfo& repeats = in(node, 1);
+    OnnxShapeInfo out;
+    out.elemType = x.elemType;
+    if (!x.rankKnown) {
+        setOutput(node, 0, out);
+        return;
+    }
+    out.rankKnown = true;
+    out.dims.assign(x.dims.size(), -1);
+    if (repeats.hasValue && repeats.value.size() == x.dims.size()) {
+        for (size_t i = 0; i < x.dims.size(); ++i) {
+            out.dims[i] = x.dims[i] < 0 ? -1 : x.dims[i] * repeats.value[i];
+        }
+        if (x.batchAxis >= 0 && repeats.value[x.batchAxis] == 1) out.batchAxis = x.batchAxis;
+        if (repeats.valueBatchIndex >= 0 && x.dims[repeats.valueBatchIndex] == 1) {
+            out.batchAxis = repeats.valueBatchIndex;
+        }
+    }
+    setOutput(node, 0, out);
+}
+
+void OnnxShapeInference::inferRange(const OnnxNode& node) {
+    const OnnxShapeInfo& start = in(node, 0);
+    const OnnxShapeInfo& limit = in(node, 1);
+    const OnnxShapeInfo& delta = in(node, 2);
+    OnnxShapeInfo out;
+    out.elemType = start.elemType;
+    out.rankKnown = true;
+    out.dims = {-1};
+    if (start.hasValue && limit.hasValue && delta.hasValue && delta.value[0] != 0) {
+        int64_t s = start.value[0];
+        int64_t l = limit.value[0];
+        int64_t d = delta.value[0];
+        int64_t n = std::max<int64_t>(0, d > 0 ? (l - s + d - 1) / d : (s - l + (-d) - 1) / (-d));
+        out.dims = {n};
+        if (n <= kMaxFoldedElements) {
+            out.hasValue = true;
+            for (int64_t i = 0; i < n; ++i) out.value.push_back(s + i * d);
+        }
+    }
+    setOutput(node, 0, out);
+}
+
+void OnnxShapeInference::inferTopK(const OnnxNode& node) {
+    const OnnxShapeInfo& x = in(node, 0);
+    OnnxShapeInfo out;
+    out.elemType = x.elemType;
+    if (x.rankKnown) {
+        out.rankKnown = true;
+        out.dims = x.dims;
+        int64_t axis = normalizeAxis(node.attrInt("axis", -1), x.dims.size());
+        int64_t k = node.attrInt("k", -1);
+        if (m_opset >= 10) k = in(node, 1).hasValue ? in(node, 1).value[0] : -1;
+        if (axis >= 0 && axis < static_cast<int64_t>(out.dims.size())) out.dims[axis] = k;
+        out.batchAxis = x.batchAxis == axis ? -1 : x.batchAxis;
+    }
+    setOutput(node, 0, out);
+    OnnxShapeInfo indices = out;
+    indices.elemType = static_cast<int32_t>(OnnxDataType::INT64);
+    setOutput(node, 1, indices);
+}
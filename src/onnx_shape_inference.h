@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include "onnx_model.h"
+
+// Shape facts for one tensor
+struct OnnxShapeInfo {
+    bool rankKnown = false;
+    std::vector<int64_t> dims;          // -1 marks an unknown extent
+    int32_t elemType = 0;
+    int batchAxis = -1;                 // axis carrying the graph batch dimension, -1 if none
+    bool hasValue = false;              // small integer contents folded at inference time
+    std::vector<int64_t> value;
+    int valueBatchIndex = -1;           // element of `value` that equals the batch size, -1 if none
+
+    int64_t numElements() const;        // -1 if any extent is unknown
+    std::string toString() const;       // e.g. "[N=2,3,640,640]"
+};
+
+// Static CPU shape inference over a decoded ONNX graph.
+//
+// Besides dims, it folds small integer tensors (Shape -> Gather -> Concat
+// chains that feed Reshape/Expand) and tracks which axis of every tensor
+// is derived from the graph's batch dimension. Inconsistencies such as a
+// Reshape whose element count does not match are reported as errors, so the
+// pass doubles as a CPU check of a graph at a given batch size.
+class OnnxShapeInference {
+public:
+    explicit OnnxShapeInference(const OnnxModel& model);
+
+    // Extent substituted for symbolic leading dimensions of graph inputs
+    void setBatchSize(int64_t batch) { m_batchSize = batch; }
+    // Overrides the declared dims of a graph input
+    void setInputShape(const std::string& name, const std::vector<int64_t>& dims);
+
+    // Returns false if any inconsistency was found (see errors())
+    bool run();
+
+    const OnnxShapeInfo* find(const std::string& tensorName) const;
+    const std::vector<std::string>& errors() const { return m_errors; }
+    const std::vector<std::string>& warnings() const { return m_warnings; }
+
+    // Folded contents of a constant float tensor (initializer or Constant node)
+    bool constantFloats(const std::string& tensorName, std::vector<float>& values) const;
+
+private:
+    const OnnxModel& m_model;
+    int64_t m_opset;
+    int64_t m_batchSize = 1;
+    std::unordered_map<std::string, std::vector<int64_t>> m_inputOverrides;
+    std::unordered_map<std::string, OnnxShapeInfo> m_infos;
+    std::unordered_map<std::string, const OnnxTensor*> m_constants;
+    std::unordered_set<std::string> m_warnedOps;
+    std::vector<std::string> m_errors;
+    std::vector<std::string> m_warnings;
+
+    const OnnxShapeInfo& in(const OnnxNode& node, size_t index) const;
+    bool hasInput(const OnnxNode& node, size_t index) const;
+    void setOutput(const OnnxNode& node, size_t index, OnnxShapeInfo info);
+    void error(const OnnxNode& node, const std::string& message);
+    void warn(const OnnxNode& node, const std::string& message);
+
+    void inferNode(const OnnxNode& node);
+    void inferElementwise(const OnnxNode& node);
+    void inferBroadcast(const OnnxNode& node);
+    void inferConvPool(const OnnxNode& node);
+    void inferResize(const OnnxNode& node);
+    void inferConcat(const OnnxNode& node);
+    void inferSplit(const OnnxNode& node);
+    void inferSlice(const OnnxNode& node);
+    void inferReshape(const OnnxNode& node);
+    void inferExpand(const OnnxNode& node);
+    void inferTranspose(const OnnxNode& node);
+    void inferFlatten(const OnnxNode& node);
+    void inferSqueeze(const OnnxNode& node, bool unsqueeze);
+    void inferGather(const OnnxNode& node);
+    void inferShape(const OnnxNode& node);
+    void inferConstant(const OnnxNode& node);
+    void inferMatMul(const OnnxNode& node);
+    void inferGemm(const OnnxNode& node);
+    void inferReduce(const OnnxNode& node);
+    void inferPad(const OnnxNode& node);
+    void inferTile(const OnnxNode& node);
+    void inferRange(const OnnxNode& node);
+    void inferTopK(const OnnxNode& node);
+
+    // Axes given either as an attribute (older opsets) or as an input
+    bool axesFrom(const OnnxNode& node, const std::string& attrName, size_t inputIndex,
+                  std::vector<int64_t>& axes, bool& present) const;
+};
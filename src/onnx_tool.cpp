@@ -0,0 +1,221 @@
+// onnx_tool: CPU-only ONNX graph utilities (no TensorRT or CUDA required)
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "onnx_model.h"
+#include "dynamic_batch.h"
+#include "qdq_inserter.h"
+
+namespace {
+
+void printUsage(const std::string& program_name) {
+    std::cout << "Usage: " << program_name << " <command> [arguments]\n\n";
+    std::cout << "Commands:\n";
+    std::cout << "  dynamic-batch <in.onnx> <out.onnx> [options]\n";
+    std::cout << "                                Turn the leading dimension of a batch-1 export into a\n";
+    std::cout << "                                symbolic batch and regenerate dependent constants\n";
+    std::cout << "      --batch-name <name>       Symbolic dimension name (default: batch)\n";
+    std::cout << "      --check <b1,b2,...>       Batch sizes to verify (default: 1,2,8)\n";
+    std::cout << "  check-batch <model.onnx> [--check <b1,b2,...>]\n";
+    std::cout << "                                CPU shape check of a dynamic-batch model\n";
+    std::cout << "  quantize <in.onnx> <out.onnx> --cache <calib.cache> [options]\n";
+    std::cout << "                                Insert QuantizeLinear/DequantizeLinear pairs for an\n";
+    std::cout << "                                explicitly quantized (Assume QAT) build\n";
+    std::cout << "      --cache <path>            TensorRT calibration cache with activation scales\n";
+    std::cout << "      --fp8                     FP8 (E4M3) instead of INT8, needs opset 19\n";
+    std::cout << "      --per-tensor              Per-tensor weight scales (default: per-channel)\n";
+    std::cout << "      --ops <A,B,...>           Op types to quantize (default: Conv,ConvTranspose,Gemm,MatMul)\n";
+    std::cout << "      --exclude <n1,n2,...>     Node names to keep in float\n\n";
+    std::cout << "Examples:\n";
+    std::cout << "  " << program_name << " dynamic-batch yolo.onnx yolo_dynamic.onnx --check 1,4,16\n";
+    std::cout << "  " << program_name << " check-batch yolo_dynamic.onnx\n";
+    std::cout << "  " << program_name << " quantize yolo.onnx yolo_qdq.onnx --cache calib.cache --exclude /model.0/conv/Conv\n";
+}
+
+bool parseBatchList(const std::string& text, std::vector<int64_t>& values) {
+    values.clear();
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        try {
+            long long value = std::stoll(item);
+            if (value < 1) return false;
+            values.push_back(value);
+        } catch (...) {
+            return false;
+        }
+    }
+    return !values.empty();
+}
+
+std::vector<std::string> splitList(const std::string& text) {
+    std::vector<std::string> items;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+// Removes a "--flag" from args, returns whether it was present
+bool takeFlag(std::vector<std::string>& args, const std::string& name) {
+    for (size_t i = 0; i < args.size(); ++i) {
+        if (args[i] == name) {
+            args.erase(args.begin() + static_cast<std::ptrdiff_t>(i));
+            return true;
+        }
+    }
+    return false;
+}
+
+// Pulls "--name value" out of args; returns false if the value is missing
+bool takeOption(std::vector<std::string>& args, const std::string& name, std::string& value) {
+    for (size_t i = 0; i < args.size(); ++i) {
+        if (args[i] != name) continue;
+        if (i + 1 >= args.size()) {
+            std::cerr << "Error: Missing value for " << name << "\n";
+            return false;
+        }
+        value = args[i + 1];
+        args.erase(args.begin() + static_cast<std::ptrdiff_t>(i), args.begin() + static_cast<std::ptrdiff_t>(i) + 2);
+        return true;
+    }
+    return true;
+}
+
+int runDynamicBatch(std::vector<std::string> args) {
+    DynamicBatchOptions options;
+    std::string checkList;
+    if (!takeOption(args, "--batch-name", options.batchParam) || !takeOption(args, "--check", checkList)) {
+        return 1;
+    }
+    if (!checkList.empty() && !parseBatchList(checkList, options.checkBatchSizes)) {
+        std::cerr << "Error: Invalid batch list: " << checkList << "\n";
+        return 1;
+    }
+    if (args.size() != 2) {
+        std::cerr << "Error: dynamic-batch expects <in.onnx> <out.onnx>\n";
+        return 1;
+    }
+
+    OnnxModel model;
+    if (!model.loadFromFile(args[0])) return 1;
+
+    DynamicBatchReport report;
+    bool ok = DynamicBatchConverter::convert(model, options, report);
+    for (const auto& name : report.inputsChanged) {
+        std::cout << "  Input '" << name << "': leading dimension -> " << options.batchParam << "\n";
+    }
+    std::cout << "  Reshape targets rewritten: " << report.reshapesRewritten << "\n";
+    std::cout << "  Expand nodes inserted: " << report.expandsInserted
+              << ", regenerated: " << report.expandsRewritten << "\n";
+    for (const auto& w : report.warnings) std::cout << "  Warning: " << w << "\n";
+    if (!ok) {
+        for (const auto& e : report.errors) std::cerr << "Error: " << e << "\n";
+        std::cerr << "Error: Dynamic-batch conversion failed, nothing written\n";
+        return 1;
+    }
+
+    if (!model.saveToFile(args[1])) return 1;
+    std::cout << "Saved: " << args[1] << "\n";
+    return 0;
+}
+
+int runCheckBatch(std::vector<std::string> args) {
+    std::vector<int64_t> batches = DynamicBatchOptions().checkBatchSizes;
+    std::string checkList;
+    if (!takeOption(args, "--check", checkList)) return 1;
+    if (!checkList.empty() && !parseBatchList(checkList, batches)) {
+        std::cerr << "Error: Invalid batch list: " << checkList << "\n";
+        return 1;
+    }
+    if (args.size() != 1) {
+        std::cerr << "Error: check-batch expects <model.onnx>\n";
+        return 1;
+    }
+
+    OnnxModel model;
+    if (!model.loadFromFile(args[0])) return 1;
+
+    std::vector<std::string> errors;
+    if (!DynamicBatchConverter::verify(model, batches, errors)) {
+        for (const auto& e : errors) std::cerr << "Error: " << e << "\n";
+        return 1;
+    }
+    std::cout << "Shape check passed for batch sizes:";
+    for (int64_t b : batches) std::cout << " " << b;
+    std::cout << "\n";
+    return 0;
+}
+
+int runQuantize(std::vector<std::string> args) {
+    QdqOptions options;
+    std::string cachePath, ops, exclude;
+    if (!takeOption(args, "--cache", cachePath) || !takeOption(args, "--ops", ops) ||
+        !takeOption(args, "--exclude", exclude)) {
+        return 1;
+    }
+    if (takeFlag(args, "--fp8")) options.format = QdqFormat::FP8;
+    if (takeFlag(args, "--per-tensor")) options.perChannelWeights = false;
+    if (!ops.empty()) {
+        options.opTypes.clear();
+        for (const auto& op : splitList(ops)) options.opTypes.insert(op);
+    }
+    for (const auto& name : splitList(exclude)) options.excludeNodes.insert(name);
+    if (args.size() != 2 || cachePath.empty()) {
+        std::cerr << "Error: quantize expects <in.onnx> <out.onnx> --cache <calib.cache>\n";
+        return 1;
+    }
+
+    CalibrationCache cache;
+    if (!cache.loadFromFile(cachePath)) return 1;
+    OnnxModel model;
+    if (!model.loadFromFile(args[0])) return 1;
+
+    QdqReport report;
+    bool ok = QdqInserter::insert(model, cache, options, report);
+    for (const auto& w : report.warnings) std::cout << "  Warning: " << w << "\n";
+    if (!ok) {
+        std::cerr << "Error: Q/DQ insertion failed, nothing written\n";
+        return 1;
+    }
+    std::cout << "  Format: " << (options.format == QdqFormat::FP8 ? "FP8 (E4M3)" : "INT8") << ", weights "
+              << (options.perChannelWeights ? "per-channel" : "per-tensor") << "\n";
+    std::cout << "  Nodes quantized: " << report.nodesQuantized << " (" << report.activationPairs
+              << " activation / " << report.weightPairs << " weight Q/DQ pairs)\n";
+    if (!report.skipped.empty()) {
+        std::cout << "  Left in float: " << report.skipped.size() << "\n";
+        for (const auto& s : report.skipped) std::cout << "    " << s << "\n";
+    }
+
+    if (!model.saveToFile(args[1])) return 1;
+    std::cout << "Saved: " << args[1] << "\n";
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> args(argv, argv + argc);
+    if (argc < 2 || args[1] == "--help" || args[1] == "-h") {
+        printUsage(args[0]);
+        return argc < 2 ? 1 : 0;
+    }
+
+    std::string command = args[1];
+    std::vector<std::string> rest(args.begin() + 2, args.end());
+    try {
+        if (command == "dynamic-batch") return runDynamicBatch(rest);
+        if (command == "check-batch") return runCheckBatch(rest);
+        if (command == "quantize") return runQuantize(rest);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    std::cerr << "Error: Unknown command: " << command << "\n";
+    printUsage(args[0]);
+    return 1;
+}
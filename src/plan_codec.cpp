@@ -0,0 +1,236 @@
+#include "plan_codec.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+namespace {
+
+const size_t kFrameHeaderSize = 8;
+const uint32_t kStoredFlag = 0x80000000u;
+const size_t kMinMatch = 4;
+const size_t kLastLiterals = 5;       // a block always ends with at least this many literals
+const size_t kMatchFindLimit = 12;    // and no match starts closer than this to its end
+const size_t kMaxOffset = 65535;
+const int kHashLog = 16;
+const size_t kWildCopy = 16;
+
+uint32_t read32(const unsigned char* data) {
+    uint32_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+void appendU32(std::string& out, uint32_t value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+uint32_t hash4(uint32_t sequence) {
+    return (sequence * 2654435761u) >> (32 - kHashLog);
+}
+
+// Lengths of 15 and up continue in bytes of 255 after the token nibble
+void appendLength(std::string& out, size_t length) {
+    for (length -= 15; length >= 255; length -= 255) out.push_back(static_cast<char>(255));
+    out.push_back(static_cast<char>(length));
+}
+
+// matchLength 0 is the closing literals-only sequence
+void appendSequence(std::string& out, const unsigned char* literals, size_t literalCount,
+                    size_t offset, size_t matchLength) {
+    size_t matchCode = matchLength ? matchLength - kMinMatch : 0;
+    out.push_back(static_cast<char>((std::min<size_t>(literalCount, 15) << 4) | std::min<size_t>(matchCode, 15)));
+    if (literalCount >= 15) appendLength(out, literalCount);
+    out.append(reinterpret_cast<const char*>(literals), literalCount);
+    if (!matchLength) return;
+    out.push_back(static_cast<char>(offset & 0xFF));
+    out.push_back(static_cast<char>(offset >> 8));
+    if (matchCode >= 15) appendLength(out, matchCode);
+}
+
+bool readLength(const unsigned char* src, size_t size, size_t& pos, size_t& length) {
+    unsigned char byte = 0;
+    do {
+        if (pos >= size) return false;
+        byte = src[pos++];
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+bool decompressBlock(const unsigned char* src, size_t size, unsigned char* dst, size_t dstSize) {
+    size_t in = 0;
+    size_t out = 0;
+    while (in < size) {
+        unsigned token = src[in++];
+        size_t literalCount = token >> 4;
+        if (literalCount == 15 && !readLength(src, size, in, literalCount)) return false;
+        if (literalCount > size - in || literalCount > dstSize - out) return false;
+        if (literalCount <= kWildCopy && size - in >= kWildCopy && dstSize - out >= kWildCopy) {
+            std::memcpy(dst + out, src + in, kWildCopy);    // fixed size compiles to two moves
+        } else {
+            std::memcpy(dst + out, src + in, literalCount);
+        }
+        in += literalCount;
+        out += literalCount;
+        if (in == size) break;    // closing sequence has no match
+
+        if (size - in < 2) return false;
+        size_t offset = src[in] | (static_cast<size_t>(src[in + 1]) << 8);
+        in += 2;
+        size_t matchLength = token & 15;
+        if (matchLength == 15 && !readLength(src, size, in, matchLength)) return false;
+        matchLength += kMinMatch;
+        if (offset == 0 || offset > out || matchLength > dstSize - out) return false;
+
+        unsigned char* target = dst + out;
+        if (offset >= kWildCopy && dstSize - out >= matchLength + kWildCopy) {
+            // Whole chunks may write past the match; later output overwrites that
+            for (size_t done = 0; done < matchLength; done += kWildCopy) {
+                std::memcpy(target + done, target - offset + done, kWildCopy);
+            }
+        } else if (offset >= matchLength) {
+            std::memcpy(target, target - offset, matchLength);
+        } else {
+            // Overlapping match: the output repeats the last `offset` bytes (runs of
+            // zeros, patterns). Lay down one period, then double what is written.
+            std::memcpy(target, target - offset, offset);
+            for (size_t done = offset; done < matchLength; done *= 2) {
+                std::memcpy(target + done, target, std::min(done, matchLength - done));
+            }
+        }
+        out += matchLength;
+    }
+    return out == dstSize;
+}
+
+struct Frame {
+    size_t input;        // data offset in the compressed stream
+    size_t storedSize;
+    size_t output;       // offset in the plan
+    size_t rawSize;
+    bool stored;
+};
+
+} // namespace
+
+void PlanCompressor::add(const void* data, size_t size, std::string& out) {
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        size_t take = std::min(size, kBlockSize - m_block.size());
+        m_block.append(bytes, take);
+        bytes += take;
+        size -= take;
+        if (m_block.size() == kBlockSize) {
+            compressBlock(reinterpret_cast<const unsigned char*>(m_block.data()), m_block.size(), out);
+            m_block.clear();
+        }
+    }
+}
+
+void PlanCompressor::finish(std::string& out) {
+    if (!m_block.empty()) {
+        compressBlock(reinterpret_cast<const unsigned char*>(m_block.data()), m_block.size(), out);
+        m_block.clear();
+    }
+}
+
+void PlanCompressor::compressBlock(const unsigned char* src, size_t size, std::string& out) {
+    size_t frameStart = out.size();
+    appendU32(out, static_cast<uint32_t>(size));
+    appendU32(out, 0);    // stored size, patched below
+    size_t dataStart = out.size();
+
+    // Greedy single-probe matcher; table entries are position + 1 so 0 means empty
+    m_hashTable.assign(size_t(1) << kHashLog, 0);
+    size_t anchor = 0;
+    size_t pos = 0;
+    if (size > kMatchFindLimit) {
+        size_t limit = size - kMatchFindLimit;
+        size_t matchEndLimit = size - kLastLiterals;
+        while (pos < limit) {
+            uint32_t sequence = read32(src + pos);
+            uint32_t& slot = m_hashTable[hash4(sequence)];
+            size_t candidate = slot;
+            slot = static_cast<uint32_t>(pos + 1);
+            if (candidate == 0 || pos - (candidate - 1) > kMaxOffset || read32(src + candidate - 1) != sequence) {
+                // Skip ahead faster the longer nothing matched (weights rarely do)
+                pos += 1 + ((pos - anchor) >> 6);
+                continue;
+            }
+            size_t match = candidate - 1;
+            size_t end = pos + kMinMatch;
+            while (end < matchEndLimit && src[end] == src[match + (end - pos)]) ++end;
+            while (pos > anchor && match > 0 && src[pos - 1] == src[match - 1]) {
+                --pos;
+                --match;
+            }
+            appendSequence(out, src + anchor, pos - anchor, pos - match, end - pos);
+            pos = end;
+            anchor = pos;
+        }
+    }
+    appendSequence(out, src + anchor, size - anchor, 0, 0);
+
+    uint32_t storedSize = static_cast<uint32_t>(out.size() - dataStart);
+    if (storedSize >= size) {
+        // Incompressible (most weights): store the block as is
+        out.resize(dataStart);
+        out.append(reinterpret_cast<const char*>(src), size);
+        storedSize = static_cast<uint32_t>(size) | kStoredFlag;
+    }
+    std::memcpy(&out[frameStart + 4], &storedSize, sizeof(storedSize));
+}
+
+bool PlanDecompressor::run(const void* data, size_t size, std::vector<char>& plan, unsigned threads) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+    // Frame offsets first, so every block knows where its output goes
+    std::vector<Frame> frames;
+    size_t input = 0;
+    size_t output = 0;
+    while (input < size) {
+        if (size - input < kFrameHeaderSize) {
+            std::cerr << "Error: Compressed plan is truncated\n";
+            return false;
+        }
+        uint32_t rawSize = read32(bytes + input);
+        uint32_t storedSize = read32(bytes + input + 4);
+        Frame frame{input + kFrameHeaderSize, storedSize & ~kStoredFlag, output, rawSize, (storedSize & kStoredFlag) != 0};
+        if (frame.storedSize > size - frame.input || (frame.stored && frame.storedSize != rawSize)) {
+            std::cerr << "Error: Compressed plan is truncated\n";
+            return false;
+        }
+        frames.push_back(frame);
+        input = frame.input + frame.storedSize;
+        output += rawSize;
+    }
+    plan.resize(output);
+
+    std::atomic<size_t> next{0};
+    std::atomic<bool> failed{false};
+    auto worker = [&]() {
+        for (size_t i = next++; i < frames.size() && !failed; i = next++) {
+            const Frame& frame = frames[i];
+            unsigned char* dst = reinterpret_cast<unsigned char*>(plan.data()) + frame.output;
+            if (frame.stored) {
+                std::memcpy(dst, bytes + frame.input, frame.rawSize);
+            } else if (!decompressBlock(bytes + frame.input, frame.storedSize, dst, frame.rawSize)) {
+                failed = true;
+            }
+        }
+    };
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<unsigned>(std::min<size_t>(threads, frames.size()));
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; ++t) pool.emplace_back(worker);
+    worker();
+    for (auto& thread : pool) thread.join();
+
+    if (failed) {
+        std::cerr << "Error: Compressed plan is damaged\n";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Compressed TensorRT plans (ExportConfig::compress_engine). The plan is cut
+// into fixed-size blocks, each compressed on its own with an LZ4-style block
+// codec (byte-aligned literals and matches, 64 KiB window), and stored as
+//
+//   uint32 raw size, uint32 stored size (top bit set: stored uncompressed), data
+//
+// one frame after another up to the end of the file. Independent blocks let
+// the loader decompress on every core straight into the buffer it hands to
+// deserializeCudaEngine, so a compressed engine loads about as fast as a raw one.
+class PlanCompressor {
+public:
+    static constexpr size_t kBlockSize = 4u << 20;
+
+    // Buffers plan bytes and appends a frame to out for every full block
+    void add(const void* data, size_t size, std::string& out);
+
+    // Frames whatever is buffered; call once after the last add()
+    void finish(std::string& out);
+
+private:
+    void compressBlock(const unsigned char* data, size_t size, std::string& out);
+
+    std::string m_block;
+    std::vector<uint32_t> m_hashTable;
+};
+
+class PlanDecompressor {
+public:
+    // Decodes all frames into plan on up to `threads` threads (0 = one per core);
+    // prints an error and returns false if a frame is damaged
+    static bool run(const void* data, size_t size, std::vector<char>& plan, unsigned threads = 0);
+};
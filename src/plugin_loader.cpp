@@ -0,0 +1,201 @@
+#include "plugin_loader.h"
+#include "logger.h"
+#include "onnx_model.h"
+#include <NvInferPlugin.h>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Registry state shared by every export in the process. Libraries are never
+// unloaded: engines built or deserialized later may still use their creators.
+std::mutex g_mutex;
+bool g_builtInsLoaded = false;
+std::map<std::string, int> g_libraries;    // canonical path -> creators it registered
+
+// The plugin library keeps the logger it was initialized with
+TensorRTLogger& pluginLogger() {
+    static TensorRTLogger logger;
+    return logger;
+}
+
+int32_t registeredCreators() {
+    int32_t count = 0;
+    getPluginRegistry()->getAllCreators(&count);
+    return count;
+}
+
+#ifdef _WIN32
+void* openLibrary(const std::string& path, std::string& error) {
+    HMODULE module = LoadLibraryA(path.c_str());
+    if (!module) error = "error code " + std::to_string(GetLastError());
+    return module;
+}
+
+bool hasSymbol(void* library, const char* name) {
+    return GetProcAddress(static_cast<HMODULE>(library), name) != nullptr;
+}
+#else
+void* openLibrary(const std::string& path, std::string& error) {
+    // RTLD_NOW: an unresolved dependency fails here, not at the first plugin call
+    void* library = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!library) error = dlerror();
+    return library;
+}
+
+bool hasSymbol(void* library, const char* name) {
+    return dlsym(library, name) != nullptr;
+}
+#endif
+
+bool loadLibrary(const std::string& path) {
+    std::error_code ec;
+    if (!fs::is_regular_file(path, ec)) {
+        std::cerr << "Error: Plugin library not found: " << path << "\n";
+        return false;
+    }
+    std::string canonical = fs::canonical(path, ec).string();
+    if (ec) canonical = path;
+    auto cached = g_libraries.find(canonical);
+    if (cached != g_libraries.end()) {
+        std::cout << "  Plugin library: " << path << " (already loaded, " << cached->second << " creators)\n";
+        return true;
+    }
+
+    int32_t before = registeredCreators();
+    std::string error;
+    void* library = openLibrary(canonical, error);
+    if (!library) {
+        std::cerr << "Error: Cannot load plugin library " << path << ": " << error << "\n";
+        return false;
+    }
+
+    // Libraries built against the plugin library API export their creators and
+    // are registered through the registry; older ones register themselves
+    // (REGISTER_TENSORRT_PLUGIN) while being loaded. A library doing both has
+    // registered its creators already, and the registry would reject them again.
+    bool selfRegistered = registeredCreators() > before;
+    if (!selfRegistered && (hasSymbol(library, "getCreators") || hasSymbol(library, "getPluginCreators"))) {
+        if (!getPluginRegistry()->loadLibrary(canonical.c_str())) {
+            std::cerr << "Error: TensorRT rejected plugin library " << path
+                      << " (are its plugins already registered by another library?)\n";
+            return false;
+        }
+    }
+    int32_t added = registeredCreators() - before;
+    if (added <= 0) {
+        std::cerr << "Error: " << path << " is not a TensorRT plugin library: it exports neither "
+                  << "getCreators nor getPluginCreators and registered no plugin creators\n";
+        return false;
+    }
+
+    g_libraries[canonical] = added;
+    std::cout << "  Plugin library: " << path << " (" << added << " creators)\n";
+    return true;
+}
+
+// Default and ONNX-ML domains; anything else (com.microsoft, custom exporters) is not standard ONNX
+bool isOnnxDomain(const std::string& domain) {
+    return domain.empty() || domain == "ai.onnx" || domain == "ai.onnx.ml";
+}
+
+// nodes plus the nodes of every If/Loop/Scan body inside them, at any depth
+bool flattenNodes(const std::vector<OnnxNode>& nodes, std::vector<OnnxNode>& flat) {
+    for (const auto& node : nodes) {
+        flat.push_back(node);
+        std::vector<OnnxGraph> bodies;
+        if (!node.subgraphs(bodies, false)) return false;
+        for (const auto& body : bodies) {
+            if (!flattenNodes(body.nodes, flat)) return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+bool PluginLoader::load(const ExportConfig& config) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    pluginLogger().setVerbose(config.verbose);
+
+    if (!g_builtInsLoaded) {
+        if (!initLibNvInferPlugins(&pluginLogger(), "")) {
+            std::cerr << "Error: Failed to initialize the TensorRT plugin library\n";
+            return false;
+        }
+        g_builtInsLoaded = true;
+        std::cout << "  Built-in plugins: " << registeredCreators() << " creators registered\n";
+    }
+
+    // Sorted, so libraries that depend on each other load in the same order every run
+    std::set<std::string> libraries;
+    for (const auto& plugin : config.selected_plugins) {
+        if (!PluginManager::isBuiltInPlugin(plugin)) libraries.insert(plugin);
+    }
+    for (const auto& path : libraries) {
+        if (!loadLibrary(path)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool PluginLoader::checkGraph(const std::vector<OnnxNode>& topLevel, const nvonnxparser::IParser& parser) {
+    // Plugin ops inside If branches and Loop bodies are parsed like top-level ones
+    std::vector<OnnxNode> nodes;
+    if (!flattenNodes(topLevel, nodes)) {
+        std::cerr << "Error: Malformed subgraph in ONNX model\n";
+        return false;
+    }
+
+    // op -> node count, for ops the parser would hand to its plugin fallback
+    std::map<std::string, int> resolved;
+    std::map<std::string, int> unresolved;
+    std::map<std::string, int> shadowed;
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        for (const auto& node : nodes) {
+            std::string domain = isOnnxDomain(node.domain) ? "" : node.domain + ":";
+            // The parser dispatches on op type alone: a custom-domain op named like
+            // a standard one gets the standard importer, never a plugin
+            if (parser.supportsOperator(node.opType.c_str())) {
+                if (!domain.empty()) ++shadowed[domain + node.opType];
+                continue;
+            }
+            // The parser looks the creator up by op type, "plugin_version" and "plugin_namespace"
+            std::string version = node.attrString("plugin_version", "1");
+            std::string pluginNamespace = node.attrString("plugin_namespace", "");
+            std::string label = domain + node.opType + " v" + version;
+            if (!pluginNamespace.empty()) label = pluginNamespace + "::" + label;
+            if (getPluginRegistry()->getCreator(node.opType.c_str(), version.c_str(), pluginNamespace.c_str())) {
+                ++resolved[label];
+            } else {
+                ++unresolved[label];
+            }
+        }
+    }
+
+    for (const auto& op : resolved) {
+        std::cout << "  Plugin op: " << op.first << " (" << op.second << " nodes)\n";
+    }
+    for (const auto& op : shadowed) {
+        std::cerr << "Warning: ONNX op '" << op.first << "' (" << op.second << " nodes) is imported as the "
+                  << "built-in operator of the same name, not as a plugin\n";
+    }
+    for (const auto& op : unresolved) {
+        std::cerr << "Error: ONNX op '" << op.first << "' (" << op.second << " nodes) is neither a "
+                  << "built-in operator nor a registered plugin; load its library with --plugins <path>\n";
+    }
+    return unresolved.empty();
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <NvOnnxParser.h>
+#include <vector>
+#include "config.h"
+
+struct OnnxNode;
+
+// Makes the plugins in ExportConfig::selected_plugins available to the parser
+// and builder. The TensorRT plugin library is initialized once, and every custom
+// library is loaded once and kept for the life of the process, so later jobs
+// (matrix variants, GUI exports) find their creators already registered.
+class PluginLoader {
+public:
+    // Registers the built-in plugins and loads the custom plugin libraries of
+    // config; prints an error and returns false if a library is missing or
+    // exports no plugin creators. Thread-safe.
+    static bool load(const ExportConfig& config);
+
+    // Checks that every op the parser has no importer for, including those in
+    // If/Loop/Scan bodies, resolves to a registered plugin creator, so a missing
+    // plugin fails before the build and not deep inside the parser. Prints the
+    // unresolved ops, and warns about custom-domain ops that a built-in
+    // importer of the same name takes instead.
+    static bool checkGraph(const std::vector<OnnxNode>& nodes, const nvonnxparser::IParser& parser);
+};
@@ -0,0 +1,204 @@
+#include "precision_policy.h"
+#include "file_utils.h"
+#include <NvInfer.h>
+#include <iostream>
+
+namespace {
+
+const char* const kPrecisions[] = {"fp32", "fp16", "bf16", "int8", "fp8"};
+
+// Indexed by nvinfer1::LayerType
+const char* const kLayerTypeNames[] = {
+    "Convolution", "Cast", "Activation", "Pooling", "LRN", "Scale", "SoftMax", "Deconvolution",
+    "Concatenation", "ElementWise", "Plugin", "Unary", "Padding", "Shuffle", "Reduce", "TopK",
+    "Gather", "MatrixMultiply", "RaggedSoftMax", "Constant", "Identity", "PluginV2", "Slice", "Shape",
+    "ParametricReLU", "Resize", "TripLimit", "Recurrence", "Iterator", "LoopOutput", "Select", "Fill",
+    "Quantize", "Dequantize", "Condition", "ConditionalInput", "ConditionalOutput", "Scatter", "Einsum",
+    "Assertion", "OneHot", "NonZero", "GridSample", "NMS", "ReverseSequence", "Normalization", "PluginV3",
+    "Squeeze", "Unsqueeze", "Cumulative", "DynamicQuantize", "AttentionInput", "AttentionOutput",
+};
+
+std::string layerTypeName(nvinfer1::LayerType type) {
+    size_t index = static_cast<size_t>(type);
+    return index < sizeof(kLayerTypeNames) / sizeof(kLayerTypeNames[0]) ? kLayerTypeNames[index] : "Unknown";
+}
+
+nvinfer1::DataType dataType(const std::string& precision) {
+    if (precision == "fp16") return nvinfer1::DataType::kHALF;
+    if (precision == "bf16") return nvinfer1::DataType::kBF16;
+    if (precision == "int8") return nvinfer1::DataType::kINT8;
+    if (precision == "fp8") return nvinfer1::DataType::kFP8;
+    return nvinfer1::DataType::kFLOAT;
+}
+
+bool isFloat(nvinfer1::DataType type) {
+    return type == nvinfer1::DataType::kFLOAT || type == nvinfer1::DataType::kHALF ||
+           type == nvinfer1::DataType::kBF16;
+}
+
+std::string stringField(const JsonValue& object, const char* key) {
+    const JsonValue* value = object.find(key);
+    return value && value->isString() ? value->asString() : "";
+}
+
+} // namespace
+
+bool PrecisionPolicy::loadFromFile(const std::string& path) {
+    JsonValue json;
+    std::string error;
+    if (!JsonValue::parseFile(path, json, error) || !parse(json, error)) {
+        std::cerr << "Error: Cannot read precision policy " << path << ": " << error << "\n";
+        return false;
+    }
+    return true;
+}
+
+bool PrecisionPolicy::parse(const JsonValue& json, std::string& error) {
+    m_rules.clear();
+    m_constraints = "obey";
+    if (!json.isObject()) {
+        error = "expected an object with a \"rules\" array";
+        return false;
+    }
+    if (const JsonValue* constraints = json.find("constraints")) {
+        m_constraints = constraints->isString() ? constraints->asString() : "";
+        if (m_constraints != "obey" && m_constraints != "prefer") {
+            error = "constraints: expected \"obey\" or \"prefer\"";
+            return false;
+        }
+    }
+    const JsonValue* rules = json.find("rules");
+    if (!rules || !rules->isArray()) {
+        error = "expected a \"rules\" array";
+        return false;
+    }
+    for (size_t i = 0; i < rules->size(); ++i) {
+        const JsonValue& item = rules->at(i);
+        std::string where = "rules[" + std::to_string(i) + "]";
+        if (!item.isObject()) {
+            error = where + ": expected an object";
+            return false;
+        }
+        PrecisionRule rule;
+        rule.layer = stringField(item, "layer");
+        rule.op = stringField(item, "op");
+        rule.precision = stringField(item, "precision");
+        rule.output = stringField(item, "output");
+        if (rule.layer.empty() && rule.op.empty()) {
+            error = where + ": needs a \"layer\" or \"op\" pattern";
+            return false;
+        }
+        if (!isPrecision(rule.precision)) {
+            error = where + ": precision must be fp32, fp16, bf16, int8 or fp8";
+            return false;
+        }
+        if (!rule.output.empty() && !isPrecision(rule.output)) {
+            error = where + ": output must be fp32, fp16, bf16, int8 or fp8";
+            return false;
+        }
+        m_rules.push_back(rule);
+    }
+    return true;
+}
+
+JsonValue PrecisionPolicy::toJson() const {
+    JsonValue json = JsonValue::makeObject();
+    json.set("constraints", m_constraints);
+    JsonValue rules = JsonValue::makeArray();
+    for (const auto& rule : m_rules) {
+        JsonValue item = JsonValue::makeObject();
+        if (!rule.layer.empty()) item.set("layer", rule.layer);
+        if (!rule.op.empty()) item.set("op", rule.op);
+        item.set("precision", rule.precision);
+        if (!rule.output.empty()) item.set("output", rule.output);
+        rules.push(item);
+    }
+    json.set("rules", rules);
+    return json;
+}
+
+bool PrecisionPolicy::saveToFile(const std::string& path) const {
+    std::string text = toJson().dump(2) + "\n";
+    if (!writeFileAtomic(path, text.data(), text.size())) {
+        std::cerr << "Error: Cannot write precision policy: " << path << "\n";
+        return false;
+    }
+    return true;
+}
+
+void PrecisionPolicy::apply(nvinfer1::INetworkDefinition& network) {
+    for (auto& rule : m_rules) rule.matched = 0;
+
+    for (int32_t i = 0; i < network.getNbLayers(); ++i) {
+        nvinfer1::ILayer* layer = network.getLayer(i);
+        if (!adjustable(*layer)) continue;
+
+        std::string name = layer->getName() ? layer->getName() : "";
+        std::string typeName = layerTypeName(layer->getType());
+        for (auto& rule : m_rules) {
+            if (!rule.layer.empty() && !globMatch(rule.layer, name)) continue;
+            if (!rule.op.empty() && !globMatch(rule.op, typeName)) continue;
+            layer->setPrecision(dataType(rule.precision));
+            std::string output = rule.output;
+            if (output.empty() && rule.precision != "int8" && rule.precision != "fp8") output = rule.precision;
+            if (!output.empty()) {
+                for (int32_t j = 0; j < layer->getNbOutputs(); ++j) {
+                    if (isFloat(layer->getOutput(j)->getType())) layer->setOutputType(j, dataType(output));
+                }
+            }
+            ++rule.matched;
+            break;
+        }
+    }
+}
+
+bool PrecisionPolicy::adjustable(const nvinfer1::ILayer& layer) {
+    // Q/DQ layers carry the quantization itself; their types are not ours to change
+    nvinfer1::LayerType type = layer.getType();
+    if (type == nvinfer1::LayerType::kQUANTIZE || type == nvinfer1::LayerType::kDEQUANTIZE ||
+        type == nvinfer1::LayerType::kDYNAMIC_QUANTIZE) {
+        return false;
+    }
+    for (int32_t j = 0; j < layer.getNbOutputs(); ++j) {
+        if (isFloat(layer.getOutput(j)->getType())) return true;
+    }
+    return false;
+}
+
+bool PrecisionPolicy::uses(const std::string& precision) const {
+    for (const auto& rule : m_rules) {
+        if (rule.precision == precision || rule.output == precision) return true;
+    }
+    return false;
+}
+
+bool PrecisionPolicy::isPrecision(const std::string& name) {
+    for (const char* precision : kPrecisions) {
+        if (name == precision) return true;
+    }
+    return false;
+}
+
+bool PrecisionPolicy::globMatch(const std::string& pattern, const std::string& text) {
+    // Iterative wildcard match; backtracks only to the last '*'
+    size_t p = 0;
+    size_t t = 0;
+    size_t star = std::string::npos;
+    size_t resume = 0;
+    while (t < text.size()) {
+        if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == text[t])) {
+            ++p;
+            ++t;
+        } else if (p < pattern.size() && pattern[p] == '*') {
+            star = p++;
+            resume = t;
+        } else if (star != std::string::npos) {
+            p = star + 1;
+            t = ++resume;
+        } else {
+            return false;
+        }
+    }
+    while (p < pattern.size() && pattern[p] == '*') ++p;
+    return p == pattern.size();
+}
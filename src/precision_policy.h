@@ -0,0 +1,64 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "json.h"
+
+namespace nvinfer1 {
+class ILayer;
+class INetworkDefinition;
+}
+
+// One rule of a precision policy. A layer matches when its name matches `layer`
+// and its type name (e.g. "Convolution", "MatrixMultiply") matches `op`; an
+// empty pattern matches anything. Patterns are globs with '*' and '?'.
+struct PrecisionRule {
+    std::string layer;
+    std::string op;
+    std::string precision;    // fp32, fp16, bf16, int8 or fp8
+    std::string output;       // output tensor type; empty = precision for fp32/fp16/bf16, left to TensorRT otherwise
+    int matched = 0;          // layers this rule set, after apply()
+};
+
+// Per-layer precision policy (ExportConfig::precision_policy), a JSON file:
+//
+//   {
+//     "constraints": "obey",
+//     "rules": [
+//       {"layer": "/model.0/*", "precision": "fp32"},
+//       {"layer": "/model.22/*", "precision": "fp16"},
+//       {"op": "Convolution", "precision": "int8"}
+//     ]
+//   }
+//
+// Rules are tried in order and the first match wins. "constraints" is "obey"
+// (the build fails if a layer cannot run as asked) or "prefer" (TensorRT falls
+// back with a warning).
+class PrecisionPolicy {
+public:
+    bool loadFromFile(const std::string& path);
+    bool parse(const JsonValue& json, std::string& error);
+    JsonValue toJson() const;
+    bool saveToFile(const std::string& path) const;
+
+    // Sets the precision and output types of the matching adjustable layers
+    void apply(nvinfer1::INetworkDefinition& network);
+
+    // False for Q/DQ layers and layers without floating-point outputs (shapes,
+    // indices); policies leave those alone
+    static bool adjustable(const nvinfer1::ILayer& layer);
+
+    // True if some rule asks for this precision as layer or output type
+    bool uses(const std::string& precision) const;
+    bool obey() const { return m_constraints == "obey"; }
+
+    const std::vector<PrecisionRule>& rules() const { return m_rules; }
+    std::vector<PrecisionRule>& rules() { return m_rules; }
+
+    static bool isPrecision(const std::string& name);
+    static bool globMatch(const std::string& pattern, const std::string& text);
+
+private:
+    std::string m_constraints = "obey";
+    std::vector<PrecisionRule> m_rules;
+};
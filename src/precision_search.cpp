@@ -0,0 +1,242 @@
+#include "precision_search.h"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+
+bool DetectionLayout::fromMetadata(const JsonValue& postprocess, int64_t dim1, int64_t dim2, DetectionLayout& layout) {
+    if (!postprocess.isObject() || dim1 <= 0 || dim2 <= 0) return false;
+    auto number = [&postprocess](const char* key, double fallback) {
+        const JsonValue* value = postprocess.find(key);
+        return value && value->isNumber() ? value->asNumber() : fallback;
+    };
+    const JsonValue* type = postprocess.find("type");
+    layout = DetectionLayout();
+    layout.nms = type && type->isString() && type->asString() == "nms";
+    layout.anchorsLast = !layout.nms && number("anchor_axis", 1) == 2;
+    layout.anchors = static_cast<int>(layout.anchorsLast ? dim2 : dim1);
+    layout.values = static_cast<int>(layout.anchorsLast ? dim1 : dim2);
+    layout.scoreThreshold = static_cast<float>(number("score_threshold", EngineContainer::kScoreThreshold));
+    layout.iouThreshold = static_cast<float>(number("iou_threshold", EngineContainer::kIouThreshold));
+    if (layout.nms) return layout.values == 6;
+    layout.numClasses = std::min(layout.values - 4, static_cast<int>(number("num_classes", layout.values - 4)));
+    return layout.numClasses > 0;
+}
+
+FrameDetections decodeDetections(const float* output, const DetectionLayout& layout) {
+    auto value = [&](int i, int j) {
+        return layout.anchorsLast ? output[static_cast<size_t>(j) * layout.anchors + i]
+                                  : output[static_cast<size_t>(i) * layout.values + j];
+    };
+
+    FrameDetections boxes;
+    for (int i = 0; i < layout.anchors; ++i) {
+        if (layout.nms) {
+            float score = value(i, 4);
+            if (score <= layout.scoreThreshold) continue;
+            boxes.push_back({value(i, 0), value(i, 1), value(i, 2), value(i, 3), score, static_cast<int>(value(i, 5))});
+            continue;
+        }
+        float best = 0.0f;
+        int classId = 0;
+        for (int c = 0; c < layout.numClasses; ++c) {
+            if (value(i, 4 + c) > best) {
+                best = value(i, 4 + c);
+                classId = c;
+            }
+        }
+        if (best <= layout.scoreThreshold) continue;
+        float cx = value(i, 0), cy = value(i, 1), w = value(i, 2), h = value(i, 3);
+        boxes.push_back({cx - w / 2, cy - h / 2, cx + w / 2, cy + h / 2, best, classId});
+    }
+    if (layout.nms) return boxes;
+
+    // Class-wise NMS, highest score first
+    std::stable_sort(boxes.begin(), boxes.end(),
+                     [](const DetectionBox& a, const DetectionBox& b) { return a.score > b.score; });
+    FrameDetections kept;
+    for (const auto& box : boxes) {
+        bool suppressed = false;
+        for (const auto& other : kept) {
+            if (other.classId == box.classId && boxIou(other, box) > layout.iouThreshold) {
+                suppressed = true;
+                break;
+            }
+        }
+        if (!suppressed) kept.push_back(box);
+    }
+    return kept;
+}
+
+float boxIou(const DetectionBox& a, const DetectionBox& b) {
+    float w = std::max(0.0f, std::min(a.x2, b.x2) - std::max(a.x1, b.x1));
+    float h = std::max(0.0f, std::min(a.y2, b.y2) - std::max(a.y1, b.y1));
+    float intersection = w * h;
+    float unionArea = (a.x2 - a.x1) * (a.y2 - a.y1) + (b.x2 - b.x1) * (b.y2 - b.y1) - intersection;
+    return unionArea > 0.0f ? intersection / unionArea : 0.0f;
+}
+
+DetectionScore scoreDetections(const std::vector<FrameDetections>& golden,
+                               const std::vector<FrameDetections>& candidate, double matchIou) {
+    DetectionScore score;
+    double iouSum = 0.0;
+    size_t frames = std::max(golden.size(), candidate.size());
+    for (size_t f = 0; f < frames; ++f) {
+        static const FrameDetections kNone;
+        const FrameDetections& truth = f < golden.size() ? golden[f] : kNone;
+        FrameDetections boxes = f < candidate.size() ? candidate[f] : kNone;
+        std::stable_sort(boxes.begin(), boxes.end(),
+                         [](const DetectionBox& a, const DetectionBox& b) { return a.score > b.score; });
+        score.golden += static_cast<int>(truth.size());
+        score.candidate += static_cast<int>(boxes.size());
+
+        std::vector<bool> taken(truth.size(), false);
+        for (const auto& box : boxes) {
+            int best = -1;
+            float bestIou = static_cast<float>(matchIou);
+            for (size_t g = 0; g < truth.size(); ++g) {
+                if (taken[g] || truth[g].classId != box.classId) continue;
+                float iou = boxIou(truth[g], box);
+                if (iou >= bestIou) {
+                    bestIou = iou;
+                    best = static_cast<int>(g);
+                }
+            }
+            if (best < 0) continue;
+            taken[best] = true;
+            ++score.matched;
+            iouSum += bestIou;
+        }
+    }
+
+    // No boxes on either side counts as a perfect match
+    if (score.candidate > 0) score.precision = static_cast<double>(score.matched) / score.candidate;
+    if (score.golden > 0) score.recall = static_cast<double>(score.matched) / score.golden;
+    double sum = score.precision + score.recall;
+    score.f1 = sum > 0.0 ? 2.0 * score.precision * score.recall / sum : 0.0;
+    if (score.matched > 0) score.meanIou = iouSum / score.matched;
+    else if (score.golden > 0 || score.candidate > 0) score.meanIou = 0.0;
+    return score;
+}
+
+PrecisionSearch::PrecisionSearch(PrecisionSearchBackend& backend, const PrecisionSearchOptions& options)
+    : m_backend(backend), m_options(options) {
+}
+
+PrecisionPolicy PrecisionSearch::makePolicy(const std::vector<std::string>& layers,
+                                            const std::vector<std::string>& precisions) {
+    PrecisionPolicy policy;
+    for (size_t i = 0; i < layers.size() && i < precisions.size(); ++i) {
+        PrecisionRule rule;
+        rule.layer = layers[i];
+        rule.precision = precisions[i];
+        policy.rules().push_back(rule);
+    }
+    return policy;
+}
+
+std::string PrecisionSearch::describe(const std::vector<std::string>& precisions) const {
+    std::map<std::string, int> counts;
+    for (const auto& precision : precisions) ++counts[precision];
+    std::ostringstream text;
+    for (const auto& count : counts) {
+        if (text.tellp() > 0) text << ", ";
+        text << count.second << " " << count.first;
+    }
+    return text.str();
+}
+
+bool PrecisionSearch::evaluate(const std::vector<std::string>& precisions, SearchCandidate& candidate,
+                               DetectionScore& score) {
+    ++m_evaluations;
+    std::cout << "Search build " << m_evaluations << ": " << describe(precisions) << "\n";
+    candidate = SearchCandidate();
+    if (!m_backend.evaluate(makePolicy(m_layers, precisions), candidate)) {
+        std::cout << "  Rejected: candidate failed to build or run\n";
+        return false;
+    }
+    score = scoreDetections(m_golden, candidate.frames, m_options.matchIou);
+    bool accepted = score.f1 >= m_options.minF1 && score.meanIou >= m_options.minMeanIou;
+
+    std::ios::fmtflags flags = std::cout.flags();
+    std::cout << std::fixed << std::setprecision(3) << "  F1 " << score.f1 << ", mean IoU " << score.meanIou
+              << ", " << std::setprecision(2) << candidate.latencyMs << " ms/frame: "
+              << (accepted ? "accepted" : "rejected") << "\n";
+    std::cout.flags(flags);
+    return accepted;
+}
+
+bool PrecisionSearch::lower(const std::vector<size_t>& indices, size_t begin, size_t end, const std::string& target,
+                            bool rejected) {
+    if (begin >= end) return false;
+    if (m_evaluations >= m_options.maxEvaluations) return false;    // the rest keeps its precision
+
+    if (!rejected) {
+        std::vector<std::string> trial = m_current;
+        for (size_t i = begin; i < end; ++i) trial[indices[i]] = target;
+        SearchCandidate candidate;
+        DetectionScore score;
+        if (evaluate(trial, candidate, score)) {
+            m_current = trial;
+            if (candidate.latencyMs < m_best.latencyMs) {
+                m_best.precisions = trial;
+                m_best.score = score;
+                m_best.latencyMs = candidate.latencyMs;
+            }
+            return true;
+        }
+    }
+    if (end - begin == 1) return false;
+    size_t middle = begin + (end - begin) / 2;
+    // Once the left half is lowered whole, lowering the right half whole is the
+    // parent trial again, already rejected: go straight to its halves
+    bool leftLowered = lower(indices, begin, middle, target, false);
+    lower(indices, middle, end, target, leftLowered);
+    return false;
+}
+
+bool PrecisionSearch::run(PrecisionSearchResult& result) {
+    m_evaluations = 0;
+    m_layers.clear();
+    if (!m_backend.listLayers(m_layers) || m_layers.empty()) {
+        std::cerr << "Error: Network has no layers whose precision can be changed\n";
+        return false;
+    }
+    std::cout << "Precision search over " << m_layers.size() << " layers\n";
+
+    // All-FP32 baseline: the golden detections every candidate is scored against
+    m_current.assign(m_layers.size(), "fp32");
+    SearchCandidate baseline;
+    ++m_evaluations;
+    std::cout << "Search build 1: baseline, " << describe(m_current) << "\n";
+    if (!m_backend.evaluate(makePolicy(m_layers, m_current), baseline)) {
+        std::cerr << "Error: FP32 baseline failed to build or run\n";
+        return false;
+    }
+    m_golden = baseline.frames;
+    m_best = PrecisionSearchResult();
+    m_best.precisions = m_current;
+    m_best.latencyMs = baseline.latencyMs;
+    m_best.baselineLatencyMs = baseline.latencyMs;
+    m_best.score = scoreDetections(m_golden, m_golden, m_options.matchIou);
+
+    std::string from = "fp32";
+    for (const auto& target : m_options.targets) {
+        std::vector<size_t> indices;
+        for (size_t i = 0; i < m_current.size(); ++i) {
+            if (m_current[i] == from) indices.push_back(i);
+        }
+        std::cout << "Lowering " << indices.size() << " " << from << " layers to " << target << "\n";
+        lower(indices, 0, indices.size(), target, false);
+        from = target;
+    }
+    if (m_evaluations >= m_options.maxEvaluations) {
+        std::cout << "Warning: Search stopped after " << m_evaluations << " builds; untried layers keep their precision\n";
+    }
+
+    result = m_best;
+    result.policy = makePolicy(m_layers, m_best.precisions);
+    result.evaluations = m_evaluations;
+    return true;
+}
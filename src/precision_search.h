@@ -0,0 +1,122 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "engine_container.h"
+#include "json.h"
+#include "precision_policy.h"
+
+// Automatic mixed-precision search: lowers layers from FP32 to cheaper
+// precisions as long as the detections on a validation clip stay close to
+// those of an all-FP32 build, and keeps the fastest configuration that does.
+// Everything here runs on the CPU; building and running candidates is left to
+// a PrecisionSearchBackend (TensorRTSearchBackend for real engines).
+
+struct DetectionBox {
+    float x1, y1, x2, y2;
+    float score;
+    int classId;
+};
+
+using FrameDetections = std::vector<DetectionBox>;
+
+// Detection head of an engine, from its EngineContainer "postprocess" metadata
+struct DetectionLayout {
+    int anchors = 0;
+    int values = 0;              // per anchor: 4 box values + class scores, or 6 for NMS output
+    bool anchorsLast = false;    // [batch, values, anchors] instead of [batch, anchors, values]
+    bool nms = false;            // x1 y1 x2 y2 score class, NMS already applied
+    int numClasses = 0;
+    float scoreThreshold = static_cast<float>(EngineContainer::kScoreThreshold);
+    float iouThreshold = static_cast<float>(EngineContainer::kIouThreshold);
+
+    // dim1/dim2 are the output's dimensions after the batch; false if the metadata
+    // does not describe a detection head
+    static bool fromMetadata(const JsonValue& postprocess, int64_t dim1, int64_t dim2, DetectionLayout& layout);
+};
+
+// Boxes of one image's output (raw heads get class-wise NMS)
+FrameDetections decodeDetections(const float* output, const DetectionLayout& layout);
+
+float boxIou(const DetectionBox& a, const DetectionBox& b);
+
+struct DetectionScore {
+    int golden = 0;
+    int candidate = 0;
+    int matched = 0;             // same class and IoU >= the match threshold
+    double precision = 1.0;
+    double recall = 1.0;
+    double f1 = 1.0;
+    double meanIou = 1.0;        // over matched boxes
+};
+
+// Candidate detections against golden ones, frame by frame; boxes are matched
+// greedily in order of candidate score
+DetectionScore scoreDetections(const std::vector<FrameDetections>& golden,
+                               const std::vector<FrameDetections>& candidate, double matchIou);
+
+struct SearchCandidate {
+    std::vector<FrameDetections> frames;
+    double latencyMs = 0.0;      // median inference time per frame, after warm-up
+};
+
+class PrecisionSearchBackend {
+public:
+    virtual ~PrecisionSearchBackend() = default;
+
+    // Layers whose precision the search may change, in network order
+    virtual bool listLayers(std::vector<std::string>& layers) = 0;
+
+    // Builds the network under policy and runs it on the validation frames;
+    // false if either fails (the search then rejects the candidate)
+    virtual bool evaluate(const PrecisionPolicy& policy, SearchCandidate& candidate) = 0;
+};
+
+struct PrecisionSearchOptions {
+    std::vector<std::string> targets = {"fp16", "int8"};    // lowered one after another
+    double minF1 = 0.98;
+    double minMeanIou = 0.90;
+    double matchIou = 0.5;
+    int maxEvaluations = 64;     // builds, including the FP32 baseline
+};
+
+struct PrecisionSearchResult {
+    PrecisionPolicy policy;      // fastest configuration within tolerance
+    std::vector<std::string> precisions;    // per layer of listLayers()
+    DetectionScore score;
+    double latencyMs = 0.0;
+    double baselineLatencyMs = 0.0;
+    int evaluations = 0;
+};
+
+// For each target in turn, tries to lower every layer that reached the previous
+// precision: a whole range at once, and if the detections drift out of
+// tolerance, each half of it, down to single layers. Ranges that pass stay
+// lowered; a configuration already rejected is never built again. Each candidate is scored against the FP32 baseline, and of all
+// accepted candidates the fastest is the result.
+class PrecisionSearch {
+public:
+    PrecisionSearch(PrecisionSearchBackend& backend, const PrecisionSearchOptions& options);
+
+    // False if the baseline cannot be built or run
+    bool run(PrecisionSearchResult& result);
+
+    // One exact-name rule per layer, obeyed
+    static PrecisionPolicy makePolicy(const std::vector<std::string>& layers, const std::vector<std::string>& precisions);
+
+private:
+    bool evaluate(const std::vector<std::string>& precisions, SearchCandidate& candidate, DetectionScore& score);
+    // True if the whole range was lowered. rejected: this range's trial is known
+    // to fail (it equals a rejected one), so only its halves are tried
+    bool lower(const std::vector<size_t>& indices, size_t begin, size_t end, const std::string& target,
+               bool rejected);
+    std::string describe(const std::vector<std::string>& precisions) const;
+
+    PrecisionSearchBackend& m_backend;
+    PrecisionSearchOptions m_options;
+    std::vector<std::string> m_layers;
+    std::vector<std::string> m_current;     // accepted precision per layer
+    std::vector<FrameDetections> m_golden;
+    PrecisionSearchResult m_best;
+    int m_evaluations = 0;
+};
@@ -0,0 +1,324 @@
+#include "precision_search_backend.h"
+#include "calibration_batches.h"
+#include "engine_container.h"
+#include "engine_exporter.h"
+#include "file_utils.h"
+#include "image_preprocess.h"
+#include "plugin_loader.h"
+#include <NvInfer.h>
+#include <NvOnnxParser.h>
+#include <cuda_runtime.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+size_t elementSize(nvinfer1::DataType type) {
+    switch (type) {
+    case nvinfer1::DataType::kINT64:
+        return 8;
+    case nvinfer1::DataType::kFLOAT:
+    case nvinfer1::DataType::kINT32:
+        return 4;
+    case nvinfer1::DataType::kHALF:
+    case nvinfer1::DataType::kBF16:
+        return 2;
+    default:
+        return 1;
+    }
+}
+
+size_t volume(const nvinfer1::Dims& dims) {
+    size_t count = 1;
+    for (int32_t i = 0; i < dims.nbDims; ++i) count *= static_cast<size_t>(std::max<int64_t>(1, dims.d[i]));
+    return count;
+}
+
+// Untimed inferences before the first measurement, and timed ones per frame
+const int kWarmupRuns = 10;
+const int kTimedRuns = 5;
+
+bool checkCuda(cudaError_t status, const char* what) {
+    if (status != cudaSuccess) {
+        std::cerr << "Error: " << what << ": " << cudaGetErrorString(status) << "\n";
+        return false;
+    }
+    return true;
+}
+
+// Device buffers of one execution context, freed with it
+struct DeviceBuffers {
+    std::vector<void*> buffers;
+    cudaStream_t stream = nullptr;
+
+    ~DeviceBuffers() {
+        for (void* buffer : buffers) cudaFree(buffer);
+        if (stream) cudaStreamDestroy(stream);
+    }
+};
+
+} // namespace
+
+TensorRTSearchBackend::TensorRTSearchBackend(const ExportConfig& config, const std::string& clip, int maxFrames)
+    : m_config(config), m_clip(clip), m_maxFrames(maxFrames), m_logger(config.verbose) {
+    m_workDir = fs::path(config.get_output_path()).replace_extension(".search").string();
+
+    // Candidates are throwaway containers: metadata for the detection head,
+    // weights included, nothing published to the store
+    m_config.output_engine_path = (fs::path(m_workDir) / "candidate.engine").string();
+    m_config.precision_policy = (fs::path(m_workDir) / "candidate.precision.json").string();
+    m_config.engine_container = true;
+    m_config.compress_engine = false;
+    m_config.strip_weights = false;
+    m_config.refit_engine.clear();
+    m_config.engine_store_dir.clear();
+    m_config.write_build_report = false;
+}
+
+TensorRTSearchBackend::~TensorRTSearchBackend() {
+    std::error_code ec;
+    fs::remove_all(m_workDir, ec);
+}
+
+bool TensorRTSearchBackend::prepare() {
+    std::error_code ec;
+    fs::create_directories(m_workDir, ec);
+    std::string frameDir = m_clip;
+    if (!fs::is_directory(m_clip, ec)) {
+        if (!fs::is_regular_file(m_clip, ec)) {
+            std::cerr << "Error: Validation clip not found: " << m_clip << "\n";
+            return false;
+        }
+        // Videos are split with ffmpeg, like engine_tester does
+        frameDir = (fs::path(m_workDir) / "frames").string();
+        fs::create_directories(frameDir, ec);
+        std::string command = "ffmpeg -loglevel error -y -i \"" + m_clip + "\" -frames:v " + std::to_string(m_maxFrames) +
+                              " -q:v 2 \"" + (fs::path(frameDir) / "frame_%05d.jpg").string() + "\"";
+        std::cout << "Extracting up to " << m_maxFrames << " frames from " << m_clip << "...\n";
+        if (std::system(command.c_str()) != 0) {
+            std::cerr << "Error: ffmpeg could not split " << m_clip << " (is ffmpeg on the PATH?)\n";
+            return false;
+        }
+    }
+    m_frames = CalibrationBatchStream::listImages(frameDir);
+    if (m_frames.size() > static_cast<size_t>(m_maxFrames)) {
+        m_frames.resize(static_cast<size_t>(m_maxFrames));
+    }
+    if (m_frames.empty()) {
+        std::cerr << "Error: No validation frames in " << m_clip << "\n";
+        return false;
+    }
+    std::cout << "  Validation frames: " << m_frames.size() << "\n";
+    return true;
+}
+
+bool TensorRTSearchBackend::listLayers(std::vector<std::string>& layers) {
+    // Parsed the way the exporter parses it, so the names are the ones policies see
+    if (!PluginLoader::load(m_config)) {
+        return false;
+    }
+    std::unique_ptr<nvinfer1::IBuilder> builder(nvinfer1::createInferBuilder(m_logger));
+    if (!builder) {
+        std::cerr << "Error: Failed to create TensorRT builder\n";
+        return false;
+    }
+    std::unique_ptr<nvinfer1::INetworkDefinition> network(builder->createNetworkV2(0));
+    std::unique_ptr<nvonnxparser::IParser> parser(
+        network ? nvonnxparser::createParser(*network, m_logger) : nullptr);
+    if (!parser || !parser->parseFromFile(m_config.input_onnx_path.c_str(),
+                                          static_cast<int>(nvinfer1::ILogger::Severity::kWARNING))) {
+        std::cerr << "Error: Failed to parse ONNX file\n";
+        return false;
+    }
+
+    layers.clear();
+    for (int32_t i = 0; i < network->getNbLayers(); ++i) {
+        const nvinfer1::ILayer* layer = network->getLayer(i);
+        if (PrecisionPolicy::adjustable(*layer) && layer->getName()) layers.push_back(layer->getName());
+    }
+    return true;
+}
+
+bool TensorRTSearchBackend::evaluate(const PrecisionPolicy& policy, SearchCandidate& candidate) {
+    if (!policy.saveToFile(m_config.precision_policy)) {
+        return false;
+    }
+    EngineExporter exporter(m_config);
+    if (!exporter.exportEngine()) {
+        return false;
+    }
+    return runEngine(m_config.output_engine_path, candidate);
+}
+
+bool TensorRTSearchBackend::runEngine(const std::string& enginePath, SearchCandidate& candidate) {
+    std::vector<char> bytes;
+    EnginePlan plan;
+    if (!readFileBytes(enginePath, bytes) || !EngineContainer::unpack(bytes.data(), bytes.size(), plan)) {
+        std::cerr << "Error: Cannot read candidate engine: " << enginePath << "\n";
+        return false;
+    }
+    const JsonValue* postprocess = plan.metadata.find("postprocess");
+    const JsonValue* inputs = plan.metadata.find("inputs");
+    if (!postprocess || !postprocess->find("output") || !inputs || inputs->size() == 0 || !inputs->at(0).find("name")) {
+        std::cerr << "Error: Engine metadata describes no detection head to score\n";
+        return false;
+    }
+    std::string inputName = inputs->at(0).find("name")->asString();
+    std::string outputName = postprocess->find("output")->asString();
+
+    // The runtime has to outlive the engine, and the engine its context
+    std::unique_ptr<nvinfer1::IRuntime> runtime(nvinfer1::createInferRuntime(m_logger));
+    std::unique_ptr<nvinfer1::ICudaEngine> engine(
+        runtime ? runtime->deserializeCudaEngine(plan.data, plan.size) : nullptr);
+    std::unique_ptr<nvinfer1::IExecutionContext> context(engine ? engine->createExecutionContext() : nullptr);
+    if (!context) {
+        std::cerr << "Error: Failed to load candidate engine\n";
+        return false;
+    }
+    plan = EnginePlan();
+    std::vector<char>().swap(bytes);
+
+    // Dynamic axes take profile 0's MIN batch and OPT size; one frame per inference,
+    // further batch slots stay zero
+    nvinfer1::Dims inputDims = engine->getTensorShape(inputName.c_str());
+    nvinfer1::Dims minDims = engine->getProfileShape(inputName.c_str(), 0, nvinfer1::OptProfileSelector::kMIN);
+    nvinfer1::Dims optDims = engine->getProfileShape(inputName.c_str(), 0, nvinfer1::OptProfileSelector::kOPT);
+    if (inputDims.nbDims != 4) {
+        std::cerr << "Error: Expected an NCHW image input: " << inputName << "\n";
+        return false;
+    }
+    for (int32_t i = 0; i < inputDims.nbDims; ++i) {
+        if (inputDims.d[i] < 0) inputDims.d[i] = std::max<int64_t>(1, i == 0 ? minDims.d[i] : optDims.d[i]);
+    }
+    if (!context->setInputShape(inputName.c_str(), inputDims)) {
+        std::cerr << "Error: Failed to set input shape\n";
+        return false;
+    }
+    nvinfer1::Dims outputDims = context->getTensorShape(outputName.c_str());
+    DetectionLayout layout;
+    if (engine->getTensorDataType(inputName.c_str()) != nvinfer1::DataType::kFLOAT ||
+        engine->getTensorDataType(outputName.c_str()) != nvinfer1::DataType::kFLOAT || outputDims.nbDims != 3 ||
+        !DetectionLayout::fromMetadata(*postprocess, outputDims.d[1], outputDims.d[2], layout)) {
+        std::cerr << "Error: Unsupported detection I/O (FP32 NCHW input and [batch, a, b] output expected)\n";
+        return false;
+    }
+
+    DeviceBuffers device;
+    if (!checkCuda(cudaStreamCreateWithFlags(&device.stream, cudaStreamNonBlocking), "Failed to create CUDA stream")) {
+        return false;
+    }
+    void* inputBuffer = nullptr;
+    void* outputBuffer = nullptr;
+    for (int32_t i = 0; i < engine->getNbIOTensors(); ++i) {
+        const char* name = engine->getIOTensorName(i);
+        size_t size = volume(context->getTensorShape(name)) * elementSize(engine->getTensorDataType(name));
+        void* buffer = nullptr;
+        if (!checkCuda(cudaMalloc(&buffer, size), "Failed to allocate device buffer")) {
+            return false;
+        }
+        device.buffers.push_back(buffer);
+        context->setTensorAddress(name, buffer);
+        if (inputName == name) inputBuffer = buffer;
+        if (outputName == name) outputBuffer = buffer;
+    }
+
+    ImagePreprocessor preprocessor;
+    preprocessor.setOutputSize(static_cast<int>(inputDims.d[1]), static_cast<int>(inputDims.d[2]),
+                               static_cast<int>(inputDims.d[3]));
+    std::vector<float> input(volume(inputDims));
+    std::vector<float> output(volume(outputDims));
+    std::vector<unsigned char> pixels;
+    std::vector<double> timesMs;
+    candidate.frames.clear();
+    for (size_t f = 0; f < m_frames.size(); ++f) {
+        const std::string& frame = m_frames[f];
+        int width = 0, height = 0, channels = 0;
+        if (!ImagePreprocessor::loadImage(frame, pixels, width, height, channels)) {
+            std::cerr << "Error: Cannot read frame: " << frame << "\n";
+            return false;
+        }
+        preprocessor.run(pixels.data(), width, height, channels, input.data());
+        if (!checkCuda(cudaMemcpyAsync(inputBuffer, input.data(), input.size() * sizeof(float),
+                                       cudaMemcpyHostToDevice, device.stream), "Failed to copy frame") ||
+            !checkCuda(cudaStreamSynchronize(device.stream), "Failed to copy frame")) {
+            return false;
+        }
+        // The first frame also warms the engine up (lazy allocations, clocks), untimed
+        int runs = kTimedRuns + (f == 0 ? kWarmupRuns : 0);
+        for (int run = 0; run < runs; ++run) {
+            auto start = std::chrono::steady_clock::now();
+            if (!context->enqueueV3(device.stream) ||
+                !checkCuda(cudaStreamSynchronize(device.stream), "Inference failed")) {
+                std::cerr << "Error: Inference failed on " << frame << "\n";
+                return false;
+            }
+            if (run >= runs - kTimedRuns) {
+                auto elapsed = std::chrono::steady_clock::now() - start;
+                timesMs.push_back(std::chrono::duration<double, std::milli>(elapsed).count());
+            }
+        }
+        if (!checkCuda(cudaMemcpyAsync(output.data(), outputBuffer, output.size() * sizeof(float),
+                                       cudaMemcpyDeviceToHost, device.stream), "Failed to copy output") ||
+            !checkCuda(cudaStreamSynchronize(device.stream), "Failed to copy output")) {
+            return false;
+        }
+        candidate.frames.push_back(decodeDetections(output.data(), layout));
+    }
+    // Median over every timed run: a short clip's mean is dominated by the odd slow run
+    std::nth_element(timesMs.begin(), timesMs.begin() + timesMs.size() / 2, timesMs.end());
+    candidate.latencyMs = timesMs[timesMs.size() / 2];
+    return true;
+}
+
+int runPrecisionSearch(const ExportConfig& config, const std::string& clip, int maxFrames,
+                       const PrecisionSearchOptions& options) {
+    // INT8/FP8 layers get their scales from the global settings (calibration, Q/DQ)
+    for (const auto& target : options.targets) {
+        if ((target == "int8" && !config.enable_int8) || (target == "fp8" && !config.enable_fp8)) {
+            std::cerr << "Error: Search target " << target << " needs --" << target
+                      << " and its calibration or a Q/DQ model\n";
+            return 2;
+        }
+    }
+
+    std::string policyPath = fs::path(config.get_output_path()).replace_extension(".precision.json").string();
+    PrecisionSearchResult result;
+    {
+        TensorRTSearchBackend backend(config, clip, maxFrames);
+        PrecisionSearch search(backend, options);
+        if (!backend.prepare() || !search.run(result)) {
+            return 1;
+        }
+    }
+    if (!result.policy.saveToFile(policyPath)) {
+        return 1;
+    }
+
+    std::map<std::string, int> counts;
+    for (const auto& precision : result.precisions) ++counts[precision];
+    std::ios::fmtflags flags = std::cout.flags();
+    std::cout << "\nPrecision search finished after " << result.evaluations << " builds\n";
+    for (const auto& count : counts) {
+        std::cout << "  " << count.first << ": " << count.second << " layers\n";
+    }
+    std::cout << std::fixed << std::setprecision(2) << "  Latency: " << result.latencyMs << " ms/frame (FP32 "
+              << result.baselineLatencyMs << " ms)\n"
+              << std::setprecision(3) << "  F1 " << result.score.f1 << ", mean IoU " << result.score.meanIou
+              << " against FP32\n";
+    std::cout.flags(flags);
+    std::cout << "Precision policy: " << policyPath << "\n\n";
+
+    // The final engine is an ordinary export with the policy found
+    ExportConfig finalConfig = config;
+    finalConfig.precision_policy = policyPath;
+    EngineExporter exporter(finalConfig);
+    return exporter.exportEngine() ? 0 : 1;
+}
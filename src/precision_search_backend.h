@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "config.h"
+#include "logger.h"
+#include "precision_search.h"
+
+// PrecisionSearch backend for real engines: builds each candidate with
+// EngineExporter under its policy and runs it on the frames of a validation
+// clip (a video, split with ffmpeg, or a folder of images).
+class TensorRTSearchBackend : public PrecisionSearchBackend {
+public:
+    // Candidates are built from config (timing cache included) into a work
+    // folder next to its output
+    TensorRTSearchBackend(const ExportConfig& config, const std::string& clip, int maxFrames);
+    ~TensorRTSearchBackend() override;
+
+    // Collects the validation frames; false if there are none
+    bool prepare();
+
+    bool listLayers(std::vector<std::string>& layers) override;
+    bool evaluate(const PrecisionPolicy& policy, SearchCandidate& candidate) override;
+
+private:
+    bool runEngine(const std::string& enginePath, SearchCandidate& candidate);
+
+    ExportConfig m_config;
+    std::string m_clip;
+    int m_maxFrames;
+    std::string m_workDir;
+    std::vector<std::string> m_frames;
+    TensorRTLogger m_logger;
+};
+
+// Searches a mixed-precision policy for config's model, writes it to
+// <output stem>.precision.json and builds the engine with it. Returns the
+// process exit code.
+int runPrecisionSearch(const ExportConfig& config, const std::string& clip, int maxFrames,
+                       const PrecisionSearchOptions& options);
@@ -0,0 +1,236 @@
+#include "qdq_inserter.h"
+#include "onnx_shape_inference.h"
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+namespace {
+
+constexpr float kInt8Max = 127.0f;
+constexpr float kFp8E4M3Max = 448.0f;
+
+// Hands out tensor/node names not yet used in the graph
+class NameAllocator {
+public:
+    explicit NameAllocator(const OnnxGraph& graph) {
+        for (const auto& node : graph.nodes) {
+            m_used.insert(node.name);
+            for (const auto& s : node.inputs) m_used.insert(s);
+            for (const auto& s : node.outputs) m_used.insert(s);
+        }
+        for (const auto& t : graph.initializers) m_used.insert(t.name);
+        for (const auto& v : graph.inputs) m_used.insert(v.name);
+        for (const auto& v : graph.outputs) m_used.insert(v.name);
+    }
+
+    std::string make(const std::string& base) {
+        std::string name = base;
+        for (int suffix = 1; m_used.count(name); ++suffix) name = base + "_" + std::to_string(suffix);
+        m_used.insert(name);
+        return name;
+    }
+
+private:
+    std::unordered_set<std::string> m_used;
+};
+
+struct WeightPlan {
+    std::string tensor;
+    int64_t axis = -1;      // -1 = per-tensor
+};
+
+struct NodePlan {
+    size_t nodeIndex = 0;
+    std::vector<std::pair<size_t, std::string>> activations;  // input index, tensor
+    std::vector<std::pair<size_t, WeightPlan>> weights;       // input index, weight
+};
+
+OnnxTensor zeroPoint(const std::string& name, QdqFormat format, const std::vector<int64_t>& dims) {
+    OnnxTensor tensor;
+    tensor.name = name;
+    tensor.dataType = static_cast<int32_t>(format == QdqFormat::FP8 ? OnnxDataType::FLOAT8E4M3FN : OnnxDataType::INT8);
+    tensor.dims = dims;
+    tensor.rawData.assign(dims.empty() ? 1 : static_cast<size_t>(dims[0]), '\0');
+    return tensor;
+}
+
+// Output-channel axis of a constant weight, -1 when only per-tensor is sensible
+int64_t weightChannelAxis(const OnnxNode& node, size_t inputIndex, const OnnxTensor& weight) {
+    size_t rank = weight.dims.size();
+    if (node.opType == "Conv") return inputIndex == 1 && rank >= 3 ? 0 : -1;
+    if (node.opType == "ConvTranspose") {
+        return inputIndex == 1 && rank >= 3 && node.attrInt("group", 1) == 1 ? 1 : -1;
+    }
+    if (node.opType == "Gemm") {
+        if (inputIndex != 1 || rank != 2) return -1;
+        return node.attrInt("transB", 0) != 0 ? 0 : 1;
+    }
+    if (node.opType == "MatMul") return inputIndex == 1 && rank == 2 ? 1 : -1;
+    return -1;
+}
+
+std::vector<float> weightScales(const OnnxTensor& weight, int64_t axis, float qmax) {
+    std::vector<float> values = weight.toFloats();
+    size_t channels = 1;
+    size_t inner = values.size();
+    if (axis >= 0) {
+        channels = static_cast<size_t>(weight.dims[axis]);
+        inner = 1;
+        for (size_t d = static_cast<size_t>(axis) + 1; d < weight.dims.size(); ++d) inner *= static_cast<size_t>(weight.dims[d]);
+    }
+    std::vector<float> amax(channels, 0.0f);
+    for (size_t i = 0; i < values.size(); ++i) {
+        size_t c = axis >= 0 ? (i / inner) % channels : 0;
+        amax[c] = std::max(amax[c], std::fabs(values[i]));
+    }
+    std::vector<float> scales(channels);
+    for (size_t c = 0; c < channels; ++c) {
+        // All-zero channels still need a positive scale
+        scales[c] = amax[c] > 0.0f ? amax[c] / qmax : 1.0f / qmax;
+    }
+    return scales;
+}
+
+} // namespace
+
+bool QdqInserter::insert(OnnxModel& model, const CalibrationCache& activations, const QdqOptions& options,
+                         QdqReport& report) {
+    OnnxGraph& graph = model.graph;
+    int64_t opset = model.opsetVersion();
+    if (opset < 10) {
+        report.warnings.push_back("QuantizeLinear needs opset 10 or newer, model has opset " + std::to_string(opset));
+        return false;
+    }
+    if (options.format == QdqFormat::FP8 && opset < 19) {
+        report.warnings.push_back("FP8 Q/DQ needs opset 19 or newer, model has opset " + std::to_string(opset) +
+                                  "; re-export the model with a newer opset");
+        return false;
+    }
+    bool perChannel = options.perChannelWeights;
+    if (perChannel && opset < 13) {
+        report.warnings.push_back("per-channel Q/DQ needs opset 13, falling back to per-tensor weight scales");
+        perChannel = false;
+    }
+    float qmax = options.format == QdqFormat::FP8 ? kFp8E4M3Max : kInt8Max;
+
+    OnnxShapeInference inference(model);
+    inference.run();
+
+    // 1. Decide what to quantize before touching the graph
+    std::vector<NodePlan> plans;
+    for (size_t n = 0; n < graph.nodes.size(); ++n) {
+        const OnnxNode& node = graph.nodes[n];
+        bool defaultDomain = node.domain.empty() || node.domain == "ai.onnx";
+        if (!defaultDomain || !options.opTypes.count(node.opType)) continue;
+        std::string label = node.name.empty() ? node.outputs[0] : node.name;
+        if (options.excludeNodes.count(node.name)) {
+            report.skipped.push_back(label + ": excluded");
+            continue;
+        }
+
+        NodePlan plan;
+        plan.nodeIndex = n;
+        std::string reason;
+        for (size_t i = 0; i < 2 && i < node.inputs.size() && reason.empty(); ++i) {
+            const std::string& input = node.inputs[i];
+            if (const OnnxTensor* weight = graph.findInitializer(input)) {
+                if (weight->dataType != static_cast<int32_t>(OnnxDataType::FLOAT) || !weight->hasData()) {
+                    reason = "weight '" + input + "' is not an embedded FP32 tensor";
+                    continue;
+                }
+                WeightPlan w;
+                w.tensor = input;
+                w.axis = perChannel ? weightChannelAxis(node, i, *weight) : -1;
+                plan.weights.push_back({i, w});
+            } else {
+                const OnnxShapeInfo* info = inference.find(input);
+                if (info && info->elemType != 0 && info->elemType != static_cast<int32_t>(OnnxDataType::FLOAT)) {
+                    reason = "input '" + input + "' is " + onnxDataTypeName(info->elemType) + ", not FP32";
+                } else if (activations.amax(input) <= 0.0f) {
+                    reason = "no calibration scale for '" + input + "'";
+                } else {
+                    plan.activations.push_back({i, input});
+                }
+            }
+        }
+        if (!reason.empty()) {
+            report.skipped.push_back(label + ": " + reason);
+            continue;
+        }
+        if (plan.activations.empty()) {
+            report.skipped.push_back(label + ": no activation input");
+            continue;
+        }
+        plans.push_back(plan);
+    }
+
+    // 2. Rebuild the node list with Q/DQ pairs right before their first consumer
+    NameAllocator names(graph);
+    // (tensor, axis) -> DQ output: a weight shared by consumers with different
+    // channel axes (Conv and ConvTranspose, say) gets one pair per axis
+    std::unordered_map<std::string, std::string> dequantized;
+    auto pairKey = [](const std::string& tensor, int64_t axis) { return tensor + "#" + std::to_string(axis); };
+    std::unordered_map<size_t, const NodePlan*> planByNode;
+    for (const auto& plan : plans) planByNode[plan.nodeIndex] = &plan;
+
+    auto addPair = [&](const std::string& tensor, const std::vector<float>& scales, int64_t axis,
+                       std::vector<OnnxNode>& out) -> std::string {
+        auto it = dequantized.find(pairKey(tensor, axis));
+        if (it != dequantized.end()) return it->second;
+
+        std::vector<int64_t> scaleDims;
+        if (axis >= 0) scaleDims.push_back(static_cast<int64_t>(scales.size()));
+        std::string scaleName = names.make(tensor + "_scale");
+        std::string zeroName = names.make(tensor + "_zero_point");
+        graph.initializers.push_back(OnnxTensor::fromFloats(scaleName, scaleDims, scales));
+        graph.initializers.push_back(zeroPoint(zeroName, options.format, scaleDims));
+
+        OnnxNode q;
+        q.opType = "QuantizeLinear";
+        q.name = names.make(tensor + "_QuantizeLinear");
+        q.inputs = {tensor, scaleName, zeroName};
+        q.outputs = {names.make(tensor + "_quantized")};
+        OnnxNode dq;
+        dq.opType = "DequantizeLinear";
+        dq.name = names.make(tensor + "_DequantizeLinear");
+        dq.inputs = {q.outputs[0], scaleName, zeroName};
+        dq.outputs = {names.make(tensor + "_dequantized")};
+        if (axis >= 0) {
+            q.setAttr(OnnxAttribute::makeInt("axis", axis));
+            dq.setAttr(OnnxAttribute::makeInt("axis", axis));
+        }
+        out.push_back(q);
+        out.push_back(dq);
+        dequantized[pairKey(tensor, axis)] = dq.outputs[0];
+        return dq.outputs[0];
+    };
+
+    std::vector<OnnxNode> rebuilt;
+    rebuilt.reserve(graph.nodes.size() + 4 * plans.size());
+    for (size_t n = 0; n < graph.nodes.size(); ++n) {
+        auto found = planByNode.find(n);
+        if (found == planByNode.end()) {
+            rebuilt.push_back(std::move(graph.nodes[n]));
+            continue;
+        }
+        OnnxNode node = std::move(graph.nodes[n]);
+        const NodePlan& plan = *found->second;
+        for (const auto& a : plan.activations) {
+            bool created = !dequantized.count(pairKey(a.second, -1));
+            float scale = activations.amax(a.second) / qmax;
+            node.inputs[a.first] = addPair(a.second, {scale}, -1, rebuilt);
+            if (created) ++report.activationPairs;
+        }
+        for (const auto& w : plan.weights) {
+            bool created = !dequantized.count(pairKey(w.second.tensor, w.second.axis));
+            std::vector<float> scales;
+            if (created) scales = weightScales(*graph.findInitializer(w.second.tensor), w.second.axis, qmax);
+            node.inputs[w.first] = addPair(w.second.tensor, scales, w.second.axis, rebuilt);
+            if (created) ++report.weightPairs;
+        }
+        rebuilt.push_back(std::move(node));
+        ++report.nodesQuantized;
+    }
+    graph.nodes = std::move(rebuilt);
+    return true;
+}
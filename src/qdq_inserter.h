@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "onnx_model.h"
+#include "calibration_cache.h"
+
+enum class QdqFormat {
+    INT8,
+    FP8     // float8e4m3fn, needs opset 19
+};
+
+struct QdqOptions {
+    QdqFormat format = QdqFormat::INT8;
+    bool perChannelWeights = true;                      // per-output-channel weight scales (opset 13+)
+    std::unordered_set<std::string> opTypes = {"Conv", "ConvTranspose", "Gemm", "MatMul"};
+    std::unordered_set<std::string> excludeNodes;       // node names left in float
+};
+
+struct QdqReport {
+    int nodesQuantized = 0;
+    int activationPairs = 0;
+    int weightPairs = 0;
+    std::vector<std::string> skipped;                   // "node: reason"
+    std::vector<std::string> warnings;
+};
+
+// Post-training Q/DQ insertion.
+//
+// Activation inputs of the selected ops get a QuantizeLinear/DequantizeLinear
+// pair with the per-tensor scale from a calibration cache; constant weights
+// get a pair with per-channel (or per-tensor) scales computed from their
+// absolute maximum. All quantization is symmetric (zero point 0), which is
+// what TensorRT's explicit-quantization path expects, so the output builds
+// directly with assume_qat_quantized.
+class QdqInserter {
+public:
+    static bool insert(OnnxModel& model, const CalibrationCache& activations, const QdqOptions& options,
+                       QdqReport& report);
+};
@@ -0,0 +1,53 @@
+#include "refit_weights.h"
+#include "onnx_model.h"
+#include <unordered_map>
+#include <unordered_set>
+
+std::vector<RefitWeight> RefitWeights::fromOnnx(const OnnxGraph& graph) {
+    std::vector<RefitWeight> weights;
+    weights.reserve(graph.initializers.size());
+    for (const auto& tensor : graph.initializers) {
+        weights.push_back({tensor.name, tensor.numElements()});
+    }
+    for (const auto& node : graph.nodes) {
+        if (node.opType != "Constant" || node.outputs.empty()) continue;
+        const OnnxAttribute* value = node.attr("value");
+        if (value && value->type == OnnxAttribute::TENSOR) {
+            weights.push_back({node.outputs[0], value->t.numElements()});
+        }
+    }
+    return weights;
+}
+
+RefitWeightCheck RefitWeights::check(const std::vector<RefitWeight>& engineWeights,
+                                     const std::vector<RefitWeight>& onnxWeights) {
+    std::unordered_map<std::string, int64_t> counts;
+    counts.reserve(onnxWeights.size());
+    for (const auto& weight : onnxWeights) counts.emplace(weight.name, weight.count);
+
+    RefitWeightCheck result;
+    for (const auto& weight : engineWeights) {
+        auto it = counts.find(weight.name);
+        if (it == counts.end()) {
+            result.derived.push_back(weight.name);
+        } else if (it->second != weight.count) {
+            result.differences.push_back("~ " + weight.name + ": " + std::to_string(weight.count) + " -> " +
+                                         std::to_string(it->second) + " values");
+        } else {
+            result.matched.push_back(weight.name);
+        }
+    }
+    return result;
+}
+
+void RefitWeights::checkTensors(const char* kind, const std::vector<std::string>& engineTensors,
+                                const std::vector<std::string>& onnxTensors, RefitWeightCheck& check) {
+    std::unordered_set<std::string> engineSet(engineTensors.begin(), engineTensors.end());
+    std::unordered_set<std::string> onnxSet(onnxTensors.begin(), onnxTensors.end());
+    for (const auto& name : engineTensors) {
+        if (!onnxSet.count(name)) check.differences.push_back(std::string("- ") + kind + " " + name + ": not in the ONNX");
+    }
+    for (const auto& name : onnxTensors) {
+        if (!engineSet.count(name)) check.differences.push_back(std::string("+ ") + kind + " " + name + ": not in the engine");
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct OnnxGraph;
+
+// One refittable weight, by name and element count. The engine side comes
+// from IRefitter (EngineRefit::describe), the model side from the ONNX graph,
+// so matching the two needs neither TensorRT nor a GPU.
+struct RefitWeight {
+    std::string name;
+    int64_t count = 0;
+};
+
+// How well an ONNX model covers an engine's refittable weights and I/O tensors
+struct RefitWeightCheck {
+    std::vector<std::string> matched;       // ONNX weight with the same name and element count
+    std::vector<std::string> derived;       // no ONNX weight of that name; the parser computes it (e.g. folded BatchNorm)
+    std::vector<std::string> differences;   // topology diff, one line each: "~ conv1.weight: 864 -> 1728 values"
+
+    // Another model, or another export of it: refitting would fail or load wrong weights
+    bool isForeign() const { return !differences.empty() || (matched.empty() && !derived.empty()); }
+};
+
+class RefitWeights {
+public:
+    // Initializers plus Constant node tensors, which the ONNX parser also turns
+    // into weights named after the node output
+    static std::vector<RefitWeight> fromOnnx(const OnnxGraph& graph);
+
+    static RefitWeightCheck check(const std::vector<RefitWeight>& engineWeights,
+                                  const std::vector<RefitWeight>& onnxWeights);
+
+    // Adds "- input x: not in the ONNX" / "+ output y: not in the engine" lines
+    // for I/O tensors that only one side has; kind is "input" or "output"
+    static void checkTensors(const char* kind, const std::vector<std::string>& engineTensors,
+                             const std::vector<std::string>& onnxTensors, RefitWeightCheck& check);
+};
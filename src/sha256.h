@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// SHA-256 (FIPS 180-4), used for content-addressed artifacts and checksums
+class Sha256 {
+public:
+    Sha256();
+
+    void update(const void* data, size_t size);
+    void update(const std::string& text) { update(text.data(), text.size()); }
+    std::string hexDigest();    // finalizes; the object must not be updated afterwards
+
+    static std::string hashString(const std::string& text);
+    // Empty string if the file cannot be read
+    static std::string hashFile(const std::string& path);
+
+private:
+    void processBlock(const uint8_t* block);
+
+    uint32_t m_state[8];
+    uint8_t m_buffer[64];
+    size_t m_bufferSize = 0;
+    uint64_t m_totalBytes = 0;
+};
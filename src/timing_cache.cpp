@@ -0,0 +1,134 @@
+#include "timing_cache.h"
+#include "file_utils.h"
+#include <cctype>
+#include <cuda_runtime_api.h>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+
+namespace {
+
+const char* kCacheExtension = ".cache";
+
+std::string sanitize(const std::string& text) {
+    std::string result;
+    for (char c : text) {
+        result += std::isalnum(static_cast<unsigned char>(c)) ? c : '-';
+    }
+    return result;
+}
+
+bool parseNumber(const std::string& text, int& value) {
+    if (text.empty()) return false;
+    for (char c : text) {
+        if (!std::isdigit(static_cast<unsigned char>(c))) return false;
+    }
+    value = std::stoi(text);
+    return true;
+}
+
+} // namespace
+
+std::string TimingCacheId::fileName() const {
+    return sanitize(deviceName) + "_sm" + std::to_string(smMajor) + std::to_string(smMinor) +
+           "_trt" + std::to_string(trtVersion) + "_" + precision + kCacheExtension;
+}
+
+bool TimingCacheId::fromFileName(const std::string& fileName, TimingCacheId& id) {
+    std::string name = std::filesystem::path(fileName).filename().string();
+    size_t extension = name.rfind(kCacheExtension);
+    if (extension == std::string::npos || extension + 6 != name.size()) return false;
+    name = name.substr(0, extension);
+
+    // <device>_sm<XY>_trt<N>_<precision>; the device part has no '_' after sanitizing
+    size_t p3 = name.rfind('_');
+    if (p3 == std::string::npos) return false;
+    size_t p2 = name.rfind('_', p3 - 1);
+    if (p2 == std::string::npos || p2 == 0) return false;
+    size_t p1 = name.rfind('_', p2 - 1);
+    if (p1 == std::string::npos || p1 == 0) return false;
+
+    std::string sm = name.substr(p1 + 1, p2 - p1 - 1);
+    std::string trt = name.substr(p2 + 1, p3 - p2 - 1);
+    int smValue = 0;
+    if (sm.size() < 4 || sm.compare(0, 2, "sm") != 0 || !parseNumber(sm.substr(2), smValue)) return false;
+    if (trt.size() < 4 || trt.compare(0, 3, "trt") != 0 || !parseNumber(trt.substr(3), id.trtVersion)) return false;
+
+    id.deviceName = name.substr(0, p1);
+    id.smMajor = smValue / 10;
+    id.smMinor = smValue % 10;
+    id.precision = name.substr(p3 + 1);
+    return !id.precision.empty();
+}
+
+bool TimingCacheId::forCurrentDevice(const std::string& precision, TimingCacheId& id) {
+    int device = 0;
+    cudaDeviceProp prop{};
+    if (cudaGetDevice(&device) != cudaSuccess || cudaGetDeviceProperties(&prop, device) != cudaSuccess) {
+        return false;
+    }
+    id.deviceName = sanitize(prop.name);
+    id.smMajor = prop.major;
+    id.smMinor = prop.minor;
+    id.trtVersion = getInferLibVersion();
+    id.precision = precision;
+    return true;
+}
+
+std::string TimingCacheId::precisionTag(bool fp16, bool fp8, bool int8, bool tf32) {
+    std::string tag;
+    auto add = [&tag](bool enabled, const char* name) {
+        if (!enabled) return;
+        if (!tag.empty()) tag += "-";
+        tag += name;
+    };
+    add(fp16, "fp16");
+    add(fp8, "fp8");
+    add(int8, "int8");
+    add(tf32, "tf32");
+    return tag.empty() ? "fp32" : tag;
+}
+
+bool TimingCacheFile::read(const std::string& path, std::vector<char>& data) {
+    data.clear();
+    if (!std::filesystem::exists(path)) return true;
+    FileLock lock(path);
+    if (!readFileBytes(path, data)) {
+        std::cerr << "Error: Cannot read timing cache: " << path << "\n";
+        return false;
+    }
+    return true;
+}
+
+bool TimingCacheFile::mergeAndWrite(const std::string& path, const nvinfer1::IBuilderConfig& config,
+                                    const nvinfer1::ITimingCache& cache) {
+    std::filesystem::path dir = std::filesystem::path(path).parent_path();
+    if (!dir.empty() && !std::filesystem::exists(dir)) {
+        std::error_code ec;
+        std::filesystem::create_directories(dir, ec);
+        if (ec) {
+            std::cerr << "Error: Cannot create timing cache directory: " << dir.string() << "\n";
+            return false;
+        }
+    }
+
+    FileLock lock(path);
+    std::unique_ptr<nvinfer1::IHostMemory> serialized;
+    std::vector<char> onDisk;
+    if (std::filesystem::exists(path) && readFileBytes(path, onDisk) && !onDisk.empty()) {
+        std::unique_ptr<nvinfer1::ITimingCache> merged(config.createTimingCache(onDisk.data(), onDisk.size()));
+        if (merged && merged->combine(cache, false)) {
+            serialized.reset(merged->serialize());
+        } else {
+            std::cerr << "Warning: Existing timing cache could not be merged, overwriting: " << path << "\n";
+        }
+    }
+    if (!serialized) {
+        serialized.reset(cache.serialize());
+    }
+    if (!serialized) {
+        std::cerr << "Error: Failed to serialize timing cache\n";
+        return false;
+    }
+    return writeFileAtomic(path, serialized->data(), serialized->size());
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <NvInfer.h>
+#include <string>
+#include <vector>
+
+// Identifies which builds may share a timing cache. Tactic timings are only
+// meaningful for the same GPU model, TensorRT version and precision flags, so
+// each combination gets its own file:
+//
+//   NVIDIA-GeForce-RTX-4090_sm89_trt101401_fp16-fp8-tf32.cache
+struct TimingCacheId {
+    std::string deviceName;     // sanitized: anything but [A-Za-z0-9] becomes '-'
+    int smMajor = 0;
+    int smMinor = 0;
+    int trtVersion = 0;         // getInferLibVersion(), e.g. 101401
+    std::string precision;      // "fp32" or enabled flags joined by '-'
+
+    std::string fileName() const;
+    static bool fromFileName(const std::string& fileName, TimingCacheId& id);
+
+    // Current CUDA device and linked TensorRT library; false if no device is available
+    static bool forCurrentDevice(const std::string& precision, TimingCacheId& id);
+    static std::string precisionTag(bool fp16, bool fp8, bool int8, bool tf32);
+};
+
+// Shared timing cache file, safe against concurrent builds on one machine
+// (or on a shared directory): reads and writes hold a cross-process lock, and
+// the file is replaced atomically.
+class TimingCacheFile {
+public:
+    // Missing file is not an error: returns true with empty data
+    static bool read(const std::string& path, std::vector<char>& data);
+
+    // Combines `cache` into whatever is on disk now (another build may have
+    // saved in the meantime) and replaces the file with the result
+    static bool mergeAndWrite(const std::string& path, const nvinfer1::IBuilderConfig& config,
+                              const nvinfer1::ITimingCache& cache);
+};
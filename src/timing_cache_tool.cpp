@@ -0,0 +1,386 @@
+// timing_cache_tool: merge, prune and inspect persistent TensorRT timing caches
+#include <NvInfer.h>
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "file_utils.h"
+#include "logger.h"
+#include "timing_cache.h"
+
+namespace {
+
+struct LoadedCache {
+    std::string path;
+    std::unique_ptr<nvinfer1::ITimingCache> cache;
+};
+
+// How one layer signature (timing cache key) is covered across the input caches
+struct SignatureStats {
+    int caches = 0;                 // input caches that already held this key
+    std::set<uint64_t> tactics;     // distinct winning tactics
+    float bestMs = std::numeric_limits<float>::max();
+};
+
+void printUsage(const std::string& program_name) {
+    std::cout << "Usage: " << program_name << " <command> [arguments]\n\n";
+    std::cout << "Commands:\n";
+    std::cout << "  merge <out_dir> <cache|dir>... [--csv <report.csv>]\n";
+    std::cout << "                                Combine caches per GPU/TensorRT/precision key into out_dir\n";
+    std::cout << "  prune <dir> [--trt <v1,v2>] [--sm <89,86>] [--dry-run]\n";
+    std::cout << "                                Delete caches for TensorRT versions or GPUs no longer in use\n";
+    std::cout << "                                (default --trt: the linked TensorRT version)\n";
+    std::cout << "  report <cache|dir>... [--csv <report.csv>]\n";
+    std::cout << "                                Per-signature key coverage and tactic agreement per\n";
+    std::cout << "                                GPU/TensorRT/precision key, without writing anything\n\n";
+    std::cout << "Cache files are named <device>_sm<XY>_trt<version>_<precision>.cache, as written by EngineExport.\n";
+}
+
+std::vector<std::string> splitList(const std::string& text) {
+    std::vector<std::string> items;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+bool takeOption(std::vector<std::string>& args, const std::string& name, std::string& value) {
+    for (size_t i = 0; i < args.size(); ++i) {
+        if (args[i] != name) continue;
+        if (i + 1 >= args.size()) {
+            std::cerr << "Error: Missing value for " << name << "\n";
+            return false;
+        }
+        value = args[i + 1];
+        args.erase(args.begin() + static_cast<std::ptrdiff_t>(i), args.begin() + static_cast<std::ptrdiff_t>(i) + 2);
+        return true;
+    }
+    return true;
+}
+
+bool takeFlag(std::vector<std::string>& args, const std::string& name) {
+    auto it = std::find(args.begin(), args.end(), name);
+    if (it == args.end()) return false;
+    args.erase(it);
+    return true;
+}
+
+// Caches only combine within one device/version/precision key, so files are
+// grouped by it; unrecognized names are skipped, or with keepUnrecognized
+// form a group of their own
+std::map<std::string, std::vector<std::string>> groupByKey(const std::vector<std::string>& files,
+                                                           bool keepUnrecognized) {
+    std::map<std::string, std::vector<std::string>> groups;
+    for (const auto& file : files) {
+        TimingCacheId id;
+        if (TimingCacheId::fromFileName(file, id)) {
+            groups[id.fileName()].push_back(file);
+        } else if (keepUnrecognized) {
+            groups[std::filesystem::path(file).filename().string()].push_back(file);
+        } else {
+            std::cerr << "Warning: Unrecognized cache name skipped: " << file << "\n";
+        }
+    }
+    return groups;
+}
+
+// Expands directories to the *.cache files they contain
+std::vector<std::string> collectCacheFiles(const std::vector<std::string>& inputs) {
+    std::vector<std::string> files;
+    for (const auto& input : inputs) {
+        if (std::filesystem::is_directory(input)) {
+            for (const auto& entry : std::filesystem::directory_iterator(input)) {
+                if (entry.is_regular_file() && entry.path().extension() == ".cache") {
+                    files.push_back(entry.path().string());
+                }
+            }
+        } else if (std::filesystem::exists(input)) {
+            files.push_back(input);
+        } else {
+            std::cerr << "Warning: Not found: " << input << "\n";
+        }
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+std::string keyToString(const nvinfer1::TimingCacheKey& key) {
+    std::string text = "0x";
+    char hex[3];
+    for (uint8_t b : key.data) {
+        std::snprintf(hex, sizeof(hex), "%02x", b);
+        text += hex;
+    }
+    return text;
+}
+
+std::vector<nvinfer1::TimingCacheKey> cacheKeys(const nvinfer1::ITimingCache& cache) {
+    int64_t count = cache.queryKeys(nullptr, 0);
+    if (count <= 0) return {};
+    std::vector<nvinfer1::TimingCacheKey> keys(static_cast<size_t>(count));
+    cache.queryKeys(keys.data(), count);
+    return keys;
+}
+
+bool loadCache(const nvinfer1::IBuilderConfig& config, const std::string& path, LoadedCache& loaded) {
+    std::vector<char> data;
+    if (!TimingCacheFile::read(path, data) || data.empty()) {
+        std::cerr << "Warning: Empty or unreadable cache skipped: " << path << "\n";
+        return false;
+    }
+    loaded.path = path;
+    loaded.cache.reset(config.createTimingCache(data.data(), data.size()));
+    if (!loaded.cache) {
+        std::cerr << "Warning: Invalid timing cache skipped: " << path << "\n";
+        return false;
+    }
+    return true;
+}
+
+// Prints key coverage per input and per signature within one group; optionally
+// writes all signatures as CSV. TensorRT does not count cache lookups, so this
+// is which signatures the caches hold, not how often builds hit them.
+void reportCoverage(const std::string& group, const std::vector<LoadedCache>& caches, std::ofstream* csv) {
+    std::map<std::string, SignatureStats> signatures;
+    std::vector<size_t> keyCounts;
+    for (const auto& loaded : caches) {
+        std::vector<nvinfer1::TimingCacheKey> keys = cacheKeys(*loaded.cache);
+        keyCounts.push_back(keys.size());
+        for (const auto& key : keys) {
+            SignatureStats& stats = signatures[keyToString(key)];
+            ++stats.caches;
+            nvinfer1::TimingCacheValue value = loaded.cache->query(key);
+            if (value.tacticHash != nvinfer1::TimingCacheValue::kINVALID_TACTIC_HASH) {
+                stats.tactics.insert(value.tacticHash);
+                stats.bestMs = std::min(stats.bestMs, value.timingMSec);
+            }
+        }
+    }
+    if (signatures.empty()) {
+        std::cout << "  No entries\n";
+        return;
+    }
+
+    size_t inAll = 0;
+    size_t disagreements = 0;
+    for (const auto& entry : signatures) {
+        if (entry.second.caches == static_cast<int>(caches.size())) ++inAll;
+        if (entry.second.tactics.size() > 1) ++disagreements;
+    }
+    std::cout << "  Layer signatures: " << signatures.size() << " ("
+              << (100.0 * inAll / signatures.size()) << "% present in every input, "
+              << disagreements << " with differing tactics)\n";
+    // Share of the group's merged signatures that input i holds on its own
+    for (size_t i = 0; i < caches.size(); ++i) {
+        std::cout << "  " << std::filesystem::path(caches[i].path).filename().string() << ": " << keyCounts[i]
+                  << " entries, coverage of merged " << (100.0 * keyCounts[i] / signatures.size()) << "%\n";
+    }
+
+    if (csv) {
+        // coverage: share of the group's caches that hold the signature
+        for (const auto& entry : signatures) {
+            const SignatureStats& stats = entry.second;
+            *csv << group << "," << entry.first << "," << stats.caches << ","
+                 << static_cast<double>(stats.caches) / caches.size() << ","
+                 << stats.tactics.size() << ","
+                 << (stats.tactics.empty() ? 0.0f : stats.bestMs) << "\n";
+        }
+    }
+}
+
+std::unique_ptr<std::ofstream> openCsv(const std::string& path) {
+    if (path.empty()) return nullptr;
+    auto csv = std::make_unique<std::ofstream>(path);
+    if (!*csv) {
+        std::cerr << "Error: Cannot create report: " << path << "\n";
+        return nullptr;
+    }
+    *csv << "group,signature,caches,coverage,distinct_tactics,best_ms\n";
+    return csv;
+}
+
+int runMerge(std::vector<std::string> args, nvinfer1::IBuilderConfig& config) {
+    std::string csvPath;
+    if (!takeOption(args, "--csv", csvPath)) return 1;
+    if (args.size() < 2) {
+        std::cerr << "Error: merge expects <out_dir> <cache|dir>...\n";
+        return 1;
+    }
+    std::string outDir = args[0];
+    std::vector<std::string> files = collectCacheFiles(std::vector<std::string>(args.begin() + 1, args.end()));
+
+    std::map<std::string, std::vector<std::string>> groups = groupByKey(files, false);
+    if (groups.empty()) {
+        std::cerr << "Error: No timing caches to merge\n";
+        return 1;
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(outDir, ec);
+    auto csv = openCsv(csvPath);
+    if (!csvPath.empty() && !csv) return 1;
+
+    int failures = 0;
+    for (const auto& group : groups) {
+        std::string outPath = (std::filesystem::path(outDir) / group.first).string();
+        std::cout << group.first << "\n";
+
+        std::vector<LoadedCache> inputs;
+        for (const auto& file : group.second) {
+            LoadedCache loaded;
+            if (loadCache(config, file, loaded)) inputs.push_back(std::move(loaded));
+        }
+        std::unique_ptr<nvinfer1::ITimingCache> merged(config.createTimingCache(nullptr, 0));
+        if (!merged) {
+            std::cerr << "Error: Failed to create timing cache\n";
+            return 1;
+        }
+        size_t combined = 0;
+        for (const auto& input : inputs) {
+            if (merged->combine(*input.cache, false)) {
+                ++combined;
+            } else {
+                std::cerr << "  Warning: Not combinable (device or version mismatch): " << input.path << "\n";
+            }
+        }
+        reportCoverage(group.first, inputs, csv.get());
+        if (combined == 0) {
+            ++failures;
+            continue;
+        }
+
+        // Through the exporter's path: a build saving to the same cache meanwhile is combined, not lost
+        if (!TimingCacheFile::mergeAndWrite(outPath, config, *merged)) {
+            ++failures;
+            continue;
+        }
+        std::cout << "  Merged " << combined << " cache(s) -> " << outPath << " ("
+                  << cacheKeys(*merged).size() << " entries)\n";
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+int runPrune(std::vector<std::string> args) {
+    std::string trtList, smList;
+    if (!takeOption(args, "--trt", trtList) || !takeOption(args, "--sm", smList)) return 1;
+    bool dryRun = takeFlag(args, "--dry-run");
+    if (args.size() != 1 || !std::filesystem::is_directory(args[0])) {
+        std::cerr << "Error: prune expects <dir>\n";
+        return 1;
+    }
+
+    std::set<int> keepTrt;
+    std::set<int> keepSm;
+    try {
+        for (const auto& v : splitList(trtList)) keepTrt.insert(std::stoi(v));
+        for (const auto& v : splitList(smList)) keepSm.insert(std::stoi(v));
+    } catch (...) {
+        std::cerr << "Error: --trt and --sm take comma-separated numbers\n";
+        return 1;
+    }
+    if (keepTrt.empty()) keepTrt.insert(getInferLibVersion());
+
+    int removed = 0;
+    int kept = 0;
+    for (const auto& file : collectCacheFiles({args[0]})) {
+        TimingCacheId id;
+        if (!TimingCacheId::fromFileName(file, id)) {
+            std::cout << "  Keep (unrecognized name): " << file << "\n";
+            ++kept;
+            continue;
+        }
+        bool keep = keepTrt.count(id.trtVersion) && (keepSm.empty() || keepSm.count(id.smMajor * 10 + id.smMinor));
+        if (keep) {
+            ++kept;
+            continue;
+        }
+        std::cout << "  " << (dryRun ? "Would remove: " : "Remove: ") << file << "\n";
+        if (!dryRun) {
+            FileLock lock(file);
+            std::error_code ec;
+            std::filesystem::remove(file, ec);
+            if (ec) {
+                std::cerr << "Error: Cannot remove " << file << ": " << ec.message() << "\n";
+                continue;
+            }
+        }
+        ++removed;
+    }
+    std::cout << (dryRun ? "Would remove " : "Removed ") << removed << ", kept " << kept << "\n";
+    return 0;
+}
+
+int runReport(std::vector<std::string> args, nvinfer1::IBuilderConfig& config) {
+    std::string csvPath;
+    if (!takeOption(args, "--csv", csvPath)) return 1;
+    std::vector<std::string> files = collectCacheFiles(args);
+    if (files.empty()) {
+        std::cerr << "Error: report expects <cache|dir>...\n";
+        return 1;
+    }
+    auto csv = openCsv(csvPath);
+    if (!csvPath.empty() && !csv) return 1;
+
+    // Coverage only means something among caches that could be merged
+    size_t loadedCount = 0;
+    for (const auto& group : groupByKey(files, true)) {
+        std::vector<LoadedCache> caches;
+        for (const auto& file : group.second) {
+            LoadedCache loaded;
+            if (loadCache(config, file, loaded)) caches.push_back(std::move(loaded));
+        }
+        if (caches.empty()) continue;
+        loadedCount += caches.size();
+        std::cout << group.first << "\n";
+        reportCoverage(group.first, caches, csv.get());
+    }
+    return loadedCount > 0 ? 0 : 1;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> args(argv, argv + argc);
+    if (argc < 2 || args[1] == "--help" || args[1] == "-h") {
+        printUsage(args[0]);
+        return argc < 2 ? 1 : 0;
+    }
+    std::string command = args[1];
+    std::vector<std::string> rest(args.begin() + 2, args.end());
+
+    try {
+        if (command == "prune") return runPrune(rest);
+        if (command != "merge" && command != "report") {
+            std::cerr << "Error: Unknown command: " << command << "\n";
+            printUsage(args[0]);
+            return 1;
+        }
+
+        // Timing caches are created and combined through a builder config
+        TensorRTLogger logger(false);
+        std::unique_ptr<nvinfer1::IBuilder> builder(nvinfer1::createInferBuilder(logger));
+        if (!builder) {
+            std::cerr << "Error: Failed to create TensorRT builder\n";
+            return 1;
+        }
+        std::unique_ptr<nvinfer1::IBuilderConfig> config(builder->createBuilderConfig());
+        if (!config) {
+            std::cerr << "Error: Failed to create builder config\n";
+            return 1;
+        }
+        return command == "merge" ? runMerge(rest, *config) : runReport(rest, *config);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
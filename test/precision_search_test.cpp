@@ -0,0 +1,308 @@
+// CPU-only checks of PrecisionSearch and detection scoring, with a scripted
+// backend in place of TensorRT builds. Run through ctest or directly; prints
+// each failed check and exits non-zero if there was one.
+
+#include "precision_search.h"
+#include <iostream>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace {
+
+int g_failures = 0;
+
+#define CHECK(condition)                                                               \
+    do {                                                                               \
+        if (!(condition)) {                                                            \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #condition ") failed\n"; \
+            ++g_failures;                                                              \
+        }                                                                              \
+    } while (0)
+
+// Stands in for building and running an engine. Each layer costs 1.0 ms in
+// fp32 and cost[precision] otherwise; a layer listed as sensitive to a
+// precision loses every detection when it runs in it.
+class ScriptedBackend : public PrecisionSearchBackend {
+public:
+    explicit ScriptedBackend(int layers) {
+        for (int i = 0; i < layers; ++i) m_layers.push_back("layer" + std::to_string(i));
+        m_golden = {{{10, 10, 50, 50, 0.9f, 0}, {60, 60, 90, 90, 0.8f, 1}}, {{5, 5, 25, 25, 0.7f, 2}}};
+    }
+
+    bool listLayers(std::vector<std::string>& layers) override {
+        layers = m_layers;
+        return true;
+    }
+
+    bool evaluate(const PrecisionPolicy& policy, SearchCandidate& candidate) override {
+        std::vector<std::string> precisions(m_layers.size(), "fp32");
+        for (const auto& rule : policy.rules()) {
+            for (size_t i = 0; i < m_layers.size(); ++i) {
+                if (rule.layer == m_layers[i]) precisions[i] = rule.precision;
+            }
+        }
+        evaluated.push_back(precisions);
+        if (failBuilds.count(evaluated.size())) return false;
+
+        bool drift = false;
+        candidate.latencyMs = 0.0;
+        for (size_t i = 0; i < m_layers.size(); ++i) {
+            auto found = sensitive.find(m_layers[i]);
+            if (found != sensitive.end() && found->second.count(precisions[i])) drift = true;
+            candidate.latencyMs += precisions[i] == "fp32" ? 1.0 : cost[precisions[i]];
+        }
+        candidate.frames = m_golden;
+        if (drift) {
+            for (auto& frame : candidate.frames) frame.clear();
+        }
+        return true;
+    }
+
+    std::map<std::string, std::set<std::string>> sensitive;    // layer -> precisions it cannot take
+    std::map<std::string, double> cost = {{"fp16", 0.5}, {"int8", 0.25}};
+    std::set<size_t> failBuilds;                               // 1-based evaluation numbers
+    std::vector<std::vector<std::string>> evaluated;
+
+private:
+    std::vector<std::string> m_layers;
+    std::vector<FrameDetections> m_golden;
+};
+
+bool allDistinct(const std::vector<std::vector<std::string>>& trials) {
+    std::set<std::vector<std::string>> seen(trials.begin(), trials.end());
+    return seen.size() == trials.size();
+}
+
+PrecisionSearchOptions options(const std::vector<std::string>& targets) {
+    PrecisionSearchOptions result;
+    result.targets = targets;
+    return result;
+}
+
+void testBisectsToSingleLayers() {
+    ScriptedBackend backend(8);
+    backend.sensitive["layer3"] = {"fp16"};
+    PrecisionSearch search(backend, options({"fp16"}));
+    PrecisionSearchResult result;
+    CHECK(search.run(result));
+
+    // baseline, 0-8 rejected, 0-4 rejected, 0-2 accepted, 2 accepted, 4-8 accepted. 2-4 after 0-2 and
+    // 3 after 2 would repeat the rejected 0-4 trial, so they are not built
+    CHECK(result.evaluations == 6);
+    CHECK(backend.evaluated.size() == 6);
+    CHECK(allDistinct(backend.evaluated));
+    std::vector<std::string> expected(8, "fp16");
+    expected[3] = "fp32";
+    CHECK(result.precisions == expected);
+    CHECK(result.latencyMs == 7 * 0.5 + 1.0);
+    CHECK(result.baselineLatencyMs == 8.0);
+    CHECK(result.score.f1 == 1.0);
+
+    // The policy names every layer exactly
+    CHECK(result.policy.rules().size() == 8);
+    CHECK(result.policy.rules()[3].layer == "layer3" && result.policy.rules()[3].precision == "fp32");
+}
+
+void testSkipsRejectedRepeats() {
+    // Sensitive layers at both ends: each rejected range splits, and whenever a
+    // left half is lowered whole, its right sibling goes straight to its halves
+    ScriptedBackend backend(16);
+    backend.sensitive["layer0"] = {"fp16"};
+    backend.sensitive["layer7"] = {"fp16"};
+    backend.sensitive["layer15"] = {"fp16"};
+    PrecisionSearch search(backend, options({"fp16"}));
+    PrecisionSearchResult result;
+    CHECK(search.run(result));
+    CHECK(allDistinct(backend.evaluated));
+    std::vector<std::string> expected(16, "fp16");
+    expected[0] = expected[7] = expected[15] = "fp32";
+    CHECK(result.precisions == expected);
+}
+
+void testEvaluationCap() {
+    ScriptedBackend backend(8);
+    backend.sensitive["layer3"] = {"fp16"};
+    PrecisionSearchOptions capped = options({"fp16"});
+    capped.maxEvaluations = 3;
+    PrecisionSearch search(backend, capped);
+    PrecisionSearchResult result;
+    CHECK(search.run(result));
+
+    // baseline, 0-8 rejected, 0-4 rejected; nothing accepted, so the baseline stands
+    CHECK(result.evaluations == 3);
+    CHECK(backend.evaluated.size() == 3);
+    CHECK(result.precisions == std::vector<std::string>(8, "fp32"));
+    CHECK(result.latencyMs == result.baselineLatencyMs);
+}
+
+void testInt8OnlyLowersFp16Layers() {
+    ScriptedBackend backend(8);
+    backend.sensitive["layer1"] = {"fp16", "int8"};
+    backend.sensitive["layer5"] = {"int8"};
+    PrecisionSearch search(backend, options({"fp16", "int8"}));
+    PrecisionSearchResult result;
+    CHECK(search.run(result));
+
+    CHECK(allDistinct(backend.evaluated));
+    // layer1 stayed fp32 in the fp16 step, so the int8 step never tries it
+    for (const auto& precisions : backend.evaluated) {
+        CHECK(precisions[1] != "int8");
+    }
+    std::vector<std::string> expected(8, "int8");
+    expected[1] = "fp32";
+    expected[5] = "fp16";
+    CHECK(result.precisions == expected);
+}
+
+void testKeepsFastestAccepted() {
+    // int8 passes but is slower than fp16 here; the faster fp16 candidate wins
+    ScriptedBackend backend(4);
+    backend.cost["int8"] = 0.75;
+    PrecisionSearch search(backend, options({"fp16", "int8"}));
+    PrecisionSearchResult result;
+    CHECK(search.run(result));
+    CHECK(result.evaluations == 3);
+    CHECK(result.precisions == std::vector<std::string>(4, "fp16"));
+    CHECK(result.latencyMs == 2.0);
+}
+
+void testFailedBuilds() {
+    // A candidate that fails to build is rejected like a drifting one: with
+    // layer0 lowered, lowering layer1 would be that candidate again
+    ScriptedBackend backend(2);
+    backend.failBuilds = {2};
+    PrecisionSearch search(backend, options({"fp16"}));
+    PrecisionSearchResult result;
+    CHECK(search.run(result));
+    CHECK(result.precisions == std::vector<std::string>({"fp16", "fp32"}));
+    CHECK(result.evaluations == 3);
+
+    // Without a baseline there is nothing to score against
+    ScriptedBackend broken(2);
+    broken.failBuilds = {1};
+    PrecisionSearch failing(broken, options({"fp16"}));
+    CHECK(!failing.run(result));
+}
+
+void testScoreDetections() {
+    const DetectionBox a = {0, 0, 10, 10, 0.9f, 0};
+    const DetectionBox b = {20, 20, 40, 40, 0.8f, 1};
+
+    // No boxes on either side is a perfect match
+    DetectionScore score = scoreDetections({{}, {}}, {{}, {}}, 0.5);
+    CHECK(score.f1 == 1.0 && score.meanIou == 1.0 && score.matched == 0);
+
+    // Boxes where the baseline has none: precision 0
+    score = scoreDetections({{}}, {{a}}, 0.5);
+    CHECK(score.precision == 0.0 && score.recall == 1.0 && score.f1 == 0.0 && score.meanIou == 0.0);
+
+    // Missing boxes, also from missing frames: recall 0
+    score = scoreDetections({{a}, {b}}, {}, 0.5);
+    CHECK(score.golden == 2 && score.candidate == 0 && score.recall == 0.0 && score.f1 == 0.0);
+
+    // Same box, other class: no match
+    DetectionBox otherClass = a;
+    otherClass.classId = 3;
+    score = scoreDetections({{a}}, {{otherClass}}, 0.5);
+    CHECK(score.matched == 0);
+
+    // A shifted box matches while its IoU reaches the threshold
+    DetectionBox shifted = {1, 0, 11, 10, 0.9f, 0};
+    score = scoreDetections({{a, b}}, {{shifted, b}}, 0.5);
+    CHECK(score.matched == 2 && score.f1 == 1.0);
+    CHECK(score.meanIou < 1.0 && score.meanIou > 0.9);
+    score = scoreDetections({{a}}, {{shifted}}, 0.9);
+    CHECK(score.matched == 0);
+
+    // One golden box matches at most one candidate box
+    score = scoreDetections({{a}}, {{a, a}}, 0.5);
+    CHECK(score.matched == 1 && score.precision == 0.5 && score.recall == 1.0);
+}
+
+void testDecodeDetections() {
+    JsonValue raw = JsonValue::makeObject();
+    raw.set("type", "raw");
+    raw.set("anchor_axis", 1);
+    raw.set("num_classes", 2);
+    raw.set("score_threshold", 0.25);
+    raw.set("iou_threshold", 0.45);
+
+    // [anchors, 4 + classes]: two overlapping class-0 boxes, one class-1 box on top
+    // of them, one below the score threshold
+    const float anchorsFirst[] = {
+        20, 20, 20, 20, 0.9f, 0.1f,
+        21, 20, 20, 20, 0.8f, 0.1f,
+        20, 20, 20, 20, 0.1f, 0.7f,
+        80, 80, 10, 10, 0.2f, 0.1f,
+    };
+    DetectionLayout layout;
+    CHECK(DetectionLayout::fromMetadata(raw, 4, 6, layout));
+    CHECK(!layout.nms && !layout.anchorsLast && layout.anchors == 4 && layout.numClasses == 2);
+    FrameDetections boxes = decodeDetections(anchorsFirst, layout);
+    CHECK(boxes.size() == 2);
+    CHECK(boxes.size() == 2 && boxes[0].classId == 0 && boxes[0].score == 0.9f && boxes[0].x1 == 10 &&
+          boxes[0].x2 == 30);
+    CHECK(boxes.size() == 2 && boxes[1].classId == 1);
+
+    // The same head with anchors last ([4 + classes, anchors]) decodes the same
+    float anchorsLast[24];
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 6; ++j) anchorsLast[j * 4 + i] = anchorsFirst[i * 6 + j];
+    }
+    raw.set("anchor_axis", 2);
+    DetectionLayout transposed;
+    CHECK(DetectionLayout::fromMetadata(raw, 6, 4, transposed));
+    CHECK(transposed.anchorsLast && transposed.anchors == 4 && transposed.values == 6);
+    FrameDetections same = decodeDetections(anchorsLast, transposed);
+    CHECK(same.size() == boxes.size());
+    for (size_t i = 0; i < same.size() && i < boxes.size(); ++i) {
+        CHECK(same[i].classId == boxes[i].classId && same[i].score == boxes[i].score && same[i].x1 == boxes[i].x1);
+    }
+
+    // Without NMS the overlapping class-0 boxes both survive an IoU threshold of 1
+    raw.set("iou_threshold", 1.0);
+    CHECK(DetectionLayout::fromMetadata(raw, 6, 4, transposed));
+    CHECK(decodeDetections(anchorsLast, transposed).size() == 3);
+
+    // NMS heads are taken as they are, only filtered by score
+    JsonValue nms = JsonValue::makeObject();
+    nms.set("type", "nms");
+    nms.set("score_threshold", 0.5);
+    const float nmsOutput[] = {
+        10, 10, 30, 30, 0.9f, 2,
+        11, 10, 31, 30, 0.8f, 2,
+        0, 0, 0, 0, 0, 0,
+    };
+    CHECK(DetectionLayout::fromMetadata(nms, 3, 6, layout));
+    CHECK(layout.nms && layout.anchors == 3);
+    boxes = decodeDetections(nmsOutput, layout);
+    CHECK(boxes.size() == 2 && boxes[0].classId == 2 && boxes[1].x1 == 11);
+    CHECK(!DetectionLayout::fromMetadata(nms, 3, 7, layout));
+
+    // Empty output: no boxes
+    CHECK(DetectionLayout::fromMetadata(nms, 0, 6, layout) == false);
+    layout.anchors = 0;
+    CHECK(decodeDetections(nmsOutput, layout).empty());
+}
+
+} // namespace
+
+int main() {
+    testBisectsToSingleLayers();
+    testSkipsRejectedRepeats();
+    testEvaluationCap();
+    testInt8OnlyLowersFp16Layers();
+    testKeepsFastestAccepted();
+    testFailedBuilds();
+    testScoreDetections();
+    testDecodeDetections();
+
+    if (g_failures > 0) {
+        std::cerr << g_failures << " checks failed\n";
+        return 1;
+    }
+    std::cout << "All precision search checks passed\n";
+    return 0;
+}
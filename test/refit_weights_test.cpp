@@ -0,0 +1,183 @@
+// CPU-only checks of RefitWeights: engine weights and I/O tensors matched
+// against an in-memory ONNX graph, as EngineRefit does before refitting.
+// Run through ctest or directly; prints each failed check and exits non-zero
+// if there was one.
+
+#include "onnx_model.h"
+#include "refit_weights.h"
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+int g_failures = 0;
+
+#define CHECK(condition)                                                               \
+    do {                                                                               \
+        if (!(condition)) {                                                            \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #condition ") failed\n"; \
+            ++g_failures;                                                              \
+        }                                                                              \
+    } while (0)
+
+bool contains(const std::vector<std::string>& items, const std::string& item) {
+    return std::find(items.begin(), items.end(), item) != items.end();
+}
+
+// conv1 (8x3x3x3) + bn1 folded by the parser, then a Constant-fed Mul
+OnnxGraph makeGraph(int64_t conv1Filters) {
+    OnnxGraph graph;
+    graph.initializers.push_back(OnnxTensor::fromFloats(
+        "conv1.weight", {conv1Filters, 3, 3, 3}, std::vector<float>(static_cast<size_t>(conv1Filters) * 27, 0.5f)));
+    graph.initializers.push_back(OnnxTensor::fromFloats("conv1.bias", {conv1Filters},
+                                                        std::vector<float>(static_cast<size_t>(conv1Filters), 0.0f)));
+    graph.initializers.push_back(OnnxTensor::fromFloats("bn1.scale", {conv1Filters},
+                                                        std::vector<float>(static_cast<size_t>(conv1Filters), 1.0f)));
+
+    OnnxNode constant;
+    constant.opType = "Constant";
+    constant.outputs = {"scale_const"};
+    constant.attributes.push_back(OnnxAttribute::makeTensor("value", OnnxTensor::fromFloats("", {4}, {1, 2, 3, 4})));
+    graph.nodes.push_back(constant);
+
+    OnnxNode other;
+    other.opType = "Relu";
+    other.inputs = {"x"};
+    other.outputs = {"y"};
+    graph.nodes.push_back(other);
+
+    OnnxValueInfo input;
+    input.name = "images";
+    graph.inputs.push_back(input);
+    OnnxValueInfo output;
+    output.name = "output0";
+    graph.outputs.push_back(output);
+    return graph;
+}
+
+// What IRefitter reports for an engine built from makeGraph(8): bn1 is folded
+// into conv1, whose folded weights the parser derives under their own names
+std::vector<RefitWeight> engineWeights() {
+    return {{"conv1.weight", 216}, {"conv1.bias", 8}, {"scale_const", 4}, {"conv1.weight_folded", 216}};
+}
+
+RefitWeightCheck checkModel(const OnnxGraph& graph, const std::vector<RefitWeight>& weights,
+                            const std::vector<std::string>& engineInputs = {"images"},
+                            const std::vector<std::string>& engineOutputs = {"output0"}) {
+    RefitWeightCheck check = RefitWeights::check(weights, RefitWeights::fromOnnx(graph));
+    std::vector<std::string> onnxInputs, onnxOutputs;
+    for (const OnnxValueInfo* input : graph.runtimeInputs()) onnxInputs.push_back(input->name);
+    for (const auto& output : graph.outputs) onnxOutputs.push_back(output.name);
+    RefitWeights::checkTensors("input", engineInputs, onnxInputs, check);
+    RefitWeights::checkTensors("output", engineOutputs, onnxOutputs, check);
+    return check;
+}
+
+void testFromOnnx() {
+    std::vector<RefitWeight> weights = RefitWeights::fromOnnx(makeGraph(8));
+    CHECK(weights.size() == 4);
+    CHECK(weights.size() == 4 && weights[0].name == "conv1.weight" && weights[0].count == 216);
+    CHECK(weights.size() == 4 && weights[3].name == "scale_const" && weights[3].count == 4);
+}
+
+void testFromOnnxWithoutData() {
+    // EngineRefit loads the model without tensor data; the check sees the same weights
+    OnnxModel model;
+    model.graph = makeGraph(8);
+    std::string bytes = model.serialize();
+    OnnxModel outline;
+    CHECK(outline.loadFromBuffer(bytes.data(), bytes.size(), false));
+    for (const auto& tensor : outline.graph.initializers) CHECK(tensor.rawData.empty());
+    CHECK(outline.graph.nodes.size() == 2 && outline.graph.nodes[0].attr("value") &&
+          outline.graph.nodes[0].attr("value")->t.rawData.empty());
+
+    std::vector<RefitWeight> full = RefitWeights::fromOnnx(model.graph);
+    std::vector<RefitWeight> names = RefitWeights::fromOnnx(outline.graph);
+    CHECK(names.size() == full.size());
+    for (size_t i = 0; i < names.size() && i < full.size(); ++i) {
+        CHECK(names[i].name == full[i].name && names[i].count == full[i].count);
+    }
+}
+
+void testMatched() {
+    // Same model, retrained: every weight matches by name and size
+    std::vector<RefitWeight> weights = {{"conv1.weight", 216}, {"conv1.bias", 8}, {"scale_const", 4}};
+    RefitWeightCheck check = checkModel(makeGraph(8), weights);
+    CHECK(check.matched.size() == 3);
+    CHECK(check.derived.empty());
+    CHECK(check.differences.empty());
+    CHECK(!check.isForeign());
+}
+
+void testDerived() {
+    // Weights the parser computes are not in the ONNX, which is fine next to matches
+    RefitWeightCheck check = checkModel(makeGraph(8), engineWeights());
+    CHECK(check.matched.size() == 3);
+    CHECK(check.derived.size() == 1 && contains(check.derived, "conv1.weight_folded"));
+    CHECK(check.differences.empty());
+    CHECK(!check.isForeign());
+}
+
+void testCountChange() {
+    // Same names, wider conv1: a topology change, listed old -> new
+    RefitWeightCheck check = checkModel(makeGraph(16), engineWeights());
+    CHECK(contains(check.differences, "~ conv1.weight: 216 -> 432 values"));
+    CHECK(contains(check.differences, "~ conv1.bias: 8 -> 16 values"));
+    CHECK(check.differences.size() == 2);
+    CHECK(contains(check.matched, "scale_const"));
+    CHECK(check.isForeign());
+}
+
+void testTensorDifferences() {
+    // Matching weights, but renamed I/O: the engine's bindings would not exist
+    RefitWeightCheck check = checkModel(makeGraph(8), engineWeights(), {"input"}, {"output0", "output1"});
+    CHECK(check.matched.size() == 3);
+    CHECK(contains(check.differences, "- input input: not in the ONNX"));
+    CHECK(contains(check.differences, "+ input images: not in the engine"));
+    CHECK(contains(check.differences, "- output output1: not in the ONNX"));
+    CHECK(check.differences.size() == 3);
+    CHECK(check.isForeign());
+
+    // Initializers listed as graph inputs (older IR versions) are not runtime inputs
+    OnnxGraph graph = makeGraph(8);
+    OnnxValueInfo listed;
+    listed.name = "conv1.weight";
+    graph.inputs.push_back(listed);
+    check = checkModel(graph, engineWeights());
+    CHECK(check.differences.empty());
+}
+
+void testForeignModel() {
+    // No weight name in common: everything looks derived, nothing matches
+    std::vector<RefitWeight> weights = {{"model.0.conv.weight", 432}, {"model.0.conv.bias", 16}};
+    RefitWeightCheck check = checkModel(makeGraph(8), weights);
+    CHECK(check.matched.empty());
+    CHECK(check.derived.size() == 2);
+    CHECK(check.differences.empty());
+    CHECK(check.isForeign());
+
+    // An engine without refittable weights has nothing to check against
+    check = RefitWeights::check({}, RefitWeights::fromOnnx(makeGraph(8)));
+    CHECK(!check.isForeign());
+}
+
+} // namespace
+
+int main() {
+    testFromOnnx();
+    testFromOnnxWithoutData();
+    testMatched();
+    testDerived();
+    testCountChange();
+    testTensorDifferences();
+    testForeignModel();
+
+    if (g_failures > 0) {
+        std::cerr << g_failures << " checks failed\n";
+        return 1;
+    }
+    std::cout << "All refit weight checks passed\n";
+    return 0;
+}